@@ -0,0 +1,22 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_compositing_benchmark.h"
+
+class CompositingOpenGLBenchmark : public GenericCompositingBenchmark
+{
+    Q_OBJECT
+public:
+    CompositingOpenGLBenchmark()
+        : GenericCompositingBenchmark(QByteArrayLiteral("O2"), KWin::OpenGLCompositing)
+    {
+    }
+};
+
+WAYLANDTEST_MAIN(CompositingOpenGLBenchmark)
+#include "compositing_opengl_benchmark.moc"
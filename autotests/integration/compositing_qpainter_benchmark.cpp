@@ -0,0 +1,22 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_compositing_benchmark.h"
+
+class CompositingQPainterBenchmark : public GenericCompositingBenchmark
+{
+    Q_OBJECT
+public:
+    CompositingQPainterBenchmark()
+        : GenericCompositingBenchmark(QByteArrayLiteral("Q"), KWin::QPainterCompositing)
+    {
+    }
+};
+
+WAYLANDTEST_MAIN(CompositingQPainterBenchmark)
+#include "compositing_qpainter_benchmark.moc"
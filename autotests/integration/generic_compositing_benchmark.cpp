@@ -0,0 +1,361 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_compositing_benchmark.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "frametimeline.h"
+#include "output.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+
+#include <KWayland/Client/subsurface.h>
+#include <KWayland/Client/surface.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace KWin;
+
+GenericCompositingBenchmark::GenericCompositingBenchmark(const QByteArray &envVariable, CompositingType compositingType)
+    : QObject()
+    , m_envVariable(envVariable)
+    , m_compositingType(compositingType)
+{
+}
+
+GenericCompositingBenchmark::~GenericCompositingBenchmark()
+{
+}
+
+void GenericCompositingBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(QStringLiteral("wayland_test_kwin_compositing_benchmark_%1-0").arg(QString::fromLatin1(m_envVariable))));
+
+    // disable all effects, only the cost of the scene is of interest
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", m_envVariable);
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QVERIFY(Compositor::self());
+
+    // OpenGL compositing on the virtual backend needs a render node, e.g. llvmpipe.
+    if (Compositor::self()->backend()->compositingType() != m_compositingType) {
+        QSKIP("The requested compositing type is not available");
+    }
+
+    m_renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+}
+
+void GenericCompositingBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void GenericCompositingBenchmark::cleanup()
+{
+    for (const QMetaObject::Connection &connection : qAsConst(m_commitConnections)) {
+        disconnect(connection);
+    }
+    m_commitConnections.clear();
+    Test::destroyWaylandConnection();
+}
+
+void GenericCompositingBenchmark::trackCommits(Window *window)
+{
+    m_commitConnections.append(connect(window->surface(), &KWaylandServer::SurfaceInterface::committed, this, [this]() {
+        m_commits.append(std::chrono::steady_clock::now().time_since_epoch());
+    }));
+}
+
+void GenericCompositingBenchmark::run(const std::function<void(int)> &step)
+{
+    bool ok = false;
+    int frameCount = qEnvironmentVariableIntValue("KWIN_BENCHMARK_FRAMES", &ok);
+    if (!ok) {
+        frameCount = 120;
+    }
+    // Older frames would fall out of the timeline before they are reported.
+    frameCount = std::clamp(frameCount, 1, FrameTimeline::capacity);
+
+    const QVector<FrameTimelineEntry> previousFrames = m_renderLoop->frameTimeline()->entries();
+    const quint64 firstFrame = previousFrames.isEmpty() ? 0 : previousFrames.constLast().frame + 1;
+    m_commits.clear();
+
+    QSignalSpy framePresentedSpy(m_renderLoop, &RenderLoop::framePresented);
+    QVERIFY(framePresentedSpy.isValid());
+    for (int i = 0; i < frameCount; ++i) {
+        step(i);
+        Test::flushWaylandConnection();
+        QVERIFY(framePresentedSpy.wait());
+    }
+
+    report(firstFrame, frameCount);
+}
+
+static double toMicroseconds(std::chrono::nanoseconds duration)
+{
+    return duration.count() / 1000.0;
+}
+
+static QJsonObject statistics(QVector<std::chrono::nanoseconds> samples)
+{
+    if (samples.isEmpty()) {
+        return QJsonObject();
+    }
+    std::sort(samples.begin(), samples.end());
+
+    std::chrono::nanoseconds sum = std::chrono::nanoseconds::zero();
+    for (const std::chrono::nanoseconds &sample : qAsConst(samples)) {
+        sum += sample;
+    }
+    const auto percentile = [&samples](int percentile) {
+        const int rank = std::max(1, int(std::ceil(percentile * samples.count() / 100.0)));
+        return toMicroseconds(samples[rank - 1]);
+    };
+
+    return QJsonObject{
+        {QStringLiteral("samples"), samples.count()},
+        {QStringLiteral("mean"), toMicroseconds(sum / samples.count())},
+        {QStringLiteral("median"), percentile(50)},
+        {QStringLiteral("p95"), percentile(95)},
+        {QStringLiteral("max"), toMicroseconds(samples.constLast())},
+    };
+}
+
+static qint64 memoryUsage(const QByteArray &field)
+{
+    QFile file(QStringLiteral("/proc/self/status"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(field + ':')) {
+            return line.mid(field.size() + 1).simplified().split(' ').constFirst().toLongLong();
+        }
+    }
+    return -1;
+}
+
+void GenericCompositingBenchmark::report(quint64 firstFrame, int frameCount)
+{
+    QVector<FrameTimelineEntry> frames = m_renderLoop->frameTimeline()->entries();
+    frames.erase(std::remove_if(frames.begin(), frames.end(), [firstFrame](const FrameTimelineEntry &frame) {
+                     return frame.frame < firstFrame;
+                 }),
+                 frames.end());
+    QVERIFY(!frames.isEmpty());
+
+    QVector<std::chrono::nanoseconds> frameTimes;
+    QVector<std::chrono::nanoseconds> renderTimes;
+    QVector<std::chrono::nanoseconds> gpuRenderTimes;
+    int failedFrames = 0;
+    int missedVblanks = 0;
+    for (const FrameTimelineEntry &frame : qAsConst(frames)) {
+        frameTimes.append(frame.submitTimestamp - frame.startTimestamp);
+        renderTimes.append(frame.renderEndTimestamp - frame.renderStartTimestamp);
+        if (frame.gpuRenderTime) {
+            gpuRenderTimes.append(*frame.gpuRenderTime);
+        }
+        failedFrames += frame.failed;
+        missedVblanks += frame.missedVblanks;
+    }
+
+    // A commit is shown by the first frame that started compositing after it.
+    QVector<std::chrono::nanoseconds> latencies;
+    auto frame = frames.constBegin();
+    for (const std::chrono::nanoseconds &commit : qAsConst(m_commits)) {
+        while (frame != frames.constEnd() && (frame->startTimestamp < commit || frame->failed || frame->presentationTimestamp == std::chrono::nanoseconds::zero())) {
+            ++frame;
+        }
+        if (frame == frames.constEnd()) {
+            break;
+        }
+        latencies.append(frame->presentationTimestamp - commit);
+    }
+
+    const QJsonObject frameTimeStatistics = statistics(frameTimes);
+    QTest::setBenchmarkResult(frameTimeStatistics[QStringLiteral("mean")].toDouble() * 1000, QTest::WalltimeNanoseconds);
+
+    const QString reportFileName = qEnvironmentVariable("KWIN_BENCHMARK_REPORT");
+    if (reportFileName.isEmpty()) {
+        return;
+    }
+
+    const QJsonObject result{
+        {QStringLiteral("benchmark"), QString::fromLatin1(metaObject()->className())},
+        {QStringLiteral("compositing"), QString::fromLatin1(m_envVariable)},
+        {QStringLiteral("test"), QString::fromLatin1(QTest::currentTestFunction())},
+        {QStringLiteral("tag"), QString::fromLatin1(QTest::currentDataTag())},
+        {QStringLiteral("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {QStringLiteral("frames"), frameCount},
+        {QStringLiteral("failedFrames"), failedFrames},
+        {QStringLiteral("missedVblanks"), missedVblanks},
+        {QStringLiteral("frameTime"), frameTimeStatistics},
+        {QStringLiteral("renderTime"), statistics(renderTimes)},
+        {QStringLiteral("gpuRenderTime"), statistics(gpuRenderTimes)},
+        {QStringLiteral("commitToPresentLatency"), statistics(latencies)},
+        {QStringLiteral("residentMemory"), memoryUsage(QByteArrayLiteral("VmRSS"))},
+        {QStringLiteral("peakResidentMemory"), memoryUsage(QByteArrayLiteral("VmHWM"))},
+    };
+
+    QFile reportFile(reportFileName);
+    QVERIFY(reportFile.open(QIODevice::WriteOnly | QIODevice::Append));
+    reportFile.write(QJsonDocument(result).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void GenericCompositingBenchmark::benchmarkManyWindows_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::addRow("1") << 1;
+    QTest::addRow("10") << 10;
+    QTest::addRow("50") << 50;
+    QTest::addRow("100") << 100;
+}
+
+void GenericCompositingBenchmark::benchmarkManyWindows()
+{
+    // This benchmark measures frames in which every window has been updated.
+    QFETCH(int, windowCount);
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+    for (int i = 0; i < windowCount; ++i) {
+        surfaces.emplace_back(Test::createSurface());
+        shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+        Window *window = Test::renderAndWaitForShown(surfaces.back().get(), QSize(256, 256), Qt::blue);
+        QVERIFY(window);
+        trackCommits(window);
+    }
+
+    run([&surfaces](int frame) {
+        for (const auto &surface : surfaces) {
+            Test::render(surface.get(), QSize(256, 256), frame % 2 ? Qt::blue : Qt::red);
+        }
+    });
+}
+
+void GenericCompositingBenchmark::benchmarkRapidCommits_data()
+{
+    QTest::addColumn<int>("commitsPerFrame");
+
+    QTest::addRow("1") << 1;
+    QTest::addRow("4") << 4;
+    QTest::addRow("16") << 16;
+}
+
+void GenericCompositingBenchmark::benchmarkRapidCommits()
+{
+    // This benchmark measures a client that commits faster than the output refreshes.
+    QFETCH(int, commitsPerFrame);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(1024, 768), Qt::blue);
+    QVERIFY(window);
+    trackCommits(window);
+
+    run([&surface, commitsPerFrame](int frame) {
+        for (int i = 0; i < commitsPerFrame; ++i) {
+            Test::render(surface.get(), QSize(1024, 768), (frame + i) % 2 ? Qt::blue : Qt::red);
+        }
+    });
+}
+
+void GenericCompositingBenchmark::benchmarkSubsurfaceTree_data()
+{
+    QTest::addColumn<int>("breadth");
+    QTest::addColumn<int>("depth");
+
+    QTest::addRow("2x3") << 2 << 3;
+    QTest::addRow("3x3") << 3 << 3;
+    QTest::addRow("4x3") << 4 << 3;
+}
+
+void GenericCompositingBenchmark::benchmarkSubsurfaceTree()
+{
+    // This benchmark measures a window with a tree of synchronized subsurfaces, all of which
+    // are updated every frame.
+    QFETCH(int, breadth);
+    QFETCH(int, depth);
+
+    std::unique_ptr<KWayland::Client::Surface> rootSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(rootSurface.get()));
+    Window *window = Test::renderAndWaitForShown(rootSurface.get(), QSize(800, 600), Qt::blue);
+    QVERIFY(window);
+    trackCommits(window);
+
+    // The surfaces are stored parents first, so children are committed before their parents.
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<KWayland::Client::SubSurface>> subSurfaces;
+    std::vector<KWayland::Client::Surface *> parents{rootSurface.get()};
+    for (int level = 0; level < depth; ++level) {
+        std::vector<KWayland::Client::Surface *> children;
+        for (KWayland::Client::Surface *parent : parents) {
+            for (int i = 0; i < breadth; ++i) {
+                surfaces.emplace_back(Test::createSurface());
+                subSurfaces.emplace_back(Test::createSubSurface(surfaces.back().get(), parent));
+                QVERIFY(subSurfaces.back());
+                subSurfaces.back()->setPosition(QPoint(i * 40, 40));
+                Test::render(surfaces.back().get(), QSize(64, 64), Qt::green);
+                children.push_back(surfaces.back().get());
+            }
+        }
+        parents = children;
+    }
+
+    run([&rootSurface, &surfaces](int frame) {
+        const QColor color = frame % 2 ? Qt::green : Qt::yellow;
+        for (auto it = surfaces.rbegin(); it != surfaces.rend(); ++it) {
+            Test::render(it->get(), QSize(64, 64), color);
+        }
+        Test::render(rootSurface.get(), QSize(800, 600), frame % 2 ? Qt::blue : Qt::red);
+    });
+}
+
+void GenericCompositingBenchmark::benchmarkResizeStorm()
+{
+    // This benchmark measures a window whose size changes every frame.
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(400, 300), Qt::blue);
+    QVERIFY(window);
+    trackCommits(window);
+
+    run([&surface](int frame) {
+        const int step = frame % 10;
+        Test::render(surface.get(), QSize(400 + step * 60, 300 + step * 40), Qt::blue);
+    });
+}
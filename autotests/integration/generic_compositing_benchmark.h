@@ -0,0 +1,63 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+#include "kwin_wayland_test.h"
+
+#include <QObject>
+
+#include <chrono>
+#include <functional>
+
+namespace KWin
+{
+class RenderLoop;
+}
+
+/**
+ * The GenericCompositingBenchmark class drives synthetic Wayland clients on the virtual backend
+ * and measures how long the compositor takes to produce frames.
+ *
+ * Every scenario runs for a fixed number of presented frames, 120 by default, which can be
+ * changed with the KWIN_BENCHMARK_FRAMES environment variable. The mean compositing time per
+ * frame is reported as the benchmark result. If KWIN_BENCHMARK_REPORT points to a file, the
+ * complete measurements of every scenario are appended to it as a JSON object per line.
+ */
+class GenericCompositingBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    ~GenericCompositingBenchmark() override;
+
+protected:
+    GenericCompositingBenchmark(const QByteArray &envVariable, KWin::CompositingType compositingType);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void benchmarkManyWindows_data();
+    void benchmarkManyWindows();
+    void benchmarkRapidCommits_data();
+    void benchmarkRapidCommits();
+    void benchmarkSubsurfaceTree_data();
+    void benchmarkSubsurfaceTree();
+    void benchmarkResizeStorm();
+
+private:
+    void trackCommits(KWin::Window *window);
+    void run(const std::function<void(int)> &step);
+    void report(quint64 firstFrame, int frameCount);
+
+    QByteArray m_envVariable;
+    KWin::CompositingType m_compositingType;
+    KWin::RenderLoop *m_renderLoop = nullptr;
+    QVector<std::chrono::nanoseconds> m_commits;
+    QVector<QMetaObject::Connection> m_commitConnections;
+};
@@ -0,0 +1,140 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "cursor.h"
+#include "input.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_hittest_benchmark-0");
+
+class HitTestBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testFindToplevel();
+    void benchmarkPointerMotion_data();
+    void benchmarkPointerMotion();
+};
+
+void HitTestBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(int, 2));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+}
+
+void HitTestBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    workspace()->setActiveOutput(QPoint(640, 512));
+    Cursors::self()->mouse()->setPos(QPoint(640, 512));
+}
+
+void HitTestBenchmark::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void HitTestBenchmark::testFindToplevel()
+{
+    // This test verifies that the window under the pointer is found after windows move and restack.
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window1);
+
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(100, 50), Qt::red);
+    QVERIFY(window2);
+
+    window1->move(QPoint(0, 0));
+    window2->move(QPoint(1500, 100));
+    QCOMPARE(input()->findToplevel(QPoint(10, 10)), window1);
+    QCOMPARE(input()->findToplevel(QPoint(1510, 110)), window2);
+    QCOMPARE(input()->findToplevel(QPoint(700, 700)), nullptr);
+
+    // Overlapping windows, the topmost one has to be picked.
+    window2->move(QPoint(50, 0));
+    QCOMPARE(input()->findToplevel(QPoint(60, 10)), window2);
+    workspace()->raiseWindow(window1);
+    QCOMPARE(input()->findToplevel(QPoint(60, 10)), window1);
+
+    // Minimized windows don't get input.
+    window1->minimize();
+    QCOMPARE(input()->findToplevel(QPoint(60, 10)), window2);
+    QCOMPARE(input()->findToplevel(QPoint(10, 10)), nullptr);
+
+    shellSurface2.reset();
+    QVERIFY(Test::waitForWindowDestroyed(window2));
+    QCOMPARE(input()->findToplevel(QPoint(60, 10)), nullptr);
+}
+
+void HitTestBenchmark::benchmarkPointerMotion_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::addRow("1") << 1;
+    QTest::addRow("10") << 10;
+    QTest::addRow("100") << 100;
+    QTest::addRow("250") << 250;
+}
+
+void HitTestBenchmark::benchmarkPointerMotion()
+{
+    // This benchmark measures the cost of a pointer motion event depending on the number
+    // of windows spread across two outputs.
+    QFETCH(int, windowCount);
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+    for (int i = 0; i < windowCount; ++i) {
+        surfaces.emplace_back(Test::createSurface());
+        shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+        Window *window = Test::renderAndWaitForShown(surfaces.back().get(), QSize(100, 50), Qt::blue);
+        QVERIFY(window);
+        window->move(QPoint((i * 97) % 2460, (i * 61) % 974));
+    }
+
+    quint32 timestamp = 1;
+    QBENCHMARK {
+        Test::pointerMotion(QPointF(400, 300), timestamp++);
+        Test::pointerMotion(QPointF(1700, 700), timestamp++);
+    }
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::HitTestBenchmark)
+#include "hittest_benchmark.moc"
@@ -0,0 +1,125 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "output.h"
+#include "platform.h"
+#include "scene.h"
+#include "surfaceitem.h"
+#include "wayland_server.h"
+#include "window.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_prepaint_benchmark-0");
+
+class PrePaintBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void benchmarkPrePaint_data();
+    void benchmarkPrePaint();
+};
+
+void PrePaintBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects, only the cost of the scene is of interest
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QVERIFY(Compositor::self());
+}
+
+void PrePaintBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void PrePaintBenchmark::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void PrePaintBenchmark::benchmarkPrePaint_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::addRow("1") << 1;
+    QTest::addRow("10") << 10;
+    QTest::addRow("100") << 100;
+    QTest::addRow("250") << 250;
+}
+
+void PrePaintBenchmark::benchmarkPrePaint()
+{
+    // This benchmark measures the cost of preparing a frame in which only one of many
+    // windows has been damaged.
+    QFETCH(int, windowCount);
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+    Window *lastWindow = nullptr;
+    for (int i = 0; i < windowCount; ++i) {
+        surfaces.emplace_back(Test::createSurface());
+        shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+        lastWindow = Test::renderAndWaitForShown(surfaces.back().get(), QSize(100, 50), Qt::blue);
+        QVERIFY(lastWindow);
+    }
+
+    Scene *scene = Compositor::self()->scene();
+    Output *output = kwinApp()->platform()->enabledOutputs().constFirst();
+    SurfaceItem *surfaceItem = lastWindow->surfaceItem();
+    QVERIFY(surfaceItem);
+
+    // Flush the repaints that have been scheduled while the windows were mapped.
+    scene->prePaint(output);
+    scene->postPaint();
+
+    QBENCHMARK {
+        surfaceItem->scheduleRepaint(QRect(0, 0, 10, 10));
+        scene->prePaint(output);
+        scene->postPaint();
+    }
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::PrePaintBenchmark)
+#include "prepaint_benchmark.moc"
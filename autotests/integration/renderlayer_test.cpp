@@ -0,0 +1,141 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "renderlayer.h"
+#include "renderlayerdelegate.h"
+#include "renderloop.h"
+#include "utils/rectregion.h"
+#include "wayland_server.h"
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_renderlayer-0");
+
+class TestDelegate : public RenderLayerDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit TestDelegate(bool opaque)
+        : m_opaque(opaque)
+    {
+    }
+
+    QRegion opaque() const override
+    {
+        return m_opaque ? layer()->rect() : QRegion();
+    }
+
+    void paint(RenderTarget *renderTarget, const QRegion &region) override
+    {
+        Q_UNUSED(renderTarget)
+        Q_UNUSED(region)
+    }
+
+private:
+    bool m_opaque;
+};
+
+class RenderLayerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testOpaqueCulling_data();
+    void testOpaqueCulling();
+    void testLayerAboveOpaque();
+};
+
+void RenderLayerTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+static RenderLayer *createLayer(RenderLoop *loop, RenderLayer *superlayer, const QRect &geometry, bool opaque)
+{
+    auto layer = new RenderLayer(loop, superlayer);
+    layer->setDelegate(new TestDelegate(opaque));
+    layer->setGeometry(geometry);
+    return layer;
+}
+
+void RenderLayerTest::testOpaqueCulling_data()
+{
+    QTest::addColumn<bool>("opaque");
+    QTest::addColumn<bool>("visible");
+    QTest::addColumn<QRect>("repaint");
+    QTest::addColumn<QRegion>("expected");
+
+    QTest::newRow("hidden") << true << true << QRect(150, 150, 50, 50) << QRegion();
+    QTest::newRow("partially hidden") << true << true << QRect(50, 50, 100, 100)
+                                      << QRegion(QRect(50, 50, 100, 100)).subtracted(QRect(100, 100, 200, 200));
+    QTest::newRow("not covered") << true << true << QRect(400, 400, 50, 50) << QRegion(400, 400, 50, 50);
+    QTest::newRow("translucent") << false << true << QRect(150, 150, 50, 50) << QRegion(150, 150, 50, 50);
+    QTest::newRow("invisible") << true << false << QRect(150, 150, 50, 50) << QRegion(150, 150, 50, 50);
+}
+
+void RenderLayerTest::testOpaqueCulling()
+{
+    // This test verifies that the repaints of a layer that are hidden behind an opaque
+    // layer above it are skipped.
+
+    QFETCH(bool, opaque);
+    QFETCH(bool, visible);
+
+    RenderLoop loop;
+    QScopedPointer<RenderLayer> root(createLayer(&loop, nullptr, QRect(0, 0, 1000, 1000), true));
+    QScopedPointer<RenderLayer> cover(createLayer(&loop, root.data(), QRect(100, 100, 200, 200), opaque));
+    cover->setVisible(visible);
+
+    // Discard the repaints scheduled when the layers were set up.
+    root->takeRepaints();
+
+    QFETCH(QRect, repaint);
+    root->addRepaint(repaint);
+    QTEST(root->takeRepaints().toQRegion(), "expected");
+    QVERIFY(root->repaints().isEmpty());
+
+    // The repaints of the opaque layer itself are never skipped.
+    cover->addRepaint(QRect(0, 0, 50, 50));
+    QCOMPARE(root->takeRepaints().toQRegion(), visible ? QRegion(100, 100, 50, 50) : QRegion());
+}
+
+void RenderLayerTest::testLayerAboveOpaque()
+{
+    // This test verifies that an opaque layer only hides the layers below it.
+
+    RenderLoop loop;
+    QScopedPointer<RenderLayer> root(createLayer(&loop, nullptr, QRect(0, 0, 1000, 1000), true));
+    QScopedPointer<RenderLayer> below(createLayer(&loop, root.data(), QRect(100, 100, 200, 200), false));
+    QScopedPointer<RenderLayer> cover(createLayer(&loop, root.data(), QRect(150, 150, 200, 200), true));
+    QScopedPointer<RenderLayer> above(createLayer(&loop, root.data(), QRect(200, 200, 200, 200), false));
+    root->takeRepaints();
+
+    below->addRepaintFull();
+    above->addRepaintFull();
+    const QRegion expected = QRegion(100, 100, 200, 200).subtracted(QRect(150, 150, 200, 200)) + QRegion(200, 200, 200, 200);
+    QCOMPARE(root->takeRepaints().toQRegion(), expected);
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::RenderLayerTest)
+#include "renderlayer_test.moc"
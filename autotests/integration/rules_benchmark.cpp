@@ -0,0 +1,196 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "platform.h"
+#include "rules.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_rules_benchmark-0");
+
+class RuleBookBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testFind();
+    void benchmarkFind_data();
+    void benchmarkFind();
+
+private:
+    void writeRules(int count);
+    Window *createWindow();
+
+    KSharedConfig::Ptr m_config;
+    QScopedPointer<KWayland::Client::Surface> m_surface;
+    QScopedPointer<Test::XdgToplevel> m_shellSurface;
+    Window *m_window = nullptr;
+};
+
+void RuleBookBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+
+    m_config = KSharedConfig::openConfig(QStringLiteral("kwinrulesrc"), KConfig::SimpleConfig);
+    RuleBook::self()->setConfig(m_config);
+}
+
+void RuleBookBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void RuleBookBenchmark::cleanup()
+{
+    if (m_shellSurface) {
+        m_shellSurface.reset();
+        m_surface.reset();
+        QVERIFY(Test::waitForWindowDestroyed(m_window));
+    }
+    Test::destroyWaylandConnection();
+
+    // Wipe the window rule config clean.
+    for (const QString &group : m_config->groupList()) {
+        m_config->deleteGroup(group);
+    }
+    workspace()->slotReconfigure();
+}
+
+void RuleBookBenchmark::writeRules(int count)
+{
+    // Most rules match the window class exactly, the others use a substring or a regular
+    // expression, which is roughly what a large user configuration looks like.
+    m_config->group("General").writeEntry("count", count);
+    for (int i = 1; i <= count; ++i) {
+        KConfigGroup group = m_config->group(QString::number(i));
+        if (i % 25 == 0) {
+            group.writeEntry("wmclass", QStringLiteral("^org\\.kde\\.app%1(-.*)?$").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::RegExpMatch));
+        } else if (i % 10 == 0) {
+            group.writeEntry("title", QStringLiteral("Document %1").arg(i));
+            group.writeEntry("titlematch", int(Rules::SubstringMatch));
+        } else {
+            group.writeEntry("wmclass", QStringLiteral("org.kde.app%1").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+        }
+        group.writeEntry("wmclasscomplete", false);
+        group.writeEntry("above", true);
+        group.writeEntry("aboverule", int(Rules::Force));
+    }
+    m_config->sync();
+
+    workspace()->slotReconfigure();
+}
+
+Window *RuleBookBenchmark::createWindow()
+{
+    m_surface.reset(Test::createSurface());
+    m_shellSurface.reset(Test::createXdgToplevelSurface(m_surface.data(), Test::CreationSetup::CreateOnly, m_surface.data()));
+    QSignalSpy surfaceConfigureRequestedSpy(m_shellSurface->xdgSurface(), &Test::XdgSurface::configureRequested);
+
+    m_shellSurface->set_app_id(QStringLiteral("org.kde.foo"));
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    if (!surfaceConfigureRequestedSpy.wait()) {
+        return nullptr;
+    }
+
+    m_shellSurface->xdgSurface()->ack_configure(surfaceConfigureRequestedSpy.last().at(0).value<quint32>());
+    m_window = Test::renderAndWaitForShown(m_surface.data(), QSize(100, 50), Qt::blue);
+    return m_window;
+}
+
+void RuleBookBenchmark::testFind()
+{
+    // This test verifies that rules are still evaluated in the order of priority when only
+    // some of them are matched exactly by the window class.
+    m_config->group("General").writeEntry("count", 4);
+
+    KConfigGroup group = m_config->group("1");
+    group.writeEntry("wmclass", "org.kde.bar");
+    group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+    group.writeEntry("position", QPoint(10, 10));
+    group.writeEntry("positionrule", int(Rules::Force));
+
+    group = m_config->group("2");
+    group.writeEntry("wmclass", "^org\\.kde\\.f.*$");
+    group.writeEntry("wmclassmatch", int(Rules::RegExpMatch));
+    group.writeEntry("position", QPoint(42, 42));
+    group.writeEntry("positionrule", int(Rules::Force));
+
+    group = m_config->group("3");
+    group.writeEntry("wmclass", "org.kde.foo");
+    group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+    group.writeEntry("position", QPoint(100, 100));
+    group.writeEntry("positionrule", int(Rules::Force));
+    group.writeEntry("above", true);
+    group.writeEntry("aboverule", int(Rules::Force));
+
+    group = m_config->group("4");
+    group.writeEntry("wmclass", "foo");
+    group.writeEntry("wmclassmatch", int(Rules::SubstringMatch));
+    group.writeEntry("skiptaskbar", true);
+    group.writeEntry("skiptaskbarrule", int(Rules::Force));
+    m_config->sync();
+    workspace()->slotReconfigure();
+
+    Window *window = createWindow();
+    QVERIFY(window);
+
+    // The regular expression rule has a higher priority than the exact match.
+    QCOMPARE(window->pos(), QPoint(42, 42));
+    QVERIFY(window->keepAbove());
+    QVERIFY(window->skipTaskbar());
+}
+
+void RuleBookBenchmark::benchmarkFind_data()
+{
+    QTest::addColumn<int>("ruleCount");
+
+    QTest::addRow("10") << 10;
+    QTest::addRow("100") << 100;
+    QTest::addRow("1000") << 1000;
+}
+
+void RuleBookBenchmark::benchmarkFind()
+{
+    QFETCH(int, ruleCount);
+    writeRules(ruleCount);
+
+    Window *window = createWindow();
+    QVERIFY(window);
+
+    QBENCHMARK {
+        RuleBook::self()->find(window, false);
+    }
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::RuleBookBenchmark)
+#include "rules_benchmark.moc"
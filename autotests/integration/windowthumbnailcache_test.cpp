@@ -0,0 +1,239 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "renderbackend.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "windowthumbnailcache.h"
+#include "workspace.h"
+
+#include <kwingltexture.h>
+
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_windowthumbnailcache-0");
+
+class WindowThumbnailCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testBucket_data();
+    void testBucket();
+    void testReuseReleased();
+    void testEviction();
+    void testWindowDestroyed();
+};
+
+void WindowThumbnailCacheTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+    QVERIFY(WindowThumbnailCache::self());
+}
+
+void WindowThumbnailCacheTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowThumbnailCacheTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+
+    // Drop the unused thumbnails left behind by the test.
+    WindowThumbnailCache *cache = WindowThumbnailCache::self();
+    const qint64 budget = cache->memoryBudget();
+    cache->setMemoryBudget(0);
+    cache->setMemoryBudget(budget);
+    QCOMPARE(cache->memoryUsage(), 0);
+}
+
+void WindowThumbnailCacheTest::testBucket_data()
+{
+    QTest::addColumn<QSize>("requestedSize");
+    QTest::addColumn<QSize>("textureSize");
+
+    QTest::newRow("full size") << QSize(400, 200) << QSize(400, 200);
+    QTest::newRow("slightly smaller") << QSize(300, 150) << QSize(400, 200);
+    QTest::newRow("half size") << QSize(200, 100) << QSize(200, 100);
+    QTest::newRow("between buckets") << QSize(150, 75) << QSize(200, 100);
+    QTest::newRow("quarter size") << QSize(100, 50) << QSize(100, 50);
+    QTest::newRow("larger than window") << QSize(800, 400) << QSize(400, 200);
+}
+
+void WindowThumbnailCacheTest::testBucket()
+{
+    // This test verifies that a thumbnail is rendered in the smallest bucket that is at
+    // least as large as the requested size.
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Window *window = Test::renderAndWaitForShown(surface.data(), QSize(400, 200), Qt::blue);
+    QVERIFY(window);
+
+    QFETCH(QSize, requestedSize);
+    const QSharedPointer<WindowThumbnail> thumbnail = WindowThumbnailCache::self()->thumbnail(window, requestedSize, 1);
+    QVERIFY(thumbnail);
+    QCOMPARE(thumbnail->window(), window);
+    QVERIFY(!thumbnail->texture());
+
+    QSignalSpy updatedSpy(thumbnail.data(), &WindowThumbnail::updated);
+    QVERIFY(updatedSpy.wait());
+    QVERIFY(thumbnail->texture());
+    QTEST(thumbnail->texture()->size(), "textureSize");
+
+    // Consumers that ask for a size in the same bucket share the thumbnail.
+    QFETCH(QSize, textureSize);
+    QCOMPARE(WindowThumbnailCache::self()->thumbnail(window, textureSize, 1), thumbnail);
+    QVERIFY(WindowThumbnailCache::self()->thumbnail(window, textureSize / 2, 1) != thumbnail);
+}
+
+void WindowThumbnailCacheTest::testReuseReleased()
+{
+    // This test verifies that a thumbnail that is no longer used is handed out again.
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Window *window = Test::renderAndWaitForShown(surface.data(), QSize(400, 200), Qt::blue);
+    QVERIFY(window);
+
+    WindowThumbnailCache *cache = WindowThumbnailCache::self();
+    QSharedPointer<WindowThumbnail> thumbnail = cache->thumbnail(window, QSize(200, 100), 1);
+    QSignalSpy updatedSpy(thumbnail.data(), &WindowThumbnail::updated);
+    QVERIFY(updatedSpy.wait());
+    const QSharedPointer<GLTexture> texture = thumbnail->texture();
+    QVERIFY(texture);
+    const qint64 memoryUsage = cache->memoryUsage();
+    QVERIFY(memoryUsage > 0);
+
+    // The released thumbnail keeps its texture.
+    const WindowThumbnail *released = thumbnail.data();
+    thumbnail.reset();
+    QCOMPARE(cache->memoryUsage(), memoryUsage);
+
+    thumbnail = cache->thumbnail(window, QSize(200, 100), 1);
+    QCOMPARE(thumbnail.data(), released);
+    QCOMPARE(thumbnail->texture(), texture);
+    QCOMPARE(cache->memoryUsage(), memoryUsage);
+}
+
+void WindowThumbnailCacheTest::testEviction()
+{
+    // This test verifies that unused thumbnails are evicted when they exceed the memory
+    // budget, but the thumbnails in use are not.
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Window *window = Test::renderAndWaitForShown(surface.data(), QSize(400, 200), Qt::blue);
+    QVERIFY(window);
+
+    WindowThumbnailCache *cache = WindowThumbnailCache::self();
+    QSharedPointer<WindowThumbnail> large = cache->thumbnail(window, QSize(400, 200), 1);
+    QSharedPointer<WindowThumbnail> small = cache->thumbnail(window, QSize(100, 50), 1);
+    QSignalSpy largeUpdatedSpy(large.data(), &WindowThumbnail::updated);
+    QSignalSpy smallUpdatedSpy(small.data(), &WindowThumbnail::updated);
+    QVERIFY(largeUpdatedSpy.wait());
+    QVERIFY(!smallUpdatedSpy.isEmpty() || smallUpdatedSpy.wait());
+
+    const qint64 largeUsage = qint64(400) * 200 * 4 * 4 / 3;
+    const qint64 smallUsage = qint64(100) * 50 * 4 * 4 / 3;
+    QCOMPARE(cache->memoryUsage(), largeUsage + smallUsage);
+
+    // Used thumbnails are not evicted.
+    const qint64 budget = cache->memoryBudget();
+    cache->setMemoryBudget(0);
+    QCOMPARE(cache->memoryUsage(), largeUsage + smallUsage);
+
+    // The unused thumbnail fits in the budget, so it is kept.
+    cache->setMemoryBudget(largeUsage);
+    small.reset();
+    QCOMPARE(cache->memoryUsage(), largeUsage + smallUsage);
+
+    // The least recently released thumbnail is evicted first.
+    large.reset();
+    QCOMPARE(cache->memoryUsage(), largeUsage);
+
+    cache->setMemoryBudget(0);
+    QCOMPARE(cache->memoryUsage(), 0);
+    cache->setMemoryBudget(budget);
+
+    // An evicted thumbnail has to be rendered again.
+    large = cache->thumbnail(window, QSize(400, 200), 1);
+    QVERIFY(!large->texture());
+}
+
+void WindowThumbnailCacheTest::testWindowDestroyed()
+{
+    // This test verifies that the thumbnails are detached from a window when it's destroyed.
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Window *window = Test::renderAndWaitForShown(surface.data(), QSize(400, 200), Qt::blue);
+    QVERIFY(window);
+
+    WindowThumbnailCache *cache = WindowThumbnailCache::self();
+    QSharedPointer<WindowThumbnail> used = cache->thumbnail(window, QSize(400, 200), 1);
+    QSignalSpy updatedSpy(used.data(), &WindowThumbnail::updated);
+    QVERIFY(updatedSpy.wait());
+
+    // Thumbnails that are requested again must not track the window more than once.
+    for (int i = 0; i < 3; ++i) {
+        cache->thumbnail(window, QSize(100, 50), 1).reset();
+    }
+
+    QSignalSpy destroyedSpy(window, &QObject::destroyed);
+    shellSurface.reset();
+    surface.reset();
+    QVERIFY(destroyedSpy.wait());
+
+    // The unused thumbnails are gone, the used one is only kept alive by its consumer.
+    QCOMPARE(used->window(), nullptr);
+    QVERIFY(used->texture());
+    QCOMPARE(cache->memoryUsage(), 0);
+    used.reset();
+    QCOMPARE(cache->memoryUsage(), 0);
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::WindowThumbnailCacheTest)
+#include "windowthumbnailcache_test.moc"
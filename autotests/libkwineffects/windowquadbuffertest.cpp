@@ -0,0 +1,527 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include <QMatrix4x4>
+#include <QTest>
+#include <QtMath>
+#include <kwineffects.h>
+
+#include "windowquadbuffer_p.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+Q_DECLARE_METATYPE(KWin::WindowQuadList)
+
+using namespace KWin;
+
+static const unsigned int s_glTriangles = 0x0004;
+static const unsigned int s_glQuads = 0x0007;
+
+// The implementation of WindowQuadList before WindowQuadBuffer was introduced, the benchmarks
+// compare against it.
+static WindowQuadList legacyMakeGrid(const WindowQuadList &quads, int maxQuadSize)
+{
+    if (quads.isEmpty()) {
+        return quads;
+    }
+
+    double left = quads.first().left();
+    double right = quads.first().right();
+    double top = quads.first().top();
+    double bottom = quads.first().bottom();
+
+    for (const WindowQuad &quad : quads) {
+        left = qMin(left, quad.left());
+        right = qMax(right, quad.right());
+        top = qMin(top, quad.top());
+        bottom = qMax(bottom, quad.bottom());
+    }
+
+    WindowQuadList ret;
+
+    for (const WindowQuad &quad : quads) {
+        const double quadLeft = quad.left();
+        const double quadRight = quad.right();
+        const double quadTop = quad.top();
+        const double quadBottom = quad.bottom();
+
+        if (quadLeft == quadRight || quadTop == quadBottom) {
+            ret.append(quad);
+            continue;
+        }
+
+        const double xBegin = left + qFloor((quadLeft - left) / maxQuadSize) * maxQuadSize;
+        const double yBegin = top + qFloor((quadTop - top) / maxQuadSize) * maxQuadSize;
+
+        for (double y = yBegin; y < quadBottom; y += maxQuadSize) {
+            const double y0 = qMax(y, quadTop);
+            const double y1 = qMin(quadBottom, y + maxQuadSize);
+
+            for (double x = xBegin; x < quadRight; x += maxQuadSize) {
+                const double x0 = qMax(x, quadLeft);
+                const double x1 = qMin(quadRight, x + maxQuadSize);
+
+                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
+            }
+        }
+    }
+
+    return ret;
+}
+
+static WindowQuadList legacyMakeRegularGrid(const WindowQuadList &quads, int xSubdivisions, int ySubdivisions)
+{
+    if (quads.isEmpty()) {
+        return quads;
+    }
+
+    double left = quads.first().left();
+    double right = quads.first().right();
+    double top = quads.first().top();
+    double bottom = quads.first().bottom();
+
+    for (const WindowQuad &quad : quads) {
+        left = qMin(left, quad.left());
+        right = qMax(right, quad.right());
+        top = qMin(top, quad.top());
+        bottom = qMax(bottom, quad.bottom());
+    }
+
+    const double xIncrement = (right - left) / xSubdivisions;
+    const double yIncrement = (bottom - top) / ySubdivisions;
+
+    WindowQuadList ret;
+
+    for (const WindowQuad &quad : quads) {
+        const double quadLeft = quad.left();
+        const double quadRight = quad.right();
+        const double quadTop = quad.top();
+        const double quadBottom = quad.bottom();
+
+        if (quadLeft == quadRight || quadTop == quadBottom) {
+            ret.append(quad);
+            continue;
+        }
+
+        const double xBegin = left + qFloor((quadLeft - left) / xIncrement) * xIncrement;
+        const double yBegin = top + qFloor((quadTop - top) / yIncrement) * yIncrement;
+
+        for (double y = yBegin; y < quadBottom; y += yIncrement) {
+            const double y0 = qMax(y, quadTop);
+            const double y1 = qMin(quadBottom, y + yIncrement);
+
+            for (double x = xBegin; x < quadRight; x += xIncrement) {
+                const double x0 = qMax(x, quadLeft);
+                const double x1 = qMin(quadRight, x + xIncrement);
+
+                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
+            }
+        }
+    }
+
+    return ret;
+}
+
+static void legacyMakeInterleavedArrays(const WindowQuadList &quads, unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &textureMatrix)
+{
+    const QVector2D coeff(textureMatrix(0, 0), textureMatrix(1, 1));
+    const QVector2D offset(textureMatrix(0, 3), textureMatrix(1, 3));
+
+    GLVertex2D *vertex = vertices;
+
+    for (const WindowQuad &quad : quads) {
+        alignas(16) GLVertex2D v[4];
+
+        for (int j = 0; j < 4; j++) {
+            const WindowVertex &wv = quad[j];
+
+            v[j].position = QVector2D(wv.x(), wv.y());
+            v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
+        }
+
+#if defined(__SSE2__)
+        if (!(intptr_t(vertex) & 0xf)) {
+            const __m128i *srcP = reinterpret_cast<const __m128i *>(&v);
+            __m128i *dstP = reinterpret_cast<__m128i *>(vertex);
+
+            if (type == s_glQuads) {
+                for (int j = 0; j < 4; j++) {
+                    _mm_stream_si128(&dstP[j], _mm_load_si128(&srcP[j]));
+                }
+                vertex += 4;
+            } else {
+                _mm_stream_si128(&dstP[0], _mm_load_si128(&srcP[1]));
+                _mm_stream_si128(&dstP[1], _mm_load_si128(&srcP[0]));
+                _mm_stream_si128(&dstP[2], _mm_load_si128(&srcP[3]));
+                _mm_stream_si128(&dstP[3], _mm_load_si128(&srcP[3]));
+                _mm_stream_si128(&dstP[4], _mm_load_si128(&srcP[2]));
+                _mm_stream_si128(&dstP[5], _mm_load_si128(&srcP[1]));
+                vertex += 6;
+            }
+            continue;
+        }
+#endif
+
+        if (type == s_glQuads) {
+            for (int j = 0; j < 4; j++) {
+                *(vertex++) = v[j];
+            }
+        } else {
+            *(vertex++) = v[1];
+            *(vertex++) = v[0];
+            *(vertex++) = v[3];
+            *(vertex++) = v[3];
+            *(vertex++) = v[2];
+            *(vertex++) = v[1];
+        }
+    }
+}
+
+class WindowQuadBufferTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testConversion();
+    void testBoundingRect();
+    void testMakeGrid_data();
+    void testMakeGrid();
+    void testMakeRegularGrid_data();
+    void testMakeRegularGrid();
+    void testClipped_data();
+    void testClipped();
+    void testMakeInterleavedArrays_data();
+    void testMakeInterleavedArrays();
+
+    void benchmarkMakeGrid_data();
+    void benchmarkMakeGrid();
+    void benchmarkMakeRegularGrid_data();
+    void benchmarkMakeRegularGrid();
+    void benchmarkMakeInterleavedArrays_data();
+    void benchmarkMakeInterleavedArrays();
+
+private:
+    WindowQuad makeQuad(const QRectF &rect, const QRectF &texture);
+    WindowQuadList makeWindow(const QSizeF &size);
+    void compareQuads(const WindowQuadList &actual, const WindowQuadList &expected);
+};
+
+WindowQuad WindowQuadBufferTest::makeQuad(const QRectF &r, const QRectF &t)
+{
+    WindowQuad quad;
+    quad[0] = WindowVertex(r.x(), r.y(), t.x(), t.y());
+    quad[1] = WindowVertex(r.x() + r.width(), r.y(), t.x() + t.width(), t.y());
+    quad[2] = WindowVertex(r.x() + r.width(), r.y() + r.height(), t.x() + t.width(), t.y() + t.height());
+    quad[3] = WindowVertex(r.x(), r.y() + r.height(), t.x(), t.y() + t.height());
+    return quad;
+}
+
+WindowQuadList WindowQuadBufferTest::makeWindow(const QSizeF &size)
+{
+    // A client area with a decoration around it, the decoration is taken from an atlas.
+    const QRectF client(4, 28, size.width() - 8, size.height() - 32);
+
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(0, 0, size.width(), 28), QRectF(0, 0, size.width(), 28)));
+    quads.append(makeQuad(QRectF(0, 28, 4, client.height()), QRectF(0, 28, 28, client.height())));
+    quads.append(makeQuad(QRectF(client.right(), 28, 4, client.height()), QRectF(28, 28, 28, client.height())));
+    quads.append(makeQuad(QRectF(0, client.bottom(), size.width(), 4), QRectF(0, 56, size.width(), 4)));
+    quads.append(makeQuad(client, QRectF(0, 0, 1, 1)));
+    return quads;
+}
+
+void WindowQuadBufferTest::compareQuads(const WindowQuadList &actual, const WindowQuadList &expected)
+{
+    QCOMPARE(actual.count(), expected.count());
+    for (int i = 0; i < actual.count(); ++i) {
+        for (int j = 0; j < 4; ++j) {
+            const WindowVertex &actualVertex = actual[i][j];
+            const WindowVertex &expectedVertex = expected[i][j];
+            // The buffer works with single precision
+            QVERIFY(qAbs(actualVertex.x() - expectedVertex.x()) < 1e-3);
+            QVERIFY(qAbs(actualVertex.y() - expectedVertex.y()) < 1e-3);
+            QVERIFY(qAbs(actualVertex.u() - expectedVertex.u()) < 1e-3);
+            QVERIFY(qAbs(actualVertex.v() - expectedVertex.v()) < 1e-3);
+        }
+    }
+}
+
+void WindowQuadBufferTest::testConversion()
+{
+    const WindowQuadList quads = makeWindow(QSizeF(200, 100));
+    const WindowQuadBuffer buffer(quads);
+    QCOMPARE(buffer.count(), 5);
+    QVERIFY(!buffer.isEmpty());
+    compareQuads(buffer.toWindowQuadList(), quads);
+
+    WindowQuadBuffer appended;
+    for (const WindowQuad &quad : quads) {
+        appended.append(quad);
+    }
+    compareQuads(appended.toWindowQuadList(), quads);
+
+    WindowQuadList actual;
+    actual.append(appended.at(4));
+    WindowQuadList expected;
+    expected.append(quads.at(4));
+    compareQuads(actual, expected);
+
+    appended.clear();
+    QVERIFY(appended.isEmpty());
+    QCOMPARE(appended.count(), 0);
+}
+
+void WindowQuadBufferTest::testBoundingRect()
+{
+    QCOMPARE(WindowQuadBuffer().boundingRect(), QRectF());
+    QCOMPARE(WindowQuadBuffer(makeWindow(QSizeF(200, 100))).boundingRect(), QRectF(0, 0, 200, 100));
+}
+
+void WindowQuadBufferTest::testMakeGrid_data()
+{
+    QTest::addColumn<WindowQuadList>("quads");
+    QTest::addColumn<int>("quadSize");
+
+    QTest::newRow("empty") << WindowQuadList() << 10;
+    QTest::newRow("quadSizeTooLarge") << makeWindow(QSizeF(20, 40)) << 100;
+    QTest::newRow("window") << makeWindow(QSizeF(200, 100)) << 40;
+    QTest::newRow("unaligned") << makeWindow(QSizeF(203.5, 97.25)) << 7;
+
+    WindowQuadList degenerate;
+    degenerate.append(makeQuad(QRectF(0, 0, 10, 10), QRectF(0, 0, 10, 10)));
+    degenerate.append(makeQuad(QRectF(5, 5, 0, 10), QRectF(0, 0, 10, 10)));
+    QTest::newRow("degenerate") << degenerate << 3;
+}
+
+void WindowQuadBufferTest::testMakeGrid()
+{
+    QFETCH(WindowQuadList, quads);
+    QFETCH(int, quadSize);
+
+    const WindowQuadList expected = legacyMakeGrid(quads, quadSize);
+    compareQuads(WindowQuadBuffer(quads).makeGrid(quadSize).toWindowQuadList(), expected);
+    compareQuads(quads.makeGrid(quadSize), expected);
+}
+
+void WindowQuadBufferTest::testMakeRegularGrid_data()
+{
+    QTest::addColumn<WindowQuadList>("quads");
+    QTest::addColumn<int>("xSubdivisions");
+    QTest::addColumn<int>("ySubdivisions");
+
+    QTest::newRow("empty") << WindowQuadList() << 2 << 2;
+    QTest::newRow("noSplit") << makeWindow(QSizeF(20, 40)) << 1 << 1;
+    QTest::newRow("window") << makeWindow(QSizeF(200, 100)) << 20 << 20;
+    QTest::newRow("unaligned") << makeWindow(QSizeF(203.5, 97.25)) << 3 << 7;
+}
+
+void WindowQuadBufferTest::testMakeRegularGrid()
+{
+    QFETCH(WindowQuadList, quads);
+    QFETCH(int, xSubdivisions);
+    QFETCH(int, ySubdivisions);
+
+    const WindowQuadList expected = legacyMakeRegularGrid(quads, xSubdivisions, ySubdivisions);
+    compareQuads(WindowQuadBuffer(quads).makeRegularGrid(xSubdivisions, ySubdivisions).toWindowQuadList(), expected);
+    compareQuads(quads.makeRegularGrid(xSubdivisions, ySubdivisions), expected);
+}
+
+void WindowQuadBufferTest::testClipped_data()
+{
+    QTest::addColumn<QRectF>("rect");
+    QTest::addColumn<WindowQuadList>("expected");
+
+    const WindowQuad quad = makeQuad(QRectF(10, 10, 100, 50), QRectF(0, 0, 1, 1));
+    WindowQuadList expected;
+
+    expected.append(quad);
+    QTest::newRow("inside") << QRectF(0, 0, 200, 200) << expected;
+
+    expected.clear();
+    QTest::newRow("outside") << QRectF(120, 0, 50, 50) << expected;
+    QTest::newRow("touching") << QRectF(110, 10, 50, 50) << expected;
+
+    expected.append(quad.makeSubQuad(10, 10, 60, 60));
+    QTest::newRow("left") << QRectF(0, 0, 60, 200) << expected;
+
+    expected.clear();
+    expected.append(quad.makeSubQuad(35, 20, 85, 45));
+    QTest::newRow("center") << QRectF(35, 20, 50, 25) << expected;
+}
+
+void WindowQuadBufferTest::testClipped()
+{
+    QFETCH(QRectF, rect);
+    QFETCH(WindowQuadList, expected);
+
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(10, 10, 100, 50), QRectF(0, 0, 1, 1)));
+    compareQuads(WindowQuadBuffer(quads).clipped(rect).toWindowQuadList(), expected);
+}
+
+void WindowQuadBufferTest::testMakeInterleavedArrays_data()
+{
+    QTest::addColumn<unsigned int>("type");
+    QTest::addColumn<int>("offset");
+
+    QTest::newRow("quads") << s_glQuads << 0;
+    QTest::newRow("triangles") << s_glTriangles << 0;
+    QTest::newRow("quads unaligned") << s_glQuads << 1;
+    QTest::newRow("triangles unaligned") << s_glTriangles << 1;
+}
+
+void WindowQuadBufferTest::testMakeInterleavedArrays()
+{
+    QFETCH(unsigned int, type);
+    QFETCH(int, offset);
+
+    // An odd number of quads, so the kernels have to deal with a remainder.
+    WindowQuadList quads = makeWindow(QSizeF(203.5, 97.25)).makeGrid(7);
+    if (quads.count() % 2 == 0) {
+        quads.append(makeQuad(QRectF(0, 0, 1, 1), QRectF(0, 0, 1, 1)));
+    }
+
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / 256, -1.0 / 128);
+    textureMatrix.translate(0, -128);
+
+    const int vertexCount = quads.count() * (type == s_glQuads ? 4 : 6);
+    QVector<GLVertex2D> expected(vertexCount);
+    legacyMakeInterleavedArrays(quads, type, expected.data(), textureMatrix);
+
+    // The offset misaligns the vertices by a float, which disables the streaming stores.
+    QVector<float> storage((vertexCount + 1) * 4);
+    GLVertex2D *vertices = reinterpret_cast<GLVertex2D *>(storage.data() + offset);
+
+    const auto verify = [&]() {
+        for (int i = 0; i < vertexCount; ++i) {
+            QCOMPARE(vertices[i].position, expected[i].position);
+            QCOMPARE(vertices[i].texcoord, expected[i].texcoord);
+        }
+    };
+
+    quads.makeInterleavedArrays(type, vertices, textureMatrix);
+    verify();
+
+    std::fill(storage.begin(), storage.end(), 0);
+    WindowQuadBuffer(quads).makeInterleavedArrays(type, vertices, textureMatrix);
+    verify();
+}
+
+void WindowQuadBufferTest::benchmarkMakeGrid_data()
+{
+    QTest::addColumn<int>("implementation");
+
+    QTest::newRow("legacy") << 0;
+    QTest::newRow("list") << 1;
+    QTest::newRow("buffer") << 2;
+}
+
+void WindowQuadBufferTest::benchmarkMakeGrid()
+{
+    QFETCH(int, implementation);
+
+    // Magic lamp splits a maximized window in cells of 40 by 40.
+    const WindowQuadList quads = makeWindow(QSizeF(1920, 1080));
+    const WindowQuadBuffer buffer(quads);
+    int count = 0;
+
+    switch (implementation) {
+    case 0:
+        QBENCHMARK {
+            count = legacyMakeGrid(quads, 40).count();
+        }
+        break;
+    case 1:
+        QBENCHMARK {
+            count = quads.makeGrid(40).count();
+        }
+        break;
+    case 2:
+        QBENCHMARK {
+            count = buffer.makeGrid(40).count();
+        }
+        break;
+    }
+
+    QVERIFY(count > 0);
+}
+
+void WindowQuadBufferTest::benchmarkMakeRegularGrid_data()
+{
+    benchmarkMakeGrid_data();
+}
+
+void WindowQuadBufferTest::benchmarkMakeRegularGrid()
+{
+    QFETCH(int, implementation);
+
+    // Wobbly windows uses a regular grid of 20 by 20 cells by default.
+    const WindowQuadList quads = makeWindow(QSizeF(1920, 1080));
+    const WindowQuadBuffer buffer(quads);
+    int count = 0;
+
+    switch (implementation) {
+    case 0:
+        QBENCHMARK {
+            count = legacyMakeRegularGrid(quads, 20, 20).count();
+        }
+        break;
+    case 1:
+        QBENCHMARK {
+            count = quads.makeRegularGrid(20, 20).count();
+        }
+        break;
+    case 2:
+        QBENCHMARK {
+            count = buffer.makeRegularGrid(20, 20).count();
+        }
+        break;
+    }
+
+    QVERIFY(count > 0);
+}
+
+void WindowQuadBufferTest::benchmarkMakeInterleavedArrays_data()
+{
+    benchmarkMakeGrid_data();
+}
+
+void WindowQuadBufferTest::benchmarkMakeInterleavedArrays()
+{
+    QFETCH(int, implementation);
+
+    const WindowQuadList quads = makeWindow(QSizeF(1920, 1080)).makeGrid(40);
+    const WindowQuadBuffer buffer(quads);
+    QVector<GLVertex2D> vertices(quads.count() * 6);
+
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / 1920, 1.0 / 1080);
+
+    switch (implementation) {
+    case 0:
+        QBENCHMARK {
+            legacyMakeInterleavedArrays(quads, s_glTriangles, vertices.data(), textureMatrix);
+        }
+        break;
+    case 1:
+        QBENCHMARK {
+            quads.makeInterleavedArrays(s_glTriangles, vertices.data(), textureMatrix);
+        }
+        break;
+    case 2:
+        QBENCHMARK {
+            buffer.makeInterleavedArrays(s_glTriangles, vertices.data(), textureMatrix);
+        }
+        break;
+    }
+}
+
+QTEST_MAIN(WindowQuadBufferTest)
+#include "windowquadbuffertest.moc"
@@ -0,0 +1,142 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include "effects/private/expolayout.h"
+
+#include <memory>
+#include <vector>
+
+class TestExpoLayout : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNaturalLayout_data();
+    void testNaturalLayout();
+
+    void benchmarkNaturalLayout_data();
+    void benchmarkNaturalLayout();
+};
+
+class Layout : public ExpoLayout
+{
+public:
+    using ExpoLayout::updatePolish;
+};
+
+struct Workspace
+{
+    Layout layout;
+    std::vector<std::unique_ptr<ExpoCell>> cells;
+};
+
+static void populate(Workspace *workspace, int cellCount, bool stacked, bool fillGaps)
+{
+    workspace->layout.setSize(QSizeF(1920, 1080));
+    workspace->layout.setFillGaps(fillGaps);
+
+    // Cells are spread over the screen the way windows usually are, or all of them have the
+    // same geometry, which is what maximized windows look like.
+    QRandomGenerator generator(7);
+    for (int i = 0; i < cellCount; ++i) {
+        auto cell = std::make_unique<ExpoCell>();
+        if (stacked) {
+            cell->setNaturalX(0);
+            cell->setNaturalY(0);
+            cell->setNaturalWidth(1920);
+            cell->setNaturalHeight(1080);
+        } else {
+            cell->setNaturalX(generator.bounded(1600));
+            cell->setNaturalY(generator.bounded(800));
+            cell->setNaturalWidth(generator.bounded(200, 1000));
+            cell->setNaturalHeight(generator.bounded(150, 700));
+        }
+        cell->setPersistentKey(QString::number(i));
+        cell->setLayout(&workspace->layout);
+        workspace->cells.push_back(std::move(cell));
+    }
+}
+
+void TestExpoLayout::testNaturalLayout_data()
+{
+    QTest::addColumn<int>("cellCount");
+    QTest::addColumn<bool>("stacked");
+    QTest::addColumn<bool>("fillGaps");
+
+    QTest::addRow("10") << 10 << false << false;
+    QTest::addRow("100") << 100 << false << false;
+    QTest::addRow("10 stacked") << 10 << true << false;
+    QTest::addRow("10 fill gaps") << 10 << false << true;
+    QTest::addRow("100 fill gaps") << 100 << false << true;
+
+    // Cells with identical geometry start with their centers on top of each other, which is
+    // the worst case for the push iteration. Large counts may hit the iteration cap.
+    QTest::addRow("2 stacked") << 2 << true << false;
+    QTest::addRow("100 stacked") << 100 << true << false;
+    QTest::addRow("500 stacked") << 500 << true << false;
+    QTest::addRow("500 stacked fill gaps") << 500 << true << true;
+}
+
+void TestExpoLayout::testNaturalLayout()
+{
+    // This test verifies that the cells don't overlap and fit in the layout. The cells can
+    // touch due to rounding when they are scaled down a lot.
+    QFETCH(int, cellCount);
+    QFETCH(bool, stacked);
+    QFETCH(bool, fillGaps);
+
+    Workspace workspace;
+    populate(&workspace, cellCount, stacked, fillGaps);
+    workspace.layout.updatePolish();
+
+    const QRect area(0, 0, 1920, 1080);
+    for (size_t i = 0; i < workspace.cells.size(); ++i) {
+        const ExpoCell *cell = workspace.cells[i].get();
+        const QRect rect = QRect(cell->x(), cell->y(), cell->width(), cell->height()).adjusted(1, 1, -1, -1);
+        QVERIFY(!rect.isEmpty());
+        QVERIFY(area.adjusted(-1, -1, 1, 1).contains(rect));
+        for (size_t j = i + 1; j < workspace.cells.size(); ++j) {
+            const ExpoCell *other = workspace.cells[j].get();
+            QVERIFY(!rect.intersects(QRect(other->x(), other->y(), other->width(), other->height())));
+        }
+    }
+}
+
+void TestExpoLayout::benchmarkNaturalLayout_data()
+{
+    QTest::addColumn<int>("cellCount");
+    QTest::addColumn<bool>("stacked");
+    QTest::addColumn<bool>("fillGaps");
+
+    for (int cellCount : {10, 50, 100, 250, 500}) {
+        QTest::addRow("%d", cellCount) << cellCount << false << false;
+        QTest::addRow("%d stacked", cellCount) << cellCount << true << false;
+        QTest::addRow("%d fill gaps", cellCount) << cellCount << false << true;
+    }
+}
+
+void TestExpoLayout::benchmarkNaturalLayout()
+{
+    QFETCH(int, cellCount);
+    QFETCH(bool, stacked);
+    QFETCH(bool, fillGaps);
+
+    Workspace workspace;
+    populate(&workspace, cellCount, stacked, fillGaps);
+
+    QBENCHMARK {
+        workspace.layout.updatePolish();
+    }
+}
+
+QTEST_MAIN(TestExpoLayout)
+#include "test_expolayout.moc"
@@ -0,0 +1,119 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QJsonObject>
+#include <QTest>
+
+#include "frametimeline.h"
+
+#include <memory>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestFrameTimeline : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testAppend();
+    void testWrapAround();
+    void testGpuRenderTime();
+    void testTraceEvents();
+};
+
+static FrameTimelineEntry makeFrame(quint64 frame)
+{
+    FrameTimelineEntry entry;
+    entry.frame = frame;
+    entry.startTimestamp = std::chrono::milliseconds(frame * 16);
+    entry.renderStartTimestamp = entry.startTimestamp + 1ms;
+    entry.renderEndTimestamp = entry.startTimestamp + 3ms;
+    entry.submitTimestamp = entry.startTimestamp + 4ms;
+    entry.presentationTimestamp = entry.startTimestamp + 10ms;
+    return entry;
+}
+
+void TestFrameTimeline::testAppend()
+{
+    auto timeline = std::make_unique<FrameTimeline>();
+    QVERIFY(timeline->entries().isEmpty());
+
+    timeline->append(makeFrame(1));
+    timeline->append(makeFrame(2));
+
+    const QVector<FrameTimelineEntry> entries = timeline->entries();
+    QCOMPARE(entries.count(), 2);
+    QCOMPARE(entries[0].frame, quint64(1));
+    QCOMPARE(entries[1].frame, quint64(2));
+    QCOMPARE(entries[1].presentationTimestamp, std::chrono::nanoseconds(42ms));
+}
+
+void TestFrameTimeline::testWrapAround()
+{
+    // This test verifies that only the most recent frames are kept once the timeline is full.
+    auto timeline = std::make_unique<FrameTimeline>();
+    const int frameCount = FrameTimeline::capacity + 10;
+    for (int i = 1; i <= frameCount; ++i) {
+        timeline->append(makeFrame(i));
+    }
+
+    const QVector<FrameTimelineEntry> entries = timeline->entries();
+    QCOMPARE(entries.count(), FrameTimeline::capacity);
+    QCOMPARE(entries.constFirst().frame, quint64(11));
+    QCOMPARE(entries.constLast().frame, quint64(frameCount));
+}
+
+void TestFrameTimeline::testGpuRenderTime()
+{
+    auto timeline = std::make_unique<FrameTimeline>();
+    timeline->append(makeFrame(1));
+    timeline->append(makeFrame(2));
+
+    timeline->setGpuRenderTime(2, 2ms);
+    timeline->setGpuRenderTime(42, 5ms);
+
+    const QVector<FrameTimelineEntry> entries = timeline->entries();
+    QCOMPARE(entries.count(), 2);
+    QVERIFY(!entries[0].gpuRenderTime.has_value());
+    QCOMPARE(*entries[1].gpuRenderTime, std::chrono::nanoseconds(2ms));
+}
+
+void TestFrameTimeline::testTraceEvents()
+{
+    auto timeline = std::make_unique<FrameTimeline>();
+    FrameTimelineEntry frame = makeFrame(1);
+    frame.gpuRenderTime = 2ms;
+    frame.missedVblanks = 1;
+    frame.textureUploadSize = 4096;
+    timeline->append(frame);
+
+    const QJsonArray events = timeline->traceEvents(QStringLiteral("Virtual-0"), 1);
+
+    // Two track names, the frame, its four stages, the GPU work and the missed vblank.
+    QCOMPARE(events.count(), 9);
+    QCOMPARE(events[0].toObject()[QStringLiteral("ph")].toString(), QStringLiteral("M"));
+    QCOMPARE(events[1].toObject()[QStringLiteral("tid")].toInt(), 2);
+
+    const QJsonObject frameEvent = events[2].toObject();
+    QCOMPARE(frameEvent[QStringLiteral("ph")].toString(), QStringLiteral("X"));
+    QCOMPARE(frameEvent[QStringLiteral("ts")].toDouble(), 16000.0);
+    QCOMPARE(frameEvent[QStringLiteral("dur")].toDouble(), 10000.0);
+    QCOMPARE(frameEvent[QStringLiteral("args")].toObject()[QStringLiteral("textureUploadSize")].toDouble(), 4096.0);
+
+    const QJsonObject gpuEvent = events[7].toObject();
+    QCOMPARE(gpuEvent[QStringLiteral("name")].toString(), QStringLiteral("GPU"));
+    QCOMPARE(gpuEvent[QStringLiteral("tid")].toInt(), 2);
+    QCOMPARE(gpuEvent[QStringLiteral("dur")].toDouble(), 2000.0);
+
+    QCOMPARE(events[8].toObject()[QStringLiteral("ph")].toString(), QStringLiteral("i"));
+}
+
+QTEST_MAIN(TestFrameTimeline)
+#include "test_frametimeline.moc"
@@ -0,0 +1,181 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QPainter>
+#include <QTest>
+
+#include "scenes/qpainter/qpainterrasterizer.h"
+
+using namespace KWin;
+
+class TestQPainterRasterizer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testDrawImage_data();
+    void testDrawImage();
+    void testFillRect();
+    void testClip();
+
+    void benchmarkOpaqueWindows_data();
+    void benchmarkOpaqueWindows();
+};
+
+static QImage makeImage(const QSize &size, QImage::Format format, int seed)
+{
+    // The left half of the image is opaque, the rest is translucent unless the format has no alpha.
+    QImage image(size, format);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int alpha = format == QImage::Format_RGB32 || x < size.width() / 2 ? 255 : (x + y + seed) % 256;
+            line[x] = qPremultiply(qRgba((x * 7 + seed) % 256, (y * 3 + seed) % 256, (x + y) % 256, alpha));
+        }
+    }
+    return image;
+}
+
+static QImage makeBuffer()
+{
+    QImage buffer(500, 300, QImage::Format_RGB32);
+    buffer.fill(Qt::darkGray);
+    return buffer;
+}
+
+void TestQPainterRasterizer::testDrawImage_data()
+{
+    QTest::addColumn<QTransform>("transform");
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<qreal>("opacity");
+    QTest::addColumn<QRectF>("source");
+
+    const QRectF fullSource(0, 0, 200, 150);
+    QTest::addRow("opaque") << QTransform::fromTranslate(37, 21) << QImage::Format_RGB32 << 1.0 << fullSource;
+    QTest::addRow("translucent") << QTransform::fromTranslate(37, 21) << QImage::Format_ARGB32_Premultiplied << 1.0 << fullSource;
+    QTest::addRow("opacity") << QTransform::fromTranslate(37, 21) << QImage::Format_RGB32 << 0.5 << fullSource;
+    QTest::addRow("scaled") << QTransform::fromScale(1.5, 1.5) << QImage::Format_RGB32 << 1.0 << fullSource;
+    QTest::addRow("subrect") << QTransform::fromTranslate(200, 100) << QImage::Format_RGB32 << 1.0 << QRectF(10, 20, 200, 150);
+}
+
+void TestQPainterRasterizer::testDrawImage()
+{
+    // This test verifies that the rasterized tiles look the same as if the image was painted
+    // with a single QPainter.
+    QFETCH(QTransform, transform);
+    QFETCH(QImage::Format, format);
+    QFETCH(qreal, opacity);
+    QFETCH(QRectF, source);
+
+    const QImage image = makeImage(QSize(220, 180), format, 3);
+    const QRectF target(0, 0, 200, 150);
+    const QRegion clip(0, 0, 500, 300);
+
+    QImage expected = makeBuffer();
+    QPainter painter(&expected);
+    painter.setTransform(transform);
+    painter.setOpacity(opacity);
+    painter.drawImage(target, image, source);
+    painter.end();
+
+    QImage actual = makeBuffer();
+    QPainterRasterizer rasterizer(4);
+    rasterizer.begin(&actual);
+    rasterizer.drawImage(transform, clip, opacity, target, image, source, QRegion(0, 0, 100, 150));
+    rasterizer.end();
+
+    QCOMPARE(actual, expected);
+}
+
+void TestQPainterRasterizer::testFillRect()
+{
+    QImage expected = makeBuffer();
+    QPainter painter(&expected);
+    painter.fillRect(QRect(10, 10, 300, 200), Qt::black);
+    painter.fillRect(QRect(100, 50, 300, 200), QColor(255, 0, 0, 128));
+    painter.end();
+
+    QImage actual = makeBuffer();
+    QPainterRasterizer rasterizer(4);
+    rasterizer.begin(&actual);
+    rasterizer.fillRect(QTransform(), actual.rect(), QRect(10, 10, 300, 200), Qt::black);
+    rasterizer.fillRect(QTransform(), actual.rect(), QRect(100, 50, 300, 200), QColor(255, 0, 0, 128));
+    rasterizer.end();
+
+    QCOMPARE(actual, expected);
+}
+
+void TestQPainterRasterizer::testClip()
+{
+    // This test verifies that nothing is painted outside the clip region, and that the painting
+    // order is preserved when several images overlap.
+    const QImage bottom = makeImage(QSize(300, 200), QImage::Format_RGB32, 1);
+    const QImage top = makeImage(QSize(300, 200), QImage::Format_ARGB32_Premultiplied, 2);
+    const QRegion clip = QRegion(0, 0, 250, 300) + QRegion(300, 150, 200, 150);
+
+    QImage expected = makeBuffer();
+    QPainter painter(&expected);
+    painter.setClipRegion(clip);
+    painter.drawImage(QPointF(20, 20), bottom);
+    painter.drawImage(QPointF(150, 80), top);
+    painter.end();
+
+    QImage actual = makeBuffer();
+    QPainterRasterizer rasterizer(4);
+    rasterizer.begin(&actual);
+    rasterizer.drawImage(QTransform::fromTranslate(20, 20), clip, 1, bottom.rect(), bottom, bottom.rect());
+    rasterizer.drawImage(QTransform::fromTranslate(150, 80), clip, 1, top.rect(), top, top.rect(), QRegion(0, 0, 100, 100));
+    rasterizer.end();
+
+    QCOMPARE(actual, expected);
+}
+
+void TestQPainterRasterizer::benchmarkOpaqueWindows_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QTest::addRow("QPainter") << 0;
+    for (int threadCount : {1, 2, 4, 8}) {
+        QTest::addRow("%d threads", threadCount) << threadCount;
+    }
+}
+
+void TestQPainterRasterizer::benchmarkOpaqueWindows()
+{
+    QFETCH(int, threadCount);
+
+    QImage buffer(1920, 1080, QImage::Format_RGB32);
+    const QImage window = makeImage(QSize(1200, 800), QImage::Format_RGB32, 0);
+    const QPoint positions[] = {QPoint(0, 0), QPoint(400, 150), QPoint(720, 280)};
+
+    if (!threadCount) {
+        QBENCHMARK {
+            QPainter painter(&buffer);
+            painter.fillRect(buffer.rect(), Qt::black);
+            for (const QPoint &position : positions) {
+                painter.drawImage(position, window);
+            }
+        }
+        return;
+    }
+
+    QPainterRasterizer rasterizer(threadCount);
+    QBENCHMARK {
+        rasterizer.begin(&buffer);
+        rasterizer.fillRect(QTransform(), buffer.rect(), buffer.rect(), Qt::black);
+        for (const QPoint &position : positions) {
+            rasterizer.drawImage(QTransform::fromTranslate(position.x(), position.y()), buffer.rect(), 1,
+                                 window.rect(), window, window.rect());
+        }
+        rasterizer.end();
+    }
+}
+
+QTEST_MAIN(TestQPainterRasterizer)
+#include "test_qpainterrasterizer.moc"
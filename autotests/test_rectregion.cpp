@@ -0,0 +1,308 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include "utils/rectregion.h"
+
+using namespace KWin;
+
+class TestRectRegion : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testQRegionRoundTrip();
+    void testOperations_data();
+    void testOperations();
+    void testIntersectedRect();
+    void testIntersects();
+    void testTranslated();
+    void testMergeBands();
+
+    void benchmarkOcclusion_data();
+    void benchmarkOcclusion();
+    void benchmarkDamageUnion_data();
+    void benchmarkDamageUnion();
+    void benchmarkClip_data();
+    void benchmarkClip();
+};
+
+static QRegion toQRegion(const QVector<QRect> &rects)
+{
+    QRegion region;
+    for (const QRect &rect : rects) {
+        region += rect;
+    }
+    return region;
+}
+
+/**
+ * Returns @c true if both regions cover the same area, regardless of how they are split into rectangles.
+ */
+static bool sameArea(const QRegion &a, const QRegion &b)
+{
+    return (a ^ b).isEmpty();
+}
+
+static RectRegion toRectRegion(const QVector<QRect> &rects)
+{
+    RectRegion region;
+    for (const QRect &rect : rects) {
+        region |= rect;
+    }
+    return region;
+}
+
+static QVector<QRect> randomRects(QRandomGenerator *generator, int count)
+{
+    QVector<QRect> rects;
+    for (int i = 0; i < count; ++i) {
+        rects.append(QRect(generator->bounded(-50, 1000), generator->bounded(-50, 1000),
+                           generator->bounded(1, 400), generator->bounded(1, 400)));
+    }
+    return rects;
+}
+
+/**
+ * Returns a typical desktop layout: a panel and a number of overlapping windows.
+ */
+static QVector<QRect> desktopLayout(int windowCount)
+{
+    QVector<QRect> rects;
+    rects.append(QRect(0, 1040, 1920, 40));
+    for (int i = 0; i < windowCount; ++i) {
+        rects.append(QRect(40 + (i * 97) % 1100, 30 + (i * 61) % 500, 640 + (i * 37) % 200, 480 + (i * 23) % 150));
+    }
+    return rects;
+}
+
+void TestRectRegion::testEmpty()
+{
+    RectRegion region;
+    QVERIFY(region.isEmpty());
+    QCOMPARE(region.rectCount(), 0);
+    QCOMPARE(region.boundingRect(), QRect());
+    QVERIFY(region.toQRegion().isEmpty());
+
+    QVERIFY(RectRegion(QRect()).isEmpty());
+    QVERIFY(RectRegion(QRect(10, 10, 0, 10)).isEmpty());
+    QVERIFY(RectRegion(QRegion()).isEmpty());
+    QVERIFY((RectRegion(QRect(0, 0, 10, 10)) - RectRegion(QRect(0, 0, 10, 10))).isEmpty());
+    QVERIFY((RectRegion(QRect(0, 0, 10, 10)) & RectRegion(QRect(10, 0, 10, 10))).isEmpty());
+}
+
+void TestRectRegion::testQRegionRoundTrip()
+{
+    QRandomGenerator generator(1);
+    for (int i = 0; i < 100; ++i) {
+        const QRegion region = toQRegion(randomRects(&generator, 10));
+        const RectRegion rectRegion(region);
+        QVERIFY(sameArea(rectRegion.toQRegion(), region));
+        QCOMPARE(rectRegion.boundingRect(), region.boundingRect());
+    }
+}
+
+void TestRectRegion::testOperations_data()
+{
+    QTest::addColumn<int>("seed");
+
+    for (int seed = 0; seed < 20; ++seed) {
+        QTest::addRow("%d", seed) << seed;
+    }
+}
+
+void TestRectRegion::testOperations()
+{
+    // The result of every operation must be the same as the one computed by QRegion.
+    QFETCH(int, seed);
+
+    QRandomGenerator generator(seed);
+    for (int i = 0; i < 50; ++i) {
+        const QVector<QRect> a = randomRects(&generator, generator.bounded(1, 12));
+        const QVector<QRect> b = randomRects(&generator, generator.bounded(1, 12));
+
+        const QRegion qa = toQRegion(a);
+        const QRegion qb = toQRegion(b);
+        const RectRegion ra = toRectRegion(a);
+        const RectRegion rb = toRectRegion(b);
+
+        QVERIFY(sameArea(ra.toQRegion(), qa));
+        QVERIFY(sameArea((ra | rb).toQRegion(), qa | qb));
+        QVERIFY(sameArea((ra & rb).toQRegion(), qa & qb));
+        QVERIFY(sameArea((ra - rb).toQRegion(), qa - qb));
+        QVERIFY(sameArea((rb - ra).toQRegion(), qb - qa));
+
+        // Equal regions must have the same representation.
+        QCOMPARE(RectRegion(qa | qb), ra | rb);
+        QCOMPARE((ra - rb) | (ra & rb), ra);
+        QCOMPARE((ra | rb).boundingRect(), (qa | qb).boundingRect());
+    }
+}
+
+void TestRectRegion::testIntersectedRect()
+{
+    QRandomGenerator generator(2);
+    for (int i = 0; i < 200; ++i) {
+        const QVector<QRect> rects = randomRects(&generator, generator.bounded(1, 12));
+        const QRect clip = randomRects(&generator, 1).constFirst();
+
+        const RectRegion clipped = toRectRegion(rects).intersected(clip);
+        QVERIFY(sameArea(clipped.toQRegion(), toQRegion(rects) & clip));
+    }
+}
+
+void TestRectRegion::testIntersects()
+{
+    const RectRegion region = RectRegion(QRect(0, 0, 100, 100)) | RectRegion(QRect(200, 200, 100, 100));
+    QVERIFY(region.intersects(QRect(50, 50, 10, 10)));
+    QVERIFY(region.intersects(QRect(90, 90, 150, 150)));
+    QVERIFY(!region.intersects(QRect(100, 100, 100, 100)));
+    QVERIFY(!region.intersects(QRect(300, 0, 10, 10)));
+    QVERIFY(!region.intersects(QRect()));
+}
+
+void TestRectRegion::testTranslated()
+{
+    const QRegion region = QRegion(0, 0, 100, 100) | QRegion(50, 50, 100, 100);
+    QVERIFY(sameArea(RectRegion(region).translated(10, -20).toQRegion(), region.translated(10, -20)));
+    QCOMPARE(RectRegion(region).translated(QPoint(-5, 5)).boundingRect(), region.boundingRect().translated(-5, 5));
+}
+
+void TestRectRegion::testMergeBands()
+{
+    // Two rectangles stacked on top of each other with the same horizontal extents are merged.
+    const RectRegion region = RectRegion(QRect(0, 0, 100, 50)) | RectRegion(QRect(0, 50, 100, 50));
+    QCOMPARE(region.rectCount(), 1);
+    QCOMPARE(region.boundingRect(), QRect(0, 0, 100, 100));
+
+    // Clipping can make bands identical, they must be merged as well.
+    const RectRegion steps = RectRegion(QRect(0, 0, 100, 50)) | RectRegion(QRect(0, 50, 200, 50));
+    QCOMPARE(steps.rectCount(), 2);
+    QCOMPARE(steps.intersected(QRect(0, 0, 100, 100)).rectCount(), 1);
+}
+
+void TestRectRegion::benchmarkOcclusion_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<bool>("qregion");
+
+    for (int windowCount : {5, 20, 50}) {
+        QTest::addRow("QRegion, %d windows", windowCount) << windowCount << true;
+        QTest::addRow("RectRegion, %d windows", windowCount) << windowCount << false;
+    }
+}
+
+void TestRectRegion::benchmarkOcclusion()
+{
+    // Mimics the occlusion culling pass of the scene: every window is clipped by the visible
+    // region and then its opaque area is removed from the visible region.
+    QFETCH(int, windowCount);
+    QFETCH(bool, qregion);
+
+    const QVector<QRect> windows = desktopLayout(windowCount);
+    const QRect screen(0, 0, 1920, 1080);
+
+    if (qregion) {
+        QBENCHMARK {
+            QRegion visible = screen;
+            for (int i = windows.count() - 1; i >= 0; --i) {
+                const QRegion windowRegion = visible & windows[i];
+                visible -= windows[i].adjusted(4, 4, -4, -4);
+                Q_UNUSED(windowRegion)
+            }
+        }
+    } else {
+        QBENCHMARK {
+            RectRegion visible = screen;
+            for (int i = windows.count() - 1; i >= 0; --i) {
+                const RectRegion windowRegion = visible & windows[i];
+                visible -= windows[i].adjusted(4, 4, -4, -4);
+                Q_UNUSED(windowRegion)
+            }
+        }
+    }
+}
+
+void TestRectRegion::benchmarkDamageUnion_data()
+{
+    QTest::addColumn<int>("damageCount");
+    QTest::addColumn<bool>("qregion");
+
+    for (int damageCount : {2, 10, 50}) {
+        QTest::addRow("QRegion, %d damage rects", damageCount) << damageCount << true;
+        QTest::addRow("RectRegion, %d damage rects", damageCount) << damageCount << false;
+    }
+}
+
+void TestRectRegion::benchmarkDamageUnion()
+{
+    // Mimics the accumulation of damage from several surfaces and the damage journal.
+    QFETCH(int, damageCount);
+    QFETCH(bool, qregion);
+
+    QRandomGenerator generator(3);
+    QVector<QRect> damage;
+    for (int i = 0; i < damageCount; ++i) {
+        damage.append(QRect(generator.bounded(1800), generator.bounded(1000), generator.bounded(8, 120), generator.bounded(8, 80)));
+    }
+
+    if (qregion) {
+        QBENCHMARK {
+            QRegion region;
+            for (const QRect &rect : qAsConst(damage)) {
+                region += rect;
+            }
+        }
+    } else {
+        QBENCHMARK {
+            RectRegion region;
+            for (const QRect &rect : qAsConst(damage)) {
+                region |= rect;
+            }
+        }
+    }
+}
+
+void TestRectRegion::benchmarkClip_data()
+{
+    QTest::addColumn<bool>("qregion");
+
+    QTest::addRow("QRegion") << true;
+    QTest::addRow("RectRegion") << false;
+}
+
+void TestRectRegion::benchmarkClip()
+{
+    // Clips a fragmented region to a window rectangle.
+    QFETCH(bool, qregion);
+
+    const QVector<QRect> windows = desktopLayout(20);
+    const QRect clip(300, 200, 800, 600);
+
+    if (qregion) {
+        const QRegion region = toQRegion(windows);
+        QBENCHMARK {
+            const QRegion clipped = region & clip;
+            Q_UNUSED(clipped)
+        }
+    } else {
+        const RectRegion region = toRectRegion(windows);
+        QBENCHMARK {
+            const RectRegion clipped = region & clip;
+            Q_UNUSED(clipped)
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestRectRegion)
+
+#include "test_rectregion.moc"
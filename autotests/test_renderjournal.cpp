@@ -0,0 +1,80 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+
+#include "renderjournal.h"
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestRenderJournal : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testPercentile_data();
+    void testPercentile();
+    void testWindow();
+};
+
+void TestRenderJournal::testEmpty()
+{
+    RenderJournal journal;
+    QCOMPARE(journal.minimum(), std::chrono::nanoseconds::zero());
+    QCOMPARE(journal.maximum(), std::chrono::nanoseconds::zero());
+    QCOMPARE(journal.average(), std::chrono::nanoseconds::zero());
+    QCOMPARE(journal.percentile(95), std::chrono::nanoseconds::zero());
+}
+
+void TestRenderJournal::testPercentile_data()
+{
+    QTest::addColumn<int>("percentile");
+    QTest::addColumn<int>("expected");
+
+    QTest::addRow("50") << 50 << 50;
+    QTest::addRow("95") << 95 << 95;
+    QTest::addRow("99") << 99 << 99;
+    QTest::addRow("100") << 100 << 100;
+}
+
+void TestRenderJournal::testPercentile()
+{
+    // The render times are added in a shuffled order, from 1 ms to 100 ms.
+    QFETCH(int, percentile);
+    QFETCH(int, expected);
+
+    RenderJournal journal;
+    for (int i = 0; i < 100; ++i) {
+        journal.add(std::chrono::milliseconds((i * 37) % 100 + 1));
+    }
+
+    QCOMPARE(journal.percentile(percentile), std::chrono::nanoseconds(std::chrono::milliseconds(expected)));
+    QCOMPARE(journal.minimum(), std::chrono::nanoseconds(1ms));
+    QCOMPARE(journal.maximum(), std::chrono::nanoseconds(100ms));
+}
+
+void TestRenderJournal::testWindow()
+{
+    // This test verifies that old render times don't affect the estimate anymore.
+    RenderJournal journal;
+    for (int i = 0; i < 10; ++i) {
+        journal.add(20ms);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        journal.add(2ms);
+    }
+
+    QCOMPARE(journal.maximum(), std::chrono::nanoseconds(2ms));
+    QCOMPARE(journal.percentile(99), std::chrono::nanoseconds(2ms));
+}
+
+QTEST_MAIN(TestRenderJournal)
+#include "test_renderjournal.moc"
@@ -0,0 +1,113 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+
+#include "textureuploader.h"
+
+#include <vector>
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+using namespace KWin;
+
+class TestTextureUploader : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testUploadRects_data();
+    void testUploadRects();
+    void testPackRect_data();
+    void testPackRect();
+};
+
+void TestTextureUploader::testUploadRects_data()
+{
+    QTest::addColumn<QRegion>("region");
+    QTest::addColumn<QVector<QRect>>("expected");
+
+    QTest::newRow("single") << QRegion(10, 20, 30, 40) << QVector<QRect>{QRect(10, 20, 30, 40)};
+
+    // Rectangles that are far apart are uploaded separately.
+    QRegion apart;
+    apart += QRect(0, 0, 10, 10);
+    apart += QRect(100, 100, 10, 10);
+    QTest::newRow("apart") << apart << QVector<QRect>{QRect(0, 0, 10, 10), QRect(100, 100, 10, 10)};
+
+    // Rectangles that fill most of their bounding rect are merged.
+    QRegion close;
+    close += QRect(0, 0, 20, 10);
+    close += QRect(0, 10, 15, 10);
+    QTest::newRow("close") << close << QVector<QRect>{QRect(0, 0, 20, 20)};
+
+    // Too many rectangles are always merged.
+    QRegion many;
+    for (int i = 0; i < 17; ++i) {
+        many += QRect(i * 20, i * 20, 2, 2);
+    }
+    QTest::newRow("many") << many << QVector<QRect>{QRect(0, 0, 16 * 20 + 2, 16 * 20 + 2)};
+}
+
+void TestTextureUploader::testUploadRects()
+{
+    QFETCH(QRegion, region);
+    QTEST(TextureUploader::uploadRects(region), "expected");
+}
+
+void TestTextureUploader::testPackRect_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<int>("padding");
+    QTest::addColumn<QRect>("rect");
+
+    QTest::newRow("whole image") << QImage::Format_ARGB32_Premultiplied << 0 << QRect(0, 0, 13, 7);
+    QTest::newRow("sub rect") << QImage::Format_ARGB32_Premultiplied << 0 << QRect(3, 2, 5, 4);
+    QTest::newRow("single pixel") << QImage::Format_RGB32 << 0 << QRect(12, 6, 1, 1);
+    QTest::newRow("single row") << QImage::Format_RGB32 << 0 << QRect(1, 4, 11, 1);
+    QTest::newRow("padded whole image") << QImage::Format_RGB32 << 12 << QRect(0, 0, 13, 7);
+    QTest::newRow("padded sub rect") << QImage::Format_ARGB32_Premultiplied << 12 << QRect(4, 1, 9, 5);
+}
+
+void TestTextureUploader::testPackRect()
+{
+    // This test verifies that the rows of the damaged rect are tightly packed, no matter how
+    // the rows of the image are laid out.
+    QFETCH(QImage::Format, format);
+    QFETCH(int, padding);
+    QFETCH(QRect, rect);
+
+    const QSize size(13, 7);
+    const int bytesPerLine = size.width() * 4 + padding;
+    std::vector<uchar> storage(bytesPerLine * size.height(), 0xcd);
+    QImage image(storage.data(), size.width(), size.height(), bytesPerLine, format);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            image.setPixel(x, y, qRgba(x * 16, y * 32, x + y, 0xff));
+        }
+    }
+
+    // The canaries after the packed data must not be touched.
+    const int packedSize = rect.width() * rect.height() * 4;
+    std::vector<uint8_t> destination(packedSize + 16, 0xab);
+    QCOMPARE(TextureUploader::packRect(image, rect, destination.data()), qint64(packedSize));
+
+    const quint32 *pixels = reinterpret_cast<const quint32 *>(destination.data());
+    for (int y = 0; y < rect.height(); ++y) {
+        for (int x = 0; x < rect.width(); ++x) {
+            QCOMPARE(pixels[y * rect.width() + x], quint32(image.pixel(rect.x() + x, rect.y() + y)));
+        }
+    }
+    for (size_t i = packedSize; i < destination.size(); ++i) {
+        QCOMPARE(destination[i], uint8_t(0xab));
+    }
+}
+
+QTEST_MAIN(TestTextureUploader)
+#include "test_textureuploader.moc"
@@ -0,0 +1,160 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QDataStream>
+#include <QDir>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "backends/virtual/virtual_framerecorder.h"
+
+#include <cstring>
+#include <memory>
+
+using namespace KWin;
+
+class TestVirtualFrameRecorder : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testReplay_data();
+    void testReplay();
+};
+
+void TestVirtualFrameRecorder::testReplay_data()
+{
+    QTest::addColumn<int>("compressionLevel");
+
+    QTest::addRow("raw") << 0;
+    QTest::addRow("compressed") << 6;
+}
+
+void TestVirtualFrameRecorder::testReplay()
+{
+    // This test verifies that the recorded stream can be replayed, even if frames have been
+    // dropped, and that every frame carries its presentation timestamp.
+    QFETCH(int, compressionLevel);
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    const QString outputName = QStringLiteral("Virtual-0");
+    const QSize size(64, 48);
+    const int frameCount = 60;
+
+    QImage screen(size, QImage::Format_RGB32);
+    screen.fill(Qt::black);
+    auto grab = [&screen](const QRect &rect) {
+        return screen.copy(rect);
+    };
+
+    // The contents of the output after every frame, indexed by the sequence number.
+    QVector<QImage> snapshots;
+    const qint64 timestampBase = 1000000;
+    const qint64 refreshInterval = 16666667;
+
+    auto recorder = std::make_unique<VirtualFrameRecorder>(directory.path(), 1, compressionLevel);
+    for (int i = 0; i < frameCount; ++i) {
+        const QRect damage((i * 7) % size.width(), (i * 5) % size.height(), 5 + i % 13, 3 + i % 11);
+        QPainter painter(&screen);
+        painter.fillRect(damage, QColor::fromHsv((i * 37) % 360, 255, 255));
+        painter.end();
+        snapshots.append(screen.copy());
+
+        recorder->record(outputName, 1, size, damage, grab);
+        if (i % 3 == 1) {
+            // The queue can hold only one frame, if this frame is accepted, the next one is
+            // recorded before this one is presented and must be dropped.
+            continue;
+        }
+        recorder->presented(outputName, std::chrono::nanoseconds(timestampBase + i * refreshInterval));
+    }
+    const quint64 droppedFrameCount = recorder->droppedFrameCount();
+    QVERIFY(droppedFrameCount >= frameCount / 3);
+    recorder.reset();
+
+    QFile file(QDir(directory.path()).filePath(outputName + QStringLiteral(".kwinframes")));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.read(8), QByteArrayLiteral("KWINFRMS"));
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 version;
+    stream >> version;
+    QCOMPARE(version, 1u);
+
+    QImage replay(size, QImage::Format_RGB32);
+    replay.fill(Qt::black);
+    quint64 expectedSequence = 0;
+    quint64 streamDroppedFrameCount = 0;
+    int frameIndex = 0;
+    while (!stream.atEnd()) {
+        quint64 sequence;
+        qint64 timestamp;
+        quint32 droppedFrames, width, height, rectCount;
+        stream >> sequence >> timestamp >> droppedFrames >> width >> height >> rectCount;
+        QCOMPARE(stream.status(), QDataStream::Ok);
+
+        // Every frame accounts for the frames that have been dropped before it.
+        QCOMPARE(sequence, expectedSequence + droppedFrames);
+        expectedSequence = sequence + 1;
+        streamDroppedFrameCount += droppedFrames;
+        QCOMPARE(QSize(width, height), size);
+
+        QVector<QRect> rects;
+        for (quint32 i = 0; i < rectCount; ++i) {
+            qint32 x, y, w, h;
+            stream >> x >> y >> w >> h;
+            rects.append(QRect(x, y, w, h));
+        }
+        if (frameIndex == 0) {
+            QRegion region;
+            region.setRects(rects.constData(), rects.count());
+            QCOMPARE(region, QRegion(QRect(QPoint(0, 0), size)));
+        }
+
+        quint32 compression, pixelDataSize;
+        stream >> compression >> pixelDataSize;
+        QCOMPARE(compression, compressionLevel > 0 ? 1u : 0u);
+        QByteArray pixels(pixelDataSize, Qt::Uninitialized);
+        QCOMPARE(stream.readRawData(pixels.data(), pixels.size()), pixels.size());
+        if (compression) {
+            pixels = qUncompress(pixels);
+        }
+
+        const char *data = pixels.constData();
+        for (const QRect &rect : qAsConst(rects)) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                memcpy(replay.scanLine(y) + rect.x() * 4, data, rect.width() * 4);
+                data += rect.width() * 4;
+            }
+        }
+        QVERIFY(data == pixels.constData() + pixels.size());
+
+        // The frame carries the timestamp it was presented at, which is either right after it
+        // has been recorded or after the next frame has been recorded and dropped.
+        QCOMPARE((timestamp - timestampBase) % refreshInterval, qint64(0));
+        const quint64 presentedAt = (timestamp - timestampBase) / refreshInterval;
+        QVERIFY(presentedAt == sequence || presentedAt == sequence + 1);
+
+        // The damage of the dropped frames has been carried over.
+        QVERIFY(sequence < quint64(snapshots.count()));
+        QCOMPARE(replay, snapshots[sequence]);
+        ++frameIndex;
+    }
+
+    QVERIFY(frameIndex > 0);
+    QCOMPARE(frameIndex + streamDroppedFrameCount + (frameCount - expectedSequence), quint64(frameCount));
+    QCOMPARE(streamDroppedFrameCount + (frameCount - expectedSequence), droppedFrameCount);
+}
+
+QTEST_MAIN(TestVirtualFrameRecorder)
+#include "test_virtual_framerecorder.moc"
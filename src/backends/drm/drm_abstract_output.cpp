@@ -31,9 +31,9 @@ void DrmAbstractOutput::frameFailed() const
     RenderLoopPrivate::get(m_renderLoop)->notifyFrameFailed();
 }
 
-void DrmAbstractOutput::pageFlipped(std::chrono::nanoseconds timestamp) const
+void DrmAbstractOutput::pageFlipped(std::chrono::nanoseconds timestamp, quint64 sequence, RenderLoop::PresentationFlags flags) const
 {
-    RenderLoopPrivate::get(m_renderLoop)->notifyFrameCompleted(timestamp);
+    RenderLoopPrivate::get(m_renderLoop)->notifyFrameCompleted(timestamp, sequence, flags);
 }
 
 QVector<int32_t> DrmAbstractOutput::regionToRects(const QRegion &region) const
@@ -57,4 +57,14 @@ DrmGpu *DrmAbstractOutput::gpu() const
     return m_gpu;
 }
 
+DrmOverlayLayer *DrmAbstractOutput::cursorLayer() const
+{
+    return nullptr;
+}
+
+QVector<DrmOverlayLayer *> DrmAbstractOutput::overlayLayers() const
+{
+    return {};
+}
+
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "output.h"
+#include "renderloop.h"
 
 namespace KWin
 {
@@ -16,6 +17,7 @@ namespace KWin
 class DrmBackend;
 class DrmGpu;
 class DrmOutputLayer;
+class DrmOverlayLayer;
 
 class DrmAbstractOutput : public Output
 {
@@ -25,12 +27,14 @@ public:
 
     RenderLoop *renderLoop() const override;
     void frameFailed() const;
-    void pageFlipped(std::chrono::nanoseconds timestamp) const;
+    void pageFlipped(std::chrono::nanoseconds timestamp, quint64 sequence, RenderLoop::PresentationFlags flags) const;
     QVector<int32_t> regionToRects(const QRegion &region) const;
     DrmGpu *gpu() const;
 
     virtual bool present() = 0;
     virtual DrmOutputLayer *outputLayer() const = 0;
+    virtual DrmOverlayLayer *cursorLayer() const;
+    virtual QVector<DrmOverlayLayer *> overlayLayers() const;
 
 protected:
     friend class DrmGpu;
@@ -41,6 +41,10 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#ifndef DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP
+#define DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP 0x15
+#endif
+
 namespace KWin
 {
 
@@ -76,6 +80,9 @@ DrmGpu::DrmGpu(DrmBackend *backend, const QString &devNode, int fd, dev_t device
     m_addFB2ModifiersSupported = drmGetCap(fd, DRM_CAP_ADDFB2_MODIFIERS, &capability) == 0 && capability == 1;
     qCDebug(KWIN_DRM) << "drmModeAddFB2WithModifiers is" << (m_addFB2ModifiersSupported ? "supported" : "not supported") << "on GPU" << m_devNode;
 
+    m_asyncPageflipSupported = drmGetCap(fd, DRM_CAP_ASYNC_PAGE_FLIP, &capability) == 0 && capability == 1;
+    m_atomicAsyncPageflipSupported = drmGetCap(fd, DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP, &capability) == 0 && capability == 1;
+
     // find out what driver this kms device is using
     DrmScopedPointer<drmVersion> version(drmGetVersion(fd));
     m_isNVidia = strstr(version->name, "nvidia-drm");
@@ -220,6 +227,29 @@ void DrmGpu::initDrmResources()
         m_crtcs << c;
         m_allObjects << c;
     }
+
+    // Distribute the overlay planes between the crtcs that can use them. Every plane gets
+    // reserved for a single crtc, so that one pipeline can't steal it from another one
+    // between atomic tests. The overlay planes show surfaces on top of the composited
+    // content, so planes that are stacked below the primary plane are not used.
+    QHash<DrmCrtc *, QVector<DrmPlane *>> overlayPlanes;
+    for (const auto &plane : qAsConst(planes)) {
+        if (plane->type() != DrmPlane::TypeIndex::Overlay) {
+            continue;
+        }
+        DrmCrtc *best = nullptr;
+        for (const auto &crtc : qAsConst(m_crtcs)) {
+            if (plane->isCrtcSupported(crtc->pipeIndex()) && plane->isStackedAbove(crtc->primaryPlane()) && (!best || overlayPlanes[crtc].size() < overlayPlanes[best].size())) {
+                best = crtc;
+            }
+        }
+        if (best) {
+            overlayPlanes[best] << plane;
+        }
+    }
+    for (auto it = overlayPlanes.constBegin(); it != overlayPlanes.constEnd(); ++it) {
+        it.key()->setOverlayPlanes(it.value());
+    }
 }
 
 bool DrmGpu::updateOutputs()
@@ -287,7 +317,7 @@ bool DrmGpu::updateOutputs()
                     addedOutputs << output;
                     Q_EMIT outputAdded(output);
                 }
-                pipeline->setLayers(m_platform->renderBackend()->createPrimaryLayer(pipeline), m_platform->renderBackend()->createCursorLayer(pipeline));
+                pipeline->setLayers(m_platform->renderBackend()->createPrimaryLayer(pipeline), m_platform->renderBackend()->createCursorLayer(pipeline), createOverlayLayers(pipeline));
                 pipeline->setActive(!conn->isNonDesktop());
                 pipeline->applyPendingChanges();
             }
@@ -523,7 +553,6 @@ static std::chrono::nanoseconds convertTimestamp(clockid_t sourceClock, clockid_
 
 void DrmGpu::pageFlipHandler(int fd, unsigned int sequence, unsigned int sec, unsigned int usec, unsigned int crtc_id, void *user_data)
 {
-    Q_UNUSED(sequence)
     Q_UNUSED(user_data)
     auto backend = dynamic_cast<DrmBackend *>(kwinApp()->platform());
     if (!backend) {
@@ -541,10 +570,13 @@ void DrmGpu::pageFlipHandler(int fd, unsigned int sequence, unsigned int sec, un
     // unsigned multiplication.
     std::chrono::nanoseconds timestamp = convertTimestamp(gpu->presentationClock(), CLOCK_MONOTONIC,
                                                           {static_cast<time_t>(sec), static_cast<long>(usec * 1000)});
+    RenderLoop::PresentationFlags flags = RenderLoop::PresentationFlag::VSync | RenderLoop::PresentationFlag::HardwareCompletion;
     if (timestamp == std::chrono::nanoseconds::zero()) {
         qCDebug(KWIN_DRM, "Got invalid timestamp (sec: %u, usec: %u) on gpu %s",
                 sec, usec, qPrintable(gpu->devNode()));
         timestamp = std::chrono::steady_clock::now().time_since_epoch();
+    } else {
+        flags |= RenderLoop::PresentationFlag::HardwareClock;
     }
     const auto pipelines = gpu->pipelines();
     auto it = std::find_if(pipelines.begin(), pipelines.end(), [crtc_id](const auto &pipeline) {
@@ -553,7 +585,7 @@ void DrmGpu::pageFlipHandler(int fd, unsigned int sequence, unsigned int sec, un
     if (it == pipelines.end()) {
         qCWarning(KWIN_DRM, "received invalid page flip event for crtc %u", crtc_id);
     } else {
-        (*it)->pageFlipped(timestamp);
+        (*it)->pageFlipped(timestamp, sequence, flags);
     }
 }
 
@@ -721,6 +753,11 @@ bool DrmGpu::addFB2ModifiersSupported() const
     return m_addFB2ModifiersSupported;
 }
 
+bool DrmGpu::asyncPageflipSupported() const
+{
+    return m_atomicModeSetting ? m_atomicAsyncPageflipSupported : m_asyncPageflipSupported;
+}
+
 bool DrmGpu::isNVidia() const
 {
     return m_isNVidia;
@@ -777,6 +814,26 @@ QVector<DrmObject *> DrmGpu::unusedObjects() const
             ret.removeOne(pipeline->crtc());
             ret.removeOne(pipeline->crtc()->primaryPlane());
             ret.removeOne(pipeline->crtc()->cursorPlane());
+            const auto overlayPlanes = pipeline->crtc()->overlayPlanes();
+            for (const auto &plane : overlayPlanes) {
+                ret.removeOne(plane);
+            }
+        }
+    }
+    return ret;
+}
+
+QVector<QSharedPointer<DrmOverlayLayer>> DrmGpu::createOverlayLayers(DrmPipeline *pipeline) const
+{
+    // the crtc of the pipeline can change with modesets, so create enough layers for any of them
+    int count = 0;
+    for (const auto &crtc : qAsConst(m_crtcs)) {
+        count = std::max(count, crtc->overlayPlanes().size());
+    }
+    QVector<QSharedPointer<DrmOverlayLayer>> ret;
+    for (int i = 0; i < count; i++) {
+        if (const auto layer = m_platform->renderBackend()->createOverlayLayer(pipeline)) {
+            ret << layer;
         }
     }
     return ret;
@@ -798,6 +855,10 @@ void DrmGpu::releaseBuffers()
     for (const auto &pipeline : qAsConst(m_pipelines)) {
         pipeline->primaryLayer()->releaseBuffers();
         pipeline->cursorLayer()->releaseBuffers();
+        const auto overlayLayers = pipeline->overlayLayers();
+        for (const auto &layer : overlayLayers) {
+            layer->releaseBuffers();
+        }
     }
     for (const auto &output : qAsConst(m_outputs)) {
         if (const auto virtualOutput = qobject_cast<DrmVirtualOutput *>(output)) {
@@ -809,7 +870,7 @@ void DrmGpu::releaseBuffers()
 void DrmGpu::recreateSurfaces()
 {
     for (const auto &pipeline : qAsConst(m_pipelines)) {
-        pipeline->setLayers(m_platform->renderBackend()->createPrimaryLayer(pipeline), m_platform->renderBackend()->createCursorLayer(pipeline));
+        pipeline->setLayers(m_platform->renderBackend()->createPrimaryLayer(pipeline), m_platform->renderBackend()->createCursorLayer(pipeline), createOverlayLayers(pipeline));
         pipeline->applyPendingChanges();
     }
     for (const auto &output : qAsConst(m_outputs)) {
@@ -817,9 +878,6 @@ void DrmGpu::recreateSurfaces()
             virtualOutput->recreateSurface();
         }
     }
-    for (const auto &output : qAsConst(m_drmOutputs)) {
-        output->updateCursor();
-    }
 }
 
 }
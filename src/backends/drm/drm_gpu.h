@@ -13,6 +13,7 @@
 #include "drm_virtual_output.h"
 
 #include <QPointer>
+#include <QSharedPointer>
 #include <QSize>
 #include <QSocketNotifier>
 #include <QVector>
@@ -43,6 +44,7 @@ class DrmPipeline;
 class DrmAbstractOutput;
 class DrmLeaseOutput;
 class DrmRenderBackend;
+class DrmOverlayLayer;
 
 class DrmGpu : public QObject
 {
@@ -57,6 +59,11 @@ public:
 
     bool atomicModeSetting() const;
     bool addFB2ModifiersSupported() const;
+    /**
+     * Returns @c true if page flips that don't wait for vblank can be requested with
+     * the modesetting API currently in use; otherwise returns @c false.
+     */
+    bool asyncPageflipSupported() const;
     bool isNVidia() const;
     gbm_device *gbmDevice() const;
     EGLDisplay eglDisplay() const;
@@ -103,6 +110,7 @@ private:
     bool checkCrtcAssignment(QVector<DrmConnector *> connectors, const QVector<DrmCrtc *> &crtcs);
     bool testPipelines();
     QVector<DrmObject *> unusedObjects() const;
+    QVector<QSharedPointer<DrmOverlayLayer>> createOverlayLayers(DrmPipeline *pipeline) const;
 
     void handleLeaseRequest(KWaylandServer::DrmLeaseV1Interface *leaseRequest);
     void handleLeaseRevoked(KWaylandServer::DrmLeaseV1Interface *lease);
@@ -114,6 +122,8 @@ private:
     const QString m_devNode;
     bool m_atomicModeSetting;
     bool m_addFB2ModifiersSupported = false;
+    bool m_asyncPageflipSupported = false;
+    bool m_atomicAsyncPageflipSupported = false;
     bool m_isNVidia;
     bool m_isVirtualMachine;
     clockid_t m_presentationClock;
@@ -7,6 +7,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "drm_layer.h"
+#include "drm_buffer.h"
 #include "drm_pipeline.h"
 
 #include <QMatrix4x4>
@@ -41,23 +42,14 @@ DrmOverlayLayer::DrmOverlayLayer(DrmPipeline *pipeline)
 {
 }
 
-void DrmOverlayLayer::setPosition(const QPoint &pos)
+QRect DrmOverlayLayer::sourceRect() const
 {
-    m_position = pos;
+    const auto buffer = currentBuffer();
+    return buffer ? QRect(QPoint(), buffer->buffer()->size()) : QRect();
 }
 
-QPoint DrmOverlayLayer::position() const
+QRect DrmOverlayLayer::destinationRect() const
 {
-    return m_position;
-}
-
-void DrmOverlayLayer::setVisible(bool visible)
-{
-    m_visible = visible;
-}
-
-bool DrmOverlayLayer::isVisible() const
-{
-    return m_visible;
+    return QRect(position(), sourceRect().size());
 }
 }
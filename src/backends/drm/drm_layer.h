@@ -49,14 +49,13 @@ class DrmOverlayLayer : public DrmPipelineLayer
 public:
     DrmOverlayLayer(DrmPipeline *pipeline);
 
-    void setPosition(const QPoint &pos);
-    void setVisible(bool visible);
-
-    QPoint position() const;
-    bool isVisible() const;
-
-protected:
-    QPoint m_position;
-    bool m_visible = false;
+    /**
+     * The part of the current buffer that is shown on the plane, in buffer pixels
+     */
+    virtual QRect sourceRect() const;
+    /**
+     * Where the source rect is shown on the crtc, in device pixels
+     */
+    virtual QRect destinationRect() const;
 };
 }
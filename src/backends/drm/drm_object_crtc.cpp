@@ -102,6 +102,16 @@ DrmPlane *DrmCrtc::cursorPlane() const
     return m_cursorPlane;
 }
 
+QVector<DrmPlane *> DrmCrtc::overlayPlanes() const
+{
+    return m_overlayPlanes;
+}
+
+void DrmCrtc::setOverlayPlanes(const QVector<DrmPlane *> &planes)
+{
+    m_overlayPlanes = planes;
+}
+
 void DrmCrtc::disable()
 {
     setPending(PropertyIndex::Active, 0);
@@ -12,6 +12,7 @@
 #include "drm_object.h"
 
 #include <QPoint>
+#include <QVector>
 #include <memory>
 
 namespace KWin
@@ -46,6 +47,12 @@ public:
     int gammaRampSize() const;
     DrmPlane *primaryPlane() const;
     DrmPlane *cursorPlane() const;
+    /**
+     * The overlay planes that are reserved for this crtc. Each overlay plane is only
+     * assigned to a single crtc, so pipelines don't compete for them.
+     */
+    QVector<DrmPlane *> overlayPlanes() const;
+    void setOverlayPlanes(const QVector<DrmPlane *> &planes);
     drmModeModeInfo queryCurrentMode();
 
     std::shared_ptr<DrmFramebuffer> current() const;
@@ -62,6 +69,7 @@ private:
     int m_pipeIndex;
     DrmPlane *m_primaryPlane;
     DrmPlane *m_cursorPlane;
+    QVector<DrmPlane *> m_overlayPlanes;
 };
 
 }
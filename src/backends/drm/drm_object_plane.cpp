@@ -35,6 +35,7 @@ DrmPlane::DrmPlane(DrmGpu *gpu, uint32_t planeId)
                                   PropertyDefinition(QByteArrayLiteral("CRTC_ID"), Requirement::Required),
                                   PropertyDefinition(QByteArrayLiteral("rotation"), Requirement::Optional, {QByteArrayLiteral("rotate-0"), QByteArrayLiteral("rotate-90"), QByteArrayLiteral("rotate-180"), QByteArrayLiteral("rotate-270"), QByteArrayLiteral("reflect-x"), QByteArrayLiteral("reflect-y")}),
                                   PropertyDefinition(QByteArrayLiteral("IN_FORMATS"), Requirement::Optional),
+                                  PropertyDefinition(QByteArrayLiteral("zpos"), Requirement::Optional),
                               },
                 DRM_MODE_OBJECT_PLANE)
 {
@@ -155,7 +156,9 @@ void DrmPlane::setBuffer(DrmFramebuffer *buffer)
 
 bool DrmPlane::needsModeset() const
 {
-    if (!gpu()->atomicModeSetting() || type() == TypeIndex::Cursor) {
+    // only the primary plane is required for the crtc to be active, cursor and overlay
+    // planes can be enabled and disabled with normal page flips
+    if (!gpu()->atomicModeSetting() || type() != TypeIndex::Primary) {
         return false;
     }
     auto rotation = getProp(PropertyIndex::Rotation);
@@ -170,6 +173,19 @@ bool DrmPlane::isCrtcSupported(int pipeIndex) const
     return (m_possibleCrtcs & (1 << pipeIndex));
 }
 
+bool DrmPlane::isStackedAbove(const DrmPlane *plane) const
+{
+    if (!plane) {
+        return true;
+    }
+    const auto zpos = getProp(PropertyIndex::Zpos);
+    const auto otherZpos = plane->getProp(PropertyIndex::Zpos);
+    if (!zpos || !otherZpos) {
+        return type() != TypeIndex::Primary && plane->type() == TypeIndex::Primary;
+    }
+    return zpos->current() > otherZpos->current();
+}
+
 QMap<uint32_t, QVector<uint64_t>> DrmPlane::formats() const
 {
     return m_supportedFormats;
@@ -42,6 +42,7 @@ public:
         CrtcId,
         Rotation,
         In_Formats,
+        Zpos,
         Count
     };
     Q_ENUM(PropertyIndex)
@@ -71,6 +72,11 @@ public:
     TypeIndex type() const;
 
     bool isCrtcSupported(int pipeIndex) const;
+    /**
+     * Returns @c true if this plane is shown on top of the given @a plane; otherwise returns
+     * @c false. Without the zpos property, only the primary plane is known to be at the bottom.
+     */
+    bool isStackedAbove(const DrmPlane *plane) const;
     QMap<uint32_t, QVector<uint64_t>> formats() const;
 
     std::shared_ptr<DrmFramebuffer> current() const;
@@ -15,12 +15,9 @@
 #include "drm_pipeline.h"
 
 #include "composite.h"
-#include "cursor.h"
 #include "drm_dumb_buffer.h"
 #include "drm_layer.h"
 #include "dumb_swapchain.h"
-#include "egl_gbm_backend.h"
-#include "kwinglutils.h"
 #include "logging.h"
 #include "main.h"
 #include "outputconfiguration.h"
@@ -31,8 +28,6 @@
 #include "session.h"
 // Qt
 #include <QCryptographicHash>
-#include <QMatrix4x4>
-#include <QPainter>
 // c++
 #include <cerrno>
 // drm
@@ -93,10 +88,6 @@ DrmOutput::DrmOutput(DrmPipeline *pipeline)
     connect(&m_turnOffTimer, &QTimer::timeout, this, [this] {
         setDrmDpmsMode(DpmsMode::Off);
     });
-
-    connect(Cursors::self(), &Cursors::currentCursorChanged, this, &DrmOutput::updateCursor);
-    connect(Cursors::self(), &Cursors::hiddenChanged, this, &DrmOutput::updateCursor);
-    connect(Cursors::self(), &Cursors::positionChanged, this, &DrmOutput::moveCursor);
 }
 
 DrmOutput::~DrmOutput()
@@ -104,84 +95,35 @@ DrmOutput::~DrmOutput()
     m_pipeline->setOutput(nullptr);
 }
 
-void DrmOutput::updateCursor()
+DrmOverlayLayer *DrmOutput::cursorLayer() const
 {
     static bool valid;
     static const bool forceSoftwareCursor = qEnvironmentVariableIntValue("KWIN_FORCE_SW_CURSOR", &valid) == 1 && valid;
     // hardware cursors are broken with the NVidia proprietary driver
     if (forceSoftwareCursor || (!valid && m_gpu->isNVidia())) {
-        m_setCursorSuccessful = false;
-        return;
-    }
-    const auto layer = m_pipeline->cursorLayer();
-    if (!m_pipeline->crtc() || !layer) {
-        return;
-    }
-    const Cursor *cursor = Cursors::self()->currentCursor();
-    if (!cursor || cursor->image().isNull() || Cursors::self()->isCursorHidden()) {
-        if (layer->isVisible()) {
-            layer->setVisible(false);
-            m_pipeline->setCursor();
-        }
-        return;
-    }
-    bool rendered = false;
-    const QMatrix4x4 monitorMatrix = logicalToNativeMatrix(geometry(), scale(), transform());
-    const QRect cursorRect = monitorMatrix.mapRect(cursor->geometry());
-    if (cursorRect.width() <= m_gpu->cursorSize().width() && cursorRect.height() <= m_gpu->cursorSize().height()) {
-        if (const auto beginInfo = layer->beginFrame()) {
-            const auto &[renderTarget, repaint] = beginInfo.value();
-            if (dynamic_cast<EglGbmBackend *>(m_gpu->platform()->renderBackend())) {
-                renderCursorOpengl(renderTarget, cursor->geometry().size() * scale());
-            } else {
-                renderCursorQPainter(renderTarget);
-            }
-            rendered = layer->endFrame(infiniteRegion(), infiniteRegion());
-        }
-    }
-    if (!rendered) {
-        if (layer->isVisible()) {
-            layer->setVisible(false);
-            m_pipeline->setCursor();
-        }
-        m_setCursorSuccessful = false;
-        return;
+        return nullptr;
     }
+    return m_pipeline->cursorLayer();
+}
 
-    const QSize surfaceSize = m_gpu->cursorSize() / scale();
-    const QRect layerRect = monitorMatrix.mapRect(QRect(cursor->geometry().topLeft(), surfaceSize));
-    layer->setPosition(layerRect.topLeft());
-    layer->setVisible(cursor->geometry().intersects(geometry()));
-    if (layer->isVisible()) {
-        m_setCursorSuccessful = m_pipeline->setCursor(logicalToNativeMatrix(QRect(QPoint(), layerRect.size()), scale(), transform()).map(cursor->hotspot()));
-        layer->setVisible(m_setCursorSuccessful);
+QVector<DrmOverlayLayer *> DrmOutput::overlayLayers() const
+{
+    static bool valid;
+    static const bool overlaysDisabled = qEnvironmentVariableIntValue("KWIN_DRM_NO_OVERLAYS", &valid) == 1 && valid;
+    if (overlaysDisabled) {
+        return {};
     }
+    return m_pipeline->overlayLayers();
 }
 
-void DrmOutput::moveCursor()
+bool DrmOutput::updateCursorLayer()
 {
-    if (!m_setCursorSuccessful || !m_pipeline->crtc()) {
-        return;
-    }
-    const auto layer = m_pipeline->cursorLayer();
-    Cursor *cursor = Cursors::self()->currentCursor();
-    if (!cursor || cursor->image().isNull() || Cursors::self()->isCursorHidden() || !cursor->geometry().intersects(geometry())) {
-        if (layer->isVisible()) {
-            layer->setVisible(false);
-            m_pipeline->setCursor();
-        }
-        return;
-    }
-    const QMatrix4x4 monitorMatrix = logicalToNativeMatrix(geometry(), scale(), transform());
-    const QSize surfaceSize = m_gpu->cursorSize() / scale();
-    const QRect cursorRect = monitorMatrix.mapRect(QRect(cursor->geometry().topLeft(), surfaceSize));
-    layer->setVisible(true);
-    layer->setPosition(cursorRect.topLeft());
-    m_moveCursorSuccessful = m_pipeline->moveCursor();
-    layer->setVisible(m_moveCursorSuccessful);
-    if (!m_moveCursorSuccessful) {
-        m_pipeline->setCursor();
-    }
+    return m_pipeline->crtc() && m_pipeline->setCursor();
+}
+
+bool DrmOutput::moveCursorLayer()
+{
+    return m_pipeline->crtc() && m_pipeline->moveCursor();
 }
 
 QList<QSharedPointer<OutputMode>> DrmOutput::getModes() const
@@ -391,8 +333,6 @@ void DrmOutput::applyQueuedChanges(const OutputConfiguration &config)
 
     m_renderLoop->scheduleRepaint();
     Q_EMIT changed();
-
-    updateCursor();
 }
 
 void DrmOutput::revertQueuedChanges()
@@ -400,11 +340,6 @@ void DrmOutput::revertQueuedChanges()
     m_pipeline->revertPendingChanges();
 }
 
-bool DrmOutput::usesSoftwareCursor() const
-{
-    return !m_setCursorSuccessful || !m_moveCursorSuccessful;
-}
-
 DrmOutputLayer *DrmOutput::outputLayer() const
 {
     return m_pipeline->primaryLayer();
@@ -420,69 +355,4 @@ void DrmOutput::setColorTransformation(const QSharedPointer<ColorTransformation>
         m_pipeline->revertPendingChanges();
     }
 }
-
-void DrmOutput::renderCursorOpengl(const RenderTarget &renderTarget, const QSize &cursorSize)
-{
-    auto allocateTexture = [this]() {
-        const QImage img = Cursors::self()->currentCursor()->image();
-        if (img.isNull()) {
-            m_cursorTextureDirty = false;
-            return;
-        }
-        m_cursorTexture.reset(new GLTexture(img));
-        m_cursorTexture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_cursorTextureDirty = false;
-    };
-
-    if (!m_cursorTexture) {
-        allocateTexture();
-
-        // handle shape update on case cursor image changed
-        connect(Cursors::self(), &Cursors::currentCursorChanged, this, [this]() {
-            m_cursorTextureDirty = true;
-        });
-    } else if (m_cursorTextureDirty) {
-        const QImage image = Cursors::self()->currentCursor()->image();
-        if (image.size() == m_cursorTexture->size()) {
-            m_cursorTexture->update(image);
-            m_cursorTextureDirty = false;
-        } else {
-            allocateTexture();
-        }
-    }
-
-    QMatrix4x4 mvp;
-    mvp.ortho(QRect(QPoint(), renderTarget.size()));
-
-    glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    m_cursorTexture->bind();
-    ShaderBinder binder(ShaderTrait::MapTexture);
-    binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-    m_cursorTexture->render(QRect(0, 0, cursorSize.width(), cursorSize.height()));
-    m_cursorTexture->unbind();
-    glDisable(GL_BLEND);
-}
-
-void DrmOutput::renderCursorQPainter(const RenderTarget &renderTarget)
-{
-    const auto layer = m_pipeline->cursorLayer();
-    const Cursor *cursor = Cursors::self()->currentCursor();
-    const QImage cursorImage = cursor->image();
-
-    QImage *c = std::get<QImage *>(renderTarget.nativeHandle());
-    c->setDevicePixelRatio(scale());
-    c->fill(Qt::transparent);
-
-    QPainter p;
-    p.begin(c);
-    p.setWorldTransform(logicalToNativeMatrix(cursor->rect(), 1, transform()).toTransform());
-    p.setRenderHint(QPainter::SmoothPixmapTransform);
-    p.drawImage(QPoint(0, 0), cursorImage);
-    p.end();
-}
 }
@@ -28,9 +28,6 @@ namespace KWin
 class DrmConnector;
 class DrmGpu;
 class DrmPipeline;
-class DumbSwapchain;
-class GLTexture;
-class RenderTarget;
 
 class KWIN_EXPORT DrmOutput : public DrmAbstractOutput
 {
@@ -50,9 +47,10 @@ public:
     void revertQueuedChanges();
     void updateModes();
 
-    bool usesSoftwareCursor() const override;
-    void updateCursor();
-    void moveCursor();
+    DrmOverlayLayer *cursorLayer() const override;
+    QVector<DrmOverlayLayer *> overlayLayers() const override;
+    bool updateCursorLayer() override;
+    bool moveCursorLayer() override;
 
     void setColorTransformation(const QSharedPointer<ColorTransformation> &transformation) override;
 
@@ -63,16 +61,9 @@ private:
 
     QList<QSharedPointer<OutputMode>> getModes() const;
 
-    void renderCursorOpengl(const RenderTarget &renderTarget, const QSize &cursorSize);
-    void renderCursorQPainter(const RenderTarget &renderTarget);
-
     DrmPipeline *m_pipeline;
     DrmConnector *m_connector;
 
-    bool m_setCursorSuccessful = false;
-    bool m_moveCursorSuccessful = false;
-    bool m_cursorTextureDirty = true;
-    std::unique_ptr<GLTexture> m_cursorTexture;
     QTimer m_turnOffTimer;
 };
 
@@ -9,6 +9,7 @@
 
 #include "drm_pipeline.h"
 
+#include <algorithm>
 #include <errno.h>
 
 #include "cursor.h"
@@ -146,7 +147,19 @@ bool DrmPipeline::commitPipelinesAtomic(const QVector<DrmPipeline *> &pipelines,
     } else {
         flags |= DRM_MODE_ATOMIC_NONBLOCK;
     }
-    if (drmModeAtomicCommit(pipelines[0]->gpu()->fd(), req, (flags & (~DRM_MODE_PAGE_FLIP_EVENT)) | DRM_MODE_ATOMIC_TEST_ONLY, nullptr) != 0) {
+    bool tested = false;
+    if (mode == CommitMode::Commit && pipelines[0]->gpu()->asyncPageflipSupported()) {
+        const bool async = std::all_of(pipelines.begin(), pipelines.end(), [](DrmPipeline *pipeline) {
+            return pipeline->asyncPageflipRequested();
+        });
+        // Drivers may reject async flips that change anything but the framebuffers,
+        // in that case fall back to waiting for vblank
+        if (async && drmModeAtomicCommit(pipelines[0]->gpu()->fd(), req, (flags & (~DRM_MODE_PAGE_FLIP_EVENT)) | DRM_MODE_PAGE_FLIP_ASYNC | DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0) {
+            flags |= DRM_MODE_PAGE_FLIP_ASYNC;
+            tested = true;
+        }
+    }
+    if (!tested && drmModeAtomicCommit(pipelines[0]->gpu()->fd(), req, (flags & (~DRM_MODE_PAGE_FLIP_EVENT)) | DRM_MODE_ATOMIC_TEST_ONLY, nullptr) != 0) {
         qCDebug(KWIN_DRM) << "Atomic test for" << mode << "failed!" << strerror(errno);
         return failed();
     }
@@ -155,6 +168,9 @@ bool DrmPipeline::commitPipelinesAtomic(const QVector<DrmPipeline *> &pipelines,
         return failed();
     }
     for (const auto &pipeline : pipelines) {
+        if (mode != CommitMode::Test) {
+            pipeline->m_asyncPageflipPending = flags & DRM_MODE_PAGE_FLIP_ASYNC;
+        }
         pipeline->atomicCommitSuccessful(mode);
     }
     for (const auto &obj : unusedObjects) {
@@ -181,7 +197,8 @@ bool DrmPipeline::populateAtomicValues(drmModeAtomicReq *req, uint32_t &flags)
         prepareAtomicModeset();
     }
     if (m_pending.crtc) {
-        m_pending.crtc->setPending(DrmCrtc::PropertyIndex::VrrEnabled, m_pending.syncMode == RenderLoopPrivate::SyncMode::Adaptive);
+        const bool vrr = m_pending.syncMode == RenderLoopPrivate::SyncMode::Adaptive || m_pending.syncMode == RenderLoopPrivate::SyncMode::AdaptiveAsync;
+        m_pending.crtc->setPending(DrmCrtc::PropertyIndex::VrrEnabled, vrr);
         m_pending.crtc->setPending(DrmCrtc::PropertyIndex::Gamma_LUT, m_pending.gamma ? m_pending.gamma->blobId() : 0);
         const auto modeSize = m_pending.mode->size();
         const auto fb = m_pending.layer->currentBuffer().get();
@@ -190,11 +207,27 @@ bool DrmPipeline::populateAtomicValues(drmModeAtomicReq *req, uint32_t &flags)
 
         if (m_pending.crtc->cursorPlane()) {
             const auto layer = cursorLayer();
-            bool active = activePending() && layer->isVisible();
+            bool active = activePending() && layer->isEnabled();
             m_pending.crtc->cursorPlane()->set(QPoint(0, 0), gpu()->cursorSize(), layer->position(), gpu()->cursorSize());
             m_pending.crtc->cursorPlane()->setBuffer(active ? layer->currentBuffer().get() : nullptr);
             m_pending.crtc->cursorPlane()->setPending(DrmPlane::PropertyIndex::CrtcId, active ? m_pending.crtc->id() : 0);
         }
+
+        const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+        for (int i = 0; i < overlayPlanes.size(); i++) {
+            const auto layer = i < m_pending.overlayLayers.size() ? m_pending.overlayLayers[i].get() : nullptr;
+            const auto fb = layer ? layer->currentBuffer().get() : nullptr;
+            if (activePending() && layer && layer->isEnabled() && fb) {
+                const QRect source = layer->sourceRect();
+                const QRect destination = layer->destinationRect();
+                overlayPlanes[i]->set(source.topLeft(), source.size(), destination.topLeft(), destination.size());
+                overlayPlanes[i]->setBuffer(fb);
+                overlayPlanes[i]->setPending(DrmPlane::PropertyIndex::CrtcId, m_pending.crtc->id());
+            } else {
+                overlayPlanes[i]->setBuffer(nullptr);
+                overlayPlanes[i]->setPending(DrmPlane::PropertyIndex::CrtcId, 0);
+            }
+        }
     }
     if (!m_connector->atomicPopulate(req)) {
         return false;
@@ -209,6 +242,12 @@ bool DrmPipeline::populateAtomicValues(drmModeAtomicReq *req, uint32_t &flags)
         if (m_pending.crtc->cursorPlane() && !m_pending.crtc->cursorPlane()->atomicPopulate(req)) {
             return false;
         }
+        const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+        for (const auto &plane : overlayPlanes) {
+            if (!plane->atomicPopulate(req)) {
+                return false;
+            }
+        }
     }
     return true;
 }
@@ -251,6 +290,10 @@ void DrmPipeline::prepareAtomicModeset()
     if (m_pending.crtc->cursorPlane()) {
         m_pending.crtc->cursorPlane()->setTransformation(DrmPlane::Transformation::Rotate0);
     }
+    const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+    for (const auto &plane : overlayPlanes) {
+        plane->setTransformation(DrmPlane::Transformation::Rotate0);
+    }
 }
 
 uint32_t DrmPipeline::calculateUnderscan()
@@ -275,6 +318,10 @@ void DrmPipeline::atomicCommitFailed()
         if (m_pending.crtc->cursorPlane()) {
             m_pending.crtc->cursorPlane()->rollbackPending();
         }
+        const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+        for (const auto &plane : overlayPlanes) {
+            plane->rollbackPending();
+        }
     }
 }
 
@@ -287,6 +334,10 @@ void DrmPipeline::atomicCommitSuccessful(CommitMode mode)
         if (m_pending.crtc->cursorPlane()) {
             m_pending.crtc->cursorPlane()->commitPending();
         }
+        const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+        for (const auto &plane : overlayPlanes) {
+            plane->commitPending();
+        }
     }
     if (mode != CommitMode::Test) {
         m_pending.needsModeset = false;
@@ -302,6 +353,12 @@ void DrmPipeline::atomicCommitSuccessful(CommitMode mode)
                 m_pending.crtc->cursorPlane()->setNext(cursorLayer()->currentBuffer());
                 m_pending.crtc->cursorPlane()->commit();
             }
+            const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+            for (int i = 0; i < overlayPlanes.size(); i++) {
+                const auto layer = i < m_pending.overlayLayers.size() ? m_pending.overlayLayers[i].get() : nullptr;
+                overlayPlanes[i]->setNext(layer && layer->isEnabled() ? layer->currentBuffer() : nullptr);
+                overlayPlanes[i]->commit();
+            }
         }
         m_current = m_pending;
         if (mode == CommitMode::CommitModeset && activePending()) {
@@ -310,10 +367,9 @@ void DrmPipeline::atomicCommitSuccessful(CommitMode mode)
     }
 }
 
-bool DrmPipeline::setCursor(const QPoint &hotspot)
+bool DrmPipeline::setCursor()
 {
     bool result;
-    m_pending.cursorHotspot = hotspot;
     // explicitly check for the cursor plane and not for AMS, as we might not always have one
     if (m_pending.crtc->cursorPlane()) {
         result = commitPipelines({this}, CommitMode::Test);
@@ -378,7 +434,7 @@ DrmGpu *DrmPipeline::gpu() const
     return m_connector->gpu();
 }
 
-void DrmPipeline::pageFlipped(std::chrono::nanoseconds timestamp)
+void DrmPipeline::pageFlipped(std::chrono::nanoseconds timestamp, quint64 sequence, RenderLoop::PresentationFlags flags)
 {
     m_current.crtc->flipBuffer();
     if (m_current.crtc->primaryPlane()) {
@@ -387,9 +443,20 @@ void DrmPipeline::pageFlipped(std::chrono::nanoseconds timestamp)
     if (m_current.crtc->cursorPlane()) {
         m_current.crtc->cursorPlane()->flipBuffer();
     }
+    const auto overlayPlanes = m_current.crtc->overlayPlanes();
+    for (const auto &plane : overlayPlanes) {
+        plane->flipBuffer();
+    }
     m_pageflipPending = false;
+    if (m_current.layer && m_current.layer->hasDirectScanoutBuffer()) {
+        flags |= RenderLoop::PresentationFlag::ZeroCopy;
+    }
+    if (m_asyncPageflipPending) {
+        flags.setFlag(RenderLoop::PresentationFlag::VSync, false);
+        m_asyncPageflipPending = false;
+    }
     if (m_output) {
-        m_output->pageFlipped(timestamp);
+        m_output->pageFlipped(timestamp, sequence, flags);
     }
 }
 
@@ -417,6 +484,21 @@ QMap<uint32_t, QVector<uint64_t>> DrmPipeline::cursorFormats() const
     }
 }
 
+QMap<uint32_t, QVector<uint64_t>> DrmPipeline::overlayFormats(const DrmOverlayLayer *layer) const
+{
+    const auto layers = overlayLayers();
+    const int index = layers.indexOf(const_cast<DrmOverlayLayer *>(layer));
+    if (index == -1) {
+        return {};
+    }
+    const DrmPlane *plane = m_pending.crtc->overlayPlanes()[index];
+    // a mutable zpos may have been changed by another drm master in the meantime
+    if (!plane->isStackedAbove(m_pending.crtc->primaryPlane())) {
+        return {};
+    }
+    return plane->formats();
+}
+
 bool DrmPipeline::pruneModifier()
 {
     if (!m_pending.layer->currentBuffer()
@@ -576,6 +658,10 @@ void DrmPipeline::printDebugInfo() const
         if (m_pending.crtc->cursorPlane()) {
             printProps(m_pending.crtc->cursorPlane(), PrintMode::All);
         }
+        const auto overlayPlanes = m_pending.crtc->overlayPlanes();
+        for (const auto &plane : overlayPlanes) {
+            printProps(plane, PrintMode::All);
+        }
     }
 }
 
@@ -609,6 +695,20 @@ DrmOverlayLayer *DrmPipeline::cursorLayer() const
     return m_pending.cursorLayer.get();
 }
 
+QVector<DrmOverlayLayer *> DrmPipeline::overlayLayers() const
+{
+    if (!m_pending.crtc) {
+        return {};
+    }
+    const int count = std::min(m_pending.overlayLayers.size(), m_pending.crtc->overlayPlanes().size());
+    QVector<DrmOverlayLayer *> ret;
+    ret.reserve(count);
+    for (int i = 0; i < count; i++) {
+        ret << m_pending.overlayLayers[i].get();
+    }
+    return ret;
+}
+
 DrmPlane::Transformations DrmPipeline::renderOrientation() const
 {
     return m_pending.renderOrientation;
@@ -624,6 +724,11 @@ RenderLoopPrivate::SyncMode DrmPipeline::syncMode() const
     return m_pending.syncMode;
 }
 
+bool DrmPipeline::asyncPageflipRequested() const
+{
+    return m_pending.syncMode == RenderLoopPrivate::SyncMode::Async || m_pending.syncMode == RenderLoopPrivate::SyncMode::AdaptiveAsync;
+}
+
 uint32_t DrmPipeline::overscan() const
 {
     return m_pending.overscan;
@@ -662,10 +767,11 @@ void DrmPipeline::setEnable(bool enable)
     m_pending.enabled = enable;
 }
 
-void DrmPipeline::setLayers(const QSharedPointer<DrmPipelineLayer> &primaryLayer, const QSharedPointer<DrmOverlayLayer> &cursorLayer)
+void DrmPipeline::setLayers(const QSharedPointer<DrmPipelineLayer> &primaryLayer, const QSharedPointer<DrmOverlayLayer> &cursorLayer, const QVector<QSharedPointer<DrmOverlayLayer>> &overlayLayers)
 {
     m_pending.layer = primaryLayer;
     m_pending.cursorLayer = cursorLayer;
+    m_pending.overlayLayers = overlayLayers;
 }
 
 void DrmPipeline::setRenderOrientation(DrmPlane::Transformations orientation)
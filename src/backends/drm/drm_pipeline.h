@@ -66,14 +66,14 @@ public:
     void applyPendingChanges();
     void revertPendingChanges();
 
-    bool setCursor(const QPoint &hotspot = QPoint());
+    bool setCursor();
     bool moveCursor();
 
     DrmConnector *connector() const;
     DrmCrtc *currentCrtc() const;
     DrmGpu *gpu() const;
 
-    void pageFlipped(std::chrono::nanoseconds timestamp);
+    void pageFlipped(std::chrono::nanoseconds timestamp, quint64 sequence = 0, RenderLoop::PresentationFlags flags = RenderLoop::PresentationFlags());
     bool pageflipPending() const;
     bool modesetPresentPending() const;
     void resetModesetPresentPending();
@@ -85,6 +85,7 @@ public:
 
     QMap<uint32_t, QVector<uint64_t>> formats() const;
     QMap<uint32_t, QVector<uint64_t>> cursorFormats() const;
+    QMap<uint32_t, QVector<uint64_t>> overlayFormats(const DrmOverlayLayer *layer) const;
     bool pruneModifier();
 
     void setOutput(DrmOutput *output);
@@ -96,9 +97,17 @@ public:
     bool enabled() const;
     DrmPipelineLayer *primaryLayer() const;
     DrmOverlayLayer *cursorLayer() const;
+    /**
+     * The layers that can be shown on the overlay planes of the current crtc
+     */
+    QVector<DrmOverlayLayer *> overlayLayers() const;
     DrmPlane::Transformations renderOrientation() const;
     DrmPlane::Transformations bufferOrientation() const;
     RenderLoopPrivate::SyncMode syncMode() const;
+    /**
+     * Returns @c true if the pending sync mode asks for page flips that don't wait for vblank
+     */
+    bool asyncPageflipRequested() const;
     uint32_t overscan() const;
     Output::RgbRange rgbRange() const;
 
@@ -106,7 +115,7 @@ public:
     void setMode(const QSharedPointer<DrmConnectorMode> &mode);
     void setActive(bool active);
     void setEnable(bool enable);
-    void setLayers(const QSharedPointer<DrmPipelineLayer> &primaryLayer, const QSharedPointer<DrmOverlayLayer> &cursorLayer);
+    void setLayers(const QSharedPointer<DrmPipelineLayer> &primaryLayer, const QSharedPointer<DrmOverlayLayer> &cursorLayer, const QVector<QSharedPointer<DrmOverlayLayer>> &overlayLayers = {});
     void setRenderOrientation(DrmPlane::Transformations orientation);
     void setBufferOrientation(DrmPlane::Transformations orientation);
     void setSyncMode(RenderLoopPrivate::SyncMode mode);
@@ -154,6 +163,7 @@ private:
     DrmConnector *m_connector = nullptr;
 
     bool m_pageflipPending = false;
+    bool m_asyncPageflipPending = false;
     bool m_modesetPresentPending = false;
 
     struct State
@@ -172,7 +182,7 @@ private:
 
         QSharedPointer<DrmPipelineLayer> layer;
         QSharedPointer<DrmOverlayLayer> cursorLayer;
-        QPoint cursorHotspot;
+        QVector<QSharedPointer<DrmOverlayLayer>> overlayLayers;
 
         // the transformation that this pipeline will apply to submitted buffers
         DrmPlane::Transformations bufferOrientation = DrmPlane::Transformation::Rotate0;
@@ -27,7 +27,10 @@ bool DrmPipeline::presentLegacy()
         return false;
     }
     const auto buffer = m_pending.layer->currentBuffer();
-    if (drmModePageFlip(gpu()->fd(), m_pending.crtc->id(), buffer->framebufferId(), DRM_MODE_PAGE_FLIP_EVENT, nullptr) != 0) {
+    // async page flips can be rejected by the driver, e.g. if the framebuffer layout changes
+    m_asyncPageflipPending = asyncPageflipRequested() && gpu()->asyncPageflipSupported()
+        && drmModePageFlip(gpu()->fd(), m_pending.crtc->id(), buffer->framebufferId(), DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC, nullptr) == 0;
+    if (!m_asyncPageflipPending && drmModePageFlip(gpu()->fd(), m_pending.crtc->id(), buffer->framebufferId(), DRM_MODE_PAGE_FLIP_EVENT, nullptr) != 0) {
         qCWarning(KWIN_DRM) << "Page flip failed:" << strerror(errno);
         return false;
     }
@@ -91,7 +94,8 @@ bool DrmPipeline::applyPendingChangesLegacy()
     }
     if (activePending()) {
         auto vrr = m_pending.crtc->getProp(DrmCrtc::PropertyIndex::VrrEnabled);
-        if (vrr && !vrr->setPropertyLegacy(m_pending.syncMode == RenderLoopPrivate::SyncMode::Adaptive)) {
+        const bool adaptive = m_pending.syncMode == RenderLoopPrivate::SyncMode::Adaptive || m_pending.syncMode == RenderLoopPrivate::SyncMode::AdaptiveAsync;
+        if (vrr && !vrr->setPropertyLegacy(adaptive)) {
             qCWarning(KWIN_DRM) << "Setting vrr failed!" << strerror(errno);
             return false;
         }
@@ -126,7 +130,7 @@ bool DrmPipeline::applyPendingChangesLegacy()
 bool DrmPipeline::setCursorLegacy()
 {
     const auto bo = cursorLayer()->currentBuffer();
-    const uint32_t handle = bo && bo->buffer() && cursorLayer()->isVisible() ? bo->buffer()->handles()[0] : 0;
+    const uint32_t handle = bo && bo->buffer() && cursorLayer()->isEnabled() ? bo->buffer()->handles()[0] : 0;
 
     struct drm_mode_cursor2 arg = {
         .flags = DRM_MODE_CURSOR_BO | DRM_MODE_CURSOR_MOVE,
@@ -136,8 +140,8 @@ bool DrmPipeline::setCursorLegacy()
         .width = (uint32_t)gpu()->cursorSize().width(),
         .height = (uint32_t)gpu()->cursorSize().height(),
         .handle = handle,
-        .hot_x = m_pending.cursorHotspot.x(),
-        .hot_y = m_pending.cursorHotspot.y(),
+        .hot_x = m_pending.cursorLayer->hotspot().x(),
+        .hot_y = m_pending.cursorLayer->hotspot().y(),
     };
     return drmIoctl(gpu()->fd(), DRM_IOCTL_MODE_CURSOR2, &arg) == 0;
 }
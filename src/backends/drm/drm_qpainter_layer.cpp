@@ -19,6 +19,8 @@
 #include "logging.h"
 #include "scene_qpainter_drm_backend.h"
 
+#include <QPainter>
+
 #include <drm_fourcc.h>
 
 namespace KWin
@@ -106,15 +108,34 @@ std::optional<OutputLayerBeginFrameInfo> DrmCursorQPainterLayer::beginFrame()
     if (!m_swapchain->acquireBuffer(&needsRepaint)) {
         return std::nullopt;
     }
+    // The cursor is painted in the logical orientation and gets rotated when copied to the buffer.
+    if (m_image.size() != m_pipeline->gpu()->cursorSize()) {
+        m_image = QImage(m_pipeline->gpu()->cursorSize(), QImage::Format_ARGB32_Premultiplied);
+    }
+    if (const DrmOutput *output = m_pipeline->output()) {
+        m_image.setDevicePixelRatio(output->scale());
+    }
+    m_image.fill(Qt::transparent);
     return OutputLayerBeginFrameInfo{
-        .renderTarget = RenderTarget(m_swapchain->currentBuffer()->image()),
-        .repaint = needsRepaint,
+        .renderTarget = RenderTarget(&m_image),
+        .repaint = QRect(QPoint(), m_image.size()),
     };
 }
 
 bool DrmCursorQPainterLayer::endFrame(const QRegion &damagedRegion, const QRegion &renderedRegion)
 {
     Q_UNUSED(renderedRegion)
+    QImage *buffer = m_swapchain->currentBuffer()->image();
+    buffer->fill(Qt::transparent);
+
+    QPainter painter(buffer);
+    if (const DrmOutput *output = m_pipeline->output()) {
+        painter.setWorldTransform(Output::logicalToNativeMatrix(QRect(QPoint(), m_image.size()), 1, output->transform()).toTransform());
+    }
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(QRect(QPoint(), m_image.size()), m_image);
+    painter.end();
+
     m_swapchain->releaseBuffer(m_swapchain->currentBuffer(), damagedRegion);
     m_currentFramebuffer = DrmFramebuffer::createFramebuffer(m_swapchain->currentBuffer());
     if (!m_currentFramebuffer) {
@@ -123,6 +144,11 @@ bool DrmCursorQPainterLayer::endFrame(const QRegion &damagedRegion, const QRegio
     return m_currentFramebuffer != nullptr;
 }
 
+std::optional<QSize> DrmCursorQPainterLayer::fixedSize() const
+{
+    return m_pipeline->gpu()->cursorSize();
+}
+
 bool DrmCursorQPainterLayer::checkTestBuffer()
 {
     return false;
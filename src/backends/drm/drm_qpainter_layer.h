@@ -48,6 +48,7 @@ public:
 
     std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
     bool endFrame(const QRegion &damagedRegion, const QRegion &renderedRegion) override;
+    std::optional<QSize> fixedSize() const override;
 
     bool checkTestBuffer() override;
     std::shared_ptr<DrmFramebuffer> currentBuffer() const override;
@@ -57,6 +58,7 @@ public:
 private:
     std::shared_ptr<DumbSwapchain> m_swapchain;
     std::shared_ptr<DrmFramebuffer> m_currentFramebuffer;
+    QImage m_image;
 };
 
 class DrmVirtualQPainterLayer : public DrmOutputLayer
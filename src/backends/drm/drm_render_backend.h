@@ -26,6 +26,11 @@ public:
 
     virtual QSharedPointer<DrmPipelineLayer> createPrimaryLayer(DrmPipeline *pipeline) = 0;
     virtual QSharedPointer<DrmOverlayLayer> createCursorLayer(DrmPipeline *pipeline) = 0;
+    /**
+     * Creates a layer that can show client buffers on an overlay plane, or @c nullptr
+     * if the render backend can't import client buffers for direct scanout.
+     */
+    virtual QSharedPointer<DrmOverlayLayer> createOverlayLayer(DrmPipeline *pipeline) = 0;
     virtual QSharedPointer<DrmOutputLayer> createLayer(DrmVirtualOutput *output) = 0;
 };
 
@@ -22,6 +22,7 @@
 #include "egl_dmabuf.h"
 #include "egl_gbm_cursor_layer.h"
 #include "egl_gbm_layer.h"
+#include "egl_gbm_overlay_layer.h"
 #include "gbm_dmabuf.h"
 #include "gbm_surface.h"
 #include "kwineglutils_p.h"
@@ -214,6 +215,17 @@ OutputLayer *EglGbmBackend::primaryLayer(Output *output)
     return static_cast<DrmAbstractOutput *>(output)->outputLayer();
 }
 
+OutputLayer *EglGbmBackend::cursorLayer(Output *output)
+{
+    return static_cast<DrmAbstractOutput *>(output)->cursorLayer();
+}
+
+QVector<OutputLayer *> EglGbmBackend::overlayLayers(Output *output)
+{
+    const auto layers = static_cast<DrmAbstractOutput *>(output)->overlayLayers();
+    return QVector<OutputLayer *>(layers.begin(), layers.end());
+}
+
 QSharedPointer<GLTexture> EglGbmBackend::textureForOutput(Output *output) const
 {
     const auto drmOutput = static_cast<DrmAbstractOutput *>(output);
@@ -253,6 +265,15 @@ QSharedPointer<DrmOverlayLayer> EglGbmBackend::createCursorLayer(DrmPipeline *pi
     return QSharedPointer<EglGbmCursorLayer>::create(this, pipeline);
 }
 
+QSharedPointer<DrmOverlayLayer> EglGbmBackend::createOverlayLayer(DrmPipeline *pipeline)
+{
+    if (pipeline->output()) {
+        return QSharedPointer<EglGbmOverlayLayer>::create(pipeline);
+    } else {
+        return nullptr;
+    }
+}
+
 QSharedPointer<DrmOutputLayer> EglGbmBackend::createLayer(DrmVirtualOutput *output)
 {
     return QSharedPointer<VirtualEglGbmLayer>::create(this, output);
@@ -67,11 +67,14 @@ public:
 
     void present(Output *output) override;
     OutputLayer *primaryLayer(Output *output) override;
+    OutputLayer *cursorLayer(Output *output) override;
+    QVector<OutputLayer *> overlayLayers(Output *output) override;
 
     void init() override;
     bool prefer10bpc() const override;
     QSharedPointer<DrmPipelineLayer> createPrimaryLayer(DrmPipeline *pipeline) override;
     QSharedPointer<DrmOverlayLayer> createCursorLayer(DrmPipeline *pipeline) override;
+    QSharedPointer<DrmOverlayLayer> createOverlayLayer(DrmPipeline *pipeline) override;
     QSharedPointer<DrmOutputLayer> createLayer(DrmVirtualOutput *output) override;
 
     QSharedPointer<GLTexture> textureForOutput(Output *requestedOutput) const override;
@@ -11,6 +11,7 @@
 #include "drm_pipeline.h"
 #include "egl_gbm_backend.h"
 
+#include <epoxy/gl.h>
 #include <gbm.h>
 
 namespace KWin
@@ -26,7 +27,13 @@ std::optional<OutputLayerBeginFrameInfo> EglGbmCursorLayer::beginFrame()
 {
     // some legacy drivers don't work with linear gbm buffers for the cursor
     const auto target = m_pipeline->gpu()->atomicModeSetting() ? EglGbmLayerSurface::BufferTarget::Linear : EglGbmLayerSurface::BufferTarget::Dumb;
-    return m_surface.startRendering(m_pipeline->gpu()->cursorSize(), m_pipeline->renderOrientation(), DrmPlane::Transformation::Rotate0, m_pipeline->cursorFormats(), target);
+    auto ret = m_surface.startRendering(m_pipeline->gpu()->cursorSize(), m_pipeline->renderOrientation(), DrmPlane::Transformation::Rotate0, m_pipeline->cursorFormats(), target);
+    if (ret.has_value()) {
+        // the cursor only covers a part of the buffer, the rest must be transparent
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    return ret;
 }
 
 void EglGbmCursorLayer::aboutToStartPainting(const QRegion &damagedRegion)
@@ -49,6 +56,11 @@ bool EglGbmCursorLayer::endFrame(const QRegion &renderedRegion, const QRegion &d
     }
 }
 
+std::optional<QSize> EglGbmCursorLayer::fixedSize() const
+{
+    return m_pipeline->gpu()->cursorSize();
+}
+
 QRegion EglGbmCursorLayer::currentDamage() const
 {
     return {};
@@ -33,6 +33,7 @@ public:
     std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
     void aboutToStartPainting(const QRegion &damagedRegion) override;
     bool endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
+    std::optional<QSize> fixedSize() const override;
     std::shared_ptr<DrmFramebuffer> currentBuffer() const override;
     QRegion currentDamage() const override;
     bool checkTestBuffer() override;
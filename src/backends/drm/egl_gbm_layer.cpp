@@ -159,7 +159,7 @@ bool EglGbmLayer::scanout(SurfaceItem *surfaceItem)
     if (m_scanoutBuffer && m_pipeline->testScanout()) {
         m_dmabufFeedback.scanoutSuccessful(surface);
         m_currentBuffer = m_scanoutBuffer;
-        m_currentDamage = surfaceItem->damage();
+        m_currentDamage = surfaceItem->mapToGlobal(surfaceItem->damage());
         surfaceItem->resetDamage();
         return true;
     } else {
@@ -0,0 +1,158 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "egl_gbm_overlay_layer.h"
+#include "drm_backend.h"
+#include "drm_buffer_gbm.h"
+#include "drm_gpu.h"
+#include "drm_output.h"
+#include "drm_pipeline.h"
+#include "surfaceitem_wayland.h"
+#include "wayland/linuxdmabufv1clientbuffer.h"
+#include "wayland/surface_interface.h"
+
+#include <drm_fourcc.h>
+
+#include <cmath>
+
+namespace KWin
+{
+
+EglGbmOverlayLayer::EglGbmOverlayLayer(DrmPipeline *pipeline)
+    : DrmOverlayLayer(pipeline)
+{
+}
+
+std::optional<OutputLayerBeginFrameInfo> EglGbmOverlayLayer::beginFrame()
+{
+    return std::nullopt;
+}
+
+bool EglGbmOverlayLayer::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
+{
+    Q_UNUSED(renderedRegion)
+    Q_UNUSED(damagedRegion)
+    return false;
+}
+
+bool EglGbmOverlayLayer::scanout(SurfaceItem *surfaceItem)
+{
+    static bool valid;
+    static const bool directScanoutDisabled = qEnvironmentVariableIntValue("KWIN_DRM_NO_DIRECT_SCANOUT", &valid) == 1 && valid;
+    if (directScanoutDisabled) {
+        return false;
+    }
+
+    SurfaceItemWayland *item = qobject_cast<SurfaceItemWayland *>(surfaceItem);
+    if (!item || !item->surface() || !m_pipeline->output()) {
+        return false;
+    }
+    const auto surface = item->surface();
+    // overlay planes are not rotated together with the output
+    if (m_pipeline->bufferOrientation() != DrmPlane::Transformations(DrmPlane::Transformation::Rotate0)
+        || m_pipeline->renderOrientation() != DrmPlane::Transformations(DrmPlane::Transformation::Rotate0)
+        || surface->bufferTransform() != Output::Transform::Normal) {
+        return false;
+    }
+    const auto buffer = qobject_cast<KWaylandServer::LinuxDmaBufV1ClientBuffer *>(surface->buffer());
+    if (!buffer || buffer->planes().isEmpty()) {
+        return false;
+    }
+
+    const auto formats = m_pipeline->overlayFormats(this);
+    if (!formats.contains(buffer->format())) {
+        return false;
+    }
+    if (buffer->planes().constFirst().modifier == DRM_FORMAT_MOD_INVALID && m_pipeline->gpu()->platform()->gpuCount() > 1) {
+        // importing a buffer from another GPU without an explicit modifier can mess up the buffer format
+        return false;
+    }
+    if (!formats[buffer->format()].contains(buffer->planes().constFirst().modifier)) {
+        return false;
+    }
+
+    const QRect sourceRect = surface->mapToBuffer(QRegion(QRect(QPoint(), surface->size()))).boundingRect() & QRect(QPoint(), buffer->size());
+    if (sourceRect.isEmpty()) {
+        return false;
+    }
+    const DrmOutput *output = m_pipeline->output();
+    const QRect logicalRect = surfaceItem->mapToGlobal(surfaceItem->rect()).translated(-output->geometry().topLeft());
+    const qreal scale = output->scale();
+    const QRect destinationRect(std::round(logicalRect.x() * scale), std::round(logicalRect.y() * scale),
+                                std::round(logicalRect.width() * scale), std::round(logicalRect.height() * scale));
+    // partially visible planes are rejected by many drivers
+    if (destinationRect.isEmpty() || !QRect(QPoint(), m_pipeline->bufferSize()).contains(destinationRect)) {
+        return false;
+    }
+
+    const auto framebuffer = importBuffer(buffer);
+    if (!framebuffer) {
+        return false;
+    }
+
+    m_currentBuffer = framebuffer;
+    m_sourceRect = sourceRect;
+    m_destinationRect = destinationRect;
+    setEnabled(true);
+    if (m_pipeline->testScanout()) {
+        surfaceItem->resetDamage();
+        return true;
+    } else {
+        m_currentBuffer.reset();
+        setEnabled(false);
+        return false;
+    }
+}
+
+std::shared_ptr<DrmFramebuffer> EglGbmOverlayLayer::importBuffer(KWaylandServer::LinuxDmaBufV1ClientBuffer *buffer)
+{
+    // The surface usually keeps its buffer for several frames, don't import it every frame.
+    // Only the buffer on screen is kept, the framebuffer holds a reference to the client
+    // buffer and would prevent it from being released to the client otherwise.
+    if (m_currentBuffer && static_cast<GbmBuffer *>(m_currentBuffer->buffer())->clientBuffer() == buffer) {
+        return m_currentBuffer;
+    }
+    const auto gbmBuffer = GbmBuffer::importBuffer(m_pipeline->gpu(), buffer);
+    if (!gbmBuffer) {
+        return nullptr;
+    }
+    return DrmFramebuffer::createFramebuffer(gbmBuffer);
+}
+
+bool EglGbmOverlayLayer::checkTestBuffer()
+{
+    // the layer is only shown with client buffers, there is nothing to allocate
+    return true;
+}
+
+std::shared_ptr<DrmFramebuffer> EglGbmOverlayLayer::currentBuffer() const
+{
+    return m_currentBuffer;
+}
+
+bool EglGbmOverlayLayer::hasDirectScanoutBuffer() const
+{
+    return m_currentBuffer != nullptr;
+}
+
+QRect EglGbmOverlayLayer::sourceRect() const
+{
+    return m_sourceRect;
+}
+
+QRect EglGbmOverlayLayer::destinationRect() const
+{
+    return m_destinationRect;
+}
+
+void EglGbmOverlayLayer::releaseBuffers()
+{
+    m_currentBuffer.reset();
+    setEnabled(false);
+}
+}
@@ -0,0 +1,49 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+#include "drm_layer.h"
+
+#include <QRect>
+
+namespace KWaylandServer
+{
+class LinuxDmaBufV1ClientBuffer;
+}
+
+namespace KWin
+{
+
+/**
+ * The EglGbmOverlayLayer class shows client buffers on a DRM overlay plane. It can't be
+ * rendered to, the compositor only assigns surfaces to it with scanout().
+ */
+class EglGbmOverlayLayer : public DrmOverlayLayer
+{
+public:
+    EglGbmOverlayLayer(DrmPipeline *pipeline);
+
+    std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
+    bool endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
+    bool scanout(SurfaceItem *surfaceItem) override;
+    bool checkTestBuffer() override;
+    std::shared_ptr<DrmFramebuffer> currentBuffer() const override;
+    bool hasDirectScanoutBuffer() const override;
+    QRect sourceRect() const override;
+    QRect destinationRect() const override;
+    void releaseBuffers() override;
+
+private:
+    std::shared_ptr<DrmFramebuffer> importBuffer(KWaylandServer::LinuxDmaBufV1ClientBuffer *buffer);
+
+    std::shared_ptr<DrmFramebuffer> m_currentBuffer;
+    QRect m_sourceRect;
+    QRect m_destinationRect;
+};
+
+}
@@ -44,6 +44,11 @@ OutputLayer *DrmQPainterBackend::primaryLayer(Output *output)
     return static_cast<DrmAbstractOutput *>(output)->outputLayer();
 }
 
+OutputLayer *DrmQPainterBackend::cursorLayer(Output *output)
+{
+    return static_cast<DrmAbstractOutput *>(output)->cursorLayer();
+}
+
 QSharedPointer<DrmPipelineLayer> DrmQPainterBackend::createPrimaryLayer(DrmPipeline *pipeline)
 {
     if (pipeline->output()) {
@@ -58,6 +63,13 @@ QSharedPointer<DrmOverlayLayer> DrmQPainterBackend::createCursorLayer(DrmPipelin
     return QSharedPointer<DrmCursorQPainterLayer>::create(pipeline);
 }
 
+QSharedPointer<DrmOverlayLayer> DrmQPainterBackend::createOverlayLayer(DrmPipeline *pipeline)
+{
+    Q_UNUSED(pipeline)
+    // client buffers are never imported for scanout with QPainter compositing
+    return nullptr;
+}
+
 QSharedPointer<DrmOutputLayer> DrmQPainterBackend::createLayer(DrmVirtualOutput *output)
 {
     return QSharedPointer<DrmVirtualQPainterLayer>::create(output);
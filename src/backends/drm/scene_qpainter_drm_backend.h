@@ -32,9 +32,11 @@ public:
 
     void present(Output *output) override;
     OutputLayer *primaryLayer(Output *output) override;
+    OutputLayer *cursorLayer(Output *output) override;
 
     QSharedPointer<DrmPipelineLayer> createPrimaryLayer(DrmPipeline *pipeline) override;
     QSharedPointer<DrmOverlayLayer> createCursorLayer(DrmPipeline *pipeline) override;
+    QSharedPointer<DrmOverlayLayer> createOverlayLayer(DrmPipeline *pipeline) override;
     QSharedPointer<DrmOutputLayer> createLayer(DrmVirtualOutput *output) override;
 
 private:
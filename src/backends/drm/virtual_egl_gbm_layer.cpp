@@ -163,7 +163,7 @@ bool VirtualEglGbmLayer::scanout(SurfaceItem *surfaceItem)
         return false;
     }
     // damage tracking for screen casting
-    m_currentDamage = m_scanoutSurface == item->surface() ? surfaceItem->damage() : infiniteRegion();
+    m_currentDamage = m_scanoutSurface == item->surface() ? surfaceItem->mapToGlobal(surfaceItem->damage()) : infiniteRegion();
     surfaceItem->resetDamage();
     m_scanoutSurface = item->surface();
     m_currentBuffer = scanoutBuffer;
@@ -15,6 +15,7 @@
 #include "screens.h"
 #include "softwarevsyncmonitor.h"
 #include "virtual_backend.h"
+#include "virtual_framerecorder.h"
 #include "virtual_output.h"
 #include <logging.h>
 // kwin libs
@@ -43,10 +44,20 @@ std::optional<OutputLayerBeginFrameInfo> VirtualOutputLayer::beginFrame()
 bool VirtualOutputLayer::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
-    Q_UNUSED(damagedRegion)
+    m_damage += damagedRegion;
     return true;
 }
 
+QRegion VirtualOutputLayer::damage() const
+{
+    return m_damage;
+}
+
+void VirtualOutputLayer::resetDamage()
+{
+    m_damage = QRegion();
+}
+
 EglGbmBackend::EglGbmBackend(VirtualBackend *b)
     : AbstractEglBackend()
     , m_backend(b)
@@ -187,36 +198,6 @@ OutputLayerBeginFrameInfo EglGbmBackend::beginFrame()
     };
 }
 
-static void convertFromGLImage(QImage &img, int w, int h)
-{
-    // from QtOpenGL/qgl.cpp
-    // SPDX-FileCopyrightText: 2010 Nokia Corporation and /or its subsidiary(-ies)
-    // see https://github.com/qt/qtbase/blob/dev/src/opengl/qgl.cpp
-    if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
-        // OpenGL gives RGBA; Qt wants ARGB
-        uint *p = reinterpret_cast<uint *>(img.bits());
-        uint *end = p + w * h;
-        while (p < end) {
-            uint a = *p << 24;
-            *p = (*p >> 8) | a;
-            p++;
-        }
-    } else {
-        // OpenGL gives ABGR (i.e. RGBA backwards); Qt wants ARGB
-        for (int y = 0; y < h; y++) {
-            uint *q = reinterpret_cast<uint *>(img.scanLine(y));
-            for (int x = 0; x < w; ++x) {
-                const uint pixel = *q;
-                *q = ((pixel << 16) & 0xff0000) | ((pixel >> 16) & 0xff)
-                    | (pixel & 0xff00ff00);
-
-                q++;
-            }
-        }
-    }
-    img = img.mirrored();
-}
-
 OutputLayer *EglGbmBackend::primaryLayer(Output *output)
 {
     Q_UNUSED(output)
@@ -229,11 +210,16 @@ void EglGbmBackend::present(Output *output)
 
     static_cast<VirtualOutput *>(output)->vsyncMonitor()->arm();
 
-    if (m_backend->saveFrames()) {
-        QImage img = QImage(QSize(m_backBuffer->width(), m_backBuffer->height()), QImage::Format_ARGB32);
-        glReadnPixels(0, 0, m_backBuffer->width(), m_backBuffer->height(), GL_RGBA, GL_UNSIGNED_BYTE, img.sizeInBytes(), (GLvoid *)img.bits());
-        convertFromGLImage(img, m_backBuffer->width(), m_backBuffer->height());
-        img.save(QStringLiteral("%1/%2.png").arg(m_backend->saveFrames()).arg(QString::number(m_frameCounter++)));
+    if (VirtualFrameRecorder *recorder = m_backend->frameRecorder()) {
+        // Only the damaged rects are read back, they are converted on the writer thread.
+        const int height = m_backBuffer->height();
+        recorder->record(output->name(), output->scale(), m_backBuffer->size(), m_layer->damage(), [height](const QRect &rect) {
+            QImage image(rect.size(), QImage::Format_RGBA8888);
+            glReadnPixels(rect.x(), height - rect.y() - rect.height(), rect.width(), rect.height(),
+                          GL_RGBA, GL_UNSIGNED_BYTE, image.sizeInBytes(), image.bits());
+            return image.mirrored();
+        });
+        m_layer->resetDamage();
     }
     GLFramebuffer::popFramebuffer();
 
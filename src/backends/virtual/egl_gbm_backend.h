@@ -26,8 +26,12 @@ public:
     std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
     bool endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
 
+    QRegion damage() const;
+    void resetDamage();
+
 private:
     EglGbmBackend *const m_backend;
+    QRegion m_damage;
 };
 
 /**
@@ -55,7 +59,6 @@ private:
     VirtualBackend *m_backend;
     GLTexture *m_backBuffer = nullptr;
     GLFramebuffer *m_fbo = nullptr;
-    int m_frameCounter = 0;
     QScopedPointer<VirtualOutputLayer> m_layer;
 };
 
@@ -11,6 +11,7 @@
 #include "screens.h"
 #include "softwarevsyncmonitor.h"
 #include "virtual_backend.h"
+#include "virtual_framerecorder.h"
 #include "virtual_output.h"
 
 #include <QPainter>
@@ -36,7 +37,7 @@ std::optional<OutputLayerBeginFrameInfo> VirtualQPainterLayer::beginFrame()
 bool VirtualQPainterLayer::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
-    Q_UNUSED(damagedRegion)
+    m_damage += damagedRegion;
     return true;
 }
 
@@ -45,6 +46,16 @@ QImage *VirtualQPainterLayer::image()
     return &m_image;
 }
 
+QRegion VirtualQPainterLayer::damage() const
+{
+    return m_damage;
+}
+
+void VirtualQPainterLayer::resetDamage()
+{
+    m_damage = QRegion();
+}
+
 VirtualQPainterBackend::VirtualQPainterBackend(VirtualBackend *backend)
     : QPainterBackend()
     , m_backend(backend)
@@ -68,8 +79,13 @@ void VirtualQPainterBackend::present(Output *output)
 {
     static_cast<VirtualOutput *>(output)->vsyncMonitor()->arm();
 
-    if (m_backend->saveFrames()) {
-        m_outputs[output]->image()->save(QStringLiteral("%1/%s-%3.png").arg(m_backend->screenshotDirPath(), output->name(), QString::number(m_frameCounter++)));
+    if (VirtualFrameRecorder *recorder = m_backend->frameRecorder()) {
+        VirtualQPainterLayer *layer = m_outputs[output].get();
+        const QImage *image = layer->image();
+        recorder->record(output->name(), output->scale(), image->size(), layer->damage(), [image](const QRect &rect) {
+            return image->copy(rect);
+        });
+        layer->resetDamage();
     }
 }
 
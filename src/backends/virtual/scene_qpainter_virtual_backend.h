@@ -29,10 +29,13 @@ public:
     std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
     bool endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
     QImage *image();
+    QRegion damage() const;
+    void resetDamage();
 
 private:
     Output *const m_output;
     QImage m_image;
+    QRegion m_damage;
 };
 
 class VirtualQPainterBackend : public QPainterBackend
@@ -50,7 +53,6 @@ private:
 
     QMap<Output *, QSharedPointer<VirtualQPainterLayer>> m_outputs;
     VirtualBackend *m_backend;
-    int m_frameCounter = 0;
 };
 
 }
@@ -14,9 +14,11 @@
 #include "egl_gbm_backend.h"
 #include "scene_qpainter_virtual_backend.h"
 #include "session.h"
+#include "virtual_framerecorder.h"
 #include "virtual_output.h"
 #include "wayland_server.h"
 // Qt
+#include <QDir>
 #include <QTemporaryDir>
 // system
 #include <fcntl.h>
@@ -30,12 +32,27 @@ VirtualBackend::VirtualBackend(QObject *parent)
     , m_session(Session::create(Session::Type::Noop, this))
 {
     if (qEnvironmentVariableIsSet("KWIN_WAYLAND_VIRTUAL_SCREENSHOTS")) {
-        m_screenshotDir.reset(new QTemporaryDir);
-        if (!m_screenshotDir->isValid()) {
-            m_screenshotDir.reset();
+        // The frames are recorded in the specified directory, or in a temporary one.
+        const QString directory = qEnvironmentVariable("KWIN_WAYLAND_VIRTUAL_SCREENSHOTS");
+        if (QDir::isAbsolutePath(directory) && QDir().mkpath(directory)) {
+            m_screenshotDirPath = directory;
+        } else {
+            m_screenshotDir.reset(new QTemporaryDir);
+            if (m_screenshotDir->isValid()) {
+                m_screenshotDirPath = m_screenshotDir->path();
+            } else {
+                m_screenshotDir.reset();
+            }
         }
-        if (!m_screenshotDir.isNull()) {
-            qDebug() << "Screenshots saved to: " << m_screenshotDir->path();
+        if (!m_screenshotDirPath.isEmpty()) {
+            bool ok = false;
+            int queueCapacity = qEnvironmentVariableIntValue("KWIN_WAYLAND_VIRTUAL_SCREENSHOTS_QUEUE", &ok);
+            if (!ok) {
+                queueCapacity = 8;
+            }
+            const int compressionLevel = qEnvironmentVariableIntValue("KWIN_WAYLAND_VIRTUAL_SCREENSHOTS_COMPRESSION");
+            m_frameRecorder.reset(new VirtualFrameRecorder(m_screenshotDirPath, queueCapacity, compressionLevel));
+            qDebug() << "Screenshots saved to: " << m_screenshotDirPath;
         }
     }
 
@@ -80,10 +97,12 @@ bool VirtualBackend::initialize()
 
 QString VirtualBackend::screenshotDirPath() const
 {
-    if (m_screenshotDir.isNull()) {
-        return QString();
-    }
-    return m_screenshotDir->path();
+    return m_screenshotDirPath;
+}
+
+VirtualFrameRecorder *VirtualBackend::frameRecorder() const
+{
+    return m_frameRecorder.data();
 }
 
 QPainterBackend *VirtualBackend::createQPainterBackend()
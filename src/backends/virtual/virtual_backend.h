@@ -21,6 +21,7 @@ class QTemporaryDir;
 namespace KWin
 {
 class VirtualBackend;
+class VirtualFrameRecorder;
 class VirtualOutput;
 
 class KWIN_EXPORT VirtualBackend : public Platform
@@ -36,10 +37,7 @@ public:
     Session *session() const override;
     bool initialize() override;
 
-    bool saveFrames() const
-    {
-        return !m_screenshotDir.isNull();
-    }
+    VirtualFrameRecorder *frameRecorder() const;
     QString screenshotDirPath() const;
 
     QPainterBackend *createQPainterBackend() override;
@@ -70,6 +68,8 @@ private:
     QVector<VirtualOutput *> m_outputs;
     QVector<VirtualOutput *> m_outputsEnabled;
     QScopedPointer<QTemporaryDir> m_screenshotDir;
+    QString m_screenshotDirPath;
+    QScopedPointer<VirtualFrameRecorder> m_frameRecorder;
     Session *m_session;
 };
 
@@ -0,0 +1,188 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "virtual_framerecorder.h"
+#include "logging.h"
+
+#include <QDataStream>
+#include <QDir>
+
+namespace KWin
+{
+
+static const quint32 s_formatVersion = 1;
+
+static QRegion toDevicePixels(const QRegion &region, qreal scale)
+{
+    QRegion device;
+    for (const QRect &rect : region) {
+        device += QRectF(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale).toAlignedRect();
+    }
+    return device;
+}
+
+VirtualFrameRecorder::VirtualFrameRecorder(const QString &directory, int queueCapacity, int compressionLevel)
+    : m_directory(directory)
+    , m_queueCapacity(std::max(1, queueCapacity))
+    , m_compressionLevel(std::clamp(compressionLevel, 0, 9))
+{
+    setObjectName(QStringLiteral("VirtualFrameRecorder"));
+    start(QThread::LowPriority);
+}
+
+VirtualFrameRecorder::~VirtualFrameRecorder()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopped = true;
+        m_condition.wakeOne();
+    }
+    // The frames that are still queued are written before the thread quits.
+    wait();
+
+    if (m_droppedFrameCount) {
+        qCWarning(KWIN_VIRTUAL) << "Dropped" << m_droppedFrameCount << "frames while recording to" << m_directory;
+    }
+}
+
+quint64 VirtualFrameRecorder::droppedFrameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedFrameCount;
+}
+
+void VirtualFrameRecorder::record(const QString &name, qreal scale, const QSize &size, const QRegion &damage,
+                                  const std::function<QImage(const QRect &)> &grab)
+{
+    const QRect bounds(QPoint(0, 0), size);
+
+    QMutexLocker locker(&m_mutex);
+    OutputState &state = m_outputs[name];
+    if (state.size != size) {
+        state.size = size;
+        state.pendingDamage = bounds;
+    }
+    const QRegion region = (state.pendingDamage | toDevicePixels(damage, scale)) & bounds;
+    const quint64 sequence = state.sequence++;
+
+    if (m_queue.count() + m_presentingFrameCount >= m_queueCapacity) {
+        state.pendingDamage = region;
+        state.droppedFrames++;
+        m_droppedFrameCount++;
+        return;
+    }
+
+    Frame frame;
+    frame.outputName = name;
+    frame.sequence = sequence;
+    frame.droppedFrames = state.droppedFrames;
+    frame.size = size;
+    state.pendingDamage = QRegion();
+    state.droppedFrames = 0;
+    m_presentingFrameCount++;
+    locker.unlock();
+
+    // The contents are grabbed without holding the lock, the writer thread keeps going meanwhile.
+    frame.rects.reserve(region.rectCount());
+    frame.images.reserve(region.rectCount());
+    for (const QRect &rect : region) {
+        frame.rects.append(rect);
+        frame.images.append(grab(rect));
+    }
+
+    locker.relock();
+    m_outputs[name].presentingFrames.enqueue(std::move(frame));
+}
+
+void VirtualFrameRecorder::presented(const QString &name, std::chrono::nanoseconds timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_outputs.find(name);
+    if (it == m_outputs.end() || it->presentingFrames.isEmpty()) {
+        return;
+    }
+    Frame frame = it->presentingFrames.dequeue();
+    frame.timestamp = timestamp;
+    m_presentingFrameCount--;
+    m_queue.enqueue(std::move(frame));
+    m_condition.wakeOne();
+}
+
+void VirtualFrameRecorder::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        while (m_queue.isEmpty() && !m_stopped) {
+            m_condition.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            break;
+        }
+        const Frame frame = m_queue.dequeue();
+        locker.unlock();
+        write(frame);
+        locker.relock();
+    }
+    m_files.clear();
+}
+
+void VirtualFrameRecorder::write(const Frame &frame)
+{
+    QSharedPointer<QFile> file = m_files.value(frame.outputName);
+    if (!file) {
+        file = QSharedPointer<QFile>::create(QDir(m_directory).filePath(frame.outputName + QStringLiteral(".kwinframes")));
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCWarning(KWIN_VIRTUAL) << "Failed to open" << file->fileName() << file->errorString();
+        } else {
+            file->write("KWINFRMS", 8);
+            QDataStream stream(file.get());
+            stream.setByteOrder(QDataStream::LittleEndian);
+            stream << s_formatVersion;
+        }
+        m_files.insert(frame.outputName, file);
+    }
+    if (!file->isOpen()) {
+        return;
+    }
+
+    int pixelCount = 0;
+    for (const QRect &rect : frame.rects) {
+        pixelCount += rect.width() * rect.height();
+    }
+    QByteArray pixels;
+    pixels.reserve(pixelCount * 4);
+    for (QImage image : frame.images) {
+        if (image.format() != QImage::Format_RGB32) {
+            image = image.convertToFormat(QImage::Format_RGB32);
+        }
+        const int rowSize = image.width() * 4;
+        for (int y = 0; y < image.height(); ++y) {
+            pixels.append(reinterpret_cast<const char *>(image.constScanLine(y)), rowSize);
+        }
+    }
+    if (m_compressionLevel > 0) {
+        pixels = qCompress(pixels, m_compressionLevel);
+    }
+
+    QDataStream stream(file.get());
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << frame.sequence
+           << qint64(frame.timestamp.count())
+           << frame.droppedFrames
+           << quint32(frame.size.width())
+           << quint32(frame.size.height())
+           << quint32(frame.rects.count());
+    for (const QRect &rect : frame.rects) {
+        stream << qint32(rect.x()) << qint32(rect.y()) << qint32(rect.width()) << qint32(rect.height());
+    }
+    stream << quint32(m_compressionLevel > 0 ? 1 : 0)
+           << quint32(pixels.size());
+    stream.writeRawData(pixels.constData(), pixels.size());
+}
+
+} // namespace KWin
@@ -0,0 +1,129 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QRegion>
+#include <QSharedPointer>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <chrono>
+#include <functional>
+
+namespace KWin
+{
+
+/**
+ * The VirtualFrameRecorder class writes the frames of the virtual outputs to disk on a
+ * background thread.
+ *
+ * Only the damaged parts of a frame are copied on the compositor thread, the conversion and
+ * the file I/O happen on the writer thread. A recorded frame is queued for writing once it has
+ * been presented. If the writer falls behind and the queue is full, frames are dropped; the
+ * damage of a dropped frame is carried over to the next recorded one, so the stream can always
+ * be replayed correctly.
+ *
+ * Every output gets its own file, named after the output with the ".kwinframes" extension.
+ * All integers are little endian. The file starts with the "KWINFRMS" magic and a quint32
+ * version, followed by the frames. Every frame consists of
+ *
+ * @li quint64 sequence number of the frame, counting the dropped frames
+ * @li qint64 presentation time of the frame in nanoseconds, CLOCK_MONOTONIC
+ * @li quint32 number of frames dropped since the previous frame
+ * @li quint32 width and quint32 height of the output, in device pixels
+ * @li quint32 number of damage rectangles, followed by qint32 x, y, width and height of every rectangle
+ * @li quint32 compression, 0 if the pixels are raw and 1 if they are compressed with qCompress()
+ * @li quint32 size of the pixel data, followed by the pixel data
+ *
+ * The pixel data contains the rows of every damage rectangle, in order, as tightly packed
+ * 0xffRRGGBB pixels. The first frame of an output covers the whole output.
+ */
+class VirtualFrameRecorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates a recorder that writes into the specified @a directory. At most @a queueCapacity
+     * frames wait for being presented or written. If @a compressionLevel is greater than zero,
+     * the pixel data is compressed with zlib at that level.
+     */
+    VirtualFrameRecorder(const QString &directory, int queueCapacity, int compressionLevel);
+    ~VirtualFrameRecorder() override;
+
+    /**
+     * Records a frame of the output with the given @a name, the @a size is in device pixels.
+     * The @a damage is specified in the logical coordinates of the output, which are converted
+     * to device pixels using the @a scale. The @a grab function is called on the calling thread
+     * for every rectangle that has to be recorded and returns its contents.
+     *
+     * The frame is written after presented() has been called for it.
+     */
+    void record(const QString &name, qreal scale, const QSize &size, const QRegion &damage,
+                const std::function<QImage(const QRect &)> &grab);
+
+    /**
+     * Notifies the recorder that the oldest recorded frame of the output with the given
+     * @a name has been presented at the specified @a timestamp.
+     */
+    void presented(const QString &name, std::chrono::nanoseconds timestamp);
+
+    /**
+     * Returns the number of frames that have been dropped because the queue was full.
+     */
+    quint64 droppedFrameCount() const;
+
+protected:
+    void run() override;
+
+private:
+    struct Frame
+    {
+        QString outputName;
+        quint64 sequence = 0;
+        std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero();
+        quint32 droppedFrames = 0;
+        QSize size;
+        QVector<QRect> rects;
+        QVector<QImage> images;
+    };
+
+    struct OutputState
+    {
+        QSize size;
+        QRegion pendingDamage;
+        quint64 sequence = 0;
+        quint32 droppedFrames = 0;
+        QQueue<Frame> presentingFrames;
+    };
+
+    void write(const Frame &frame);
+
+    const QString m_directory;
+    const int m_queueCapacity;
+    const int m_compressionLevel;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<Frame> m_queue;
+    QHash<QString, OutputState> m_outputs;
+    int m_presentingFrameCount = 0;
+    quint64 m_droppedFrameCount = 0;
+    bool m_stopped = false;
+
+    // Only used by the writer thread.
+    QHash<QString, QSharedPointer<QFile>> m_files;
+};
+
+} // namespace KWin
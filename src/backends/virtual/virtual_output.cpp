@@ -8,6 +8,7 @@
 */
 #include "virtual_output.h"
 #include "virtual_backend.h"
+#include "virtual_framerecorder.h"
 
 #include "renderloop_p.h"
 #include "softwarevsyncmonitor.h"
@@ -62,6 +63,10 @@ void VirtualOutput::setGeometry(const QRect &geo)
 
 void VirtualOutput::vblank(std::chrono::nanoseconds timestamp)
 {
+    if (VirtualFrameRecorder *recorder = m_backend->frameRecorder()) {
+        recorder->presented(name(), timestamp);
+    }
+
     RenderLoopPrivate *renderLoopPrivate = RenderLoopPrivate::get(m_renderLoop);
     renderLoopPrivate->notifyFrameCompleted(timestamp);
 }
@@ -35,6 +35,7 @@
 #include "unmanaged.h"
 #include "useractions.h"
 #include "utils/common.h"
+#include "utils/rectregion.h"
 #include "utils/xcbutils.h"
 #include "wayland/surface_interface.h"
 #include "wayland_server.h"
@@ -44,6 +45,7 @@
 
 #include <kwinglplatform.h>
 #include <kwingltexture.h>
+#include <kwinglutils.h>
 
 #include <KGlobalAccel>
 #include <KLocalizedString>
@@ -54,6 +56,7 @@
 
 #include <QDateTime>
 #include <QFutureWatcher>
+#include <QMatrix4x4>
 #include <QMenu>
 #include <QOpenGLContext>
 #include <QQuickWindow>
@@ -432,27 +435,121 @@ void Compositor::addOutput(Output *output)
         workspaceLayer->setGeometry(output->rect());
     });
 
+    auto createCursorDelegate = [this]() -> RenderLayerDelegate * {
+        if (m_backend->compositingType() == OpenGLCompositing) {
+            return new CursorDelegateOpenGL();
+        } else {
+            return new CursorDelegateQPainter();
+        }
+    };
+
     auto cursorLayer = new RenderLayer(output->renderLoop());
     cursorLayer->setVisible(false);
-    if (m_backend->compositingType() == OpenGLCompositing) {
-        cursorLayer->setDelegate(new CursorDelegateOpenGL());
-    } else {
-        cursorLayer->setDelegate(new CursorDelegateQPainter());
-    }
+    cursorLayer->setDelegate(createCursorDelegate());
     cursorLayer->setParent(workspaceLayer);
     cursorLayer->setSuperlayer(workspaceLayer);
 
-    auto updateCursorLayer = [output, cursorLayer]() {
+    // The hardware cursor layer is not a part of the layer tree. It's used only to paint the
+    // cursor in the cursor output layer, if the output has one.
+    auto hardwareCursorLayer = new RenderLayer(output->renderLoop());
+    hardwareCursorLayer->setDelegate(createCursorDelegate());
+    hardwareCursorLayer->setParent(cursorLayer);
+
+    auto cursorOutputLayerRect = [output](OutputLayer *outputLayer) {
+        const Cursor *cursor = Cursors::self()->currentCursor();
+        const QMatrix4x4 monitorMatrix = Output::logicalToNativeMatrix(output->geometry(), output->scale(), output->transform());
+        if (const auto fixedSize = outputLayer->fixedSize()) {
+            return monitorMatrix.mapRect(QRect(cursor->geometry().topLeft(), *fixedSize / output->scale()));
+        }
+        return monitorMatrix.mapRect(cursor->geometry());
+    };
+
+    auto renderHardwareCursor = [this, output, hardwareCursorLayer, cursorOutputLayerRect]() {
+        OutputLayer *outputLayer = m_backend->cursorLayer(output);
+        if (!outputLayer) {
+            return false;
+        }
+
+        const Cursor *cursor = Cursors::self()->currentCursor();
+        const QMatrix4x4 monitorMatrix = Output::logicalToNativeMatrix(output->geometry(), output->scale(), output->transform());
+        const QRect nativeCursorRect = monitorMatrix.mapRect(cursor->geometry());
+        if (const auto fixedSize = outputLayer->fixedSize()) {
+            if (nativeCursorRect.width() > fixedSize->width() || nativeCursorRect.height() > fixedSize->height()) {
+                return false;
+            }
+        }
+
+        auto beginInfo = outputLayer->beginFrame();
+        if (!beginInfo) {
+            return false;
+        }
+        auto &[renderTarget, repaint] = beginInfo.value();
+        renderTarget.setDevicePixelRatio(output->scale());
+
+        hardwareCursorLayer->setGeometry(QRect(QPoint(0, 0), cursor->geometry().size()));
+        hardwareCursorLayer->delegate()->paint(&renderTarget, infiniteRegion());
+        if (!outputLayer->endFrame(infiniteRegion(), infiniteRegion())) {
+            return false;
+        }
+
+        const QRect layerRect = cursorOutputLayerRect(outputLayer);
+        outputLayer->setPosition(layerRect.topLeft());
+        outputLayer->setHotspot(Output::logicalToNativeMatrix(QRect(QPoint(), layerRect.size()), output->scale(), output->transform()).map(cursor->hotspot()));
+        outputLayer->setEnabled(true);
+        return output->updateCursorLayer();
+    };
+
+    auto disableHardwareCursor = [this, output]() {
+        OutputLayer *outputLayer = m_backend->cursorLayer(output);
+        if (outputLayer && outputLayer->isEnabled()) {
+            outputLayer->setEnabled(false);
+            output->updateCursorLayer();
+        }
+    };
+
+    auto updateCursorLayer = [output, cursorLayer, renderHardwareCursor, disableHardwareCursor]() {
+        const Cursor *cursor = Cursors::self()->currentCursor();
+        if (!cursor->isOnOutput(output) || !output->usesSoftwareCursor()) {
+            disableHardwareCursor();
+            cursorLayer->setVisible(false);
+            return;
+        }
+
+        // Fall back to compositing the cursor only if it can't be put in a hardware plane.
+        if (renderHardwareCursor()) {
+            cursorLayer->setVisible(false);
+        } else {
+            disableHardwareCursor();
+            cursorLayer->setVisible(true);
+            cursorLayer->setGeometry(output->mapFromGlobal(cursor->geometry()));
+            cursorLayer->addRepaintFull();
+        }
+    };
+
+    auto moveCursorLayer = [this, output, cursorLayer, cursorOutputLayerRect, updateCursorLayer]() {
         const Cursor *cursor = Cursors::self()->currentCursor();
-        cursorLayer->setVisible(cursor->isOnOutput(output) && output->usesSoftwareCursor());
-        cursorLayer->setGeometry(output->mapFromGlobal(cursor->geometry()));
-        cursorLayer->addRepaintFull();
+        if (cursor->isOnOutput(output)) {
+            // Moving the hardware cursor requires neither repainting nor rendering.
+            OutputLayer *outputLayer = m_backend->cursorLayer(output);
+            if (outputLayer && outputLayer->isEnabled()) {
+                outputLayer->setPosition(cursorOutputLayerRect(outputLayer).topLeft());
+                if (output->moveCursorLayer()) {
+                    return;
+                }
+            } else if (cursorLayer->isVisible()) {
+                cursorLayer->setGeometry(output->mapFromGlobal(cursor->geometry()));
+                return;
+            }
+        }
+        updateCursorLayer();
     };
+
     updateCursorLayer();
     connect(output, &Output::geometryChanged, cursorLayer, updateCursorLayer);
+    connect(output, &Output::changed, cursorLayer, updateCursorLayer);
     connect(Cursors::self(), &Cursors::currentCursorChanged, cursorLayer, updateCursorLayer);
     connect(Cursors::self(), &Cursors::hiddenChanged, cursorLayer, updateCursorLayer);
-    connect(Cursors::self(), &Cursors::positionChanged, cursorLayer, updateCursorLayer);
+    connect(Cursors::self(), &Cursors::positionChanged, cursorLayer, moveCursorLayer);
 
     addSuperLayer(workspaceLayer);
 }
@@ -471,6 +568,11 @@ void Compositor::addSuperLayer(RenderLayer *layer)
 void Compositor::removeSuperLayer(RenderLayer *layer)
 {
     m_superlayers.remove(layer->loop());
+    m_overlayRegions.remove(layer->loop());
+    if (m_renderTimeQueries.contains(layer->loop())) {
+        m_scene->makeOpenGLContextCurrent();
+        m_renderTimeQueries.remove(layer->loop());
+    }
     disconnect(layer->loop(), &RenderLoop::frameRequested, this, &Compositor::handleFrameRequested);
     delete layer;
 }
@@ -643,6 +745,12 @@ void Compositor::composite(RenderLoop *renderLoop)
     SurfaceItem *scanoutCandidate = superLayer->delegate()->scanoutCandidate();
     renderLoop->setFullscreenSurface(scanoutCandidate);
 
+    // The overlay layers are assigned again every frame, release the ones from the last frame.
+    const QVector<OutputLayer *> overlayLayers = m_backend->overlayLayers(output);
+    for (OutputLayer *overlayLayer : overlayLayers) {
+        overlayLayer->setEnabled(false);
+    }
+
     renderLoop->beginFrame();
     bool directScanout = false;
     if (scanoutCandidate) {
@@ -655,20 +763,47 @@ void Compositor::composite(RenderLoop *renderLoop)
         }
     }
 
+    QRegion overlayRegion;
+    if (!directScanout && !overlayLayers.isEmpty() && !output->directScanoutInhibited()) {
+        overlayRegion = assignOverlayLayers(superLayer, output, overlayLayers);
+    }
+
+    // The contents of the primary layer below the overlay layers are not kept up to date,
+    // repaint them once the overlay layers don't cover them anymore.
+    const QRegion uncoveredRegion = m_overlayRegions.value(renderLoop) - overlayRegion;
+    if (!uncoveredRegion.isEmpty()) {
+        outputLayer->addRepaint(uncoveredRegion);
+    }
+    m_overlayRegions[renderLoop] = overlayRegion;
+
+    // The GPU render time of a frame is read back when the next frame is rendered. If this
+    // frame isn't rendered, the measurement is dropped so it's not attributed to this frame.
+    bool renderTimeQueried = false;
     if (!directScanout) {
-        QRegion surfaceDamage = outputLayer->repaints();
+        RectRegion surfaceDamage(outputLayer->repaints());
         outputLayer->resetRepaints();
-        preparePaintPass(superLayer, &surfaceDamage);
+        surfaceDamage |= superLayer->takeRepaints();
+        surfaceDamage -= RectRegion(overlayRegion);
 
         if (auto beginInfo = outputLayer->beginFrame()) {
             auto &[renderTarget, repaint] = beginInfo.value();
             renderTarget.setDevicePixelRatio(output->scale());
 
-            const QRegion bufferDamage = surfaceDamage.united(repaint).intersected(superLayer->rect());
+            const QRegion bufferDamage = surfaceDamage.united(RectRegion(repaint)).intersected(superLayer->rect()).toQRegion();
             outputLayer->aboutToStartPainting(bufferDamage);
 
+            GLRenderTimeQuery *renderTimeQuery = beginRenderTimeQuery(renderLoop);
             paintPass(superLayer, &renderTarget, bufferDamage);
-            outputLayer->endFrame(bufferDamage, surfaceDamage);
+            outputLayer->endFrame(bufferDamage, surfaceDamage.toQRegion());
+            if (renderTimeQuery) {
+                renderTimeQuery->end();
+                renderTimeQueried = true;
+            }
+        }
+    }
+    if (!renderTimeQueried) {
+        if (const QSharedPointer<GLRenderTimeQuery> renderTimeQuery = m_renderTimeQueries.value(renderLoop)) {
+            renderTimeQuery->discard();
         }
     }
     renderLoop->endFrame();
@@ -676,8 +811,10 @@ void Compositor::composite(RenderLoop *renderLoop)
     postPaintPass(superLayer);
 
     m_backend->present(output);
+    renderLoop->notifyFrameSubmitted();
 
-    // TODO: Put it inside the cursor layer once the cursor layer can be backed by a real output layer.
+    // The cursor is shown either in the cursor output layer or in the primary layer, so it has
+    // been rendered as part of this frame in both cases.
     if (waylandServer()) {
         const std::chrono::milliseconds frameTime =
             std::chrono::duration_cast<std::chrono::milliseconds>(output->renderLoop()->lastPresentationTimestamp());
@@ -691,6 +828,60 @@ void Compositor::composite(RenderLoop *renderLoop)
     }
 }
 
+GLRenderTimeQuery *Compositor::beginRenderTimeQuery(RenderLoop *renderLoop)
+{
+    if (m_backend->compositingType() != OpenGLCompositing || !GLRenderTimeQuery::supported()) {
+        return nullptr;
+    }
+
+    QSharedPointer<GLRenderTimeQuery> &query = m_renderTimeQueries[renderLoop];
+    if (!query) {
+        query.reset(new GLRenderTimeQuery());
+    } else if (query->isPending()) {
+        // The previous frame has been presented by now, so the GPU is done with it and
+        // reading the result back doesn't stall.
+        if (const auto renderTime = query->result()) {
+            renderLoop->setGpuRenderTime(*renderTime);
+        }
+    }
+
+    query->begin();
+    return query.data();
+}
+
+QRegion Compositor::assignOverlayLayers(RenderLayer *superLayer, Output *output, const QVector<OutputLayer *> &overlayLayers)
+{
+    // The sublayers, e.g. the software cursor, are composited on top of the primary layer.
+    // Surfaces below them can't be moved to overlay layers.
+    QRegion blocked;
+    const auto sublayers = superLayer->sublayers();
+    for (RenderLayer *sublayer : sublayers) {
+        if (sublayer->isVisible()) {
+            blocked += sublayer->mapToGlobal(sublayer->rect());
+        }
+    }
+
+    QRegion overlayRegion;
+    int nextLayer = 0;
+    const QVector<SurfaceItem *> candidates = superLayer->delegate()->overlayCandidates();
+    for (SurfaceItem *candidate : candidates) {
+        if (nextLayer == overlayLayers.size()) {
+            break;
+        }
+        const QRect rect = candidate->mapToGlobal(candidate->rect()).translated(-output->geometry().topLeft());
+        if (blocked.intersects(rect)) {
+            continue;
+        }
+        // Every successful scanout is tested together with the layers that have already
+        // been assigned, so a failure only affects this candidate.
+        if (overlayLayers[nextLayer]->scanout(candidate)) {
+            overlayRegion += rect;
+            nextLayer++;
+        }
+    }
+    return overlayRegion;
+}
+
 void Compositor::prePaintPass(RenderLayer *layer)
 {
     layer->delegate()->prePaint();
@@ -709,19 +900,6 @@ void Compositor::postPaintPass(RenderLayer *layer)
     }
 }
 
-void Compositor::preparePaintPass(RenderLayer *layer, QRegion *repaint)
-{
-    // TODO: Cull opaque region.
-    *repaint += layer->mapToGlobal(layer->repaints() + layer->delegate()->repaints());
-    layer->resetRepaints();
-    const auto sublayers = layer->sublayers();
-    for (RenderLayer *sublayer : sublayers) {
-        if (sublayer->isVisible()) {
-            preparePaintPass(sublayer, repaint);
-        }
-    }
-}
-
 void Compositor::paintPass(RenderLayer *layer, RenderTarget *target, const QRegion &region)
 {
     layer->delegate()->paint(target, region);
@@ -13,14 +13,18 @@
 
 #include <QObject>
 #include <QRegion>
+#include <QSharedPointer>
 #include <QTimer>
 
 namespace KWin
 {
 
 class Output;
+class OutputLayer;
 class CompositorSelectionOwner;
 class CursorView;
+class GLRenderTimeQuery;
+class RectRegion;
 class RenderBackend;
 class RenderLayer;
 class RenderLoop;
@@ -142,10 +146,11 @@ private:
     void addSuperLayer(RenderLayer *layer);
     void removeSuperLayer(RenderLayer *layer);
 
+    QRegion assignOverlayLayers(RenderLayer *superLayer, Output *output, const QVector<OutputLayer *> &overlayLayers);
     void prePaintPass(RenderLayer *layer);
     void postPaintPass(RenderLayer *layer);
-    void preparePaintPass(RenderLayer *layer, QRegion *repaint);
     void paintPass(RenderLayer *layer, RenderTarget *target, const QRegion &region);
+    GLRenderTimeQuery *beginRenderTimeQuery(RenderLoop *renderLoop);
 
     State m_state = State::Off;
     CompositorSelectionOwner *m_selectionOwner = nullptr;
@@ -155,6 +160,8 @@ private:
     Scene *m_scene = nullptr;
     RenderBackend *m_backend = nullptr;
     QHash<RenderLoop *, RenderLayer *> m_superlayers;
+    QHash<RenderLoop *, QRegion> m_overlayRegions;
+    QHash<RenderLoop *, QSharedPointer<GLRenderTimeQuery>> m_renderTimeQueries;
 };
 
 class KWIN_EXPORT WaylandCompositor final : public Compositor
@@ -29,6 +29,8 @@
 
 #include <xcb/xcb_cursor.h>
 
+#include <cmath>
+
 namespace KWin
 {
 Cursors *Cursors::s_self = nullptr;
@@ -213,10 +215,79 @@ void Cursor::setPos(int x, int y)
     setPos(QPoint(x, y));
 }
 
+QRegion Cursor::opaqueRegion() const
+{
+    return m_opaqueRegion;
+}
+
+static QRegion computeOpaqueRegion(const QImage &image)
+{
+    if (image.isNull()) {
+        return QRegion();
+    }
+    const qreal scale = image.devicePixelRatio();
+    if (!image.hasAlphaChannel()) {
+        return QRect(QPoint(0, 0), image.size() / scale);
+    }
+
+    QImage pixels = image;
+    if (pixels.format() != QImage::Format_ARGB32 && pixels.format() != QImage::Format_ARGB32_Premultiplied) {
+        pixels = pixels.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    // Scan every row for runs of opaque pixels, runs that are the same in consecutive rows
+    // are merged, so typical cursors end up with a handful of rectangles. The rectangles are
+    // shrunk to whole logical pixels so they never cover translucent pixels.
+    QRegion region;
+    QVector<QRect> band;
+    QVector<QRect> row;
+    auto flush = [&]() {
+        for (const QRect &rect : qAsConst(band)) {
+            const QRect logical(QPoint(std::ceil(rect.left() / scale), std::ceil(rect.top() / scale)),
+                                QPoint(std::floor((rect.right() + 1) / scale) - 1, std::floor((rect.bottom() + 1) / scale) - 1));
+            if (logical.isValid()) {
+                region += logical;
+            }
+        }
+        band.clear();
+    };
+    for (int y = 0; y < pixels.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(pixels.constScanLine(y));
+        row.clear();
+        for (int x = 0; x < pixels.width();) {
+            if (qAlpha(line[x]) != 0xff) {
+                ++x;
+                continue;
+            }
+            const int start = x;
+            while (x < pixels.width() && qAlpha(line[x]) == 0xff) {
+                ++x;
+            }
+            row.append(QRect(start, y, x - start, 1));
+        }
+
+        bool sameRuns = row.count() == band.count();
+        for (int i = 0; sameRuns && i < row.count(); ++i) {
+            sameRuns = row[i].left() == band[i].left() && row[i].right() == band[i].right();
+        }
+        if (sameRuns) {
+            for (QRect &rect : band) {
+                rect.setBottom(y);
+            }
+        } else {
+            flush();
+            band = row;
+        }
+    }
+    flush();
+    return region;
+}
+
 void Cursor::updateCursor(const QImage &image, const QPoint &hotspot)
 {
     m_image = image;
     m_hotspot = hotspot;
+    m_opaqueRegion = computeOpaqueRegion(image);
     Q_EMIT cursorChanged();
 }
 
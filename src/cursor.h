@@ -14,6 +14,7 @@
 #include <QHash>
 #include <QObject>
 #include <QPoint>
+#include <QRegion>
 // KF
 #include <KSharedConfig>
 // xcb
@@ -180,6 +181,12 @@ public:
     QRect geometry() const;
     QRect rect() const;
 
+    /**
+     * Returns the part of the cursor that is covered by fully opaque pixels, in the cursor's
+     * local coordinates.
+     */
+    QRegion opaqueRegion() const;
+
     /**
      * Returns @c true if the cursor is visible on the given output; otherwise returns @c false.
      */
@@ -260,6 +267,7 @@ private:
     QPoint m_pos;
     QPoint m_hotspot;
     QImage m_image;
+    QRegion m_opaqueRegion;
     int m_mousePollingCounter;
     int m_cursorTrackingCounter;
     QString m_themeName;
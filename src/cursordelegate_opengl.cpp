@@ -17,12 +17,21 @@ namespace KWin
 CursorDelegateOpenGL::CursorDelegateOpenGL(QObject *parent)
     : RenderLayerDelegate(parent)
 {
+    // handle shape update on case cursor image changed
+    connect(Cursors::self(), &Cursors::currentCursorChanged, this, [this]() {
+        m_cursorTextureDirty = true;
+    });
 }
 
 CursorDelegateOpenGL::~CursorDelegateOpenGL()
 {
 }
 
+QRegion CursorDelegateOpenGL::opaque() const
+{
+    return Cursors::self()->currentCursor()->opaqueRegion();
+}
+
 void CursorDelegateOpenGL::paint(RenderTarget *renderTarget, const QRegion &region)
 {
     if (!region.intersects(layer()->mapToGlobal(layer()->rect()))) {
@@ -40,14 +49,9 @@ void CursorDelegateOpenGL::paint(RenderTarget *renderTarget, const QRegion &regi
         m_cursorTextureDirty = false;
     };
 
-    // lazy init texture cursor only in case we need software rendering
+    // lazy init texture cursor only in case we need to paint the cursor
     if (!m_cursorTexture) {
         allocateTexture();
-
-        // handle shape update on case cursor image changed
-        connect(Cursors::self(), &Cursors::currentCursorChanged, this, [this]() {
-            m_cursorTextureDirty = true;
-        });
     } else if (m_cursorTextureDirty) {
         const QImage image = Cursors::self()->currentCursor()->image();
         if (image.size() == m_cursorTexture->size()) {
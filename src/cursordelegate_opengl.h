@@ -21,6 +21,7 @@ public:
     explicit CursorDelegateOpenGL(QObject *parent = nullptr);
     ~CursorDelegateOpenGL() override;
 
+    QRegion opaque() const override;
     void paint(RenderTarget *renderTarget, const QRegion &region) override;
 
 private:
@@ -19,6 +19,11 @@ CursorDelegateQPainter::CursorDelegateQPainter(QObject *parent)
 {
 }
 
+QRegion CursorDelegateQPainter::opaque() const
+{
+    return Cursors::self()->currentCursor()->opaqueRegion();
+}
+
 void CursorDelegateQPainter::paint(RenderTarget *renderTarget, const QRegion &region)
 {
     if (!region.intersects(layer()->mapToGlobal(layer()->rect()))) {
@@ -18,6 +18,7 @@ class CursorDelegateQPainter final : public RenderLayerDelegate
 public:
     explicit CursorDelegateQPainter(QObject *parent = nullptr);
 
+    QRegion opaque() const override;
     void paint(RenderTarget *renderTarget, const QRegion &region) override;
 };
 
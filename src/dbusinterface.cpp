@@ -17,6 +17,7 @@
 #include "atoms.h"
 #include "composite.h"
 #include "debug_console.h"
+#include "frametimeline.h"
 #include "kwinadaptor.h"
 #include "main.h"
 #include "output.h"
@@ -24,6 +25,7 @@
 #include "platform.h"
 #include "pluginmanager.h"
 #include "renderbackend.h"
+#include "renderloop.h"
 #include "unmanaged.h"
 #include "virtualdesktops.h"
 #include "window.h"
@@ -34,6 +36,8 @@
 
 // Qt
 #include <QDBusServiceWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QOpenGLContext>
 
 namespace KWin
@@ -265,6 +269,70 @@ QVariantMap DBusInterface::getWindowInfo(const QString &uuid)
     }
 }
 
+static QVariantMap frameToVariantMap(const FrameTimelineEntry &frame)
+{
+    QVariantMap map{
+        {QStringLiteral("frame"), frame.frame},
+        {QStringLiteral("targetPresentationTimestamp"), qint64(frame.targetPresentationTimestamp.count())},
+        {QStringLiteral("startTimestamp"), qint64(frame.startTimestamp.count())},
+        {QStringLiteral("prePaintTime"), qint64((frame.renderStartTimestamp - frame.startTimestamp).count())},
+        {QStringLiteral("renderTime"), qint64((frame.renderEndTimestamp - frame.renderStartTimestamp).count())},
+        {QStringLiteral("submitTime"), qint64((frame.submitTimestamp - frame.renderEndTimestamp).count())},
+        {QStringLiteral("textureUploadSize"), frame.textureUploadSize},
+        {QStringLiteral("failed"), frame.failed},
+    };
+    if (frame.gpuRenderTime) {
+        map.insert(QStringLiteral("gpuRenderTime"), qint64(frame.gpuRenderTime->count()));
+    }
+    if (!frame.failed) {
+        map.insert(QStringLiteral("presentationTimestamp"), qint64(frame.presentationTimestamp.count()));
+        map.insert(QStringLiteral("presentationLatency"), qint64((frame.presentationTimestamp - frame.submitTimestamp).count()));
+        map.insert(QStringLiteral("missedVblanks"), frame.missedVblanks);
+        if (frame.presentationSequence) {
+            map.insert(QStringLiteral("sequence"), frame.presentationSequence);
+        }
+    }
+    return map;
+}
+
+QVariantList DBusInterface::frameTimeline(const QString &outputName)
+{
+    Output *output = kwinApp()->platform()->findOutput(outputName);
+    if (!output || !output->isEnabled()) {
+        sendErrorReply(QStringLiteral("org.kde.KWin.Error.InvalidOutput"),
+                       QStringLiteral("There is no enabled output called %1").arg(outputName));
+        return {};
+    }
+
+    QVariantList frames;
+    const QVector<FrameTimelineEntry> entries = output->renderLoop()->frameTimeline()->entries();
+    for (const FrameTimelineEntry &entry : entries) {
+        frames.append(frameToVariantMap(entry));
+    }
+    return frames;
+}
+
+QString DBusInterface::frameTrace()
+{
+    // Every output gets a track for the CPU and another one for the GPU.
+    QJsonArray events;
+    int trackId = 1;
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    for (Output *output : outputs) {
+        const QJsonArray outputEvents = output->renderLoop()->frameTimeline()->traceEvents(output->name(), trackId);
+        for (const QJsonValue &event : outputEvents) {
+            events.append(event);
+        }
+        trackId += 2;
+    }
+
+    const QJsonObject trace{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    return QString::fromUtf8(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+}
+
 CompositorDBusInterface::CompositorDBusInterface(Compositor *parent)
     : QObject(parent)
     , m_compositor(parent)
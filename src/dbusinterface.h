@@ -86,6 +86,22 @@ public Q_SLOTS: // METHODS
      */
     QVariantMap getWindowInfo(const QString &uuid);
 
+    /**
+     * Returns the timings of the recently presented frames of the output with the
+     * specified @a outputName, from the oldest to the newest frame.
+     *
+     * Every frame is described by a map with timestamps from the monotonic clock and
+     * durations, both in nanoseconds, the number of missed vblanks, the number of bytes
+     * of uploaded texture data, etc.
+     */
+    QVariantList frameTimeline(const QString &outputName);
+
+    /**
+     * Returns the timings of the recently presented frames of all outputs in the Chrome
+     * trace event format, which can be loaded in chrome://tracing or ui.perfetto.dev.
+     */
+    QString frameTrace();
+
 private Q_SLOTS:
     void becomeKWinService(const QString &service);
 
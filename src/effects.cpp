@@ -27,6 +27,7 @@
 #include "pointer_input.h"
 #include "renderbackend.h"
 #include "renderlayer.h"
+#include "renderloop.h"
 #include "unmanaged.h"
 #include "x11window.h"
 #if KWIN_BUILD_TABBOX
@@ -1257,6 +1258,11 @@ void EffectsHandlerImpl::addRepaint(int x, int y, int w, int h)
     m_compositor->scene()->addRepaint(x, y, w, h);
 }
 
+void EffectsHandlerImpl::scheduleRepaint(EffectScreen *screen)
+{
+    static_cast<EffectScreenImpl *>(screen)->platformOutput()->renderLoop()->scheduleRepaint();
+}
+
 EffectScreen *EffectsHandlerImpl::activeScreen() const
 {
     return EffectScreenImpl::get(workspace()->activeOutput());
@@ -2490,7 +2496,7 @@ EffectFrameImpl::EffectFrameImpl(EffectFrameStyle style, bool staticSize, QPoint
     , m_view(new EffectFrameQuickScene(style, staticSize, position, alignment, nullptr))
 {
     connect(m_view, &OffscreenQuickScene::repaintNeeded, this, [this] {
-        effects->addRepaint(geometry());
+        effects->addRepaint(m_view->damage().translated(m_view->geometry().topLeft()));
     });
     connect(m_view, &OffscreenQuickScene::geometryChanged, this, [this](const QRect &oldGeometry, const QRect &newGeometry) {
         effects->addRepaint(oldGeometry);
@@ -136,6 +136,7 @@ public:
     void addRepaint(const QRect &r) override;
     void addRepaint(const QRegion &r) override;
     void addRepaint(int x, int y, int w, int h) override;
+    void scheduleRepaint(EffectScreen *screen) override;
     EffectScreen *activeScreen() const override;
     QRect clientArea(clientAreaOption, const EffectScreen *screen, int desktop) const override;
     QRect clientArea(clientAreaOption, const EffectWindow *c) const override;
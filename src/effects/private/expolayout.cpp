@@ -10,6 +10,9 @@
 
 #include "expolayout.h"
 
+#include <QHash>
+
+#include <algorithm>
 #include <cmath>
 
 ExpoCell::ExpoCell(QObject *parent)
@@ -456,28 +459,119 @@ static inline int heightForWidth(ExpoCell *cell, int width)
     return int((width / qreal(cell->naturalWidth())) * cell->naturalHeight());
 }
 
-static bool isOverlappingAny(ExpoCell *w, const QHash<ExpoCell *, QRect> &targets, const QRegion &border, int spacing)
+// The layout normally converges long before that, this only guards against pathological cases,
+// e.g. hundreds of windows with the same geometry.
+static const int s_maxIterations = 1000;
+
+static inline int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * The LayoutGrid class is a broadphase for the overlap tests in the natural layout.
+ *
+ * The layout area is split in square tiles, and every tile lists the cells that overlap it,
+ * so every cell is only tested against the cells that are close to it.
+ */
+class LayoutGrid
 {
-    QHash<ExpoCell *, QRect>::const_iterator winTarget = targets.find(w);
-    if (winTarget == targets.constEnd()) {
-        return false;
+public:
+    LayoutGrid(int tileSize, int cellCount)
+        : m_tileSize(std::max(1, tileSize))
+        , m_visited(cellCount, 0)
+    {
+    }
+
+    void insert(int index, const QRect &rect)
+    {
+        const QRect range = tileRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                m_tiles[key(x, y)].append(index);
+            }
+        }
     }
-    if (border.intersects(*winTarget)) {
-        return true;
+
+    void remove(int index, const QRect &rect)
+    {
+        const QRect range = tileRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                auto it = m_tiles.find(key(x, y));
+                if (it != m_tiles.end()) {
+                    it->removeOne(index);
+                    if (it->isEmpty()) {
+                        m_tiles.erase(it);
+                    }
+                }
+            }
+        }
     }
-    const QMargins halfSpacing(spacing / 2, spacing / 2, spacing / 2, spacing / 2);
 
-    // Is there a better way to do this?
-    QHash<ExpoCell *, QRect>::const_iterator target;
-    for (target = targets.constBegin(); target != targets.constEnd(); ++target) {
-        if (target == winTarget) {
-            continue;
+    void move(int index, const QRect &from, const QRect &to)
+    {
+        if (tileRange(from) != tileRange(to)) {
+            remove(index, from);
+            insert(index, to);
         }
-        if (winTarget->marginsAdded(halfSpacing).intersects(target->marginsAdded(halfSpacing))) {
-            return true;
+    }
+
+    /**
+     * Returns the cells that may overlap the given @a rect, except the cell at @a index, in
+     * ascending order so the layout doesn't depend on the order in which tiles are visited.
+     */
+    const QVector<int> &query(int index, const QRect &rect)
+    {
+        m_candidates.clear();
+        ++m_query;
+
+        const QRect range = tileRange(rect);
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const auto it = m_tiles.constFind(key(x, y));
+                if (it == m_tiles.constEnd()) {
+                    continue;
+                }
+                for (int candidate : *it) {
+                    if (candidate != index && m_visited[candidate] != m_query) {
+                        m_visited[candidate] = m_query;
+                        m_candidates.append(candidate);
+                    }
+                }
+            }
         }
+
+        std::sort(m_candidates.begin(), m_candidates.end());
+        return m_candidates;
+    }
+
+private:
+    static quint64 key(int x, int y)
+    {
+        return (quint64(quint32(x)) << 32) | quint32(y);
+    }
+
+    QRect tileRange(const QRect &rect) const
+    {
+        return QRect(QPoint(floorDiv(rect.left(), m_tileSize), floorDiv(rect.top(), m_tileSize)),
+                     QPoint(floorDiv(rect.right(), m_tileSize), floorDiv(rect.bottom(), m_tileSize)));
+    }
+
+    int m_tileSize;
+    QHash<quint64, QVector<int>> m_tiles;
+    QVector<quint32> m_visited;
+    QVector<int> m_candidates;
+    quint32 m_query = 0;
+};
+
+static int averageTileSize(const QVector<QRect> &rects)
+{
+    qint64 size = 0;
+    for (const QRect &rect : rects) {
+        size += std::max(rect.width(), rect.height());
     }
-    return false;
+    return rects.isEmpty() ? 1 : int(size / rects.count());
 }
 
 void ExpoLayout::calculateWindowTransformationsNatural()
@@ -490,104 +584,118 @@ void ExpoLayout::calculateWindowTransformationsNatural()
         return a->persistentKey() < b->persistentKey();
     });
 
+    const int cellCount = m_cells.count();
     QRect bounds;
-    int direction = 0;
-    QHash<ExpoCell *, QRect> targets;
-    QHash<ExpoCell *, int> directions;
+    QVector<QRect> targets;
+    targets.reserve(cellCount);
 
     for (ExpoCell *cell : qAsConst(m_cells)) {
         const QRect cellRect(cell->naturalX(), cell->naturalY(), cell->naturalWidth(), cell->naturalHeight());
-        targets[cell] = cellRect;
-        // Reuse the unused "slot" as a preferred direction attribute. This is used when the window
-        // is on the edge of the screen to try to use as much screen real estate as possible.
-        directions[cell] = direction;
+        targets.append(cellRect);
         bounds = bounds.united(cellRect);
-        direction++;
-        if (direction == 4) {
-            direction = 0;
-        }
     }
 
-    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
-    // brute-force the most optimal positions over many iterations.
+    // The index of a cell modulo 4 is used as its preferred direction. This is used when the
+    // window is on the edge of the screen to try to use as much screen real estate as possible.
+    auto direction = [](int index) {
+        return index % 4;
+    };
+
     const int halfSpacing = m_spacing / 2;
+    const QMargins halfSpacingMargins(halfSpacing, halfSpacing, halfSpacing, halfSpacing);
+
+    LayoutGrid grid(averageTileSize(targets) + m_spacing, cellCount);
+    for (int i = 0; i < cellCount; ++i) {
+        grid.insert(i, targets[i].marginsAdded(halfSpacingMargins));
+    }
+
+    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations. The candidates are
+    // looked up before the windows are pushed, windows that start overlapping because of
+    // that are handled in the next iteration.
     bool overlap;
+    int iteration = 0;
     do {
         overlap = false;
-        for (ExpoCell *cell : qAsConst(m_cells)) {
-            QRect *target_w = &targets[cell];
-            for (ExpoCell *e : qAsConst(m_cells)) {
-                if (cell == e) {
+        for (int i = 0; i < cellCount; ++i) {
+            QRect &target_w = targets[i];
+            const QVector<int> &candidates = grid.query(i, target_w.marginsAdded(halfSpacingMargins));
+            for (int j : candidates) {
+                QRect &target_e = targets[j];
+                if (!target_w.marginsAdded(halfSpacingMargins).intersects(target_e.marginsAdded(halfSpacingMargins))) {
                     continue;
                 }
+                overlap = true;
 
-                QRect *target_e = &targets[e];
-                if (target_w->adjusted(-halfSpacing, -halfSpacing, halfSpacing, halfSpacing)
-                        .intersects(target_e->adjusted(-halfSpacing, -halfSpacing, halfSpacing, halfSpacing))) {
-                    overlap = true;
+                const QRect oldTarget_w = target_w;
+                const QRect oldTarget_e = target_e;
 
-                    // Determine pushing direction
-                    QPoint diff(target_e->center() - target_w->center());
-                    // Prevent dividing by zero and non-movement
-                    if (diff.x() == 0 && diff.y() == 0) {
-                        diff.setX(1);
-                    }
-                    // Try to keep screen aspect ratio
-                    // if (bounds.height() / bounds.width() > area.height() / area.width())
-                    //    diff.setY(diff.y() / 2);
-                    // else
-                    //    diff.setX(diff.x() / 2);
-                    // Approximate a vector of between 10px and 20px in magnitude in the same direction
-                    diff *= m_accuracy / qreal(diff.manhattanLength());
-                    // Move both windows apart
-                    target_w->translate(-diff);
-                    target_e->translate(diff);
-
-                    // Try to keep the bounding rect the same aspect as the screen so that more
-                    // screen real estate is utilised. We do this by splitting the screen into nine
-                    // equal sections, if the window center is in any of the corner sections pull the
-                    // window towards the outer corner. If it is in any of the other edge sections
-                    // alternate between each corner on that edge. We don't want to determine it
-                    // randomly as it will not produce consistant locations when using the filter.
-                    // Only move one window so we don't cause large amounts of unnecessary zooming
-                    // in some situations. We need to do this even when expanding later just in case
-                    // all windows are the same size.
-                    // (We are using an old bounding rect for this, hopefully it doesn't matter)
-                    int xSection = (target_w->x() - bounds.x()) / (bounds.width() / 3);
-                    int ySection = (target_w->y() - bounds.y()) / (bounds.height() / 3);
-                    diff = QPoint(0, 0);
-                    if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
-                        if (xSection == 1) {
-                            xSection = (directions[cell] / 2 ? 2 : 0);
-                        }
-                        if (ySection == 1) {
-                            ySection = (directions[cell] % 2 ? 2 : 0);
-                        }
-                    }
-                    if (xSection == 0 && ySection == 0) {
-                        diff = QPoint(bounds.topLeft() - target_w->center());
-                    }
-                    if (xSection == 2 && ySection == 0) {
-                        diff = QPoint(bounds.topRight() - target_w->center());
-                    }
-                    if (xSection == 2 && ySection == 2) {
-                        diff = QPoint(bounds.bottomRight() - target_w->center());
-                    }
-                    if (xSection == 0 && ySection == 2) {
-                        diff = QPoint(bounds.bottomLeft() - target_w->center());
+                // Determine pushing direction
+                QPoint diff(target_e.center() - target_w.center());
+                // Prevent dividing by zero and non-movement
+                if (diff.x() == 0 && diff.y() == 0) {
+                    diff.setX(1);
+                }
+                // Approximate a vector of between 10px and 20px in magnitude in the same direction
+                diff *= m_accuracy / qreal(diff.manhattanLength());
+                // Move both windows apart
+                target_w.translate(-diff);
+                target_e.translate(diff);
+
+                // Try to keep the bounding rect the same aspect as the screen so that more
+                // screen real estate is utilised. We do this by splitting the screen into nine
+                // equal sections, if the window center is in any of the corner sections pull the
+                // window towards the outer corner. If it is in any of the other edge sections
+                // alternate between each corner on that edge. We don't want to determine it
+                // randomly as it will not produce consistant locations when using the filter.
+                // Only move one window so we don't cause large amounts of unnecessary zooming
+                // in some situations. We need to do this even when expanding later just in case
+                // all windows are the same size.
+                // (We are using an old bounding rect for this, hopefully it doesn't matter)
+                int xSection = (target_w.x() - bounds.x()) / (bounds.width() / 3);
+                int ySection = (target_w.y() - bounds.y()) / (bounds.height() / 3);
+                diff = QPoint(0, 0);
+                if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+                    if (xSection == 1) {
+                        xSection = (direction(i) / 2 ? 2 : 0);
                     }
-                    if (diff.x() != 0 || diff.y() != 0) {
-                        diff *= m_accuracy / qreal(diff.manhattanLength());
-                        target_w->translate(diff);
+                    if (ySection == 1) {
+                        ySection = (direction(i) % 2 ? 2 : 0);
                     }
-
-                    // Update bounding rect
-                    bounds = bounds.united(*target_w);
-                    bounds = bounds.united(*target_e);
                 }
+                if (xSection == 0 && ySection == 0) {
+                    diff = QPoint(bounds.topLeft() - target_w.center());
+                }
+                if (xSection == 2 && ySection == 0) {
+                    diff = QPoint(bounds.topRight() - target_w.center());
+                }
+                if (xSection == 2 && ySection == 2) {
+                    diff = QPoint(bounds.bottomRight() - target_w.center());
+                }
+                if (xSection == 0 && ySection == 2) {
+                    diff = QPoint(bounds.bottomLeft() - target_w.center());
+                }
+                if (diff.x() != 0 || diff.y() != 0) {
+                    diff *= m_accuracy / qreal(diff.manhattanLength());
+                    target_w.translate(diff);
+                }
+
+                grid.move(i, oldTarget_w.marginsAdded(halfSpacingMargins), target_w.marginsAdded(halfSpacingMargins));
+                grid.move(j, oldTarget_e.marginsAdded(halfSpacingMargins), target_e.marginsAdded(halfSpacingMargins));
+
+                // Update bounding rect
+                bounds = bounds.united(target_w);
+                bounds = bounds.united(target_e);
             }
         }
-    } while (overlap);
+    } while (overlap && ++iteration < s_maxIterations);
+
+    // The windows may still overlap if the iteration cap has been hit, use the grid layout
+    // instead, which never places windows on top of each other.
+    if (overlap) {
+        calculateWindowTransformationsClosest();
+        return;
+    }
 
     // Compute the scale factor so the bounding rect fits the target area.
     qreal scale;
@@ -605,30 +713,47 @@ void ExpoLayout::calculateWindowTransformationsNatural()
                    area.height() / scale);
 
     // Move all windows back onto the screen and set their scale
-    QHash<ExpoCell *, QRect>::iterator target = targets.begin();
-    while (target != targets.end()) {
-        target->setRect((target->x() - bounds.x()) * scale + area.x(),
-                        (target->y() - bounds.y()) * scale + area.y(),
-                        target->width() * scale,
-                        target->height() * scale);
-        ++target;
+    for (QRect &target : targets) {
+        target.setRect((target.x() - bounds.x()) * scale + area.x(),
+                       (target.y() - bounds.y()) * scale + area.y(),
+                       target.width() * scale,
+                       target.height() * scale);
     }
 
     // Try to fill the gaps by enlarging windows if they have the space
     if (m_fillGaps) {
+        LayoutGrid gapGrid(averageTileSize(targets) + m_spacing, cellCount);
+        for (int i = 0; i < cellCount; ++i) {
+            gapGrid.insert(i, targets[i].marginsAdded(halfSpacingMargins));
+        }
+
         // Don't expand onto or over the border
-        QRegion borderRegion(area.adjusted(-200, -200, 200, 200));
-        borderRegion ^= area;
+        auto isOverlappingAny = [&](int index) {
+            const QRect rect = targets[index].marginsAdded(halfSpacingMargins);
+            if (!area.contains(targets[index])) {
+                return true;
+            }
+            const QVector<int> &candidates = gapGrid.query(index, rect);
+            for (int candidate : candidates) {
+                if (rect.intersects(targets[candidate].marginsAdded(halfSpacingMargins))) {
+                    return true;
+                }
+            }
+            return false;
+        };
 
         bool moved;
+        iteration = 0;
         do {
             moved = false;
-            for (ExpoCell *cell : qAsConst(m_cells)) {
+            for (int i = 0; i < cellCount; ++i) {
+                ExpoCell *cell = m_cells[i];
+                QRect &target = targets[i];
+                const QRect initialRect = target;
                 QRect oldRect;
-                QRect *target = &targets[cell];
                 // This may cause some slight distortion if the windows are enlarged a large amount
                 int widthDiff = m_accuracy;
-                int heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
+                int heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
                 int xDiff = widthDiff / 2; // Also move a bit in the direction of the enlarge, allows the
                 int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
 
@@ -636,79 +761,83 @@ void ExpoLayout::calculateWindowTransformationsNatural()
                 // so that the error introduced in the window's aspect ratio is minimized
 
                 // Attempt enlarging to the top-right
-                oldRect = *target;
-                target->setRect(target->x() + xDiff,
-                                target->y() - yDiff - heightDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
+                oldRect = target;
+                target.setRect(target.x() + xDiff,
+                               target.y() - yDiff - heightDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
                 } else {
                     moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
                     yDiff = heightDiff / 2;
                 }
 
                 // Attempt enlarging to the bottom-right
-                oldRect = *target;
-                target->setRect(target->x() + xDiff,
-                                target->y() + yDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
+                oldRect = target;
+                target.setRect(target.x() + xDiff,
+                               target.y() + yDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
                 } else {
                     moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
                     yDiff = heightDiff / 2;
                 }
 
                 // Attempt enlarging to the bottom-left
-                oldRect = *target;
-                target->setRect(target->x() - xDiff - widthDiff,
-                                target->y() + yDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
+                oldRect = target;
+                target.setRect(target.x() - xDiff - widthDiff,
+                               target.y() + yDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
                 } else {
                     moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
                     yDiff = heightDiff / 2;
                 }
 
                 // Attempt enlarging to the top-left
-                oldRect = *target;
-                target->setRect(target->x() - xDiff - widthDiff,
-                                target->y() - yDiff - heightDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
+                oldRect = target;
+                target.setRect(target.x() - xDiff - widthDiff,
+                               target.y() - yDiff - heightDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
                 } else {
                     moved = true;
                 }
+
+                gapGrid.move(i, initialRect.marginsAdded(halfSpacingMargins), target.marginsAdded(halfSpacingMargins));
             }
-        } while (moved);
+        } while (moved && ++iteration < s_maxIterations);
 
         // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
         // We can't add this to the loop above as it would cause a never-ending loop so we have to make
         // do with the less-than-optimal space usage with using this method.
-        for (ExpoCell *cell : qAsConst(m_cells)) {
-            QRect *target = &targets[cell];
-            qreal scale = target->width() / qreal(cell->naturalWidth());
+        for (int i = 0; i < cellCount; ++i) {
+            ExpoCell *cell = m_cells[i];
+            QRect &target = targets[i];
+            qreal scale = target.width() / qreal(cell->naturalWidth());
             if (scale > 2.0 || (scale > 1.0 && (cell->naturalWidth() > 300 || cell->naturalHeight() > 300))) {
                 scale = (cell->naturalWidth() > 300 || cell->naturalHeight() > 300) ? 1.0 : 2.0;
-                target->setRect(target->center().x() - int(cell->naturalWidth() * scale) / 2,
-                                target->center().y() - int(cell->naturalHeight() * scale) / 2,
-                                cell->naturalWidth() * scale,
-                                cell->naturalHeight() * scale);
+                target.setRect(target.center().x() - int(cell->naturalWidth() * scale) / 2,
+                               target.center().y() - int(cell->naturalHeight() * scale) / 2,
+                               cell->naturalWidth() * scale,
+                               cell->naturalHeight() * scale);
             }
         }
     }
 
-    for (ExpoCell *cell : qAsConst(m_cells)) {
-        const QRect rect = centered(cell, targets.value(cell).marginsRemoved(cell->margins()));
+    for (int i = 0; i < cellCount; ++i) {
+        ExpoCell *cell = m_cells[i];
+        const QRect rect = centered(cell, targets[i].marginsRemoved(cell->margins()));
 
         cell->setX(rect.x());
         cell->setY(rect.y());
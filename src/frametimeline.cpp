@@ -0,0 +1,172 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "frametimeline.h"
+
+#include <QJsonObject>
+
+namespace KWin
+{
+
+// The number of attempts to read a slot that is being written at the same time.
+static const int s_readAttempts = 3;
+
+void FrameTimeline::write(Slot *slot, const FrameTimelineEntry &entry)
+{
+    // The version is odd while the slot is being written.
+    const quint32 version = slot->version.load(std::memory_order_relaxed);
+    slot->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->entry = entry;
+    slot->version.store(version + 2, std::memory_order_release);
+}
+
+bool FrameTimeline::read(const Slot *slot, FrameTimelineEntry *entry) const
+{
+    for (int i = 0; i < s_readAttempts; ++i) {
+        const quint32 version = slot->version.load(std::memory_order_acquire);
+        if (version & 1) {
+            continue;
+        }
+        *entry = slot->entry;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->version.load(std::memory_order_relaxed) == version) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameTimeline::append(const FrameTimelineEntry &entry)
+{
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    write(&m_slots[head % capacity], entry);
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void FrameTimeline::setGpuRenderTime(quint64 frame, std::chrono::nanoseconds renderTime)
+{
+    // The GPU render time is known shortly after the frame has been presented, so only the
+    // most recent entries need to be checked.
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    for (quint64 i = head; i > 0 && head - i < 4; --i) {
+        Slot *slot = &m_slots[(i - 1) % capacity];
+        if (slot->entry.frame == frame) {
+            FrameTimelineEntry entry = slot->entry;
+            entry.gpuRenderTime = renderTime;
+            write(slot, entry);
+            return;
+        }
+    }
+}
+
+QVector<FrameTimelineEntry> FrameTimeline::entries() const
+{
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 tail = head > quint64(capacity) ? head - capacity : 0;
+
+    QVector<FrameTimelineEntry> entries;
+    entries.reserve(head - tail);
+    for (quint64 i = tail; i < head; ++i) {
+        FrameTimelineEntry entry;
+        if (!read(&m_slots[i % capacity], &entry)) {
+            continue;
+        }
+        // The writer may have wrapped around while the timeline was being read.
+        if (!entries.isEmpty() && entries.constLast().frame >= entry.frame) {
+            continue;
+        }
+        entries.append(entry);
+    }
+    return entries;
+}
+
+static double toMicroseconds(std::chrono::nanoseconds timestamp)
+{
+    return timestamp.count() / 1000.0;
+}
+
+static QJsonObject durationEvent(const QString &name, int trackId, std::chrono::nanoseconds start, std::chrono::nanoseconds end)
+{
+    return QJsonObject{
+        {QStringLiteral("name"), name},
+        {QStringLiteral("cat"), QStringLiteral("frame")},
+        {QStringLiteral("ph"), QStringLiteral("X")},
+        {QStringLiteral("pid"), 1},
+        {QStringLiteral("tid"), trackId},
+        {QStringLiteral("ts"), toMicroseconds(start)},
+        {QStringLiteral("dur"), toMicroseconds(std::max(end - start, std::chrono::nanoseconds::zero()))},
+    };
+}
+
+static QJsonObject trackNameEvent(const QString &name, int trackId)
+{
+    return QJsonObject{
+        {QStringLiteral("name"), QStringLiteral("thread_name")},
+        {QStringLiteral("ph"), QStringLiteral("M")},
+        {QStringLiteral("pid"), 1},
+        {QStringLiteral("tid"), trackId},
+        {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), name}}},
+    };
+}
+
+QJsonArray FrameTimeline::traceEvents(const QString &name, int trackId) const
+{
+    const int gpuTrackId = trackId + 1;
+
+    QJsonArray events;
+    events.append(trackNameEvent(name, trackId));
+    events.append(trackNameEvent(name + QStringLiteral(" (GPU)"), gpuTrackId));
+
+    const QVector<FrameTimelineEntry> entries = this->entries();
+    for (const FrameTimelineEntry &entry : entries) {
+        const std::chrono::nanoseconds endTimestamp = entry.failed ? entry.submitTimestamp : entry.presentationTimestamp;
+
+        QJsonObject frame = durationEvent(QStringLiteral("Frame %1").arg(entry.frame), trackId, entry.startTimestamp, endTimestamp);
+        QJsonObject args{
+            {QStringLiteral("frame"), double(entry.frame)},
+            {QStringLiteral("targetPresentation"), toMicroseconds(entry.targetPresentationTimestamp)},
+            {QStringLiteral("missedVblanks"), entry.missedVblanks},
+            {QStringLiteral("failed"), entry.failed},
+            {QStringLiteral("textureUploadSize"), double(entry.textureUploadSize)},
+        };
+        if (entry.presentationSequence) {
+            args.insert(QStringLiteral("sequence"), double(entry.presentationSequence));
+        }
+        frame.insert(QStringLiteral("args"), args);
+        events.append(frame);
+
+        events.append(durationEvent(QStringLiteral("Prepaint"), trackId, entry.startTimestamp, entry.renderStartTimestamp));
+        events.append(durationEvent(QStringLiteral("Render"), trackId, entry.renderStartTimestamp, entry.renderEndTimestamp));
+        events.append(durationEvent(QStringLiteral("Submit"), trackId, entry.renderEndTimestamp, entry.submitTimestamp));
+        if (!entry.failed) {
+            events.append(durationEvent(QStringLiteral("Page flip"), trackId, entry.submitTimestamp, entry.presentationTimestamp));
+        }
+
+        // The GPU clock can't be mapped to the CPU clock, the GPU work is shown as if it had
+        // started when the rendering commands started being issued.
+        if (entry.gpuRenderTime) {
+            events.append(durationEvent(QStringLiteral("GPU"), gpuTrackId, entry.renderStartTimestamp, entry.renderStartTimestamp + *entry.gpuRenderTime));
+        }
+
+        if (entry.missedVblanks > 0) {
+            events.append(QJsonObject{
+                {QStringLiteral("name"), QStringLiteral("Missed vblank")},
+                {QStringLiteral("cat"), QStringLiteral("frame")},
+                {QStringLiteral("ph"), QStringLiteral("i")},
+                {QStringLiteral("s"), QStringLiteral("t")},
+                {QStringLiteral("pid"), 1},
+                {QStringLiteral("tid"), trackId},
+                {QStringLiteral("ts"), toMicroseconds(entry.presentationTimestamp)},
+                {QStringLiteral("args"), QJsonObject{{QStringLiteral("count"), entry.missedVblanks}}},
+            });
+        }
+    }
+
+    return events;
+}
+
+} // namespace KWin
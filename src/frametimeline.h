@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QJsonArray>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+namespace KWin
+{
+
+/**
+ * The FrameTimelineEntry struct describes how a single frame went through the compositing
+ * pipeline. All timestamps are in the CLOCK_MONOTONIC time domain.
+ */
+struct FrameTimelineEntry
+{
+    /**
+     * The number of the frame, it is incremented with every compositing cycle.
+     */
+    quint64 frame = 0;
+    /**
+     * The time when the frame was expected to be presented when the compositing cycle started.
+     */
+    std::chrono::nanoseconds targetPresentationTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when the compositing cycle started.
+     */
+    std::chrono::nanoseconds startTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when the prepaint pass finished and the scene started being rendered.
+     */
+    std::chrono::nanoseconds renderStartTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when the scene finished being rendered, i.e. all rendering commands have
+     * been issued.
+     */
+    std::chrono::nanoseconds renderEndTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when the frame was handed over to the backend for presentation.
+     */
+    std::chrono::nanoseconds submitTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when the frame was shown on the screen, or zero if it has not been presented.
+     */
+    std::chrono::nanoseconds presentationTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time the GPU spent rendering the frame, if it is known.
+     */
+    std::optional<std::chrono::nanoseconds> gpuRenderTime;
+    /**
+     * The number of bytes of texture data uploaded while rendering the frame.
+     */
+    qint64 textureUploadSize = 0;
+    /**
+     * The vblank sequence number of the presentation, or zero if the backend doesn't provide it.
+     */
+    quint64 presentationSequence = 0;
+    /**
+     * The number of vblanks between the expected and the actual presentation.
+     */
+    int missedVblanks = 0;
+    /**
+     * Whether the frame failed to be presented.
+     */
+    bool failed = false;
+};
+
+/**
+ * The FrameTimeline class keeps the timings of the most recent frames of an output.
+ *
+ * The entries are stored in a fixed size ring buffer. There is only one writer, the compositing
+ * cycle of the output, and readers never block it. A reader copies a slot and checks that it has
+ * not been overwritten in the meantime, otherwise the entry is skipped.
+ */
+class KWIN_EXPORT FrameTimeline
+{
+public:
+    static constexpr int capacity = 600;
+
+    /**
+     * Adds the @a entry to the timeline, overwriting the oldest entry if the timeline is full.
+     */
+    void append(const FrameTimelineEntry &entry);
+
+    /**
+     * Sets the GPU render time of the specified @a frame. This does nothing if the frame is
+     * not in the timeline anymore.
+     */
+    void setGpuRenderTime(quint64 frame, std::chrono::nanoseconds renderTime);
+
+    /**
+     * Returns the entries in the timeline, from the oldest to the newest one.
+     */
+    QVector<FrameTimelineEntry> entries() const;
+
+    /**
+     * Returns the entries in the timeline as Chrome trace events, which can be loaded in
+     * chrome://tracing or Perfetto. The CPU side of the frames is put in the track with the
+     * specified @a trackId and the GPU side in the track next to it.
+     */
+    QJsonArray traceEvents(const QString &name, int trackId) const;
+
+private:
+    struct Slot
+    {
+        std::atomic<quint32> version{0};
+        FrameTimelineEntry entry;
+    };
+
+    void write(Slot *slot, const FrameTimelineEntry &entry);
+    bool read(const Slot *slot, FrameTimelineEntry *entry) const;
+
+    std::array<Slot, capacity> m_slots;
+    std::atomic<quint64> m_head{0};
+};
+
+} // namespace KWin
@@ -0,0 +1,254 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hittestindex.h"
+#include "internalwindow.h"
+#include "unmanaged.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static const int s_cellSize = 256;
+
+static int cellCoordinate(int value)
+{
+    return value >= 0 ? value / s_cellSize : -((-value - 1) / s_cellSize) - 1;
+}
+
+static quint64 cellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+HitTestIndex::HitTestIndex(Workspace *workspace)
+    : QObject(workspace)
+    , m_workspace(workspace)
+    , m_bounds(workspace->geometry())
+{
+    connect(workspace, &Workspace::stackingOrderChanged, this, &HitTestIndex::syncStackingOrder);
+    connect(workspace, &Workspace::geometryChanged, this, [this]() {
+        m_bounds = m_workspace->geometry();
+        markAllDirty();
+    });
+    connect(workspace, &Workspace::windowRemoved, this, &HitTestIndex::remove);
+    connect(workspace, &Workspace::internalWindowRemoved, this, [this](InternalWindow *window) {
+        remove(window);
+    });
+    connect(workspace, &Workspace::unmanagedAdded, this, [this](Unmanaged *window) {
+        add(window, true);
+    });
+    connect(workspace, &Workspace::unmanagedRemoved, this, [this](Unmanaged *window) {
+        remove(window);
+    });
+
+    const QList<Unmanaged *> unmanaged = workspace->unmanagedList();
+    for (Unmanaged *window : unmanaged) {
+        add(window, true);
+    }
+    syncStackingOrder();
+}
+
+HitTestIndex::~HitTestIndex()
+{
+}
+
+bool HitTestIndex::contains(const QPoint &pos) const
+{
+    return m_bounds.contains(pos);
+}
+
+const QVector<Window *> &HitTestIndex::managedWindowsAt(const QPoint &pos)
+{
+    return windowsAt(m_managedCells, pos);
+}
+
+const QVector<Window *> &HitTestIndex::unmanagedWindowsAt(const QPoint &pos)
+{
+    return windowsAt(m_unmanagedCells, pos);
+}
+
+const QVector<Window *> &HitTestIndex::windowsAt(QHash<quint64, Cell> &cells, const QPoint &pos)
+{
+    static const QVector<Window *> noWindows;
+
+    flush();
+
+    auto it = cells.find(cellKey(cellCoordinate(pos.x()), cellCoordinate(pos.y())));
+    if (it == cells.end()) {
+        return noWindows;
+    }
+
+    if (!it->sorted) {
+        if (&cells == &m_managedCells) {
+            std::sort(it->windows.begin(), it->windows.end(), [](const Window *a, const Window *b) {
+                return a->stackingOrder() > b->stackingOrder();
+            });
+        } else {
+            std::sort(it->windows.begin(), it->windows.end(), [this](Window *a, Window *b) {
+                return m_entries.value(a).serial < m_entries.value(b).serial;
+            });
+        }
+        it->sorted = true;
+    }
+
+    return it->windows;
+}
+
+void HitTestIndex::add(Window *window, bool unmanaged)
+{
+    Entry &entry = m_entries[window];
+    entry.serial = m_nextSerial++;
+    entry.unmanaged = unmanaged;
+
+    auto markWindowDirty = [this, window]() {
+        markDirty(window);
+    };
+    connect(window, &Window::frameGeometryChanged, this, markWindowDirty);
+    connect(window, &Window::bufferGeometryChanged, this, markWindowDirty);
+    connect(window, &Window::visibleGeometryChanged, this, markWindowDirty);
+    connect(window, &Window::decorationChanged, this, markWindowDirty);
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        remove(window);
+    });
+
+    m_dirty.insert(window);
+}
+
+void HitTestIndex::remove(Window *window)
+{
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    QHash<quint64, Cell> &cells = it->unmanaged ? m_unmanagedCells : m_managedCells;
+    const QRect range = it->cells;
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        for (int x = range.left(); x <= range.right(); ++x) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell != cells.end()) {
+                cell->windows.removeOne(window);
+                if (cell->windows.isEmpty()) {
+                    cells.erase(cell);
+                }
+            }
+        }
+    }
+
+    m_entries.erase(it);
+    m_dirty.remove(window);
+    disconnect(window, nullptr, this, nullptr);
+}
+
+void HitTestIndex::markDirty(Window *window)
+{
+    m_dirty.insert(window);
+}
+
+void HitTestIndex::markAllDirty()
+{
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        m_dirty.insert(it.key());
+    }
+}
+
+void HitTestIndex::syncStackingOrder()
+{
+    // Windows are added to the index when they show up in the stacking order for the first time.
+    QSet<Window *> managed;
+    const QList<Window *> stackingOrder = m_workspace->stackingOrder();
+    for (Window *window : stackingOrder) {
+        if (window->isDeleted() || window->isUnmanaged()) {
+            continue;
+        }
+        managed.insert(window);
+        if (!m_entries.contains(window)) {
+            add(window, false);
+        }
+    }
+
+    QVector<Window *> removed;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!it->unmanaged && !managed.contains(it.key())) {
+            removed.append(it.key());
+        }
+    }
+    for (Window *window : std::as_const(removed)) {
+        remove(window);
+    }
+
+    for (Cell &cell : m_managedCells) {
+        cell.sorted = false;
+    }
+}
+
+void HitTestIndex::flush()
+{
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+    for (Window *window : std::as_const(m_dirty)) {
+        update(window, m_entries[window]);
+    }
+    m_dirty.clear();
+}
+
+void HitTestIndex::update(Window *window, Entry &entry)
+{
+    const QRect oldRange = entry.cells;
+    const QRect newRange = cellRange(window);
+    if (oldRange == newRange) {
+        return;
+    }
+
+    QHash<quint64, Cell> &cells = entry.unmanaged ? m_unmanagedCells : m_managedCells;
+
+    for (int y = oldRange.top(); y <= oldRange.bottom(); ++y) {
+        for (int x = oldRange.left(); x <= oldRange.right(); ++x) {
+            if (newRange.contains(x, y)) {
+                continue;
+            }
+            auto cell = cells.find(cellKey(x, y));
+            if (cell != cells.end()) {
+                cell->windows.removeOne(window);
+                if (cell->windows.isEmpty()) {
+                    cells.erase(cell);
+                }
+            }
+        }
+    }
+
+    for (int y = newRange.top(); y <= newRange.bottom(); ++y) {
+        for (int x = newRange.left(); x <= newRange.right(); ++x) {
+            if (oldRange.contains(x, y)) {
+                continue;
+            }
+            Cell &cell = cells[cellKey(x, y)];
+            cell.windows.append(window);
+            cell.sorted = false;
+        }
+    }
+
+    entry.cells = newRange;
+}
+
+QRect HitTestIndex::cellRange(Window *window) const
+{
+    // The input area of a window can extend past its frame, e.g. the resize borders or the
+    // sub-surfaces, so use the union of all the geometries that hitTest() may look at.
+    const QRect rect = (window->inputGeometry() | window->bufferGeometry() | window->visibleGeometry()) & m_bounds;
+    if (rect.isEmpty()) {
+        return QRect();
+    }
+    return QRect(QPoint(cellCoordinate(rect.left()), cellCoordinate(rect.top())),
+                 QPoint(cellCoordinate(rect.right()), cellCoordinate(rect.bottom())));
+}
+
+} // namespace KWin
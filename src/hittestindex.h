@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QSet>
+#include <QVector>
+
+namespace KWin
+{
+
+class Window;
+class Workspace;
+
+/**
+ * The HitTestIndex class is a spatial index of the windows that can receive pointer input.
+ *
+ * The workspace is split in a grid of square cells. Every cell lists the windows whose input
+ * area may overlap the cell, so finding the window under the pointer requires checking only
+ * a few windows rather than walking the whole stacking order.
+ *
+ * The index is updated incrementally. When the geometry of a window changes, the window is
+ * marked as dirty and it is moved to new cells the next time the index is queried.
+ */
+class KWIN_EXPORT HitTestIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HitTestIndex(Workspace *workspace);
+    ~HitTestIndex() override;
+
+    /**
+     * Returns the managed windows that may contain the given @a pos, from top to bottom.
+     *
+     * The windows still need to be hit tested, the index doesn't check whether they are
+     * visible or accept input either.
+     */
+    const QVector<Window *> &managedWindowsAt(const QPoint &pos);
+
+    /**
+     * Returns the unmanaged windows that may contain the given @a pos, in the same order as
+     * in Workspace::unmanagedList().
+     */
+    const QVector<Window *> &unmanagedWindowsAt(const QPoint &pos);
+
+    /**
+     * Returns @c true if the given @a pos is covered by the index; otherwise returns @c false.
+     */
+    bool contains(const QPoint &pos) const;
+
+private:
+    struct Cell
+    {
+        QVector<Window *> windows;
+        bool sorted = true;
+    };
+
+    struct Entry
+    {
+        QRect cells;
+        quint64 serial = 0;
+        bool unmanaged = false;
+    };
+
+    void add(Window *window, bool unmanaged);
+    void remove(Window *window);
+    void markDirty(Window *window);
+    void markAllDirty();
+    void syncStackingOrder();
+    void flush();
+    void update(Window *window, Entry &entry);
+
+    QRect cellRange(Window *window) const;
+    const QVector<Window *> &windowsAt(QHash<quint64, Cell> &cells, const QPoint &pos);
+
+    Workspace *m_workspace;
+    QRect m_bounds;
+    QHash<Window *, Entry> m_entries;
+    QSet<Window *> m_dirty;
+    QHash<quint64, Cell> m_managedCells;
+    QHash<quint64, Cell> m_unmanagedCells;
+    quint64 m_nextSerial = 0;
+};
+
+} // namespace KWin
@@ -17,6 +17,7 @@
 #include "gestures.h"
 #include "globalshortcuts.h"
 #include "hide_cursor_spy.h"
+#include "hittestindex.h"
 #include "input_event.h"
 #include "input_event_spy.h"
 #include "inputbackend.h"
@@ -2655,6 +2656,8 @@ void InputRedirection::init()
 void InputRedirection::setupWorkspace()
 {
     if (waylandServer()) {
+        m_hitTestIndex = new HitTestIndex(workspace());
+
         m_keyboard->init();
         m_pointer->init();
         m_touch->init();
@@ -3193,10 +3196,19 @@ Window *InputRedirection::findToplevel(const QPoint &pos)
         if (effects && static_cast<EffectsHandlerImpl *>(effects)->isMouseInterception()) {
             return nullptr;
         }
-        const QList<Unmanaged *> &unmanaged = Workspace::self()->unmanagedList();
-        for (Unmanaged *u : unmanaged) {
-            if (u->hitTest(pos)) {
-                return u;
+        if (m_hitTestIndex && m_hitTestIndex->contains(pos)) {
+            const QVector<Window *> &unmanaged = m_hitTestIndex->unmanagedWindowsAt(pos);
+            for (Window *u : unmanaged) {
+                if (u->hitTest(pos)) {
+                    return u;
+                }
+            }
+        } else {
+            const QList<Unmanaged *> &unmanaged = Workspace::self()->unmanagedList();
+            for (Unmanaged *u : unmanaged) {
+                if (u->hitTest(pos)) {
+                    return u;
+                }
             }
         }
     }
@@ -3209,33 +3221,42 @@ Window *InputRedirection::findManagedToplevel(const QPoint &pos)
         return nullptr;
     }
     const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
-    const QList<Window *> &stacking = Workspace::self()->stackingOrder();
-    if (stacking.isEmpty()) {
-        return nullptr;
-    }
-    auto it = stacking.end();
-    do {
-        --it;
-        Window *window = (*it);
+    auto acceptsPointer = [isScreenLocked, &pos](Window *window) {
         if (window->isDeleted()) {
             // a deleted window doesn't get mouse events
-            continue;
+            return false;
         }
         if (!window->isOnCurrentActivity() || !window->isOnCurrentDesktop() || window->isMinimized() || window->isHiddenInternal()) {
-            continue;
+            return false;
         }
         if (!window->readyForPainting()) {
-            continue;
+            return false;
         }
         if (isScreenLocked) {
             if (!window->isLockScreen() && !window->isInputMethod()) {
-                continue;
+                return false;
             }
         }
-        if (window->hitTest(pos)) {
-            return window;
+        return window->hitTest(pos);
+    };
+
+    // The index lists only the windows near the given position, from top to bottom.
+    if (m_hitTestIndex && m_hitTestIndex->contains(pos)) {
+        const QVector<Window *> &windows = m_hitTestIndex->managedWindowsAt(pos);
+        for (Window *window : windows) {
+            if (acceptsPointer(window)) {
+                return window;
+            }
         }
-    } while (it != stacking.begin());
+        return nullptr;
+    }
+
+    const QList<Window *> &stacking = Workspace::self()->stackingOrder();
+    for (auto it = stacking.crbegin(); it != stacking.crend(); ++it) {
+        if (acceptsPointer(*it)) {
+            return *it;
+        }
+    }
     return nullptr;
 }
 
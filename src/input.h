@@ -34,6 +34,7 @@ namespace KWin
 {
 class Window;
 class GlobalShortcutsManager;
+class HitTestIndex;
 class InputEventFilter;
 class InputEventSpy;
 class KeyboardInputRedirection;
@@ -325,6 +326,7 @@ private:
     QList<InputDevice *> m_inputDevices;
 
     WindowSelectorFilter *m_windowSelector = nullptr;
+    QPointer<HitTestIndex> m_hitTestIndex;
 
     QVector<InputEventFilter *> m_filters;
     QVector<InputEventSpy *> m_spies;
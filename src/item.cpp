@@ -89,6 +89,7 @@ void Item::addChild(Item *item)
 
     m_childItems.append(item);
     markSortedChildItemsDirty();
+    markSubtreeDirty();
 
     updateBoundingRect();
     scheduleRepaint(item->boundingRect().translated(item->position()));
@@ -299,11 +300,13 @@ void Item::scheduleRepaintInternal(const QRegion &region)
             const QRegion dirtyRegion = globalRegion & output->geometry();
             if (!dirtyRegion.isEmpty()) {
                 m_repaints[output] += dirtyRegion;
+                markSubtreeDirty(output);
                 output->renderLoop()->scheduleRepaint(this);
             }
         }
     } else {
         m_repaints[outputs.constFirst()] += globalRegion;
+        markSubtreeDirty(outputs.constFirst());
         outputs.constFirst()->renderLoop()->scheduleRepaint(this);
     }
 }
@@ -338,6 +341,7 @@ WindowQuadList Item::buildQuads() const
 void Item::discardQuads()
 {
     m_quads.reset();
+    m_quadVertices.reset();
 }
 
 WindowQuadList Item::quads() const
@@ -348,6 +352,34 @@ WindowQuadList Item::quads() const
     return m_quads.value();
 }
 
+QVector<GLVertex2D> Item::quadVertices(const QMatrix4x4 &textureMatrix) const
+{
+    if (m_quadVertices.has_value() && m_quadVerticesTextureMatrix == textureMatrix) {
+        return m_quadVertices.value();
+    }
+
+    // The texture matrix only scales and translates the texture coordinates.
+    const QVector2D coeff(textureMatrix(0, 0), textureMatrix(1, 1));
+    const QVector2D offset(textureMatrix(0, 3), textureMatrix(1, 3));
+
+    const WindowQuadList quads = this->quads();
+    QVector<GLVertex2D> vertices;
+    vertices.reserve(quads.count() * 4);
+    for (const WindowQuad &quad : quads) {
+        for (int i = 0; i < 4; ++i) {
+            const WindowVertex &vertex = quad[i];
+            vertices.append(GLVertex2D{
+                .position = QVector2D(vertex.x(), vertex.y()),
+                .texcoord = QVector2D(vertex.u(), vertex.v()) * coeff + offset,
+            });
+        }
+    }
+
+    m_quadVertices = vertices;
+    m_quadVerticesTextureMatrix = textureMatrix;
+    return vertices;
+}
+
 QRegion Item::repaints(Output *output) const
 {
     return m_repaints.value(output, QRect(QPoint(0, 0), screens()->size()));
@@ -361,6 +393,35 @@ void Item::resetRepaints(Output *output)
 void Item::removeRepaints(Output *output)
 {
     m_repaints.remove(output);
+    markSubtreeDirty(output);
+}
+
+bool Item::hasDirtySubtree(Output *output) const
+{
+    return !m_cleanSubtrees.contains(output);
+}
+
+void Item::markSubtreeClean(Output *output)
+{
+    m_cleanSubtrees.insert(output);
+}
+
+void Item::markSubtreeDirty(Output *output)
+{
+    // If an item is clean, so are all of its descendants. Therefore the walk can stop
+    // as soon as it finds an ancestor that is already dirty.
+    for (Item *item = this; item; item = item->m_parentItem) {
+        if (!item->m_cleanSubtrees.remove(output)) {
+            break;
+        }
+    }
+}
+
+void Item::markSubtreeDirty()
+{
+    for (Item *item = this; item && !item->m_cleanSubtrees.isEmpty(); item = item->m_parentItem) {
+        item->m_cleanSubtrees.clear();
+    }
 }
 
 bool Item::explicitVisible() const
@@ -11,6 +11,7 @@
 
 #include <QMatrix4x4>
 #include <QObject>
+#include <QSet>
 
 #include <optional>
 
@@ -102,7 +103,25 @@ public:
     QRegion repaints(Output *output) const;
     void resetRepaints(Output *output);
 
+    /**
+     * Returns @c true if this item or any of its descendants may have repaints scheduled on
+     * the given @a output; otherwise returns @c false. Subtrees that are not dirty need not be
+     * visited when collecting repaints.
+     */
+    bool hasDirtySubtree(Output *output) const;
+    /**
+     * Marks this item and all of its descendants as having no repaints on the given @a output.
+     * This must be called only after the repaints of the whole subtree have been reset.
+     */
+    void markSubtreeClean(Output *output);
+
     WindowQuadList quads() const;
+    /**
+     * Returns the vertices of the quads(), four per quad, with the texture coordinates mapped
+     * by the given @a textureMatrix. The vertices are cached until either the quads or the
+     * texture matrix change.
+     */
+    QVector<GLVertex2D> quadVertices(const QMatrix4x4 &textureMatrix) const;
     virtual void preprocess();
 
 Q_SIGNALS:
@@ -135,6 +154,8 @@ private:
     bool computeEffectiveVisibility() const;
     void updateEffectiveVisibility();
     void removeRepaints(Output *output);
+    void markSubtreeDirty(Output *output);
+    void markSubtreeDirty();
 
     QPointer<Item> m_parentItem;
     QList<Item *> m_childItems;
@@ -147,7 +168,10 @@ private:
     bool m_explicitVisible = true;
     bool m_effectiveVisible = true;
     QMap<Output *, QRegion> m_repaints;
+    QSet<Output *> m_cleanSubtrees;
     mutable std::optional<WindowQuadList> m_quads;
+    mutable std::optional<QVector<GLVertex2D>> m_quadVertices;
+    mutable QMatrix4x4 m_quadVerticesTextureMatrix;
     mutable std::optional<QList<Item *>> m_sortedChildItems;
 };
 
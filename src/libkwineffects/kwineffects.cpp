@@ -10,6 +10,7 @@
 */
 
 #include "kwineffects.h"
+#include "windowquadbuffer_p.h"
 
 #include "config-kwin.h"
 
@@ -25,10 +26,15 @@
 #include <kconfiggroup.h>
 #include <ksharedconfig.h>
 
-#if defined(__SSE2__)
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
+#include <algorithm>
 #include <optional>
 
 namespace KWin
@@ -1004,28 +1010,55 @@ WindowQuadList WindowQuadList::splitAtY(double y) const
     return ret;
 }
 
-WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
+// Calls the function with the part of the quad that is covered by each intersecting cell of a
+// grid, the grid starts at the specified left and top coordinates.
+template<typename Function>
+static void forEachGridCell(double quadLeft, double quadTop, double quadRight, double quadBottom,
+                            double left, double top, double xIncrement, double yIncrement, Function function)
 {
-    if (empty()) {
-        return *this;
+    // Compute the top-left corner of the first intersecting grid cell
+    const double xBegin = left + qFloor((quadLeft - left) / xIncrement) * xIncrement;
+    const double yBegin = top + qFloor((quadTop - top) / yIncrement) * yIncrement;
+
+    // Loop over all intersecting cells
+    for (double y = yBegin; y < quadBottom; y += yIncrement) {
+        const double y0 = qMax(y, quadTop);
+        const double y1 = qMin(quadBottom, y + yIncrement);
+
+        for (double x = xBegin; x < quadRight; x += xIncrement) {
+            const double x0 = qMax(x, quadLeft);
+            const double x1 = qMin(quadRight, x + xIncrement);
+
+            function(x0, y0, x1, y1);
+        }
     }
+}
 
-    // Find the bounding rectangle
-    double left = first().left();
-    double right = first().right();
-    double top = first().top();
-    double bottom = first().bottom();
+static WindowQuadList subdivideQuads(const WindowQuadList &quads, double left, double top, double xIncrement, double yIncrement)
+{
+    // Count the sub-quads first, so the list is allocated only once
+    int subQuadCount = 0;
+    for (const WindowQuad &quad : quads) {
+        const double quadLeft = quad.left();
+        const double quadRight = quad.right();
+        const double quadTop = quad.top();
+        const double quadBottom = quad.bottom();
 
-    for (const WindowQuad &quad : qAsConst(*this)) {
-        left = qMin(left, quad.left());
-        right = qMax(right, quad.right());
-        top = qMin(top, quad.top());
-        bottom = qMax(bottom, quad.bottom());
+        if (quadLeft == quadRight || quadTop == quadBottom) {
+            subQuadCount++;
+            continue;
+        }
+
+        forEachGridCell(quadLeft, quadTop, quadRight, quadBottom, left, top, xIncrement, yIncrement,
+                        [&subQuadCount](double, double, double, double) {
+                            subQuadCount++;
+                        });
     }
 
     WindowQuadList ret;
+    ret.reserve(subQuadCount);
 
-    for (const WindowQuad &quad : qAsConst(*this)) {
+    for (const WindowQuad &quad : quads) {
         const double quadLeft = quad.left();
         const double quadRight = quad.right();
         const double quadTop = quad.top();
@@ -1037,25 +1070,35 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
             continue;
         }
 
-        // Compute the top-left corner of the first intersecting grid cell
-        const double xBegin = left + qFloor((quadLeft - left) / maxQuadSize) * maxQuadSize;
-        const double yBegin = top + qFloor((quadTop - top) / maxQuadSize) * maxQuadSize;
+        forEachGridCell(quadLeft, quadTop, quadRight, quadBottom, left, top, xIncrement, yIncrement,
+                        [&ret, &quad](double x0, double y0, double x1, double y1) {
+                            ret.append(quad.makeSubQuad(x0, y0, x1, y1));
+                        });
+    }
 
-        // Loop over all intersecting cells and add sub-quads
-        for (double y = yBegin; y < quadBottom; y += maxQuadSize) {
-            const double y0 = qMax(y, quadTop);
-            const double y1 = qMin(quadBottom, y + maxQuadSize);
+    return ret;
+}
 
-            for (double x = xBegin; x < quadRight; x += maxQuadSize) {
-                const double x0 = qMax(x, quadLeft);
-                const double x1 = qMin(quadRight, x + maxQuadSize);
+WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
+{
+    if (empty()) {
+        return *this;
+    }
 
-                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
-            }
-        }
+    // Find the bounding rectangle
+    double left = first().left();
+    double right = first().right();
+    double top = first().top();
+    double bottom = first().bottom();
+
+    for (const WindowQuad &quad : qAsConst(*this)) {
+        left = qMin(left, quad.left());
+        right = qMax(right, quad.right());
+        top = qMin(top, quad.top());
+        bottom = qMax(bottom, quad.bottom());
     }
 
-    return ret;
+    return subdivideQuads(*this, left, top, maxQuadSize, maxQuadSize);
 }
 
 WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisions) const
@@ -1080,163 +1123,406 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double xIncrement = (right - left) / xSubdivisions;
     double yIncrement = (bottom - top) / ySubdivisions;
 
-    WindowQuadList ret;
+    return subdivideQuads(*this, left, top, xIncrement, yIncrement);
+}
 
-    for (const WindowQuad &quad : *this) {
-        const double quadLeft = quad.left();
-        const double quadRight = quad.right();
-        const double quadTop = quad.top();
-        const double quadBottom = quad.bottom();
+#ifndef GL_TRIANGLES
+#define GL_TRIANGLES 0x0004
+#endif
 
-        // sanity check, see BUG 390953
-        if (quadLeft == quadRight || quadTop == quadBottom) {
-            ret.append(quad);
-            continue;
-        }
+#ifndef GL_QUADS
+#define GL_QUADS 0x0007
+#endif
+
+// The quad kernels below work on the four vertices of a quad at once.
+#if defined(__SSE2__)
+typedef __m128 Float4;
 
-        // Compute the top-left corner of the first intersecting grid cell
-        const double xBegin = left + qFloor((quadLeft - left) / xIncrement) * xIncrement;
-        const double yBegin = top + qFloor((quadTop - top) / yIncrement) * yIncrement;
+static inline Float4 loadFloat4(const float *p)
+{
+    return _mm_loadu_ps(p);
+}
 
-        // Loop over all intersecting cells and add sub-quads
-        for (double y = yBegin; y < quadBottom; y += yIncrement) {
-            const double y0 = qMax(y, quadTop);
-            const double y1 = qMin(quadBottom, y + yIncrement);
+static inline void storeFloat4(float *p, Float4 a)
+{
+    _mm_storeu_ps(p, a);
+}
 
-            for (double x = xBegin; x < quadRight; x += xIncrement) {
-                const double x0 = qMax(x, quadLeft);
-                const double x1 = qMin(quadRight, x + xIncrement);
+static inline Float4 setFloat4(float a, float b, float c, float d)
+{
+    return _mm_setr_ps(a, b, c, d);
+}
 
-                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
-            }
-        }
+static inline Float4 splatFloat4(float a)
+{
+    return _mm_set1_ps(a);
+}
+
+static inline Float4 addFloat4(Float4 a, Float4 b)
+{
+    return _mm_add_ps(a, b);
+}
+
+static inline Float4 subFloat4(Float4 a, Float4 b)
+{
+    return _mm_sub_ps(a, b);
+}
+
+static inline Float4 mulFloat4(Float4 a, Float4 b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+static inline Float4 minFloat4(Float4 a, Float4 b)
+{
+    return _mm_min_ps(a, b);
+}
+
+static inline Float4 maxFloat4(Float4 a, Float4 b)
+{
+    return _mm_max_ps(a, b);
+}
+
+static inline float horizontalMin(Float4 a)
+{
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(a);
+}
+
+static inline float horizontalMax(Float4 a)
+{
+    a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(a);
+}
+#elif defined(__ARM_NEON)
+typedef float32x4_t Float4;
+
+static inline Float4 loadFloat4(const float *p)
+{
+    return vld1q_f32(p);
+}
+
+static inline void storeFloat4(float *p, Float4 a)
+{
+    vst1q_f32(p, a);
+}
+
+static inline Float4 setFloat4(float a, float b, float c, float d)
+{
+    const float values[4] = {a, b, c, d};
+    return vld1q_f32(values);
+}
+
+static inline Float4 splatFloat4(float a)
+{
+    return vdupq_n_f32(a);
+}
+
+static inline Float4 addFloat4(Float4 a, Float4 b)
+{
+    return vaddq_f32(a, b);
+}
+
+static inline Float4 subFloat4(Float4 a, Float4 b)
+{
+    return vsubq_f32(a, b);
+}
+
+static inline Float4 mulFloat4(Float4 a, Float4 b)
+{
+    return vmulq_f32(a, b);
+}
+
+static inline Float4 minFloat4(Float4 a, Float4 b)
+{
+    return vminq_f32(a, b);
+}
+
+static inline Float4 maxFloat4(Float4 a, Float4 b)
+{
+    return vmaxq_f32(a, b);
+}
+
+static inline float horizontalMin(Float4 a)
+{
+    float32x2_t m = vpmin_f32(vget_low_f32(a), vget_high_f32(a));
+    m = vpmin_f32(m, m);
+    return vget_lane_f32(m, 0);
+}
+
+static inline float horizontalMax(Float4 a)
+{
+    float32x2_t m = vpmax_f32(vget_low_f32(a), vget_high_f32(a));
+    m = vpmax_f32(m, m);
+    return vget_lane_f32(m, 0);
+}
+#else
+struct Float4
+{
+    float values[4];
+};
+
+static inline Float4 loadFloat4(const float *p)
+{
+    return Float4{{p[0], p[1], p[2], p[3]}};
+}
+
+static inline void storeFloat4(float *p, Float4 a)
+{
+    std::copy(a.values, a.values + 4, p);
+}
+
+static inline Float4 setFloat4(float a, float b, float c, float d)
+{
+    return Float4{{a, b, c, d}};
+}
+
+static inline Float4 splatFloat4(float a)
+{
+    return Float4{{a, a, a, a}};
+}
+
+template<typename Operation>
+static inline Float4 applyFloat4(Float4 a, Float4 b, Operation operation)
+{
+    for (int i = 0; i < 4; ++i) {
+        a.values[i] = operation(a.values[i], b.values[i]);
     }
+    return a;
+}
 
-    return ret;
+static inline Float4 addFloat4(Float4 a, Float4 b)
+{
+    return applyFloat4(a, b, std::plus<float>());
 }
 
-#ifndef GL_TRIANGLES
-#define GL_TRIANGLES 0x0004
+static inline Float4 subFloat4(Float4 a, Float4 b)
+{
+    return applyFloat4(a, b, std::minus<float>());
+}
+
+static inline Float4 mulFloat4(Float4 a, Float4 b)
+{
+    return applyFloat4(a, b, std::multiplies<float>());
+}
+
+static inline Float4 minFloat4(Float4 a, Float4 b)
+{
+    return applyFloat4(a, b, [](float x, float y) {
+        return std::min(x, y);
+    });
+}
+
+static inline Float4 maxFloat4(Float4 a, Float4 b)
+{
+    return applyFloat4(a, b, [](float x, float y) {
+        return std::max(x, y);
+    });
+}
+
+static inline float horizontalMin(Float4 a)
+{
+    return *std::min_element(a.values, a.values + 4);
+}
+
+static inline float horizontalMax(Float4 a)
+{
+    return *std::max_element(a.values, a.values + 4);
+}
 #endif
 
-#ifndef GL_QUADS
-#define GL_QUADS 0x0007
+// Writes the vertices of a quad in the order that the primitive type expects.
+static inline void emitQuadVertices(unsigned int type, const GLVertex2D *corners, GLVertex2D *&vertex)
+{
+    if (type == GL_QUADS) {
+        *(vertex++) = corners[0]; // Top-left
+        *(vertex++) = corners[1]; // Top-right
+        *(vertex++) = corners[2]; // Bottom-right
+        *(vertex++) = corners[3]; // Bottom-left
+    } else {
+        // First triangle
+        *(vertex++) = corners[1]; // Top-right
+        *(vertex++) = corners[0]; // Top-left
+        *(vertex++) = corners[3]; // Bottom-left
+
+        // Second triangle
+        *(vertex++) = corners[3]; // Bottom-left
+        *(vertex++) = corners[2]; // Bottom-right
+        *(vertex++) = corners[1]; // Top-right
+    }
+}
+
+#if defined(__SSE2__)
+static inline void storeVertex(GLVertex2D *vertex, __m128 data, bool aligned)
+{
+    // The vertices are read by the GPU, so don't pollute the cache with them if possible
+    if (aligned) {
+        _mm_stream_ps(reinterpret_cast<float *>(vertex), data);
+    } else {
+        _mm_storeu_ps(reinterpret_cast<float *>(vertex), data);
+    }
+}
+
+static inline void emitQuadVertices(unsigned int type, __m128 v0, __m128 v1, __m128 v2, __m128 v3,
+                                    bool aligned, GLVertex2D *&vertex)
+{
+    if (type == GL_QUADS) {
+        storeVertex(vertex++, v0, aligned); // Top-left
+        storeVertex(vertex++, v1, aligned); // Top-right
+        storeVertex(vertex++, v2, aligned); // Bottom-right
+        storeVertex(vertex++, v3, aligned); // Bottom-left
+    } else {
+        // First triangle
+        storeVertex(vertex++, v1, aligned); // Top-right
+        storeVertex(vertex++, v0, aligned); // Top-left
+        storeVertex(vertex++, v3, aligned); // Bottom-left
+
+        // Second triangle
+        storeVertex(vertex++, v3, aligned); // Bottom-left
+        storeVertex(vertex++, v2, aligned); // Bottom-right
+        storeVertex(vertex++, v1, aligned); // Top-right
+    }
+}
 #endif
 
-void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &textureMatrix) const
+// Generates the vertices of quads that are stored as a structure of arrays, four entries per quad.
+static void interleaveQuads(unsigned int type, const float *x, const float *y, const float *u, const float *v,
+                            int quadCount, GLVertex2D *vertices, const QMatrix4x4 &textureMatrix)
 {
+    Q_ASSERT(type == GL_QUADS || type == GL_TRIANGLES);
+
     // Since we know that the texture matrix just scales and translates
     // we can use this information to optimize the transformation
-    const QVector2D coeff(textureMatrix(0, 0), textureMatrix(1, 1));
-    const QVector2D offset(textureMatrix(0, 3), textureMatrix(1, 3));
+    const float uCoeff = textureMatrix(0, 0);
+    const float vCoeff = textureMatrix(1, 1);
+    const float uOffset = textureMatrix(0, 3);
+    const float vOffset = textureMatrix(1, 3);
 
     GLVertex2D *vertex = vertices;
+    int i = 0;
 
-    Q_ASSERT(type == GL_QUADS || type == GL_TRIANGLES);
-
-    switch (type) {
-    case GL_QUADS:
 #if defined(__SSE2__)
-        if (!(intptr_t(vertex) & 0xf)) {
-            for (const WindowQuad &quad : *this) {
-                alignas(16) GLVertex2D v[4];
+    const bool aligned = !(intptr_t(vertex) & 0xf);
+
+#if defined(__AVX__)
+    // Two quads per iteration, every 128 bit lane holds one quad
+    const __m256 uCoeff8 = _mm256_set1_ps(uCoeff);
+    const __m256 vCoeff8 = _mm256_set1_ps(vCoeff);
+    const __m256 uOffset8 = _mm256_set1_ps(uOffset);
+    const __m256 vOffset8 = _mm256_set1_ps(vOffset);
+
+    for (; i + 2 <= quadCount; i += 2) {
+        const __m256 px = _mm256_loadu_ps(x + i * 4);
+        const __m256 py = _mm256_loadu_ps(y + i * 4);
+        const __m256 tu = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(u + i * 4), uCoeff8), uOffset8);
+        const __m256 tv = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(v + i * 4), vCoeff8), vOffset8);
+
+        const __m256 xy01 = _mm256_unpacklo_ps(px, py);
+        const __m256 xy23 = _mm256_unpackhi_ps(px, py);
+        const __m256 uv01 = _mm256_unpacklo_ps(tu, tv);
+        const __m256 uv23 = _mm256_unpackhi_ps(tu, tv);
+
+        const __m256 v0 = _mm256_shuffle_ps(xy01, uv01, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 v1 = _mm256_shuffle_ps(xy01, uv01, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 v2 = _mm256_shuffle_ps(xy23, uv23, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 v3 = _mm256_shuffle_ps(xy23, uv23, _MM_SHUFFLE(3, 2, 3, 2));
+
+        emitQuadVertices(type, _mm256_castps256_ps128(v0), _mm256_castps256_ps128(v1),
+                         _mm256_castps256_ps128(v2), _mm256_castps256_ps128(v3), aligned, vertex);
+        emitQuadVertices(type, _mm256_extractf128_ps(v0, 1), _mm256_extractf128_ps(v1, 1),
+                         _mm256_extractf128_ps(v2, 1), _mm256_extractf128_ps(v3, 1), aligned, vertex);
+    }
+#endif // __AVX__
 
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
+    const __m128 uCoeff4 = _mm_set1_ps(uCoeff);
+    const __m128 vCoeff4 = _mm_set1_ps(vCoeff);
+    const __m128 uOffset4 = _mm_set1_ps(uOffset);
+    const __m128 vOffset4 = _mm_set1_ps(vOffset);
 
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
+    for (; i < quadCount; ++i) {
+        __m128 v0 = _mm_loadu_ps(x + i * 4);
+        __m128 v1 = _mm_loadu_ps(y + i * 4);
+        __m128 v2 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(u + i * 4), uCoeff4), uOffset4);
+        __m128 v3 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v + i * 4), vCoeff4), vOffset4);
 
-                const __m128i *srcP = reinterpret_cast<const __m128i *>(&v);
-                __m128i *dstP = reinterpret_cast<__m128i *>(vertex);
+        // The rows hold x, y, u and v of the four vertices, transpose them into vertices
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
 
-                _mm_stream_si128(&dstP[0], _mm_load_si128(&srcP[0])); // Top-left
-                _mm_stream_si128(&dstP[1], _mm_load_si128(&srcP[1])); // Top-right
-                _mm_stream_si128(&dstP[2], _mm_load_si128(&srcP[2])); // Bottom-right
-                _mm_stream_si128(&dstP[3], _mm_load_si128(&srcP[3])); // Bottom-left
+        emitQuadVertices(type, v0, v1, v2, v3, aligned, vertex);
+    }
 
-                vertex += 4;
-            }
-        } else
-#endif // __SSE2__
-        {
-            for (const WindowQuad &quad : *this) {
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    GLVertex2D v;
-                    v.position = QVector2D(wv.x(), wv.y());
-                    v.texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-
-                    *(vertex++) = v;
-                }
-            }
+    if (aligned) {
+        _mm_sfence();
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t uCoeff4 = vdupq_n_f32(uCoeff);
+    const float32x4_t vCoeff4 = vdupq_n_f32(vCoeff);
+    const float32x4_t uOffset4 = vdupq_n_f32(uOffset);
+    const float32x4_t vOffset4 = vdupq_n_f32(vOffset);
+
+    for (; i < quadCount; ++i) {
+        float32x4x4_t planes;
+        planes.val[0] = vld1q_f32(x + i * 4);
+        planes.val[1] = vld1q_f32(y + i * 4);
+        planes.val[2] = vaddq_f32(vmulq_f32(vld1q_f32(u + i * 4), uCoeff4), uOffset4);
+        planes.val[3] = vaddq_f32(vmulq_f32(vld1q_f32(v + i * 4), vCoeff4), vOffset4);
+
+        // vst4q interleaves the planes, which yields the four vertices of the quad
+        if (type == GL_QUADS) {
+            vst4q_f32(reinterpret_cast<float *>(vertex), planes);
+            vertex += 4;
+        } else {
+            GLVertex2D corners[4];
+            vst4q_f32(reinterpret_cast<float *>(corners), planes);
+            emitQuadVertices(type, corners, vertex);
         }
-        break;
-
-    case GL_TRIANGLES:
-#if defined(__SSE2__)
-        if (!(intptr_t(vertex) & 0xf)) {
-            for (const WindowQuad &quad : *this) {
-                alignas(16) GLVertex2D v[4];
-
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
+    }
+#endif
 
-                const __m128i *srcP = reinterpret_cast<const __m128i *>(&v);
-                __m128i *dstP = reinterpret_cast<__m128i *>(vertex);
+    for (; i < quadCount; ++i) {
+        GLVertex2D corners[4]; // Four unique vertices / quad
 
-                __m128i src[4];
-                src[0] = _mm_load_si128(&srcP[0]); // Top-left
-                src[1] = _mm_load_si128(&srcP[1]); // Top-right
-                src[2] = _mm_load_si128(&srcP[2]); // Bottom-right
-                src[3] = _mm_load_si128(&srcP[3]); // Bottom-left
+        for (int j = 0; j < 4; j++) {
+            const int index = i * 4 + j;
+            corners[j].position = QVector2D(x[index], y[index]);
+            corners[j].texcoord = QVector2D(u[index] * uCoeff + uOffset, v[index] * vCoeff + vOffset);
+        }
 
-                // First triangle
-                _mm_stream_si128(&dstP[0], src[1]); // Top-right
-                _mm_stream_si128(&dstP[1], src[0]); // Top-left
-                _mm_stream_si128(&dstP[2], src[3]); // Bottom-left
+        emitQuadVertices(type, corners, vertex);
+    }
+}
 
-                // Second triangle
-                _mm_stream_si128(&dstP[3], src[3]); // Bottom-left
-                _mm_stream_si128(&dstP[4], src[2]); // Bottom-right
-                _mm_stream_si128(&dstP[5], src[1]); // Top-right
+void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &textureMatrix) const
+{
+    Q_ASSERT(type == GL_QUADS || type == GL_TRIANGLES);
 
-                vertex += 6;
-            }
-        } else
-#endif // __SSE2__
-        {
-            for (const WindowQuad &quad : *this) {
-                GLVertex2D v[4]; // Four unique vertices / quad
-
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
-
-                // First triangle
-                *(vertex++) = v[1]; // Top-right
-                *(vertex++) = v[0]; // Top-left
-                *(vertex++) = v[3]; // Bottom-left
-
-                // Second triangle
-                *(vertex++) = v[3]; // Bottom-left
-                *(vertex++) = v[2]; // Bottom-right
-                *(vertex++) = v[1]; // Top-right
+    // Convert the quads in blocks that stay in the cache, the vertices are generated by the
+    // same kernel as for WindowQuadBuffer
+    constexpr int blockSize = 64;
+    alignas(32) float x[blockSize * 4];
+    alignas(32) float y[blockSize * 4];
+    alignas(32) float u[blockSize * 4];
+    alignas(32) float v[blockSize * 4];
+
+    const int verticesPerQuad = type == GL_QUADS ? 4 : 6;
+
+    for (int first = 0; first < count(); first += blockSize) {
+        const int quadCount = std::min(blockSize, count() - first);
+
+        for (int i = 0; i < quadCount; ++i) {
+            const WindowQuad &quad = at(first + i);
+            for (int j = 0; j < 4; ++j) {
+                const WindowVertex &wv = quad.verts[j];
+                x[i * 4 + j] = wv.px;
+                y[i * 4 + j] = wv.py;
+                u[i * 4 + j] = wv.tx;
+                v[i * 4 + j] = wv.ty;
             }
         }
-        break;
 
-    default:
-        break;
+        interleaveQuads(type, x, y, u, v, quadCount, vertices + first * verticesPerQuad, textureMatrix);
     }
 }
 
@@ -1264,6 +1550,297 @@ void WindowQuadList::makeArrays(float **vertices, float **texcoords, const QSize
     }
 }
 
+/***************************************************************
+ WindowQuadBuffer
+***************************************************************/
+
+struct QuadBounds
+{
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+static inline QuadBounds quadBounds(const float *x, const float *y)
+{
+    const Float4 xs = loadFloat4(x);
+    const Float4 ys = loadFloat4(y);
+    return QuadBounds{horizontalMin(xs), horizontalMin(ys), horizontalMax(xs), horizontalMax(ys)};
+}
+
+// Computes the texture coordinates of sub-quads with bilinear interpolation, the same way as
+// WindowQuad::makeSubQuad() does.
+class SubQuadInterpolator
+{
+public:
+    SubQuadInterpolator(const float *u, const float *v, const QuadBounds &bounds)
+        : m_left(splatFloat4(bounds.left))
+        , m_top(splatFloat4(bounds.top))
+        , m_widthReciprocal(splatFloat4(1 / (bounds.right - bounds.left)))
+        , m_heightReciprocal(splatFloat4(1 / (bounds.bottom - bounds.top)))
+        , m_u{splatFloat4(u[0]), splatFloat4(u[1]), splatFloat4(u[2]), splatFloat4(u[3])}
+        , m_v{splatFloat4(v[0]), splatFloat4(v[1]), splatFloat4(v[2]), splatFloat4(v[3])}
+    {
+    }
+
+    void write(float x1, float y1, float x2, float y2, float *x, float *y, float *u, float *v) const
+    {
+        // vertices are clockwise starting from topleft
+        const Float4 px = setFloat4(x1, x2, x2, x1);
+        const Float4 py = setFloat4(y1, y1, y2, y2);
+
+        const Float4 one = splatFloat4(1);
+        const Float4 w1 = mulFloat4(subFloat4(px, m_left), m_widthReciprocal);
+        const Float4 w2 = mulFloat4(subFloat4(py, m_top), m_heightReciprocal);
+        const Float4 invW1 = subFloat4(one, w1);
+        const Float4 invW2 = subFloat4(one, w2);
+
+        // The weights of the four corners of the original quad
+        const Float4 c0 = mulFloat4(invW1, invW2);
+        const Float4 c1 = mulFloat4(w1, invW2);
+        const Float4 c2 = mulFloat4(w1, w2);
+        const Float4 c3 = mulFloat4(invW1, w2);
+
+        storeFloat4(x, px);
+        storeFloat4(y, py);
+        storeFloat4(u, addFloat4(addFloat4(mulFloat4(c0, m_u[0]), mulFloat4(c1, m_u[1])),
+                                 addFloat4(mulFloat4(c2, m_u[2]), mulFloat4(c3, m_u[3]))));
+        storeFloat4(v, addFloat4(addFloat4(mulFloat4(c0, m_v[0]), mulFloat4(c1, m_v[1])),
+                                 addFloat4(mulFloat4(c2, m_v[2]), mulFloat4(c3, m_v[3]))));
+    }
+
+private:
+    const Float4 m_left;
+    const Float4 m_top;
+    const Float4 m_widthReciprocal;
+    const Float4 m_heightReciprocal;
+    const Float4 m_u[4];
+    const Float4 m_v[4];
+};
+
+WindowQuadBuffer::WindowQuadBuffer()
+{
+}
+
+WindowQuadBuffer::WindowQuadBuffer(const WindowQuadList &quads)
+{
+    resize(quads.count());
+
+    float *x = m_x.data();
+    float *y = m_y.data();
+    float *u = m_u.data();
+    float *v = m_v.data();
+
+    for (const WindowQuad &quad : quads) {
+        for (int j = 0; j < 4; ++j) {
+            const WindowVertex &wv = quad[j];
+            *(x++) = wv.x();
+            *(y++) = wv.y();
+            *(u++) = wv.u();
+            *(v++) = wv.v();
+        }
+    }
+}
+
+void WindowQuadBuffer::resize(int quadCount)
+{
+    m_x.resize(quadCount * 4);
+    m_y.resize(quadCount * 4);
+    m_u.resize(quadCount * 4);
+    m_v.resize(quadCount * 4);
+}
+
+void WindowQuadBuffer::reserve(int quadCount)
+{
+    m_x.reserve(quadCount * 4);
+    m_y.reserve(quadCount * 4);
+    m_u.reserve(quadCount * 4);
+    m_v.reserve(quadCount * 4);
+}
+
+void WindowQuadBuffer::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_u.clear();
+    m_v.clear();
+}
+
+void WindowQuadBuffer::append(const WindowQuad &quad)
+{
+    for (int j = 0; j < 4; ++j) {
+        const WindowVertex &wv = quad[j];
+        m_x.append(wv.x());
+        m_y.append(wv.y());
+        m_u.append(wv.u());
+        m_v.append(wv.v());
+    }
+}
+
+WindowQuad WindowQuadBuffer::at(int index) const
+{
+    Q_ASSERT(index >= 0 && index < count());
+    WindowQuad quad;
+    for (int j = 0; j < 4; ++j) {
+        const int i = index * 4 + j;
+        quad[j] = WindowVertex(m_x[i], m_y[i], m_u[i], m_v[i]);
+    }
+    return quad;
+}
+
+WindowQuadList WindowQuadBuffer::toWindowQuadList() const
+{
+    WindowQuadList ret;
+    ret.reserve(count());
+    for (int i = 0; i < count(); ++i) {
+        ret.append(at(i));
+    }
+    return ret;
+}
+
+QRectF WindowQuadBuffer::boundingRect() const
+{
+    if (isEmpty()) {
+        return QRectF();
+    }
+
+    Float4 left = loadFloat4(m_x.constData());
+    Float4 right = left;
+    Float4 top = loadFloat4(m_y.constData());
+    Float4 bottom = top;
+
+    for (int i = 4; i < m_x.count(); i += 4) {
+        const Float4 xs = loadFloat4(m_x.constData() + i);
+        const Float4 ys = loadFloat4(m_y.constData() + i);
+        left = minFloat4(left, xs);
+        right = maxFloat4(right, xs);
+        top = minFloat4(top, ys);
+        bottom = maxFloat4(bottom, ys);
+    }
+
+    return QRectF(QPointF(horizontalMin(left), horizontalMin(top)),
+                  QPointF(horizontalMax(right), horizontalMax(bottom)));
+}
+
+WindowQuadBuffer WindowQuadBuffer::makeGrid(int maxQuadSize) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    const QRectF bounds = boundingRect();
+    return subdivided(bounds.left(), bounds.top(), maxQuadSize, maxQuadSize);
+}
+
+WindowQuadBuffer WindowQuadBuffer::makeRegularGrid(int xSubdivisions, int ySubdivisions) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    const QRectF bounds = boundingRect();
+    return subdivided(bounds.left(), bounds.top(), bounds.width() / xSubdivisions, bounds.height() / ySubdivisions);
+}
+
+WindowQuadBuffer WindowQuadBuffer::subdivided(double left, double top, double xIncrement, double yIncrement) const
+{
+    // Count the sub-quads first, so the buffer is allocated only once
+    int subQuadCount = 0;
+    for (int source = 0; source < m_x.count(); source += 4) {
+        const QuadBounds bounds = quadBounds(m_x.constData() + source, m_y.constData() + source);
+        if (bounds.left == bounds.right || bounds.top == bounds.bottom) {
+            subQuadCount++;
+            continue;
+        }
+
+        forEachGridCell(bounds.left, bounds.top, bounds.right, bounds.bottom, left, top, xIncrement, yIncrement,
+                        [&subQuadCount](double, double, double, double) {
+                            subQuadCount++;
+                        });
+    }
+
+    WindowQuadBuffer ret;
+    ret.resize(subQuadCount);
+
+    float *x = ret.m_x.data();
+    float *y = ret.m_y.data();
+    float *u = ret.m_u.data();
+    float *v = ret.m_v.data();
+
+    for (int source = 0; source < m_x.count(); source += 4) {
+        const QuadBounds bounds = quadBounds(m_x.constData() + source, m_y.constData() + source);
+
+        // sanity check, see BUG 390953
+        if (bounds.left == bounds.right || bounds.top == bounds.bottom) {
+            storeFloat4(x, loadFloat4(m_x.constData() + source));
+            storeFloat4(y, loadFloat4(m_y.constData() + source));
+            storeFloat4(u, loadFloat4(m_u.constData() + source));
+            storeFloat4(v, loadFloat4(m_v.constData() + source));
+            x += 4;
+            y += 4;
+            u += 4;
+            v += 4;
+            continue;
+        }
+
+        const SubQuadInterpolator interpolator(m_u.constData() + source, m_v.constData() + source, bounds);
+        forEachGridCell(bounds.left, bounds.top, bounds.right, bounds.bottom, left, top, xIncrement, yIncrement,
+                        [&](double x0, double y0, double x1, double y1) {
+                            interpolator.write(x0, y0, x1, y1, x, y, u, v);
+                            x += 4;
+                            y += 4;
+                            u += 4;
+                            v += 4;
+                        });
+    }
+
+    return ret;
+}
+
+WindowQuadBuffer WindowQuadBuffer::clipped(const QRectF &rect) const
+{
+    const float clipLeft = rect.left();
+    const float clipTop = rect.top();
+    const float clipRight = rect.right();
+    const float clipBottom = rect.bottom();
+
+    // Every quad yields at most one quad
+    WindowQuadBuffer ret;
+    ret.resize(count());
+
+    int target = 0;
+    for (int source = 0; source < m_x.count(); source += 4) {
+        const QuadBounds bounds = quadBounds(m_x.constData() + source, m_y.constData() + source);
+        if (bounds.right <= clipLeft || bounds.left >= clipRight || bounds.bottom <= clipTop || bounds.top >= clipBottom) {
+            continue;
+        }
+
+        const bool inside = bounds.left >= clipLeft && bounds.right <= clipRight && bounds.top >= clipTop && bounds.bottom <= clipBottom;
+        if (inside || bounds.left == bounds.right || bounds.top == bounds.bottom) {
+            storeFloat4(ret.m_x.data() + target, loadFloat4(m_x.constData() + source));
+            storeFloat4(ret.m_y.data() + target, loadFloat4(m_y.constData() + source));
+            storeFloat4(ret.m_u.data() + target, loadFloat4(m_u.constData() + source));
+            storeFloat4(ret.m_v.data() + target, loadFloat4(m_v.constData() + source));
+        } else {
+            const SubQuadInterpolator interpolator(m_u.constData() + source, m_v.constData() + source, bounds);
+            interpolator.write(std::max(bounds.left, clipLeft), std::max(bounds.top, clipTop),
+                               std::min(bounds.right, clipRight), std::min(bounds.bottom, clipBottom),
+                               ret.m_x.data() + target, ret.m_y.data() + target,
+                               ret.m_u.data() + target, ret.m_v.data() + target);
+        }
+        target += 4;
+    }
+
+    ret.resize(target / 4);
+    return ret;
+}
+
+void WindowQuadBuffer::makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &matrix) const
+{
+    interleaveQuads(type, m_x.constData(), m_y.constData(), m_u.constData(), m_v.constData(), count(), vertices, matrix);
+}
+
 /***************************************************************
  Motion1D
 ***************************************************************/
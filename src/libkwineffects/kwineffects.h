@@ -180,7 +180,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION(major, minor) ((major) << 8 | (minor))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 234
+#define KWIN_EFFECT_API_VERSION_MINOR 235
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
     KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR)
 
@@ -1175,6 +1175,12 @@ public:
     Q_SCRIPTABLE virtual void addRepaint(const QRect &r) = 0;
     Q_SCRIPTABLE virtual void addRepaint(const QRegion &r) = 0;
     Q_SCRIPTABLE virtual void addRepaint(int x, int y, int w, int h) = 0;
+    /**
+     * Schedules a new frame on the given @a screen without repainting anything. This is
+     * meant for effects that find out what needs to be repainted only in prePaintScreen().
+     * @since 5.26
+     */
+    virtual void scheduleRepaint(EffectScreen *screen) = 0;
 
     CompositingType compositingType() const;
     /**
@@ -0,0 +1,174 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglshadercache_p.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b574753; // "KWGS"
+static const quint32 s_version = 1;
+
+static bool supportsRetrievableHint()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        return hasGLVersion(3, 0);
+    }
+    return hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+}
+
+GLShaderCache::GLShaderCache()
+{
+    bool ok;
+    const int enabled = qEnvironmentVariableIntValue("KWIN_GL_SHADER_CACHE", &ok);
+    if (ok && !enabled) {
+        return;
+    }
+
+    GLPlatform *platform = GLPlatform::instance();
+    const bool supported = platform->isGLES()
+        ? hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))
+        : hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+    if (!supported) {
+        return;
+    }
+
+    // Some drivers advertise the extension without supporting any binary format.
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        return;
+    }
+
+    const QString cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (cacheDirectory.isEmpty()) {
+        return;
+    }
+    m_directory = cacheDirectory + QLatin1String("/kwin/glsl");
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the shader cache directory" << m_directory;
+        return;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(platform->glVendorString());
+    hash.addData(platform->glRendererString());
+    hash.addData(platform->glVersionString());
+    hash.addData(platform->glShadingLanguageVersionString());
+    m_driverId = hash.result();
+
+    m_valid = true;
+}
+
+bool GLShaderCache::isValid() const
+{
+    return m_valid;
+}
+
+QByteArray GLShaderCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &salt) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_driverId);
+    hash.addData(salt);
+    hash.addData(QByteArrayLiteral("\0vertex\0"));
+    hash.addData(vertexSource);
+    hash.addData(QByteArrayLiteral("\0fragment\0"));
+    hash.addData(fragmentSource);
+    return hash.result().toHex();
+}
+
+QString GLShaderCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1String(".bin");
+}
+
+void GLShaderCache::prepare(GLuint program) const
+{
+    if (supportsRetrievableHint()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool GLShaderCache::load(GLuint program, const QByteArray &key) const
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 format = 0;
+    QByteArray binary;
+    stream >> magic >> version >> format >> binary;
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version || binary.isEmpty()) {
+        qCDebug(LIBKWINGLUTILS) << "Discarding malformed shader cache entry" << file.fileName();
+        file.remove();
+        return false;
+    }
+
+    glProgramBinary(program, format, binary.constData(), binary.size());
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        // The driver may reject binaries produced by an older build even if the version
+        // string hasn't changed. The program will be linked from the sources instead.
+        qCDebug(LIBKWINGLUTILS) << "Discarding stale shader cache entry" << file.fileName();
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+void GLShaderCache::store(GLuint program, const QByteArray &key) const
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.truncate(written);
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to open" << file.fileName() << "for writing";
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << s_magic << s_version << quint32(format) << binary;
+    if (!file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write shader cache entry" << file.fileName();
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,74 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_GLSHADERCACHE_P_H
+#define KWIN_GLSHADERCACHE_P_H
+
+#include <QByteArray>
+#include <QString>
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The GLShaderCache class stores linked shader programs on disk in the driver-specific
+ * binary format, so they don't have to be compiled and linked again the next time.
+ *
+ * Cache entries are keyed by the driver identification strings and the shader sources.
+ * A driver update invalidates all previous entries. If the driver rejects a stored binary,
+ * the caller falls back to compiling the shader and the entry is overwritten.
+ *
+ * The cache can be disabled by setting the KWIN_GL_SHADER_CACHE environment variable to 0.
+ */
+class GLShaderCache
+{
+public:
+    GLShaderCache();
+
+    /**
+     * Returns @c true if program binaries are supported by the driver and the cache can
+     * be used; otherwise returns @c false.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns the cache key for the program built from the given sources. The @a salt
+     * identifies everything else that affects the linked program, e.g. attribute bindings.
+     */
+    QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &salt) const;
+
+    /**
+     * Loads the cached binary with the given @a key into the @a program. Returns @c true
+     * if the program has been loaded and linked successfully; otherwise returns @c false.
+     */
+    bool load(GLuint program, const QByteArray &key) const;
+
+    /**
+     * Stores the binary of the linked @a program under the given @a key.
+     */
+    void store(GLuint program, const QByteArray &key) const;
+
+    /**
+     * Marks the @a program so that the driver keeps its binary retrievable. This must be
+     * called before linking the program.
+     */
+    void prepare(GLuint program) const;
+
+private:
+    QString filePath(const QByteArray &key) const;
+
+    QString m_directory;
+    QByteArray m_driverId;
+    bool m_valid = false;
+};
+
+} // namespace KWin
+
+#endif
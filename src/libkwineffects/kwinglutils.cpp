@@ -13,6 +13,8 @@
 // need to call GLTexturePrivate::initStatic()
 #include "kwingltexture_p.h"
 
+#include "kwinglshadercache_p.h"
+
 #include "kwineffects.h"
 #include "kwinglplatform.h"
 #include "logging_p.h"
@@ -153,6 +155,7 @@ void initGL(const std::function<resolveFuncPtr(const char *)> &resolveFunction)
 
     GLTexturePrivate::initStatic();
     GLFramebuffer::initStatic();
+    GLRenderTimeQuery::initStatic();
     GLVertexBuffer::initStatic();
 }
 
@@ -161,6 +164,7 @@ void cleanupGL()
     ShaderManager::cleanup();
     GLTexturePrivate::cleanup();
     GLFramebuffer::cleanup();
+    GLRenderTimeQuery::cleanup();
     GLVertexBuffer::cleanup();
     GLPlatform::cleanup();
 
@@ -641,6 +645,7 @@ void ShaderManager::cleanup()
 }
 
 ShaderManager::ShaderManager()
+    : m_cache(std::make_unique<GLShaderCache>())
 {
 }
 
@@ -805,13 +810,20 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
 #endif
 
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+
+    // The salt identifies the attribute bindings below.
+    const QByteArray cacheKey = m_cache->isValid() ? m_cache->key(vertex, fragment, QByteArrayLiteral("position,texcoord")) : QByteArray();
+    if (loadCachedShader(shader, cacheKey)) {
+        return shader;
+    }
+
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
-    shader->link();
+    linkShader(shader, cacheKey);
     return shader;
 }
 
@@ -936,13 +948,42 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+
+    // The salt identifies the attribute bindings in bindAttributeLocations().
+    const QByteArray cacheKey = m_cache->isValid() ? m_cache->key(vertexSource, fragmentSource, QByteArrayLiteral("vertex,texCoord")) : QByteArray();
+    if (loadCachedShader(shader, cacheKey)) {
+        return shader;
+    }
+
     shader->load(vertexSource, fragmentSource);
     bindAttributeLocations(shader);
     bindFragDataLocations(shader);
-    shader->link();
+    linkShader(shader, cacheKey);
     return shader;
 }
 
+bool ShaderManager::loadCachedShader(GLShader *shader, const QByteArray &cacheKey)
+{
+    if (cacheKey.isEmpty() || !m_cache->load(shader->mProgram, cacheKey)) {
+        return false;
+    }
+    shader->mValid = true;
+    return true;
+}
+
+void ShaderManager::linkShader(GLShader *shader, const QByteArray &cacheKey)
+{
+    if (cacheKey.isEmpty()) {
+        shader->link();
+        return;
+    }
+
+    m_cache->prepare(shader->mProgram);
+    if (shader->link()) {
+        m_cache->store(shader->mProgram, cacheKey);
+    }
+}
+
 /***  GLFramebuffer  ***/
 bool GLFramebuffer::sSupported = false;
 bool GLFramebuffer::s_blitSupported = false;
@@ -1166,6 +1207,112 @@ void GLFramebuffer::blitFromFramebuffer(const QRect &source, const QRect &destin
     GLFramebuffer::popFramebuffer();
 }
 
+/***  GLRenderTimeQuery  ***/
+bool GLRenderTimeQuery::s_supported = false;
+bool GLRenderTimeQuery::s_disjointSupported = false;
+
+void GLRenderTimeQuery::initStatic()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        s_supported = hasGLExtension(QByteArrayLiteral("GL_EXT_disjoint_timer_query"));
+        s_disjointSupported = s_supported;
+    } else {
+        s_supported = hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"));
+        s_disjointSupported = false;
+    }
+}
+
+void GLRenderTimeQuery::cleanup()
+{
+    s_supported = false;
+    s_disjointSupported = false;
+}
+
+bool GLRenderTimeQuery::supported()
+{
+    return s_supported;
+}
+
+GLRenderTimeQuery::GLRenderTimeQuery()
+{
+    if (s_supported) {
+        glGenQueries(2, m_queries);
+    }
+}
+
+GLRenderTimeQuery::~GLRenderTimeQuery()
+{
+    if (m_queries[0]) {
+        glDeleteQueries(2, m_queries);
+    }
+}
+
+void GLRenderTimeQuery::begin()
+{
+    if (!m_queries[0]) {
+        return;
+    }
+    if (s_disjointSupported) {
+        // Reading the disjoint state resets it, so only the disjoint operations that happen
+        // during this measurement are reported in result().
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+    glQueryCounter(m_queries[0], GL_TIMESTAMP);
+    m_pending = false;
+}
+
+void GLRenderTimeQuery::end()
+{
+    if (!m_queries[0]) {
+        return;
+    }
+    glQueryCounter(m_queries[1], GL_TIMESTAMP);
+    m_pending = true;
+}
+
+bool GLRenderTimeQuery::isPending() const
+{
+    return m_pending;
+}
+
+void GLRenderTimeQuery::discard()
+{
+    m_pending = false;
+}
+
+std::optional<std::chrono::nanoseconds> GLRenderTimeQuery::result()
+{
+    if (!m_pending) {
+        return std::nullopt;
+    }
+
+    // The queries complete in order, so the first one is done if the second one is.
+    GLuint available = 0;
+    glGetQueryObjectuiv(m_queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return std::nullopt;
+    }
+    m_pending = false;
+
+    if (s_disjointSupported) {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint) {
+            return std::nullopt;
+        }
+    }
+
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &end);
+    if (end < start) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(end - start);
+}
+
 // ------------------------------------------------------------------
 
 static const uint16_t indices[] = {
@@ -20,6 +20,10 @@
 #include <QSize>
 #include <QStack>
 
+#include <chrono>
+#include <memory>
+#include <optional>
+
 /** @addtogroup kwineffects */
 /** @{ */
 
@@ -34,6 +38,7 @@ class QHash;
 namespace KWin
 {
 
+class GLShaderCache;
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
 
@@ -303,8 +308,12 @@ private:
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     GLShader *generateShader(ShaderTraits traits);
 
+    bool loadCachedShader(GLShader *shader, const QByteArray &cacheKey);
+    void linkShader(GLShader *shader, const QByteArray &cacheKey);
+
     QStack<GLShader *> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
+    std::unique_ptr<GLShaderCache> m_cache;
     static ShaderManager *s_shaderManager;
 };
 
@@ -488,6 +497,74 @@ private:
     bool mForeign = false;
 };
 
+/**
+ * @short Measures how long the GPU takes to execute rendering commands.
+ *
+ * The time it takes to execute the commands issued between begin() and end() is measured
+ * using timer queries. The result is read back without stalling the pipeline, so it only
+ * becomes available after the GPU has finished executing the commands, for example after
+ * the frame has been presented.
+ *
+ * The query objects belong to the current OpenGL context, which must also be current when
+ * the GLRenderTimeQuery is destroyed.
+ *
+ * @since 5.26
+ */
+class KWINGLUTILS_EXPORT GLRenderTimeQuery
+{
+public:
+    GLRenderTimeQuery();
+    ~GLRenderTimeQuery();
+
+    /**
+     * Returns @c true if timer queries are supported by the OpenGL implementation.
+     */
+    static bool supported();
+
+    /**
+     * Starts measuring. Any result that hasn't been retrieved yet is discarded.
+     */
+    void begin();
+    /**
+     * Stops measuring.
+     */
+    void end();
+
+    /**
+     * Returns @c true if the measurement has been started and its result hasn't been retrieved yet.
+     */
+    bool isPending() const;
+
+    /**
+     * Discards the pending measurement without reading its result back.
+     */
+    void discard();
+
+    /**
+     * Returns the time the GPU spent executing the commands between begin() and end(), or
+     * @c std::nullopt if the GPU hasn't finished executing them yet or the measurement has
+     * been invalidated, e.g. because the GPU was reset.
+     */
+    std::optional<std::chrono::nanoseconds> result();
+
+    /**
+     * @internal
+     */
+    static void initStatic();
+
+    /**
+     * @internal
+     */
+    static void cleanup();
+
+private:
+    static bool s_supported;
+    static bool s_disjointSupported;
+
+    GLuint m_queries[2] = {0, 0};
+    bool m_pending = false;
+};
+
 enum VertexAttributeType {
     VA_Position = 0,
     VA_TexCoord = 1,
@@ -25,16 +25,58 @@
 #include <QOffscreenSurface>
 #include <QOpenGLContext>
 #include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
 #include <QTimer>
+#include <QVector2D>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QQuickOpenGLUtils>
 #include <QQuickRenderTarget>
 #include <private/qeventpoint_p.h> // for QMutableEventPoint
 #endif
 
+#include <cstring>
+
 namespace KWin
 {
 
+// The damage is tracked in square tiles of this size, in device pixels.
+static const int s_damageTileSize = 16;
+
+static const char s_damageVertexShader[] = R"(
+attribute highp vec2 position;
+
+void main()
+{
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+// Every fragment covers one tile, it's set to 1 if any pixel in the tile has changed.
+static const char s_damageFragmentShader[] = R"(
+#ifdef GL_ES
+precision highp float;
+#endif
+
+uniform sampler2D current;
+uniform sampler2D previous;
+uniform vec2 bufferSize;
+
+void main()
+{
+    vec2 origin = floor(gl_FragCoord.xy) * 16.0;
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            vec2 texCoord = (origin + vec2(float(x), float(y)) + 0.5) / bufferSize;
+            if (texture2D(current, texCoord) != texture2D(previous, texCoord)) {
+                gl_FragColor = vec4(1.0);
+                return;
+            }
+        }
+    }
+    gl_FragColor = vec4(0.0);
+}
+)";
+
 class EffectQuickRenderControl : public QQuickRenderControl
 {
     Q_OBJECT
@@ -66,10 +108,18 @@ public:
     QScopedPointer<QOffscreenSurface> m_offscreenSurface;
     QScopedPointer<QOpenGLContext> m_glcontext;
     QScopedPointer<QOpenGLFramebufferObject> m_fbo;
+    // The buffer with the previous frame, it's swapped with m_fbo on every update. Only views
+    // that read their contents back use it.
+    QScopedPointer<QOpenGLFramebufferObject> m_previousFbo;
+    QScopedPointer<QOpenGLFramebufferObject> m_damageFbo;
+    QScopedPointer<QOpenGLShaderProgram> m_damageProgram;
+    QRegion m_damage;
 
     QTimer *m_repaintTimer;
     QImage m_image;
     QScopedPointer<GLTexture> m_textureExport;
+    // The region of m_image that hasn't been uploaded to m_textureExport yet, in device pixels.
+    QRegion m_exportDamage;
     // if we should capture a QImage after rendering into our BO.
     // Used for either software QtQuick rendering and nonGL kwin rendering
     bool m_useBlit = false;
@@ -90,6 +140,9 @@ public:
 
     void releaseResources();
 
+    QRegion computeDamage();
+    void readPixels(const QRegion &region);
+
     void updateTouchState(Qt::TouchPointState state, qint32 id, const QPointF &pos);
 };
 
@@ -242,6 +295,31 @@ void OffscreenQuickView::handleRenderRequested()
     Q_EMIT renderRequested();
 }
 
+static QRegion imageDamage(const QImage &previous, const QImage &current)
+{
+    if (previous.size() != current.size() || previous.format() != current.format()) {
+        return current.rect();
+    }
+
+    QRegion damage;
+    const int bytesPerPixel = current.depth() / 8;
+    for (int y = 0; y < current.height(); y += s_damageTileSize) {
+        const int tileHeight = std::min(s_damageTileSize, current.height() - y);
+        for (int x = 0; x < current.width(); x += s_damageTileSize) {
+            const int tileWidth = std::min(s_damageTileSize, current.width() - x);
+            for (int row = y; row < y + tileHeight; ++row) {
+                if (memcmp(previous.constScanLine(row) + x * bytesPerPixel,
+                           current.constScanLine(row) + x * bytesPerPixel,
+                           tileWidth * bytesPerPixel)) {
+                    damage += QRect(x, y, tileWidth, tileHeight);
+                    break;
+                }
+            }
+        }
+    }
+    return damage;
+}
+
 void OffscreenQuickView::update()
 {
     if (!d->m_visible) {
@@ -262,9 +340,19 @@ void OffscreenQuickView::update()
         const QSize nativeSize = d->m_view->size() * d->m_view->effectiveDevicePixelRatio();
         if (d->m_fbo.isNull() || d->m_fbo->size() != nativeSize) {
             d->m_textureExport.reset(nullptr);
+            d->m_fbo.reset();
+            d->m_previousFbo.reset();
+        } else if (d->m_useBlit) {
+            // Render into the other buffer, so the damage can be computed by comparing the new
+            // frame with the previous one. That pays off only if the contents are read back,
+            // views that export their texture are damaged as a whole instead of stalling the GPU.
+            d->m_previousFbo.swap(d->m_fbo);
+        }
+        if (d->m_fbo.isNull()) {
             d->m_fbo.reset(new QOpenGLFramebufferObject(nativeSize, QOpenGLFramebufferObject::CombinedDepthStencil));
             if (!d->m_fbo->isValid()) {
                 d->m_fbo.reset();
+                d->m_previousFbo.reset();
                 d->m_glcontext->doneCurrent();
                 return;
             }
@@ -279,24 +367,54 @@ void OffscreenQuickView::update()
     d->m_renderControl->polishItems();
     d->m_renderControl->sync();
 
+    // QtQuick doesn't expose the dirty region of the scene graph and its renderer resets the
+    // scissor state, so the whole view is rendered. The damage is worked out afterwards.
     d->m_renderControl->render();
+
+    QRegion nativeDamage;
     if (usingGl) {
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
         d->m_view->resetOpenGLState();
 #else
         QQuickOpenGLUtils::resetOpenGLState();
 #endif
+
+        if (d->m_useBlit) {
+            // Only the damaged parts of the buffer are read back.
+            nativeDamage = d->computeDamage();
+            d->readPixels(nativeDamage);
+        } else {
+            nativeDamage = QRect(QPoint(0, 0), d->m_fbo->size());
+        }
+
+        QOpenGLFramebufferObject::bindDefault();
+        d->m_glcontext->doneCurrent();
+    } else {
+        const QImage image = d->m_renderControl->grab();
+        nativeDamage = imageDamage(d->m_image, image);
+        d->m_image = image;
     }
 
     if (d->m_useBlit) {
-        d->m_image = d->m_renderControl->grab();
+        d->m_exportDamage += nativeDamage;
     }
 
-    if (usingGl) {
-        QOpenGLFramebufferObject::bindDefault();
-        d->m_glcontext->doneCurrent();
+    const qreal devicePixelRatio = d->m_view->effectiveDevicePixelRatio();
+    d->m_damage = QRegion();
+    for (const QRect &rect : nativeDamage) {
+        d->m_damage += QRectF(rect.x() / devicePixelRatio, rect.y() / devicePixelRatio,
+                              rect.width() / devicePixelRatio, rect.height() / devicePixelRatio)
+                           .toAlignedRect();
+    }
+
+    if (!d->m_damage.isEmpty()) {
+        Q_EMIT repaintNeeded();
     }
-    Q_EMIT repaintNeeded();
+}
+
+QRegion OffscreenQuickView::damage() const
+{
+    return d->m_damage;
 }
 
 void OffscreenQuickView::forwardMouseEvent(QEvent *e)
@@ -469,7 +587,14 @@ GLTexture *OffscreenQuickView::bufferAsTexture()
         if (d->m_image.isNull()) {
             return nullptr;
         }
-        d->m_textureExport.reset(new GLTexture(d->m_image));
+        if (!d->m_textureExport || d->m_textureExport->size() != d->m_image.size()) {
+            d->m_textureExport.reset(new GLTexture(d->m_image));
+        } else {
+            for (const QRect &rect : qAsConst(d->m_exportDamage)) {
+                d->m_textureExport->update(d->m_image, rect.topLeft(), rect);
+            }
+        }
+        d->m_exportDamage = QRegion();
     } else {
         if (!d->m_fbo) {
             return nullptr;
@@ -509,6 +634,116 @@ void OffscreenQuickView::Private::releaseResources()
     }
 }
 
+QRegion OffscreenQuickView::Private::computeDamage()
+{
+    const QSize bufferSize = m_fbo->size();
+    const QRect bufferRect(QPoint(0, 0), bufferSize);
+    if (!m_previousFbo) {
+        return bufferRect;
+    }
+
+    if (!m_damageProgram) {
+        m_damageProgram.reset(new QOpenGLShaderProgram);
+        m_damageProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, s_damageVertexShader);
+        m_damageProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, s_damageFragmentShader);
+        m_damageProgram->bindAttributeLocation("position", 0);
+        if (!m_damageProgram->link()) {
+            qCWarning(LIBKWINEFFECTS) << "Failed to link the damage tracking shader:" << m_damageProgram->log();
+        }
+    }
+    if (!m_damageProgram->isLinked()) {
+        return bufferRect;
+    }
+
+    const QSize tileCount((bufferSize.width() + s_damageTileSize - 1) / s_damageTileSize,
+                          (bufferSize.height() + s_damageTileSize - 1) / s_damageTileSize);
+    if (!m_damageFbo || m_damageFbo->size() != tileCount) {
+        m_damageFbo.reset(new QOpenGLFramebufferObject(tileCount));
+    }
+
+    m_damageFbo->bind();
+    glViewport(0, 0, tileCount.width(), tileCount.height());
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_previousFbo->texture());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_fbo->texture());
+
+    static const GLfloat vertices[] = {
+        -1.0, -1.0,
+        1.0, -1.0,
+        -1.0, 1.0,
+        1.0, 1.0,
+    };
+
+    m_damageProgram->bind();
+    m_damageProgram->setUniformValue("current", 0);
+    m_damageProgram->setUniformValue("previous", 1);
+    m_damageProgram->setUniformValue("bufferSize", QVector2D(bufferSize.width(), bufferSize.height()));
+    m_damageProgram->enableAttributeArray(0);
+    m_damageProgram->setAttributeArray(0, GL_FLOAT, vertices, 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_damageProgram->disableAttributeArray(0);
+    m_damageProgram->release();
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    QVector<quint32> tiles(tileCount.width() * tileCount.height());
+    glReadPixels(0, 0, tileCount.width(), tileCount.height(), GL_RGBA, GL_UNSIGNED_BYTE, tiles.data());
+
+    // The rows of the buffer are stored bottom to top, merge adjacent damaged tiles in every
+    // row and flip them to get the damage in the image coordinates.
+    QRegion damage;
+    for (int row = 0; row < tileCount.height(); ++row) {
+        const quint32 *tileRow = tiles.constData() + row * tileCount.width();
+        for (int column = 0; column < tileCount.width();) {
+            if (!tileRow[column]) {
+                ++column;
+                continue;
+            }
+            const int start = column;
+            while (column < tileCount.width() && tileRow[column]) {
+                ++column;
+            }
+            const QRect rect = QRect(start * s_damageTileSize, row * s_damageTileSize,
+                                     (column - start) * s_damageTileSize, s_damageTileSize)
+                                   .intersected(bufferRect);
+            damage += QRect(rect.x(), bufferSize.height() - rect.y() - rect.height(), rect.width(), rect.height());
+        }
+    }
+
+    return damage;
+}
+
+void OffscreenQuickView::Private::readPixels(const QRegion &region)
+{
+    const QSize bufferSize = m_fbo->size();
+
+    QRegion dirty = region;
+    if (m_image.size() != bufferSize) {
+        m_image = QImage(bufferSize, QImage::Format_RGBA8888_Premultiplied);
+        dirty = m_image.rect();
+    }
+    m_image.setDevicePixelRatio(m_view->effectiveDevicePixelRatio());
+
+    m_fbo->bind();
+    for (const QRect &rect : qAsConst(dirty)) {
+        QImage chunk(rect.size(), QImage::Format_RGBA8888_Premultiplied);
+        glReadPixels(rect.x(), bufferSize.height() - rect.y() - rect.height(), rect.width(), rect.height(),
+                     GL_RGBA, GL_UNSIGNED_BYTE, chunk.bits());
+
+        // The rows are read bottom to top.
+        for (int i = 0; i < rect.height(); ++i) {
+            memcpy(m_image.scanLine(rect.y() + i) + rect.x() * 4,
+                   chunk.constScanLine(rect.height() - i - 1),
+                   rect.width() * 4);
+        }
+    }
+}
+
 void OffscreenQuickView::Private::updateTouchState(Qt::TouchPointState state, qint32 id, const QPointF &pos)
 {
     // Remove the points that were previously in a released state, since they
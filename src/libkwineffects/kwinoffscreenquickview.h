@@ -11,6 +11,7 @@
 
 #include <QObject>
 #include <QRect>
+#include <QRegion>
 #include <QUrl>
 
 #include <kwineffects_export.h>
@@ -108,6 +109,18 @@ public:
      */
     void update();
 
+    /**
+     * Returns the region of the view that has changed during the last update(),
+     * in the view-local logical coordinates.
+     *
+     * QtQuick always renders the whole view, the damage only limits what is read back and
+     * repainted afterwards. For views that export an image, it's computed by comparing the new
+     * contents of the buffer with the previous ones in 16x16 tiles, the whole view is damaged
+     * after the view has been resized. Views that export a texture are always damaged as a
+     * whole, their dirty region is not tracked.
+     */
+    QRegion damage() const;
+
     /** The invisble root item of the window*/
     QQuickItem *contentItem() const;
     QQuickWindow *window() const;
@@ -114,8 +114,10 @@ void QuickSceneView::resetDirty()
 
 void QuickSceneView::scheduleRepaint()
 {
+    // The view is updated in prePaintScreen(), that's when the damaged area is known. With
+    // OpenGL compositing, the view exports a texture, so the damage is the whole view.
     markDirty();
-    effects->addRepaint(geometry());
+    effects->scheduleRepaint(m_screen);
 }
 
 QuickSceneEffect::QuickSceneEffect(QObject *parent)
@@ -243,12 +245,14 @@ void QuickSceneEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::mil
         if (screenView && screenView->isDirty()) {
             screenView->update();
             screenView->resetDirty();
+            data.paint += screenView->damage().translated(screenView->geometry().topLeft());
         }
     } else {
         for (QuickSceneView *screenView : qAsConst(d->views)) {
             if (screenView->isDirty()) {
                 screenView->update();
                 screenView->resetDirty();
+                data.paint += screenView->damage().translated(screenView->geometry().topLeft());
             }
         }
     }
@@ -305,9 +309,6 @@ void QuickSceneEffect::addScreen(EffectScreen *screen)
     }
     view->setAutomaticRepaint(false);
 
-    connect(view, &QuickSceneView::repaintNeeded, this, [view]() {
-        effects->addRepaint(view->geometry());
-    });
     connect(view, &QuickSceneView::renderRequested, view, &QuickSceneView::scheduleRepaint);
     connect(view, &QuickSceneView::sceneChanged, view, &QuickSceneView::scheduleRepaint);
 
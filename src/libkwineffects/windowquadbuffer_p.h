@@ -0,0 +1,116 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwineffects.h"
+
+namespace KWin
+{
+
+/**
+ * @short Structure-of-arrays storage for window quads.
+ *
+ * The positions and the texture coordinates of the vertices are stored as floats in four
+ * separate arrays, every quad occupies four consecutive entries in the same clockwise order
+ * as the vertices of a WindowQuad. Subdividing and clipping quads and generating vertex data
+ * for the GPU process the four vertices of a quad at once with SIMD instructions.
+ *
+ * Unlike WindowQuadList, the texture coordinates are computed in single precision.
+ *
+ * The class is private to libkwineffects, it's only exported for the tests.
+ * WindowQuadList::makeInterleavedArrays() generates its vertices with the same kernel.
+ */
+class KWINEFFECTS_EXPORT WindowQuadBuffer
+{
+public:
+    WindowQuadBuffer();
+    explicit WindowQuadBuffer(const WindowQuadList &quads);
+
+    int count() const
+    {
+        return m_x.count() / 4;
+    }
+    bool isEmpty() const
+    {
+        return m_x.isEmpty();
+    }
+    void reserve(int quadCount);
+    void clear();
+
+    void append(const WindowQuad &quad);
+    WindowQuad at(int index) const;
+    WindowQuadList toWindowQuadList() const;
+
+    /**
+     * Returns the x coordinates of the vertices, four per quad.
+     */
+    const float *x() const
+    {
+        return m_x.constData();
+    }
+    /**
+     * Returns the y coordinates of the vertices, four per quad.
+     */
+    const float *y() const
+    {
+        return m_y.constData();
+    }
+    /**
+     * Returns the horizontal texture coordinates of the vertices, four per quad.
+     */
+    const float *u() const
+    {
+        return m_u.constData();
+    }
+    /**
+     * Returns the vertical texture coordinates of the vertices, four per quad.
+     */
+    const float *v() const
+    {
+        return m_v.constData();
+    }
+
+    /**
+     * Returns the bounding rectangle of all quads.
+     */
+    QRectF boundingRect() const;
+
+    /**
+     * Splits the quads along a grid with cells of at most @a maxQuadSize by @a maxQuadSize.
+     * This is equivalent to WindowQuadList::makeGrid().
+     */
+    WindowQuadBuffer makeGrid(int maxQuadSize) const;
+    /**
+     * Splits the bounding rectangle of the quads in @a xSubdivisions by @a ySubdivisions cells.
+     * This is equivalent to WindowQuadList::makeRegularGrid().
+     */
+    WindowQuadBuffer makeRegularGrid(int xSubdivisions, int ySubdivisions) const;
+    /**
+     * Returns the parts of the quads that are inside the @a rect. Quads outside the rectangle
+     * are dropped. The quads must be axis aligned, as the ones passed to WindowQuad::makeSubQuad().
+     */
+    WindowQuadBuffer clipped(const QRectF &rect) const;
+    /**
+     * Writes the vertices to @a vertices, either four per quad for GL_QUADS or six per quad
+     * for GL_TRIANGLES. The @a matrix may only scale and translate the texture coordinates.
+     */
+    void makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &matrix) const;
+
+private:
+    WindowQuadBuffer subdivided(double left, double top, double xIncrement, double yIncrement) const;
+    void resize(int quadCount);
+
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<float> m_u;
+    QVector<float> m_v;
+};
+
+} // namespace KWin
@@ -57,6 +57,8 @@ Options::Options(QObject *parent)
     , m_xwaylandMaxCrashCount(Options::defaultXwaylandMaxCrashCount())
     , m_latencyPolicy(Options::defaultLatencyPolicy())
     , m_renderTimeEstimator(Options::defaultRenderTimeEstimator())
+    , m_renderTimePercentile(Options::defaultRenderTimePercentile())
+    , m_renderTimeSafetyMargin(Options::defaultRenderTimeSafetyMargin())
     , m_compositingMode(Options::defaultCompositingMode())
     , m_useCompositing(Options::defaultUseCompositing())
     , m_hiddenPreviews(Options::defaultHiddenPreviews())
@@ -66,6 +68,7 @@ Options::Options(QObject *parent)
     , m_glPreferBufferSwap(Options::defaultGlPreferBufferSwap())
     , m_glPlatformInterface(Options::defaultGlPlatformInterface())
     , m_windowsBlockCompositing(true)
+    , m_allowTearing(true)
     , m_MoveMinimizedWindowsToEndOfTabBoxFocusChain(false)
     , OpTitlebarDblClick(Options::defaultOperationTitlebarDblClick())
     , CmdActiveTitlebar1(Options::defaultCommandActiveTitlebar1())
@@ -589,6 +592,15 @@ void Options::setWindowsBlockCompositing(bool value)
     Q_EMIT windowsBlockCompositingChanged();
 }
 
+void Options::setAllowTearing(bool allow)
+{
+    if (m_allowTearing == allow) {
+        return;
+    }
+    m_allowTearing = allow;
+    Q_EMIT allowTearingChanged();
+}
+
 void Options::setMoveMinimizedWindowsToEndOfTabBoxFocusChain(bool value)
 {
     if (m_MoveMinimizedWindowsToEndOfTabBoxFocusChain == value) {
@@ -644,6 +656,34 @@ void Options::setRenderTimeEstimator(RenderTimeEstimator estimator)
     Q_EMIT renderTimeEstimatorChanged();
 }
 
+int Options::renderTimePercentile() const
+{
+    return m_renderTimePercentile;
+}
+
+void Options::setRenderTimePercentile(int percentile)
+{
+    if (m_renderTimePercentile == percentile) {
+        return;
+    }
+    m_renderTimePercentile = percentile;
+    Q_EMIT renderTimePercentileChanged();
+}
+
+int Options::renderTimeSafetyMargin() const
+{
+    return m_renderTimeSafetyMargin;
+}
+
+void Options::setRenderTimeSafetyMargin(int margin)
+{
+    if (m_renderTimeSafetyMargin == margin) {
+        return;
+    }
+    m_renderTimeSafetyMargin = margin;
+    Q_EMIT renderTimeSafetyMarginChanged();
+}
+
 void Options::setGlPlatformInterface(OpenGLPlatformInterface interface)
 {
     // check environment variable
@@ -786,9 +826,12 @@ void Options::syncFromKcfgc()
     setElectricBorderTiling(m_settings->electricBorderTiling());
     setElectricBorderCornerRatio(m_settings->electricBorderCornerRatio());
     setWindowsBlockCompositing(m_settings->windowsBlockCompositing());
+    setAllowTearing(m_settings->allowTearing());
     setMoveMinimizedWindowsToEndOfTabBoxFocusChain(m_settings->moveMinimizedWindowsToEndOfTabBoxFocusChain());
     setLatencyPolicy(m_settings->latencyPolicy());
     setRenderTimeEstimator(m_settings->renderTimeEstimator());
+    setRenderTimePercentile(m_settings->renderTimePercentile());
+    setRenderTimeSafetyMargin(m_settings->renderTimeSafetyMargin());
 }
 
 bool Options::loadCompositingConfig(bool force)
@@ -60,6 +60,11 @@ enum RenderTimeEstimator {
     RenderTimeEstimatorMinimum,
     RenderTimeEstimatorMaximum,
     RenderTimeEstimatorAverage,
+    /**
+     * The render time within which most of the recent frames have been rendered,
+     * see Options::renderTimePercentile().
+     */
+    RenderTimeEstimatorPercentile,
 };
 
 class Settings;
@@ -192,8 +197,20 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(GlSwapStrategy glPreferBufferSwap READ glPreferBufferSwap WRITE setGlPreferBufferSwap NOTIFY glPreferBufferSwapChanged)
     Q_PROPERTY(KWin::OpenGLPlatformInterface glPlatformInterface READ glPlatformInterface WRITE setGlPlatformInterface NOTIFY glPlatformInterfaceChanged)
     Q_PROPERTY(bool windowsBlockCompositing READ windowsBlockCompositing WRITE setWindowsBlockCompositing NOTIFY windowsBlockCompositingChanged)
+    /**
+     * Whether fullscreen windows that ask for it may be presented without waiting for vblank.
+     */
+    Q_PROPERTY(bool allowTearing READ allowTearing WRITE setAllowTearing NOTIFY allowTearingChanged)
     Q_PROPERTY(LatencyPolicy latencyPolicy READ latencyPolicy WRITE setLatencyPolicy NOTIFY latencyPolicyChanged)
     Q_PROPERTY(RenderTimeEstimator renderTimeEstimator READ renderTimeEstimator WRITE setRenderTimeEstimator NOTIFY renderTimeEstimatorChanged)
+    /**
+     * The percentage of recent frames whose render time the percentile render time estimator covers.
+     */
+    Q_PROPERTY(int renderTimePercentile READ renderTimePercentile WRITE setRenderTimePercentile NOTIFY renderTimePercentileChanged)
+    /**
+     * The time in microseconds that is added to the estimated render time to account for mispredictions.
+     */
+    Q_PROPERTY(int renderTimeSafetyMargin READ renderTimeSafetyMargin WRITE setRenderTimeSafetyMargin NOTIFY renderTimeSafetyMarginChanged)
 public:
     explicit Options(QObject *parent = nullptr);
     ~Options() override;
@@ -665,6 +682,11 @@ public:
         return m_windowsBlockCompositing;
     }
 
+    bool allowTearing() const
+    {
+        return m_allowTearing;
+    }
+
     bool moveMinimizedWindowsToEndOfTabBoxFocusChain() const
     {
         return m_MoveMinimizedWindowsToEndOfTabBoxFocusChain;
@@ -673,6 +695,8 @@ public:
     QStringList modifierOnlyDBusShortcut(Qt::KeyboardModifier mod) const;
     LatencyPolicy latencyPolicy() const;
     RenderTimeEstimator renderTimeEstimator() const;
+    int renderTimePercentile() const;
+    int renderTimeSafetyMargin() const;
 
     // setters
     void setFocusPolicy(FocusPolicy focusPolicy);
@@ -728,9 +752,12 @@ public:
     void setGlPreferBufferSwap(char glPreferBufferSwap);
     void setGlPlatformInterface(OpenGLPlatformInterface interface);
     void setWindowsBlockCompositing(bool set);
+    void setAllowTearing(bool allow);
     void setMoveMinimizedWindowsToEndOfTabBoxFocusChain(bool set);
     void setLatencyPolicy(LatencyPolicy policy);
     void setRenderTimeEstimator(RenderTimeEstimator estimator);
+    void setRenderTimePercentile(int percentile);
+    void setRenderTimeSafetyMargin(int margin);
 
     // default values
     static WindowOperation defaultOperationTitlebarDblClick()
@@ -859,7 +886,15 @@ public:
     }
     static RenderTimeEstimator defaultRenderTimeEstimator()
     {
-        return RenderTimeEstimatorMaximum;
+        return RenderTimeEstimatorPercentile;
+    }
+    static int defaultRenderTimePercentile()
+    {
+        return 95;
+    }
+    static int defaultRenderTimeSafetyMargin()
+    {
+        return 1500;
     }
     /**
      * Performs loading all settings except compositing related.
@@ -928,10 +963,13 @@ Q_SIGNALS:
     void glPreferBufferSwapChanged();
     void glPlatformInterfaceChanged();
     void windowsBlockCompositingChanged();
+    void allowTearingChanged();
     void animationSpeedChanged();
     void latencyPolicyChanged();
     void configChanged();
     void renderTimeEstimatorChanged();
+    void renderTimePercentileChanged();
+    void renderTimeSafetyMarginChanged();
 
 private:
     void setElectricBorders(int borders);
@@ -962,6 +1000,8 @@ private:
     int m_xwaylandMaxCrashCount;
     LatencyPolicy m_latencyPolicy;
     RenderTimeEstimator m_renderTimeEstimator;
+    int m_renderTimePercentile;
+    int m_renderTimeSafetyMargin;
 
     CompositingType m_compositingMode;
     bool m_useCompositing;
@@ -973,6 +1013,7 @@ private:
     GlSwapStrategy m_glPreferBufferSwap;
     OpenGLPlatformInterface m_glPlatformInterface;
     bool m_windowsBlockCompositing;
+    bool m_allowTearing;
     bool m_MoveMinimizedWindowsToEndOfTabBoxFocusChain;
 
     WindowOperation OpTitlebarDblClick;
@@ -135,6 +135,16 @@ bool Output::usesSoftwareCursor() const
     return true;
 }
 
+bool Output::updateCursorLayer()
+{
+    return false;
+}
+
+bool Output::moveCursorLayer()
+{
+    return false;
+}
+
 QRect Output::mapFromGlobal(const QRect &rect) const
 {
     return rect.translated(-geometry().topLeft());
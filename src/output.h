@@ -213,6 +213,20 @@ public:
 
     virtual bool usesSoftwareCursor() const;
 
+    /**
+     * Applies the buffer, position, hotspot and enablement of the cursor output layer. Returns
+     * @c true if the hardware accepted the cursor layer; otherwise the cursor must be composited.
+     *
+     * @see RenderBackend::cursorLayer()
+     */
+    virtual bool updateCursorLayer();
+
+    /**
+     * Applies only the position of the cursor output layer. This is cheaper than updateCursorLayer()
+     * and doesn't involve any rendering. Returns @c false if the new position has been rejected.
+     */
+    virtual bool moveCursorLayer();
+
     void moveTo(const QPoint &pos);
     void setScale(qreal scale);
 
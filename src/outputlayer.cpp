@@ -29,6 +29,41 @@ void OutputLayer::resetRepaints()
     m_repaints = QRegion();
 }
 
+QPoint OutputLayer::position() const
+{
+    return m_position;
+}
+
+void OutputLayer::setPosition(const QPoint &position)
+{
+    m_position = position;
+}
+
+QPoint OutputLayer::hotspot() const
+{
+    return m_hotspot;
+}
+
+void OutputLayer::setHotspot(const QPoint &hotspot)
+{
+    m_hotspot = hotspot;
+}
+
+bool OutputLayer::isEnabled() const
+{
+    return m_enabled;
+}
+
+void OutputLayer::setEnabled(bool enable)
+{
+    m_enabled = enable;
+}
+
+std::optional<QSize> OutputLayer::fixedSize() const
+{
+    return std::nullopt;
+}
+
 void OutputLayer::aboutToStartPainting(const QRegion &damage)
 {
     Q_UNUSED(damage)
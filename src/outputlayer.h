@@ -34,6 +34,31 @@ public:
     void resetRepaints();
     void addRepaint(const QRegion &region);
 
+    /**
+     * Returns the position of the layer in the device coordinates of the output. Only
+     * overlay layers, e.g. the cursor layer, can be positioned.
+     */
+    QPoint position() const;
+    void setPosition(const QPoint &position);
+
+    /**
+     * Returns the hotspot of the layer in the device coordinates of the buffer. This
+     * is only meaningful for the cursor layer.
+     */
+    QPoint hotspot() const;
+    void setHotspot(const QPoint &hotspot);
+
+    /**
+     * Returns @c true if the contents of the layer should be shown on the output.
+     */
+    bool isEnabled() const;
+    void setEnabled(bool enable);
+
+    /**
+     * Returns the size of the buffers of the layer if it can't be changed.
+     */
+    virtual std::optional<QSize> fixedSize() const;
+
     /**
      * Notifies about starting to paint.
      *
@@ -52,6 +77,9 @@ public:
 
 private:
     QRegion m_repaints;
+    QPoint m_position;
+    QPoint m_hotspot;
+    bool m_enabled = false;
 };
 
 } // namespace KWin
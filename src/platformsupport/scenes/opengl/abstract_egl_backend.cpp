@@ -12,6 +12,7 @@
 #include "options.h"
 #include "output.h"
 #include "platform.h"
+#include "textureuploader.h"
 #include "utils/common.h"
 #include "utils/egl_context_attribute_builder.h"
 #include "wayland/display.h"
@@ -81,6 +82,7 @@ void AbstractEglBackend::teardown()
 void AbstractEglBackend::cleanup()
 {
     cleanupSurfaces();
+    setTextureUploader(nullptr);
     cleanupGL();
     doneCurrent();
     eglDestroyContext(m_display, m_context);
@@ -151,6 +153,11 @@ void AbstractEglBackend::initKWinGL()
     }
     glPlatform->printResults();
     initGL(&getProcAddress);
+
+    // Only Wayland clients can submit shared memory buffers.
+    if (waylandServer() && TextureUploader::isSupported() && qgetenv("KWIN_GL_ASYNC_UPLOAD") != QByteArrayLiteral("0")) {
+        setTextureUploader(std::make_unique<TextureUploader>());
+    }
 }
 
 void AbstractEglBackend::initBufferAge()
@@ -9,6 +9,7 @@
 #include "kwineglext.h"
 #include "kwingltexture.h"
 #include "surfaceitem_wayland.h"
+#include "textureuploader.h"
 #include "utils/common.h"
 #include "wayland/drmclientbuffer.h"
 #include "wayland/linuxdmabufv1clientbuffer.h"
@@ -97,6 +98,20 @@ void BasicEGLSurfaceTextureWayland::updateShmTexture(KWaylandServer::ShmClientBu
     }
 
     const QRegion damage = mapRegion(m_pixmap->item()->surfaceToBufferMatrix(), region);
+
+    if (TextureUploader *uploader = m_backend->textureUploader()) {
+        switch (uploader->upload(m_texture.data(), image, damage)) {
+        case TextureUploader::Result::Uploaded:
+            return;
+        case TextureUploader::Result::Deferred:
+            // The texture keeps showing the old contents until the next frame.
+            m_pixmap->item()->addDamage(region);
+            return;
+        case TextureUploader::Result::Failed:
+            break;
+        }
+    }
+
     for (const QRect &rect : damage) {
         m_texture->update(image, rect.topLeft(), rect);
     }
@@ -12,6 +12,7 @@
 #include <kwinglutils_funcs.h>
 
 #include "screens.h"
+#include "textureuploader.h"
 #include "utils/common.h"
 
 #include <QElapsedTimer>
@@ -32,6 +33,16 @@ OpenGLBackend::~OpenGLBackend()
 {
 }
 
+TextureUploader *OpenGLBackend::textureUploader() const
+{
+    return m_textureUploader.get();
+}
+
+void OpenGLBackend::setTextureUploader(std::unique_ptr<TextureUploader> &&uploader)
+{
+    m_textureUploader = std::move(uploader);
+}
+
 CompositingType OpenGLBackend::compositingType() const
 {
     return OpenGLCompositing;
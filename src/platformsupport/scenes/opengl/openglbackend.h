@@ -14,6 +14,8 @@
 
 #include <QRegion>
 
+#include <memory>
+
 namespace KWin
 {
 class Output;
@@ -24,6 +26,7 @@ class SurfacePixmapX11;
 class SurfacePixmapWayland;
 class SurfaceTexture;
 class GLTexture;
+class TextureUploader;
 
 /**
  * @brief The OpenGLBackend creates and holds the OpenGL context and is responsible for Texture from Pixmap.
@@ -127,6 +130,12 @@ public:
 
     virtual QSharedPointer<GLTexture> textureForOutput(Output *output) const;
 
+    /**
+     * Returns the uploader that streams client buffers into textures, or @c nullptr if
+     * asynchronous texture uploads are not supported.
+     */
+    TextureUploader *textureUploader() const;
+
 protected:
     /**
      * @brief Sets the backend initialization to failed.
@@ -181,6 +190,12 @@ protected:
         m_extensions = extensions;
     }
 
+    /**
+     * Sets the texture uploader. The OpenGL context must be current because the previous
+     * uploader releases its OpenGL resources.
+     */
+    void setTextureUploader(std::unique_ptr<TextureUploader> &&uploader);
+
 private:
     /**
      * @brief Whether direct rendering is used, defaults to @c false.
@@ -204,6 +219,7 @@ private:
      */
     bool m_failed;
     QList<QByteArray> m_extensions;
+    std::unique_ptr<TextureUploader> m_textureUploader;
 };
 
 }
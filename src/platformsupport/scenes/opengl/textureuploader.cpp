@@ -0,0 +1,221 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "textureuploader.h"
+#include "ftrace.h"
+#include "utils/common.h"
+
+#include <kwinglplatform.h>
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <cstring>
+
+namespace KWin
+{
+
+// The size of the staging ring, it must be large enough to hold a few frames worth of uploads.
+static const qint64 s_ringSize = 64 * 1024 * 1024;
+static const qint64 s_defaultFrameBudget = 24 * 1024 * 1024;
+
+static qint64 align(qint64 value, qint64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+QVector<QRect> TextureUploader::uploadRects(const QRegion &region)
+{
+    // Every glTexSubImage2D() call has a fixed cost, so if the damage consists of many small
+    // rectangles, it's cheaper to upload a few extra pixels in a single call.
+    const QRect bounds = region.boundingRect();
+    if (region.rectCount() == 1) {
+        return {bounds};
+    }
+
+    qint64 area = 0;
+    for (const QRect &rect : region) {
+        area += qint64(rect.width()) * rect.height();
+    }
+
+    if (region.rectCount() > 16 || qint64(bounds.width()) * bounds.height() <= area * 3 / 2) {
+        return {bounds};
+    }
+    return QVector<QRect>(region.begin(), region.end());
+}
+
+qint64 TextureUploader::packRect(const QImage &image, const QRect &rect, uint8_t *destination)
+{
+    const qint64 stride = rect.width() * 4;
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        std::memcpy(destination, image.constScanLine(y) + rect.x() * 4, stride);
+        destination += stride;
+    }
+    return stride * rect.height();
+}
+
+TextureUploader::TextureUploader()
+    : m_frameBudget(s_defaultFrameBudget)
+{
+    bool ok;
+    const int budget = qEnvironmentVariableIntValue("KWIN_GL_UPLOAD_BUDGET", &ok);
+    if (ok && budget > 0) {
+        m_frameBudget = qint64(budget) * 1024 * 1024;
+    }
+
+    if (GLPlatform::instance()->isGLES()) {
+        m_format = GL_BGRA_EXT;
+        m_type = GL_UNSIGNED_BYTE;
+    }
+
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, s_ringSize, nullptr, access);
+    m_map = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, s_ringSize, access));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (m_map) {
+        m_size = s_ringSize;
+    } else {
+        qCWarning(KWIN_OPENGL) << "Failed to map the texture upload buffer";
+    }
+}
+
+TextureUploader::~TextureUploader()
+{
+    for (const Fence &fence : m_fences) {
+        glDeleteSync(fence.sync);
+    }
+    glDeleteBuffers(1, &m_buffer);
+}
+
+bool TextureUploader::isSupported()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        return hasGLVersion(3, 0)
+            && hasGLExtension(QByteArrayLiteral("GL_EXT_buffer_storage"))
+            && hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
+    } else {
+        return (hasGLVersion(4, 4) || hasGLExtension(QByteArrayLiteral("GL_ARB_buffer_storage")))
+            && (hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync")));
+    }
+}
+
+void TextureUploader::beginFrame()
+{
+    retireFences();
+}
+
+qint64 TextureUploader::endFrame()
+{
+    const qint64 frameBytes = m_frameBytes;
+    if (frameBytes == 0) {
+        return 0;
+    }
+
+    fTrace("Uploaded ", frameBytes, " bytes of texture data");
+    m_frameBytes = 0;
+
+    const GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (sync) {
+        m_fences.push_back(Fence{sync, m_head});
+    }
+    return frameBytes;
+}
+
+void TextureUploader::retireFences()
+{
+    while (!m_fences.empty()) {
+        const Fence &fence = m_fences.front();
+
+        GLint status;
+        glGetSynciv(fence.sync, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED) {
+            break;
+        }
+
+        m_tail = fence.end;
+        glDeleteSync(fence.sync);
+        m_fences.pop_front();
+    }
+}
+
+bool TextureUploader::allocate(qint64 size, qint64 *offset)
+{
+    if (size > m_size) {
+        return false;
+    }
+
+    // m_head and m_tail grow monotonically, the data between them may still be read by the GPU.
+    qint64 start = m_head;
+    const qint64 position = start % m_size;
+    if (position + size > m_size) {
+        start += m_size - position;
+    }
+
+    if (start + size - m_tail > m_size) {
+        retireFences();
+        if (start + size - m_tail > m_size) {
+            return false;
+        }
+    }
+
+    m_head = start + size;
+    *offset = start % m_size;
+    return true;
+}
+
+TextureUploader::Result TextureUploader::upload(GLTexture *texture, const QImage &image, const QRegion &region)
+{
+    if (!m_map) {
+        return Result::Failed;
+    }
+    if (image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_RGB32) {
+        return Result::Failed;
+    }
+
+    const QRegion damage = region & image.rect();
+    if (damage.isEmpty()) {
+        return Result::Uploaded;
+    }
+
+    const QVector<QRect> rects = uploadRects(damage);
+
+    qint64 bytes = 0;
+    for (const QRect &rect : rects) {
+        bytes += qint64(rect.width()) * rect.height() * 4;
+    }
+
+    // Let at least one upload through in every frame, so large surfaces are not starved.
+    if (m_frameBytes > 0 && m_frameBytes + bytes > m_frameBudget) {
+        return Result::Deferred;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    texture->bind();
+
+    Result result = Result::Uploaded;
+    for (const QRect &rect : rects) {
+        qint64 offset;
+        if (!allocate(align(qint64(rect.width()) * rect.height() * 4, 64), &offset)) {
+            result = Result::Failed;
+            break;
+        }
+
+        m_frameBytes += packRect(image, rect, m_map + offset);
+
+        glTexSubImage2D(texture->target(), 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                        m_format, m_type, reinterpret_cast<const void *>(offset));
+    }
+
+    texture->unbind();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return result;
+}
+
+} // namespace KWin
@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QImage>
+#include <QRegion>
+
+#include <deque>
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+class GLTexture;
+
+/**
+ * The TextureUploader class streams pixel data from client memory into textures.
+ *
+ * The pixel data is copied into a persistently mapped pixel unpack buffer, which is used as a
+ * ring. glTexSubImage2D() then sources the data from the buffer object, so the call returns as
+ * soon as the transfer is queued rather than when the data has been copied to the GPU. The
+ * parts of the ring that are still in use by the GPU are protected with fences, the uploader
+ * never waits for them.
+ *
+ * The amount of data uploaded in a frame is limited to 24 MiB, the KWIN_GL_UPLOAD_BUDGET
+ * environment variable overrides the limit in MiB.
+ */
+class KWIN_EXPORT TextureUploader
+{
+public:
+    enum class Result {
+        /**
+         * The upload has been queued.
+         */
+        Uploaded,
+        /**
+         * The frame budget has been exhausted. The upload should be retried in the next frame.
+         */
+        Deferred,
+        /**
+         * The data can't be uploaded asynchronously, the caller must upload it on its own.
+         */
+        Failed,
+    };
+
+    TextureUploader();
+    ~TextureUploader();
+
+    /**
+     * Returns @c true if the current OpenGL context supports asynchronous uploads.
+     */
+    static bool isSupported();
+
+    void beginFrame();
+    /**
+     * Ends the frame and returns the number of bytes that have been uploaded in it.
+     */
+    qint64 endFrame();
+
+    /**
+     * Uploads the @a region of the @a image to the @a texture. The region is in the image
+     * coordinates, the texture must have the same size as the image.
+     */
+    Result upload(GLTexture *texture, const QImage &image, const QRegion &region);
+
+    /**
+     * Returns the rectangles that are uploaded for the damaged @a region. Every upload has
+     * a fixed cost, so damage that consists of many small rectangles is merged.
+     */
+    static QVector<QRect> uploadRects(const QRegion &region);
+
+    /**
+     * Copies the @a rect of the @a image to @a destination as tightly packed rows of 32 bit
+     * pixels. Returns the number of copied bytes.
+     */
+    static qint64 packRect(const QImage &image, const QRect &rect, uint8_t *destination);
+
+private:
+    bool allocate(qint64 size, qint64 *offset);
+    void retireFences();
+
+    struct Fence
+    {
+        GLsync sync;
+        qint64 end;
+    };
+
+    GLuint m_buffer = 0;
+    uint8_t *m_map = nullptr;
+    qint64 m_size = 0;
+    qint64 m_head = 0;
+    qint64 m_tail = 0;
+    std::deque<Fence> m_fences;
+
+    GLenum m_format = GL_BGRA;
+    GLenum m_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+
+    qint64 m_frameBudget;
+    qint64 m_frameBytes = 0;
+};
+
+} // namespace KWin
@@ -23,7 +23,7 @@ public:
     bool isValid() const override;
 
     QPainterBackend *backend() const;
-    QImage image() const;
+    virtual QImage image() const;
 
     virtual bool create() = 0;
     virtual void update(const QRegion &region) = 0;
@@ -10,7 +10,7 @@
 #include "wayland/shmclientbuffer.h"
 #include "wayland/surface_interface.h"
 
-#include <QPainter>
+#include <cstring>
 
 namespace KWin
 {
@@ -22,9 +22,39 @@ QPainterSurfaceTextureWayland::QPainterSurfaceTextureWayland(QPainterBackend *ba
 {
 }
 
+void QPainterSurfaceTextureWayland::setDirectSampling(bool enabled)
+{
+    m_directSampling = enabled;
+}
+
+bool QPainterSurfaceTextureWayland::isValid() const
+{
+    if (m_directSampling) {
+        return m_valid;
+    }
+    return QPainterSurfaceTexture::isValid();
+}
+
+QImage QPainterSurfaceTextureWayland::image() const
+{
+    if (!m_directSampling) {
+        return m_image;
+    }
+    // The access to the buffer begins here and ends when the last copy of the image is gone.
+    auto buffer = qobject_cast<KWaylandServer::ShmClientBuffer *>(m_pixmap->buffer());
+    if (Q_UNLIKELY(!buffer)) {
+        return QImage();
+    }
+    return buffer->data();
+}
+
 bool QPainterSurfaceTextureWayland::create()
 {
     auto buffer = qobject_cast<KWaylandServer::ShmClientBuffer *>(m_pixmap->buffer());
+    if (m_directSampling) {
+        m_valid = buffer && !buffer->size().isEmpty();
+        return m_valid;
+    }
     if (Q_LIKELY(buffer)) {
         // The buffer data is copied as the buffer interface returns a QImage
         // which doesn't own the data of the underlying wl_shm_buffer object.
@@ -35,20 +65,36 @@ bool QPainterSurfaceTextureWayland::create()
 
 void QPainterSurfaceTextureWayland::update(const QRegion &region)
 {
+    if (m_directSampling) {
+        // The buffer is read when it's painted, there's nothing to copy.
+        return;
+    }
+
     auto buffer = qobject_cast<KWaylandServer::ShmClientBuffer *>(m_pixmap->buffer());
     if (Q_UNLIKELY(!buffer)) {
         return;
     }
 
+    // The damaged rects are copied while the buffer is being accessed on this thread. Reading
+    // the client's memory at any other time isn't protected against the client truncating the
+    // shm pool, and the rasterizer threads may only ever see the copy.
     const QImage image = buffer->data();
-    const QRegion dirtyRegion = mapRegion(m_pixmap->item()->surfaceToBufferMatrix(), region);
-    QPainter painter(&m_image);
+    if (image.isNull()) {
+        return;
+    }
+    if (image.size() != m_image.size() || image.format() != m_image.format()) {
+        m_image = image.copy();
+        return;
+    }
 
-    // The buffer data is copied as the buffer interface returns a QImage
-    // which doesn't own the data of the underlying wl_shm_buffer object.
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    const QRegion dirtyRegion = mapRegion(m_pixmap->item()->surfaceToBufferMatrix(), region) & image.rect();
+    const int bytesPerPixel = image.depth() / 8;
     for (const QRect &rect : dirtyRegion) {
-        painter.drawImage(rect, image, rect);
+        const int offset = rect.x() * bytesPerPixel;
+        const int rowSize = rect.width() * bytesPerPixel;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            std::memcpy(m_image.scanLine(y) + offset, image.constScanLine(y) + offset, rowSize);
+        }
     }
 }
 
@@ -18,11 +18,25 @@ class KWIN_EXPORT QPainterSurfaceTextureWayland : public QPainterSurfaceTexture
 public:
     QPainterSurfaceTextureWayland(QPainterBackend *backend, SurfacePixmapWayland *pixmap);
 
+    /**
+     * Sets whether the client's shm buffer is sampled directly instead of being copied.
+     *
+     * The image returned by image() then references the client's memory and the access to
+     * the buffer lasts as long as the image is alive. It must only be used on the compositor
+     * thread, and only one such image may be alive at a time.
+     */
+    void setDirectSampling(bool enabled);
+
+    bool isValid() const override;
+    QImage image() const override;
+
     bool create() override;
     void update(const QRegion &region) override;
 
 private:
     SurfacePixmapWayland *m_pixmap;
+    bool m_directSampling = false;
+    bool m_valid = false;
 };
 
 } // namespace KWin
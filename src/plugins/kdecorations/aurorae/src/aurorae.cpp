@@ -613,7 +613,7 @@ void Decoration::updateBuffer()
     }
     updateShadow();
     updateBlur();
-    update();
+    update(m_view->damage().translated(m_view->geometry().topLeft()).boundingRect() & rect());
 }
 
 KDecoration2::DecoratedClient *Decoration::clientPointer() const
@@ -5,7 +5,6 @@
 */
 
 #include "outputscreencastsource.h"
-#include "screencastutils.h"
 
 #include "composite.h"
 #include "kwingltexture.h"
@@ -34,14 +33,6 @@ QSize OutputScreenCastSource::textureSize() const
     return m_output->pixelSize();
 }
 
-void OutputScreenCastSource::render(QImage *image)
-{
-    const QSharedPointer<GLTexture> outputTexture = Compositor::self()->scene()->textureForOutput(m_output);
-    if (outputTexture) {
-        grabTexture(outputTexture.data(), image);
-    }
-}
-
 void OutputScreenCastSource::render(GLFramebuffer *target)
 {
     const QSharedPointer<GLTexture> outputTexture = Compositor::self()->scene()->textureForOutput(m_output);
@@ -56,11 +47,18 @@ void OutputScreenCastSource::render(GLFramebuffer *target)
     projectionMatrix.ortho(geometry);
     shaderBinder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, projectionMatrix);
 
+    // The filter is applied when the texture is bound, and it's restored for other users.
+    const GLenum filter = outputTexture->filter();
+    if (target->size() != geometry.size()) {
+        outputTexture->setFilter(GL_LINEAR);
+    }
+
     GLFramebuffer::pushFramebuffer(target);
     outputTexture->bind();
     outputTexture->render(geometry);
     outputTexture->unbind();
     GLFramebuffer::popFramebuffer();
+    outputTexture->setFilter(filter);
 }
 
 std::chrono::nanoseconds OutputScreenCastSource::clock() const
@@ -68,4 +66,9 @@ std::chrono::nanoseconds OutputScreenCastSource::clock() const
     return m_output->renderLoop()->lastPresentationTimestamp();
 }
 
+uint OutputScreenCastSource::refreshRate() const
+{
+    return m_output->refreshRate();
+}
+
 } // namespace KWin
@@ -26,8 +26,8 @@ public:
     QSize textureSize() const override;
 
     void render(GLFramebuffer *target) override;
-    void render(QImage *image) override;
     std::chrono::nanoseconds clock() const override;
+    uint refreshRate() const override;
 
 private:
     QPointer<Output> m_output;
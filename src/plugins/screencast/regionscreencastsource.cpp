@@ -5,7 +5,6 @@
 */
 
 #include "regionscreencastsource.h"
-#include "screencastutils.h"
 
 #include <composite.h>
 #include <kwingltexture.h>
@@ -73,6 +72,18 @@ std::chrono::nanoseconds RegionScreenCastSource::clock() const
     return m_last;
 }
 
+uint RegionScreenCastSource::refreshRate() const
+{
+    uint ret = 0;
+    const auto allOutputs = kwinApp()->platform()->enabledOutputs();
+    for (auto output : allOutputs) {
+        if (output->geometry().intersects(m_region)) {
+            ret = std::max<uint>(ret, output->refreshRate());
+        }
+    }
+    return ret;
+}
+
 void RegionScreenCastSource::render(GLFramebuffer *target)
 {
     if (!m_renderedTexture) {
@@ -94,21 +105,18 @@ void RegionScreenCastSource::render(GLFramebuffer *target)
     projectionMatrix.ortho(r);
     shader->setUniform(GLShader::ModelViewProjectionMatrix, projectionMatrix);
 
+    // The filter is applied when the texture is bound, and it's restored for other users.
+    const GLenum filter = m_renderedTexture->filter();
+    if (target->size() != m_renderedTexture->size()) {
+        m_renderedTexture->setFilter(GL_LINEAR);
+    }
     m_renderedTexture->bind();
     m_renderedTexture->render(r);
     m_renderedTexture->unbind();
+    m_renderedTexture->setFilter(filter);
 
     ShaderManager::instance()->popShader();
     GLFramebuffer::popFramebuffer();
 }
 
-void RegionScreenCastSource::render(QImage *image)
-{
-    GLTexture offscreenTexture(hasAlphaChannel() ? GL_RGBA8 : GL_RGB8, textureSize());
-    GLFramebuffer offscreenTarget(&offscreenTexture);
-
-    render(&offscreenTarget);
-    grabTexture(&offscreenTexture, image);
-}
-
 }
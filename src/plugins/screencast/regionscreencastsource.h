@@ -27,13 +27,17 @@ public:
     QSize textureSize() const override;
 
     void render(GLFramebuffer *target) override;
-    void render(QImage *image) override;
     std::chrono::nanoseconds clock() const override;
+    uint refreshRate() const override;
 
     QRect region() const
     {
         return m_region;
     }
+    qreal scale() const
+    {
+        return m_scale;
+    }
     void updateOutput(Output *output);
 
 private:
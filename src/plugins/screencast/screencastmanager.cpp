@@ -29,6 +29,21 @@
 namespace KWin
 {
 
+/**
+ * Maps the @a region from the logical coordinates of the stream to the stream buffer.
+ */
+static QRegion scaleRegion(const QRegion &region, qreal scale)
+{
+    if (scale == 1) {
+        return region;
+    }
+    QRegion scaled;
+    for (const QRect &rect : region) {
+        scaled += QRectF(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale).toAlignedRect();
+    }
+    return scaled;
+}
+
 ScreencastManager::ScreencastManager(QObject *parent)
     : Plugin(parent)
     , m_screencast(new KWaylandServer::ScreencastV1Interface(waylandServer()->display(), this))
@@ -75,8 +90,10 @@ private:
 
     void bufferToStream()
     {
+        // The damage is reported in the coordinates of the surface that has been damaged,
+        // which may be a sub-surface, so consider the whole window as damaged.
         if (!m_damagedRegion.isEmpty()) {
-            recordFrame(m_damagedRegion);
+            recordFrame(QRect(QPoint(), m_window->clientGeometry().size()));
             m_damagedRegion = {};
         }
     }
@@ -129,9 +146,10 @@ void ScreencastManager::streamOutput(KWaylandServer::ScreencastStreamV1Interface
     auto stream = new ScreenCastStream(new OutputScreenCastSource(streamOutput), this);
     stream->setObjectName(streamOutput->name());
     stream->setCursorMode(mode, streamOutput->scale(), streamOutput->geometry());
-    auto bufferToStream = [stream](const QRegion &damagedRegion) {
+    auto bufferToStream = [streamOutput, stream](const QRegion &damagedRegion) {
         if (!damagedRegion.isEmpty()) {
-            stream->recordFrame(damagedRegion);
+            const QRect geometry = streamOutput->geometry();
+            stream->recordFrame(scaleRegion(damagedRegion.intersected(geometry).translated(-geometry.topLeft()), streamOutput->scale()));
         }
     };
     connect(stream, &ScreenCastStream::startStreaming, waylandStream, [streamOutput, stream, bufferToStream] {
@@ -172,7 +190,7 @@ void ScreencastManager::streamRegion(KWaylandServer::ScreencastStreamV1Interface
                     const QRect streamRegion = source->region();
                     const QRegion region = output->pixelSize() != output->modeSize() ? output->geometry() : damagedRegion;
                     source->updateOutput(output);
-                    stream->recordFrame(region.translated(-streamRegion.topLeft()).intersected(streamRegion));
+                    stream->recordFrame(scaleRegion(region.intersected(streamRegion).translated(-streamRegion.topLeft()), source->scale()));
                 };
                 connect(output, &Output::outputChange, stream, bufferToStream);
             }
@@ -24,8 +24,11 @@ public:
     virtual QSize textureSize() const = 0;
 
     virtual void render(GLFramebuffer *target) = 0;
-    virtual void render(QImage *image) = 0;
     virtual std::chrono::nanoseconds clock() const = 0;
+    /**
+     * Returns the rate at which the source is updated, in millihertz.
+     */
+    virtual uint refreshRate() const = 0;
 
 Q_SIGNALS:
     void closed();
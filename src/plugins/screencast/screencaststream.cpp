@@ -67,6 +67,24 @@ void ScreenCastStream::onStreamStateChanged(void *data, pw_stream_state old, pw_
     }
 }
 
+/**
+ * Maps the @a region from the source to the stream buffer if the consumer has asked for a
+ * downscaled frame.
+ */
+static QRegion scaleDamage(const QRegion &region, const QSize &sourceSize, const QSize &size)
+{
+    if (sourceSize == size || sourceSize.isEmpty()) {
+        return region;
+    }
+    const qreal xScale = qreal(size.width()) / sourceSize.width();
+    const qreal yScale = qreal(size.height()) / sourceSize.height();
+    QRegion scaled;
+    for (const QRect &rect : region) {
+        scaled += QRectF(rect.x() * xScale, rect.y() * yScale, rect.width() * xScale, rect.height() * yScale).toAlignedRect();
+    }
+    return scaled;
+}
+
 #define CURSOR_BPP 4
 #define CURSOR_META_SIZE(w, h) (sizeof(struct spa_meta_cursor) + sizeof(struct spa_meta_bitmap) + w * h * CURSOR_BPP)
 static const int videoDamageRegionCount = 16;
@@ -128,6 +146,10 @@ void ScreenCastStream::onStreamParamChanged(void *data, uint32_t id, const struc
     // make test allocation, fixate format, ...
     // depends on how flexible kwin will become in that regard.
     pw->m_hasModifier = spa_pod_find_prop(format, nullptr, SPA_FORMAT_VIDEO_modifier) != nullptr;
+    // The consumer may ask for a smaller frame, the source is downscaled when it's rendered.
+    if (pw->videoFormat.size.width > 0 && pw->videoFormat.size.height > 0) {
+        pw->m_resolution = QSize(pw->videoFormat.size.width, pw->videoFormat.size.height);
+    }
     qCDebug(KWIN_SCREENCAST) << "Stream format changed" << pw << pw->videoFormat.format;
     pw->newStreamParams();
 }
@@ -171,6 +193,7 @@ void ScreenCastStream::onStreamAddBuffer(void *data, pw_buffer *buffer)
             return;
         }
         spa_data->mapoffset = 0;
+        stream->m_staleRegionForPwBuffer.insert(buffer, QRect(QPoint(), stream->m_resolution));
 
         if (ftruncate(spa_data->fd, spa_data->maxsize) < 0) {
             qCCritical(KWIN_SCREENCAST) << "memfd: Can't truncate to" << spa_data->maxsize;
@@ -201,6 +224,7 @@ void ScreenCastStream::onStreamRemoveBuffer(void *data, pw_buffer *buffer)
 {
     ScreenCastStream *stream = static_cast<ScreenCastStream *>(data);
     stream->m_dmabufDataForPwBuffer.remove(buffer);
+    stream->m_staleRegionForPwBuffer.remove(buffer);
 
     struct spa_buffer *spa_buffer = buffer->buffer;
     struct spa_data *spa_data = spa_buffer->datas;
@@ -214,6 +238,7 @@ ScreenCastStream::ScreenCastStream(ScreenCastSource *source, QObject *parent)
     : QObject(parent)
     , m_source(source)
     , m_resolution(source->textureSize())
+    , m_sourceSize(source->textureSize())
 {
     connect(source, &ScreenCastSource::closed, this, &ScreenCastStream::stopStreaming);
 
@@ -222,6 +247,18 @@ ScreenCastStream::ScreenCastStream(ScreenCastSource *source, QObject *parent)
     pwStreamEvents.remove_buffer = &ScreenCastStream::onStreamRemoveBuffer;
     pwStreamEvents.state_changed = &ScreenCastStream::onStreamStateChanged;
     pwStreamEvents.param_changed = &ScreenCastStream::onStreamParamChanged;
+
+    m_readbackTimer.setSingleShot(true);
+    m_readbackTimer.setInterval(1);
+    connect(&m_readbackTimer, &QTimer::timeout, this, &ScreenCastStream::pollReadback);
+
+    m_throttleTimer.setSingleShot(true);
+    connect(&m_throttleTimer, &QTimer::timeout, this, [this]() {
+        if (auto scene = Compositor::self()->scene()) {
+            scene->makeOpenGLContextCurrent();
+        }
+        recordFrame(QRegion());
+    });
 }
 
 ScreenCastStream::~ScreenCastStream()
@@ -230,6 +267,15 @@ ScreenCastStream::~ScreenCastStream()
     if (pwStream) {
         pw_stream_destroy(pwStream);
     }
+    if (m_readback.pixelPackBuffer || m_readback.sync) {
+        if (Compositor::self() && Compositor::self()->scene()) {
+            Compositor::self()->scene()->makeOpenGLContextCurrent();
+        }
+        if (m_readback.sync) {
+            glDeleteSync(m_readback.sync);
+        }
+        glDeleteBuffers(1, &m_readback.pixelPackBuffer);
+    }
 }
 
 bool ScreenCastStream::init()
@@ -272,31 +318,8 @@ bool ScreenCastStream::createStream()
 
     uint8_t buffer[2048];
     spa_pod_builder podBuilder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
-    spa_fraction minFramerate = SPA_FRACTION(1, 1);
-    spa_fraction maxFramerate = SPA_FRACTION(25, 1);
-    spa_fraction defaultFramerate = SPA_FRACTION(0, 1);
-
-    spa_rectangle resolution = SPA_RECTANGLE(uint32_t(m_resolution.width()), uint32_t(m_resolution.height()));
-
-    // TODO[explicit_modifiers]: query modifiers supported/used by kwin
-    uint64_t modifier = DRM_FORMAT_MOD_INVALID;
-
     const spa_pod *params[2];
-    int n_params;
-
-    auto canCreateDmaBuf = [this]() -> bool {
-        return !QSharedPointer<DmaBufTexture>(kwinApp()->platform()->createDmaBufTexture(m_resolution)).isNull();
-    };
-    const auto format = m_source->hasAlphaChannel() ? SPA_VIDEO_FORMAT_BGRA : SPA_VIDEO_FORMAT_BGR;
-
-    if (canCreateDmaBuf()) {
-        params[0] = buildFormat(&podBuilder, SPA_VIDEO_FORMAT_BGRA, &resolution, &defaultFramerate, &minFramerate, &maxFramerate, &modifier, 1);
-        params[1] = buildFormat(&podBuilder, format, &resolution, &defaultFramerate, &minFramerate, &maxFramerate, nullptr, 0);
-        n_params = 2;
-    } else {
-        params[0] = buildFormat(&podBuilder, format, &resolution, &defaultFramerate, &minFramerate, &maxFramerate, nullptr, 0);
-        n_params = 1;
-    }
+    const int n_params = buildFormats(&podBuilder, params);
 
     pw_stream_add_listener(pwStream, &streamListener, &pwStreamEvents, this);
     auto flags = pw_stream_flags(PW_STREAM_FLAG_DRIVER | PW_STREAM_FLAG_ALLOC_BUFFERS);
@@ -337,13 +360,45 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
 {
     Q_ASSERT(!m_stopped);
 
+    // The damage is accumulated until a frame is recorded, every early return below keeps it.
+    // Otherwise a frame that is dropped would leave stale pixels in the consumer's buffers.
+    m_pendingDamage |= damagedRegion;
+
+    // Don't produce frames faster than the consumer wants them.
+    if (videoFormat.max_framerate.num > 0 && videoFormat.max_framerate.denom > 0) {
+        const std::chrono::nanoseconds interval(std::chrono::seconds(videoFormat.max_framerate.denom));
+        const std::chrono::nanoseconds frameInterval = interval / videoFormat.max_framerate.num;
+        const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - m_lastFrameTime;
+        if (elapsed < frameInterval) {
+            if (!m_throttleTimer.isActive()) {
+                m_throttleTimer.start(std::chrono::ceil<std::chrono::milliseconds>(frameInterval - elapsed));
+            }
+            return;
+        }
+    }
+    m_throttleTimer.stop();
+
+    // The frame is recorded once the pending buffer has been queued, see enqueue().
     if (m_pendingBuffer) {
-        qCWarning(KWIN_SCREENCAST) << "Dropping a screencast frame because the compositor is slow";
+        qCWarning(KWIN_SCREENCAST) << "Delaying a screencast frame because the compositor is slow";
         return;
     }
 
-    if (m_source->textureSize() != m_resolution) {
-        m_resolution = m_source->textureSize();
+    if (m_source->textureSize() != m_sourceSize) {
+        // Follow the source unless the consumer has asked for a smaller frame.
+        if (m_resolution == m_sourceSize) {
+            m_resolution = m_source->textureSize();
+        }
+        m_sourceSize = m_source->textureSize();
+        m_pendingDamage = QRect(QPoint(), m_sourceSize);
+
+        // Advertise the new size range, so the consumer can follow the source.
+        uint8_t buffer[2048];
+        spa_pod_builder podBuilder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+        const spa_pod *params[2];
+        const int n_params = buildFormats(&podBuilder, params);
+        pw_stream_update_params(pwStream, params, n_params);
+
         newStreamParams();
         return;
     }
@@ -360,6 +415,10 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
     struct pw_buffer *buffer = pw_stream_dequeue_buffer(pwStream);
 
     if (!buffer) {
+        // The consumer holds all buffers, try again later rather than wait for the next damage.
+        if (!m_pendingDamage.isEmpty() && !m_throttleTimer.isActive()) {
+            m_throttleTimer.start(std::chrono::milliseconds(16));
+        }
         return;
     }
 
@@ -373,31 +432,43 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
         return;
     }
 
-    const auto size = m_source->textureSize();
+    m_lastFrameTime = std::chrono::steady_clock::now();
+    const QRegion sourceDamage = std::exchange(m_pendingDamage, QRegion());
+
+    const auto size = m_resolution;
+    const QRegion bufferDamage = scaleDamage(sourceDamage, m_sourceSize, size);
     spa_data->chunk->offset = 0;
     if (data || spa_data[0].type == SPA_DATA_MemFd) {
         const bool hasAlpha = m_source->hasAlphaChannel();
         const int bpp = data && !hasAlpha ? 3 : 4;
         const uint stride = SPA_ROUND_UP_N(size.width() * bpp, 4);
 
-        QImage dest(data, size.width(), size.height(), stride, hasAlpha ? QImage::Format_RGBA8888_Premultiplied : QImage::Format_RGB888);
-        if (dest.sizeInBytes() > spa_data->maxsize) {
+        if (stride * size.height() > spa_data->maxsize) {
             qCDebug(KWIN_SCREENCAST) << "Failed to record frame: frame is too big";
+            m_pendingDamage |= sourceDamage;
             pw_stream_queue_buffer(pwStream, buffer);
             return;
         }
 
-        spa_data->chunk->size = dest.sizeInBytes();
-        spa_data->chunk->stride = dest.bytesPerLine();
+        spa_data->chunk->size = stride * size.height();
+        spa_data->chunk->stride = stride;
+
+        if (!m_readback.framebuffer || m_readback.framebuffer->size() != size) {
+            m_readback.texture.reset(new GLTexture(hasAlpha ? GL_RGBA8 : GL_RGB8, size));
+            m_readback.framebuffer.reset(new GLFramebuffer(m_readback.texture.data()));
+        }
 
-        m_source->render(&dest);
+        m_source->render(m_readback.framebuffer.data());
+        renderCursor(m_readback.framebuffer.data());
 
-        auto cursor = Cursors::self()->currentCursor();
-        if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos())) {
-            QPainter painter(&dest);
-            const auto position = (cursor->pos() - m_cursor.viewport.topLeft() - cursor->hotspot()) * m_cursor.scale;
-            painter.drawImage(QRect{position, cursor->image().size()}, cursor->image());
+        // The buffer is reused, only the parts that changed since it was filled last time
+        // need to be read back.
+        for (QRegion &staleRegion : m_staleRegionForPwBuffer) {
+            staleRegion |= bufferDamage;
         }
+        QRegion &staleRegion = m_staleRegionForPwBuffer[buffer];
+        readPixels(buffer, staleRegion & QRect(QPoint(), size), stride);
+        staleRegion = QRegion();
     } else {
         auto &buf = m_dmabufDataForPwBuffer[buffer];
 
@@ -405,48 +476,164 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
         spa_data->chunk->size = spa_data->maxsize;
 
         m_source->render(buf->framebuffer());
+        renderCursor(buf->framebuffer());
+    }
+
+    if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Metadata) {
+        sendCursorData(Cursors::self()->currentCursor(),
+                       (spa_meta_cursor *)spa_buffer_find_meta_data(spa_buffer, SPA_META_Cursor, sizeof(spa_meta_cursor)));
+    }
 
-        auto cursor = Cursors::self()->currentCursor();
-        if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos())) {
-            GLFramebuffer::pushFramebuffer(buf->framebuffer());
+    addDamage(spa_buffer, bufferDamage & QRect(QPoint(), size));
+    addHeader(spa_buffer);
+    tryEnqueue(buffer);
+}
 
-            QRect r(QPoint(), size);
-            auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
+void ScreenCastStream::renderCursor(GLFramebuffer *target)
+{
+    auto cursor = Cursors::self()->currentCursor();
+    if (m_cursor.mode != KWaylandServer::ScreencastV1Interface::Embedded || !m_cursor.viewport.contains(cursor->pos())) {
+        return;
+    }
 
-            QMatrix4x4 mvp;
-            mvp.ortho(r);
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    GLFramebuffer::pushFramebuffer(target);
 
-            if (!m_cursor.texture || m_cursor.lastKey != cursor->image().cacheKey()) {
-                m_cursor.texture.reset(new GLTexture(cursor->image()));
-            }
+    // The cursor is positioned in the source coordinates, the viewport takes care of scaling
+    // it if the stream is downscaled.
+    QRect r(QPoint(), m_sourceSize);
+    auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
+
+    QMatrix4x4 mvp;
+    mvp.ortho(r);
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+
+    if (!m_cursor.texture || m_cursor.lastKey != cursor->image().cacheKey()) {
+        m_cursor.texture.reset(new GLTexture(cursor->image()));
+    }
 
-            m_cursor.texture->setYInverted(false);
-            m_cursor.texture->bind();
-            const auto cursorRect = cursorGeometry(cursor);
-            mvp.translate(cursorRect.left(), r.height() - cursorRect.top() - cursor->image().height());
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            m_cursor.texture->render(cursorRect);
-            glDisable(GL_BLEND);
-            m_cursor.texture->unbind();
-            m_cursor.lastRect = cursorRect;
-
-            ShaderManager::instance()->popShader();
-            GLFramebuffer::popFramebuffer();
+    m_cursor.texture->setYInverted(false);
+    m_cursor.texture->bind();
+    const auto cursorRect = cursorGeometry(cursor);
+    mvp.translate(cursorRect.left(), r.height() - cursorRect.top() - cursor->image().height());
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_cursor.texture->render(cursorRect);
+    glDisable(GL_BLEND);
+    m_cursor.texture->unbind();
+    m_cursor.lastRect = cursorRect;
+
+    ShaderManager::instance()->popShader();
+    GLFramebuffer::popFramebuffer();
+}
+
+void ScreenCastStream::readPixels(pw_buffer *buffer, const QRegion &region, int stride)
+{
+    const QSize size = m_readback.framebuffer->size();
+    const bool hasAlpha = m_source->hasAlphaChannel();
+    const GLenum format = hasAlpha ? GL_BGRA : GL_BGR;
+    const int bpp = hasAlpha ? 4 : 3;
+
+    // Every glReadPixels() call has a fixed cost, read a few extra pixels instead if the
+    // damage is fragmented.
+    QVector<QRect> rects;
+    if (region.rectCount() > videoDamageRegionCount - 1) {
+        rects.append(region.boundingRect());
+    } else {
+        rects = QVector<QRect>(region.begin(), region.end());
+    }
+
+    // Pixel pack buffers need glMapBufferRange() to get the data back.
+    const bool async = hasGLVersion(3, 0);
+    if (async && m_readback.pixelPackBufferSize != qint64(stride) * size.height()) {
+        if (!m_readback.pixelPackBuffer) {
+            glGenBuffers(1, &m_readback.pixelPackBuffer);
+        }
+        m_readback.pixelPackBufferSize = qint64(stride) * size.height();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.pixelPackBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, m_readback.pixelPackBufferSize, nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    GLFramebuffer::pushFramebuffer(m_readback.framebuffer.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    if (async) {
+        // The pixels are written to the pack buffer at the same offsets as in the stream
+        // buffer, they are copied once the GPU is done, see finishReadback().
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.pixelPackBuffer);
+        glPixelStorei(GL_PACK_ROW_LENGTH, size.width());
+        for (const QRect &rect : std::as_const(rects)) {
+            const qintptr offset = qintptr(rect.y()) * stride + rect.x() * bpp;
+            glReadPixels(rect.x(), rect.y(), rect.width(), rect.height(), format, GL_UNSIGNED_BYTE, reinterpret_cast<void *>(offset));
+        }
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        m_readback.rects = rects;
+        m_readback.stride = stride;
+        m_readback.bytesPerPixel = bpp;
+        m_readback.pending = true;
+    } else {
+        // Without GL_PACK_ROW_LENGTH, only whole rows can be read directly into the buffer.
+        uint8_t *data = static_cast<uint8_t *>(buffer->buffer->datas[0].data);
+        for (const QRect &rect : std::as_const(rects)) {
+            glReadPixels(0, rect.y(), size.width(), rect.height(), format, GL_UNSIGNED_BYTE, data + qintptr(rect.y()) * stride);
         }
     }
 
-    if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Metadata) {
-        sendCursorData(Cursors::self()->currentCursor(),
-                       (spa_meta_cursor *)spa_buffer_find_meta_data(spa_buffer, SPA_META_Cursor, sizeof(spa_meta_cursor)));
+    GLFramebuffer::popFramebuffer();
+}
+
+void ScreenCastStream::finishReadback()
+{
+    m_readback.pending = false;
+
+    if (auto scene = Compositor::self()->scene()) {
+        scene->makeOpenGLContextCurrent();
+    }
+    if (m_readback.sync) {
+        glDeleteSync(m_readback.sync);
+        m_readback.sync = nullptr;
     }
 
-    addDamage(spa_buffer, damagedRegion | QRect({0, 0}, size));
-    addHeader(spa_buffer);
-    tryEnqueue(buffer);
+    uint8_t *data = static_cast<uint8_t *>(m_pendingBuffer->buffer->datas[0].data);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.pixelPackBuffer);
+    const auto map = static_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_readback.pixelPackBufferSize, GL_MAP_READ_BIT));
+    if (map) {
+        for (const QRect &rect : std::as_const(m_readback.rects)) {
+            const qint64 rowSize = qint64(rect.width()) * m_readback.bytesPerPixel;
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                const qint64 offset = qint64(y) * m_readback.stride + rect.x() * m_readback.bytesPerPixel;
+                memcpy(data + offset, map + offset, rowSize);
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        qCWarning(KWIN_SCREENCAST) << "Failed to map the screencast pixel pack buffer";
+        auto it = m_staleRegionForPwBuffer.find(m_pendingBuffer);
+        if (it != m_staleRegionForPwBuffer.end()) {
+            *it = QRect(QPoint(), m_readback.framebuffer->size());
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ScreenCastStream::pollReadback()
+{
+    if (auto scene = Compositor::self()->scene()) {
+        scene->makeOpenGLContextCurrent();
+    }
+
+    GLint status = GL_SIGNALED;
+    glGetSynciv(m_readback.sync, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status == GL_SIGNALED) {
+        enqueue();
+    } else {
+        m_readbackTimer.start();
+    }
 }
 
 void ScreenCastStream::addHeader(spa_buffer *spaBuffer)
@@ -549,6 +736,17 @@ void ScreenCastStream::tryEnqueue(pw_buffer *buffer)
                                                     QSocketNotifier::Read, this);
             connect(m_pendingNotifier, &QSocketNotifier::activated, this, &ScreenCastStream::enqueue);
         }
+    } else if (m_readback.pending) {
+        // Rather than stall the graphics pipeline until the pixels have been read back,
+        // check every now and then whether the GPU is done with the readback.
+        m_readback.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (m_readback.sync) {
+            glFlush();
+            m_readbackTimer.start();
+        } else {
+            glFinish();
+            enqueue();
+        }
     } else {
         // The compositing backend doesn't support native fences. We don't have any other choice
         // but stall the graphics pipeline. Otherwise stream consumers may see an incomplete buffer.
@@ -561,6 +759,10 @@ void ScreenCastStream::enqueue()
 {
     Q_ASSERT_X(m_pendingBuffer, "enqueue", "pending buffer must be valid");
 
+    if (m_readback.pending) {
+        finishReadback();
+    }
+
     delete m_pendingFence;
     delete m_pendingNotifier;
 
@@ -569,9 +771,47 @@ void ScreenCastStream::enqueue()
     m_pendingBuffer = nullptr;
     m_pendingFence = nullptr;
     m_pendingNotifier = nullptr;
+
+    // Record the frame that had to be delayed while the buffer was pending.
+    if (!m_pendingDamage.isEmpty() && !m_throttleTimer.isActive()) {
+        m_throttleTimer.start(0);
+    }
+}
+
+int ScreenCastStream::buildFormats(struct spa_pod_builder *b, const spa_pod **params)
+{
+    // Let the consumer pick any frame rate up to the refresh rate of the source.
+    const uint refreshRate = std::max(1u, (m_source->refreshRate() + 999) / 1000);
+    spa_fraction minFramerate = SPA_FRACTION(1, 1);
+    spa_fraction maxFramerate = SPA_FRACTION(refreshRate, 1);
+    spa_fraction defaultFramerate = SPA_FRACTION(0, 1);
+
+    // The consumer may ask for any size up to the size of the source, also after it has
+    // asked for a smaller one.
+    const QSize defaultSize = m_resolution.boundedTo(m_sourceSize);
+    spa_rectangle resolution = SPA_RECTANGLE(uint32_t(defaultSize.width()), uint32_t(defaultSize.height()));
+    spa_rectangle maxResolution = SPA_RECTANGLE(uint32_t(m_sourceSize.width()), uint32_t(m_sourceSize.height()));
+
+    // TODO[explicit_modifiers]: query modifiers supported/used by kwin
+    uint64_t modifier = DRM_FORMAT_MOD_INVALID;
+
+    auto canCreateDmaBuf = [this]() -> bool {
+        return !QSharedPointer<DmaBufTexture>(kwinApp()->platform()->createDmaBufTexture(m_resolution)).isNull();
+    };
+    const auto format = m_source->hasAlphaChannel() ? SPA_VIDEO_FORMAT_BGRA : SPA_VIDEO_FORMAT_BGR;
+
+    if (canCreateDmaBuf()) {
+        params[0] = buildFormat(b, SPA_VIDEO_FORMAT_BGRA, &resolution, &maxResolution, &defaultFramerate, &minFramerate, &maxFramerate, &modifier, 1);
+        params[1] = buildFormat(b, format, &resolution, &maxResolution, &defaultFramerate, &minFramerate, &maxFramerate, nullptr, 0);
+        return 2;
+    } else {
+        params[0] = buildFormat(b, format, &resolution, &maxResolution, &defaultFramerate, &minFramerate, &maxFramerate, nullptr, 0);
+        return 1;
+    }
 }
 
 spa_pod *ScreenCastStream::buildFormat(struct spa_pod_builder *b, enum spa_video_format format, struct spa_rectangle *resolution,
+                                       struct spa_rectangle *maxResolution,
                                        struct spa_fraction *defaultFramerate, struct spa_fraction *minFramerate, struct spa_fraction *maxFramerate,
                                        uint64_t *modifiers, int modifierCount)
 {
@@ -606,8 +846,9 @@ spa_pod *ScreenCastStream::buildFormat(struct spa_pod_builder *b, enum spa_video
         spa_pod_builder_pop(b, &f[1]);
     }
 
-    /* frame size */
-    spa_pod_builder_add(b, SPA_FORMAT_VIDEO_size, SPA_POD_Rectangle(resolution), 0);
+    /* frame size, the consumer may ask for a downscaled frame */
+    spa_rectangle minResolution = SPA_RECTANGLE(1, 1);
+    spa_pod_builder_add(b, SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle(resolution, &minResolution, maxResolution), 0);
 
     /* variable framerate */
     spa_pod_builder_add(b, SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction(defaultFramerate), 0);
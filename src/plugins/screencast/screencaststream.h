@@ -18,9 +18,11 @@
 #include <QSharedPointer>
 #include <QSize>
 #include <QSocketNotifier>
+#include <QTimer>
 #include <chrono>
 #include <optional>
 
+#include <epoxy/gl.h>
 #include <pipewire/pipewire.h>
 #include <spa/param/format-utils.h>
 #include <spa/param/props.h>
@@ -32,6 +34,7 @@ namespace KWin
 class Cursor;
 class DmaBufTexture;
 class EGLNativeFence;
+class GLFramebuffer;
 class GLTexture;
 class PipeWireCore;
 class ScreenCastSource;
@@ -54,8 +57,8 @@ public:
     void stop();
 
     /**
-     * Renders @p frame into the current framebuffer into the stream
-     * @p timestamp
+     * Renders the source into the stream. The @p damagedRegion is in the stream buffer
+     * coordinates and is reported to the consumer.
      */
     void recordFrame(const QRegion &damagedRegion);
 
@@ -84,8 +87,14 @@ private:
     void newStreamParams();
     void tryEnqueue(pw_buffer *buffer);
     void enqueue();
+    void renderCursor(GLFramebuffer *target);
+    void readPixels(pw_buffer *buffer, const QRegion &region, int stride);
+    void finishReadback();
+    void pollReadback();
+    int buildFormats(struct spa_pod_builder *b, const spa_pod **params);
     spa_pod *buildFormat(struct spa_pod_builder *b, enum spa_video_format format, struct spa_rectangle *resolution,
-                         struct spa_fraction *defaultFramerate, struct spa_fraction *minFramerate, struct spa_fraction *maxFramerate,
+                         struct spa_rectangle *maxResolution, struct spa_fraction *defaultFramerate,
+                         struct spa_fraction *minFramerate, struct spa_fraction *maxFramerate,
                          uint64_t *modifiers, int modifier_count);
 
     QSharedPointer<PipeWireCore> pwCore;
@@ -97,6 +106,7 @@ private:
     uint32_t pwNodeId = 0;
 
     QSize m_resolution;
+    QSize m_sourceSize;
     bool m_stopped = false;
 
     spa_video_info_raw videoFormat;
@@ -117,6 +127,28 @@ private:
     QRect cursorGeometry(Cursor *cursor) const;
 
     QHash<struct pw_buffer *, QSharedPointer<DmaBufTexture>> m_dmabufDataForPwBuffer;
+    // the parts of memfd buffers that have changed since the buffers were filled last time
+    QHash<struct pw_buffer *, QRegion> m_staleRegionForPwBuffer;
+
+    struct
+    {
+        QScopedPointer<GLTexture> texture;
+        QScopedPointer<GLFramebuffer> framebuffer;
+        GLuint pixelPackBuffer = 0;
+        qint64 pixelPackBufferSize = 0;
+        GLsync sync = nullptr;
+        QVector<QRect> rects;
+        int stride = 0;
+        int bytesPerPixel = 0;
+        bool pending = false;
+    } m_readback;
+    QTimer m_readbackTimer;
+
+    QTimer m_throttleTimer;
+    // The damage that hasn't been sent to the consumer yet. It is only cleared once a frame
+    // has actually been recorded, so frames that are dropped or delayed don't lose it.
+    QRegion m_pendingDamage;
+    std::chrono::steady_clock::time_point m_lastFrameTime;
 
     pw_buffer *m_pendingBuffer = nullptr;
     QSocketNotifier *m_pendingNotifier = nullptr;
@@ -5,7 +5,6 @@
 */
 
 #include "windowscreencastsource.h"
-#include "screencastutils.h"
 
 #include "composite.h"
 #include "deleted.h"
@@ -39,15 +38,6 @@ QSize WindowScreenCastSource::textureSize() const
     return m_window->clientGeometry().size();
 }
 
-void WindowScreenCastSource::render(QImage *image)
-{
-    GLTexture offscreenTexture(hasAlphaChannel() ? GL_RGBA8 : GL_RGB8, textureSize());
-    GLFramebuffer offscreenTarget(&offscreenTexture);
-
-    render(&offscreenTarget);
-    grabTexture(&offscreenTexture, image);
-}
-
 void WindowScreenCastSource::render(GLFramebuffer *target)
 {
     const QRect geometry = m_window->clientGeometry();
@@ -70,4 +60,9 @@ std::chrono::nanoseconds WindowScreenCastSource::clock() const
     return m_window->output()->renderLoop()->lastPresentationTimestamp();
 }
 
+uint WindowScreenCastSource::refreshRate() const
+{
+    return m_window->output()->refreshRate();
+}
+
 } // namespace KWin
@@ -24,4 +24,16 @@ bool RenderBackend::checkGraphicsReset()
     return false;
 }
 
+OutputLayer *RenderBackend::cursorLayer(Output *output)
+{
+    Q_UNUSED(output)
+    return nullptr;
+}
+
+QVector<OutputLayer *> RenderBackend::overlayLayers(Output *output)
+{
+    Q_UNUSED(output)
+    return {};
+}
+
 } // namespace KWin
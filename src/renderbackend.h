@@ -10,6 +10,7 @@
 #include "rendertarget.h"
 
 #include <QObject>
+#include <QVector>
 
 namespace KWin
 {
@@ -34,6 +35,17 @@ public:
     virtual bool checkGraphicsReset();
 
     virtual OutputLayer *primaryLayer(Output *output) = 0;
+    /**
+     * Returns the hardware layer that can be used to show the cursor on the given @a output,
+     * or @c nullptr if the cursor must be composited.
+     */
+    virtual OutputLayer *cursorLayer(Output *output);
+    /**
+     * Returns the hardware layers that can show surfaces on the given @a output next to the
+     * primary layer, stacked above it. Surfaces shown in these layers don't need to be
+     * composited.
+     */
+    virtual QVector<OutputLayer *> overlayLayers(Output *output);
     virtual void present(Output *output) = 0;
 };
 
@@ -6,6 +6,10 @@
 
 #include "renderjournal.h"
 
+#include <QVarLengthArray>
+
+#include <algorithm>
+
 namespace KWin
 {
 
@@ -13,18 +17,12 @@ RenderJournal::RenderJournal()
 {
 }
 
-void RenderJournal::beginFrame()
-{
-    m_timer.start();
-}
-
-void RenderJournal::endFrame()
+void RenderJournal::add(std::chrono::nanoseconds renderTime)
 {
-    std::chrono::nanoseconds duration(m_timer.nsecsElapsed());
     if (m_log.count() >= m_size) {
         m_log.dequeue();
     }
-    m_log.enqueue(duration);
+    m_log.enqueue(renderTime);
 }
 
 std::chrono::nanoseconds RenderJournal::minimum() const
@@ -53,4 +51,17 @@ std::chrono::nanoseconds RenderJournal::average() const
     return result / m_log.count();
 }
 
+std::chrono::nanoseconds RenderJournal::percentile(int percentile) const
+{
+    if (m_log.isEmpty()) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    // Nearest-rank method, the result is always one of the recorded render times.
+    QVarLengthArray<std::chrono::nanoseconds, 120> sorted(m_log.constBegin(), m_log.constEnd());
+    const int rank = std::clamp((percentile * sorted.count() + 99) / 100, 1, int(sorted.count()));
+    std::nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.end());
+    return sorted[rank - 1];
+}
+
 } // namespace KWin
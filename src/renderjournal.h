@@ -8,15 +8,19 @@
 
 #include "kwinglobals.h"
 
-#include <QElapsedTimer>
 #include <QQueue>
 
+#include <chrono>
+
 namespace KWin
 {
 
 /**
- * The RenderJournal class measures how long it takes to render frames and estimates how
+ * The RenderJournal class keeps track of how long it takes to render frames and estimates how
  * long it will take to render the next frame.
+ *
+ * The render time of a frame is the time from the start of the compositing cycle until the
+ * GPU has finished rendering the frame, if it's known, or until the frame has been submitted.
  */
 class KWIN_EXPORT RenderJournal
 {
@@ -24,14 +28,9 @@ public:
     RenderJournal();
 
     /**
-     * This function must be called before starting rendering a new frame.
-     */
-    void beginFrame();
-
-    /**
-     * This function must be called after finishing rendering a frame.
+     * Adds the render time of the last frame to the journal.
      */
-    void endFrame();
+    void add(std::chrono::nanoseconds renderTime);
 
     /**
      * Returns the maximum estimated amount of time that it takes to render a single frame.
@@ -48,10 +47,15 @@ public:
      */
     std::chrono::nanoseconds average() const;
 
+    /**
+     * Returns the amount of time that it takes to render the specified @a percentile of frames.
+     * For example, 95 percent of the recent frames have been rendered within percentile(95).
+     */
+    std::chrono::nanoseconds percentile(int percentile) const;
+
 private:
-    QElapsedTimer m_timer;
     QQueue<std::chrono::nanoseconds> m_log;
-    int m_size = 15;
+    int m_size = 120;
 };
 
 } // namespace KWin
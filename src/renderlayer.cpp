@@ -8,6 +8,7 @@
 #include "outputlayer.h"
 #include "renderlayerdelegate.h"
 #include "renderloop.h"
+#include "utils/rectregion.h"
 
 namespace KWin
 {
@@ -185,6 +186,30 @@ void RenderLayer::resetRepaints()
     m_repaints = QRegion();
 }
 
+RectRegion RenderLayer::takeRepaints()
+{
+    RectRegion repaint;
+    RectRegion opaque;
+    takeRepaints(&repaint, &opaque);
+    return repaint;
+}
+
+void RenderLayer::takeRepaints(RectRegion *repaint, RectRegion *opaque)
+{
+    // The sublayers are painted on top of the layer, so walk the layer tree from top to bottom
+    // and discard the repaints that are hidden behind the opaque contents of the layers above.
+    for (auto it = m_sublayers.crbegin(); it != m_sublayers.crend(); ++it) {
+        if ((*it)->isVisible()) {
+            (*it)->takeRepaints(repaint, opaque);
+        }
+    }
+
+    const RectRegion layerRepaints(mapToGlobal(m_repaints + m_delegate->repaints()));
+    m_repaints = QRegion();
+    *repaint |= layerRepaints - *opaque;
+    *opaque |= RectRegion(mapToGlobal(m_delegate->opaque()));
+}
+
 bool RenderLayer::isVisible() const
 {
     return m_effectiveVisible;
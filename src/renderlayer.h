@@ -19,6 +19,7 @@ namespace KWin
 {
 
 class OutputLayer;
+class RectRegion;
 class RenderLayerDelegate;
 class RenderLoop;
 
@@ -75,7 +76,15 @@ public:
     QRegion repaints() const;
     void resetRepaints();
 
+    /**
+     * Returns the repaints of this layer, its delegate and its visible sublayers in global
+     * coordinates, and resets them. Repaints hidden behind the opaque contents of the layers
+     * painted above them are discarded.
+     */
+    RectRegion takeRepaints();
+
 private:
+    void takeRepaints(RectRegion *repaint, RectRegion *opaque);
     void addSublayer(RenderLayer *sublayer);
     void removeSublayer(RenderLayer *sublayer);
     void updateBoundingRect();
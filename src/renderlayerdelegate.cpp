@@ -29,6 +29,11 @@ QRegion RenderLayerDelegate::repaints() const
     return QRegion();
 }
 
+QRegion RenderLayerDelegate::opaque() const
+{
+    return QRegion();
+}
+
 void RenderLayerDelegate::prePaint()
 {
 }
@@ -42,4 +47,9 @@ SurfaceItem *RenderLayerDelegate::scanoutCandidate() const
     return nullptr;
 }
 
+QVector<SurfaceItem *> RenderLayerDelegate::overlayCandidates() const
+{
+    return {};
+}
+
 } // namespace KWin
@@ -10,6 +10,7 @@
 
 #include <QObject>
 #include <QRegion>
+#include <QVector>
 
 namespace KWin
 {
@@ -36,6 +37,12 @@ public:
      */
     virtual QRegion repaints() const;
 
+    /**
+     * Returns the region in the render layer's coordinates that is covered by opaque
+     * contents. The compositor uses it to discard repaints of the render layers below.
+     */
+    virtual QRegion opaque() const;
+
     /**
      * This function is called by the compositor before starting compositing. Reimplement
      * this function to do frame initialization.
@@ -54,6 +61,13 @@ public:
      */
     virtual SurfaceItem *scanoutCandidate() const;
 
+    /**
+     * Returns the surfaces that can be shown in overlay output layers instead of being
+     * composited, ordered from top to bottom. Each candidate must be opaque and must not
+     * be covered by anything else in the render layer.
+     */
+    virtual QVector<SurfaceItem *> overlayCandidates() const;
+
     /**
      * This function is called when the compositor wants the render layer delegate
      * to repaint its contents.
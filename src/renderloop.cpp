@@ -37,14 +37,24 @@ void RenderLoopPrivate::scheduleRepaint()
     if (kwinApp()->isTerminating() || compositeTimer.isActive()) {
         return;
     }
-    if (vrrPolicy == RenderLoop::VrrPolicy::Always || (vrrPolicy == RenderLoop::VrrPolicy::Automatic && fullscreenItem != nullptr)) {
-        presentMode = SyncMode::Adaptive;
+    const bool vrr = vrrPolicy == RenderLoop::VrrPolicy::Always || (vrrPolicy == RenderLoop::VrrPolicy::Automatic && fullscreenItem != nullptr);
+    const bool tearing = fullscreenItemAllowsTearing && options->allowTearing();
+    if (tearing) {
+        presentMode = vrr ? SyncMode::AdaptiveAsync : SyncMode::Async;
     } else {
-        presentMode = SyncMode::Fixed;
+        presentMode = vrr ? SyncMode::Adaptive : SyncMode::Fixed;
     }
     const std::chrono::nanoseconds vblankInterval(1'000'000'000'000ull / refreshRate);
     const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
 
+    // The fullscreen surface wants its frames to be shown as soon as possible, there's no
+    // point in waiting for the deadline of the next vblank.
+    if (tearing) {
+        nextPresentationTimestamp = currentTime;
+        compositeTimer.start(0);
+        return;
+    }
+
     // Estimate when the next presentation will occur. Note that this is a prediction.
     nextPresentationTimestamp = lastPresentationTimestamp + vblankInterval;
     if (nextPresentationTimestamp < currentTime && presentMode == SyncMode::Fixed) {
@@ -53,7 +63,7 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 
     // Estimate when it's a good time to perform the next compositing cycle.
-    const std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
+    const std::chrono::nanoseconds safetyMargin = std::chrono::microseconds(options->renderTimeSafetyMargin());
 
     std::chrono::nanoseconds renderTime;
     switch (q->latencyPolicy()) {
@@ -84,6 +94,9 @@ void RenderLoopPrivate::scheduleRepaint()
     case RenderTimeEstimatorAverage:
         renderTime = std::max(renderTime, renderJournal.average());
         break;
+    case RenderTimeEstimatorPercentile:
+        renderTime = std::max(renderTime, renderJournal.percentile(options->renderTimePercentile()));
+        break;
     }
 
     std::chrono::nanoseconds nextRenderTimestamp = nextPresentationTimestamp - renderTime - safetyMargin;
@@ -115,12 +128,21 @@ void RenderLoopPrivate::notifyFrameFailed()
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
+    // The frame may fail before the Compositor has finished submitting it.
+    if (submittedFrames.count() > pendingFrameCount) {
+        FrameTimelineEntry frame = submittedFrames.dequeue();
+        frame.failed = true;
+        frameTimeline.append(frame);
+    } else {
+        currentFrame.failed = true;
+    }
+
     if (!inhibitCount) {
         maybeScheduleRepaint();
     }
 }
 
-void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
+void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp, quint64 sequence, RenderLoop::PresentationFlags flags)
 {
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
@@ -133,6 +155,17 @@ void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
                   static_cast<long long>(timestamp.count()),
                   static_cast<long long>(lastPresentationTimestamp.count()));
         lastPresentationTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+        flags.setFlag(RenderLoop::PresentationFlag::HardwareClock, false);
+    }
+    lastPresentationSequence = sequence;
+    lastPresentationFlags = flags;
+
+    if (submittedFrames.count() > pendingFrameCount) {
+        FrameTimelineEntry frame = submittedFrames.dequeue();
+        recordPresentation(&frame);
+        frameTimeline.append(frame);
+    } else {
+        recordPresentation(&currentFrame);
     }
 
     if (!inhibitCount) {
@@ -142,12 +175,43 @@ void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
     Q_EMIT q->framePresented(q, timestamp);
 }
 
+void RenderLoopPrivate::recordPresentation(FrameTimelineEntry *frame)
+{
+    frame->presentationTimestamp = lastPresentationTimestamp;
+    frame->presentationSequence = lastPresentationSequence;
+
+    // Missed vblanks can only be told apart from late frames with a fixed refresh rate.
+    if (presentMode == SyncMode::Fixed && frame->targetPresentationTimestamp > std::chrono::nanoseconds::zero()) {
+        const std::chrono::nanoseconds vblankInterval(1'000'000'000'000ull / refreshRate);
+        const std::chrono::nanoseconds delay = frame->presentationTimestamp - frame->targetPresentationTimestamp;
+        if (delay > vblankInterval / 2) {
+            frame->missedVblanks = (delay + vblankInterval / 2) / vblankInterval;
+        }
+    }
+}
+
+void RenderLoopPrivate::journalRenderTime(const FrameTimelineEntry &frame)
+{
+    // The GPU starts executing the rendering commands while they are still being issued, so
+    // the frame is done when either the CPU or the GPU is done, whichever happens last. The
+    // submit stage is left out, swapping buffers may block until the vblank and would then
+    // make the frame look as long as the refresh cycle. Its cost is in the frame timeline.
+    const std::chrono::nanoseconds cpuRenderTime = frame.renderEndTimestamp - frame.renderStartTimestamp;
+    const std::chrono::nanoseconds gpuRenderTime = frame.gpuRenderTime.value_or(std::chrono::nanoseconds::zero());
+    renderJournal.add(frame.renderEndTimestamp - frame.startTimestamp - cpuRenderTime + std::max(cpuRenderTime, gpuRenderTime));
+}
+
 void RenderLoopPrivate::dispatch()
 {
     // On X11, we want to ignore repaints that are scheduled by windows right before
     // the Compositor starts repainting.
     pendingRepaint = true;
 
+    currentFrame = FrameTimelineEntry();
+    currentFrame.frame = ++frameCounter;
+    currentFrame.startTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+    currentFrame.targetPresentationTimestamp = nextPresentationTimestamp;
+
     Q_EMIT q->frameRequested(q);
 
     // The Compositor may decide to not repaint when the frameRequested() signal is
@@ -159,6 +223,7 @@ void RenderLoopPrivate::invalidate()
 {
     pendingReschedule = false;
     pendingFrameCount = 0;
+    submittedFrames.clear();
     compositeTimer.stop();
 }
 
@@ -195,12 +260,59 @@ void RenderLoop::beginFrame()
 {
     d->pendingRepaint = false;
     d->pendingFrameCount++;
-    d->renderJournal.beginFrame();
+    d->currentFrame.renderStartTimestamp = std::chrono::steady_clock::now().time_since_epoch();
 }
 
 void RenderLoop::endFrame()
 {
-    d->renderJournal.endFrame();
+    d->currentFrame.renderEndTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+}
+
+void RenderLoop::notifyFrameSubmitted()
+{
+    d->currentFrame.submitTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+    d->lastSubmittedFrame = d->currentFrame.frame;
+
+    // The GPU render time of the previous frame should have been reported by now, if it's known.
+    if (d->unjournaledFrame) {
+        d->journalRenderTime(*d->unjournaledFrame);
+    }
+    d->unjournaledFrame = d->currentFrame;
+
+    // Some backends present or discard the frame right away.
+    if (d->currentFrame.failed || d->currentFrame.presentationTimestamp > std::chrono::nanoseconds::zero()) {
+        d->frameTimeline.append(d->currentFrame);
+    } else {
+        d->submittedFrames.enqueue(d->currentFrame);
+    }
+}
+
+void RenderLoop::addTextureUploadSize(qint64 size)
+{
+    d->currentFrame.textureUploadSize += size;
+}
+
+void RenderLoop::setGpuRenderTime(std::chrono::nanoseconds renderTime)
+{
+    if (d->unjournaledFrame && d->unjournaledFrame->frame == d->lastSubmittedFrame) {
+        d->unjournaledFrame->gpuRenderTime = renderTime;
+        d->journalRenderTime(*d->unjournaledFrame);
+        d->unjournaledFrame.reset();
+    }
+
+    // The frame may still be waiting for presentation.
+    for (FrameTimelineEntry &frame : d->submittedFrames) {
+        if (frame.frame == d->lastSubmittedFrame) {
+            frame.gpuRenderTime = renderTime;
+            return;
+        }
+    }
+    d->frameTimeline.setGpuRenderTime(d->lastSubmittedFrame, renderTime);
+}
+
+const FrameTimeline *RenderLoop::frameTimeline() const
+{
+    return &d->frameTimeline;
 }
 
 int RenderLoop::refreshRate() const
@@ -249,14 +361,25 @@ std::chrono::nanoseconds RenderLoop::lastPresentationTimestamp() const
     return d->lastPresentationTimestamp;
 }
 
+quint64 RenderLoop::lastPresentationSequence() const
+{
+    return d->lastPresentationSequence;
+}
+
+RenderLoop::PresentationFlags RenderLoop::lastPresentationFlags() const
+{
+    return d->lastPresentationFlags;
+}
+
 std::chrono::nanoseconds RenderLoop::nextPresentationTimestamp() const
 {
     return d->nextPresentationTimestamp;
 }
 
-void RenderLoop::setFullscreenSurface(Item *surfaceItem)
+void RenderLoop::setFullscreenSurface(SurfaceItem *surfaceItem)
 {
     d->fullscreenItem = surfaceItem;
+    d->fullscreenItemAllowsTearing = surfaceItem && surfaceItem->allowsTearing();
 }
 
 RenderLoop::VrrPolicy RenderLoop::vrrPolicy() const
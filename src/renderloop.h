@@ -14,8 +14,10 @@
 namespace KWin
 {
 
+class FrameTimeline;
 class RenderLoopPrivate;
 class Item;
+class SurfaceItem;
 
 /**
  * The RenderLoop class represents the compositing scheduler on a particular output.
@@ -33,6 +35,29 @@ public:
     explicit RenderLoop(QObject *parent = nullptr);
     ~RenderLoop() override;
 
+    /**
+     * This enum type describes how a frame has been presented on the screen.
+     */
+    enum class PresentationFlag : uint {
+        /**
+         * The presentation was synchronized to the vertical retrace of the output.
+         */
+        VSync = 0x1,
+        /**
+         * The presentation timestamp was provided by the display hardware.
+         */
+        HardwareClock = 0x2,
+        /**
+         * The display hardware signalled that it started using the new image content.
+         */
+        HardwareCompletion = 0x4,
+        /**
+         * The presentation of the frame was done zero-copy, i.e. via direct scanout.
+         */
+        ZeroCopy = 0x8,
+    };
+    Q_DECLARE_FLAGS(PresentationFlags, PresentationFlag)
+
     /**
      * Pauses the render loop. While the render loop is inhibited, scheduleRepaint()
      * requests are queued.
@@ -59,6 +84,27 @@ public:
      */
     void endFrame();
 
+    /**
+     * This function must be called after the Compositor has handed the frame over to
+     * the backend for presentation.
+     */
+    void notifyFrameSubmitted();
+
+    /**
+     * Sets the time the GPU spent rendering the last submitted frame to @a renderTime.
+     */
+    void setGpuRenderTime(std::chrono::nanoseconds renderTime);
+
+    /**
+     * Adds @a size bytes to the amount of texture data uploaded for the current frame.
+     */
+    void addTextureUploadSize(qint64 size);
+
+    /**
+     * Returns the timings of the recently presented frames.
+     */
+    const FrameTimeline *frameTimeline() const;
+
     /**
      * Returns the refresh rate at which the output is being updated, in millihertz.
      */
@@ -80,6 +126,17 @@ public:
      */
     std::chrono::nanoseconds lastPresentationTimestamp() const;
 
+    /**
+     * Returns the vertical retrace counter value corresponding to the last frame that
+     * has been presented on the screen, or @c 0 if the output doesn't provide one.
+     */
+    quint64 lastPresentationSequence() const;
+
+    /**
+     * Returns the flags that describe how the last frame has been presented on the screen.
+     */
+    PresentationFlags lastPresentationFlags() const;
+
     /**
      * If a repaint has been scheduled, this function returns the expected time when
      * the next frame will be presented on the screen. The returned timestamp is sourced
@@ -89,9 +146,10 @@ public:
 
     /**
      * Sets the surface that currently gets scanned out,
-     * so that this RenderLoop can adjust its timing behavior to that surface
+     * so that this RenderLoop can adjust its timing behavior to that surface.
+     * If the surface allows tearing, frames will be presented without waiting for vblank.
      */
-    void setFullscreenSurface(Item *surface);
+    void setFullscreenSurface(SurfaceItem *surface);
 
     enum class VrrPolicy : uint32_t {
         Never = 0,
@@ -150,3 +208,5 @@ private:
 };
 
 } // namespace KWin
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::RenderLoop::PresentationFlags)
@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include "frametimeline.h"
 #include "renderjournal.h"
 #include "renderloop.h"
 
+#include <QQueue>
 #include <QTimer>
 
 #include <optional>
@@ -30,13 +32,23 @@ public:
     void maybeScheduleRepaint();
 
     void notifyFrameFailed();
-    void notifyFrameCompleted(std::chrono::nanoseconds timestamp);
+    void notifyFrameCompleted(std::chrono::nanoseconds timestamp, quint64 sequence = 0, RenderLoop::PresentationFlags flags = RenderLoop::PresentationFlags());
+    void recordPresentation(FrameTimelineEntry *frame);
+    void journalRenderTime(const FrameTimelineEntry &frame);
 
     RenderLoop *q;
     std::chrono::nanoseconds lastPresentationTimestamp = std::chrono::nanoseconds::zero();
     std::chrono::nanoseconds nextPresentationTimestamp = std::chrono::nanoseconds::zero();
+    quint64 lastPresentationSequence = 0;
+    RenderLoop::PresentationFlags lastPresentationFlags;
     QTimer compositeTimer;
     RenderJournal renderJournal;
+    FrameTimeline frameTimeline;
+    FrameTimelineEntry currentFrame;
+    QQueue<FrameTimelineEntry> submittedFrames;
+    quint64 frameCounter = 0;
+    quint64 lastSubmittedFrame = 0;
+    std::optional<FrameTimelineEntry> unjournaledFrame;
     int refreshRate = 60000;
     int pendingFrameCount = 0;
     int inhibitCount = 0;
@@ -45,10 +57,19 @@ public:
     RenderLoop::VrrPolicy vrrPolicy = RenderLoop::VrrPolicy::Never;
     std::optional<LatencyPolicy> latencyPolicy;
     Item *fullscreenItem = nullptr;
+    bool fullscreenItemAllowsTearing = false;
 
     enum class SyncMode {
         Fixed,
         Adaptive,
+        /**
+         * The frames are presented as soon as possible, without waiting for vblank.
+         */
+        Async,
+        /**
+         * Same as Async, but with variable refresh rate enabled.
+         */
+        AdaptiveAsync,
     };
     SyncMode presentMode = SyncMode::Fixed;
 };
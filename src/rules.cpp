@@ -18,6 +18,8 @@
 #include <QTemporaryFile>
 #include <kconfig.h>
 
+#include <algorithm>
+
 #ifndef KCMRULES
 #include "client_machine.h"
 #include "main.h"
@@ -115,6 +117,16 @@ Rules::Rules(const RuleSettings *settings)
     readFromSettings(settings);
 }
 
+static QRegularExpression compileMatchRegExp(const QString &pattern, Rules::StringMatch match)
+{
+    if (match != Rules::RegExpMatch) {
+        return QRegularExpression();
+    }
+    QRegularExpression regExp(pattern);
+    regExp.optimize();
+    return regExp;
+}
+
 void Rules::readFromSettings(const RuleSettings *settings)
 {
     description = settings->description();
@@ -126,6 +138,10 @@ void Rules::readFromSettings(const RuleSettings *settings)
     READ_MATCH_STRING(windowrole, .toLower().toLatin1());
     READ_MATCH_STRING(title, );
     READ_MATCH_STRING(clientmachine, .toLower().toLatin1());
+    wmclassregexp = compileMatchRegExp(QString::fromUtf8(wmclass), wmclassmatch);
+    windowroleregexp = compileMatchRegExp(QString::fromUtf8(windowrole), windowrolematch);
+    titleregexp = compileMatchRegExp(title, titlematch);
+    clientmachineregexp = compileMatchRegExp(QString::fromUtf8(clientmachine), clientmachinematch);
     types = NET::WindowTypeMask(settings->types());
     READ_FORCE_RULE(placement, );
     READ_SET_RULE(position);
@@ -339,11 +355,10 @@ bool Rules::matchType(NET::WindowType match_type) const
 bool Rules::matchWMClass(const QByteArray &match_class, const QByteArray &match_name) const
 {
     if (wmclassmatch != UnimportantMatch) {
-        // TODO optimize?
         QByteArray cwmclass = wmclasscomplete
             ? match_name + ' ' + match_class
             : match_class;
-        if (wmclassmatch == RegExpMatch && !QRegularExpression(QString::fromUtf8(wmclass)).match(QString::fromUtf8(cwmclass)).hasMatch()) {
+        if (wmclassmatch == RegExpMatch && !wmclassregexp.match(QString::fromUtf8(cwmclass)).hasMatch()) {
             return false;
         }
         if (wmclassmatch == ExactMatch && wmclass != cwmclass) {
@@ -359,7 +374,7 @@ bool Rules::matchWMClass(const QByteArray &match_class, const QByteArray &match_
 bool Rules::matchRole(const QByteArray &match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && !QRegularExpression(QString::fromUtf8(windowrole)).match(QString::fromUtf8(match_role)).hasMatch()) {
+        if (windowrolematch == RegExpMatch && !windowroleregexp.match(QString::fromUtf8(match_role)).hasMatch()) {
             return false;
         }
         if (windowrolematch == ExactMatch && windowrole != match_role) {
@@ -375,7 +390,7 @@ bool Rules::matchRole(const QByteArray &match_role) const
 bool Rules::matchTitle(const QString &match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && !QRegularExpression(title).match(match_title).hasMatch()) {
+        if (titlematch == RegExpMatch && !titleregexp.match(match_title).hasMatch()) {
             return false;
         }
         if (titlematch == ExactMatch && title != match_title) {
@@ -397,7 +412,7 @@ bool Rules::matchClientMachine(const QByteArray &match_machine, bool local) cons
             return true;
         }
         if (clientmachinematch == RegExpMatch
-            && !QRegularExpression(QString::fromUtf8(clientmachine)).match(QString::fromUtf8(match_machine)).hasMatch()) {
+            && !clientmachineregexp.match(QString::fromUtf8(match_machine)).hasMatch()) {
             return false;
         }
         if (clientmachinematch == ExactMatch
@@ -671,6 +686,15 @@ bool Rules::isTemporary() const
     return temporary_state > 0;
 }
 
+QByteArray Rules::exactWMClass(bool *complete) const
+{
+    if (wmclassmatch != ExactMatch) {
+        return QByteArray();
+    }
+    *complete = wmclasscomplete;
+    return wmclass;
+}
+
 bool Rules::discardTemporary(bool force)
 {
     if (temporary_state == 0) { // not temporary
@@ -920,29 +944,65 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    invalidateMatchIndex();
+}
+
+void RuleBook::invalidateMatchIndex()
+{
+    m_matchIndexDirty = true;
+}
+
+void RuleBook::updateMatchIndex()
+{
+    if (!m_matchIndexDirty) {
+        return;
+    }
+    m_indexedRules = m_rules.toVector();
+    m_wmclassIndex.clear();
+    m_completeWmclassIndex.clear();
+    m_unindexedRules.clear();
+    for (int i = 0; i < m_indexedRules.count(); ++i) {
+        bool complete = false;
+        const QByteArray wmclass = m_indexedRules[i]->exactWMClass(&complete);
+        if (wmclass.isNull()) {
+            m_unindexedRules.append(i);
+        } else if (complete) {
+            m_completeWmclassIndex[wmclass].append(i);
+        } else {
+            m_wmclassIndex[wmclass].append(i);
+        }
+    }
+    m_matchIndexDirty = false;
 }
 
 WindowRules RuleBook::find(const Window *c, bool ignore_temporary)
 {
+    updateMatchIndex();
+
+    // The buckets are sorted, merge them to evaluate the candidates in the order of priority.
+    QVector<int> candidates = m_unindexedRules;
+    candidates += m_wmclassIndex.value(c->resourceClass());
+    candidates += m_completeWmclassIndex.value(c->resourceName() + ' ' + c->resourceClass());
+    std::sort(candidates.begin(), candidates.end());
+
     QVector<Rules *> ret;
-    for (QList<Rules *>::Iterator it = m_rules.begin();
-         it != m_rules.end();) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    bool removedTemporary = false;
+    for (int index : qAsConst(candidates)) {
+        Rules *rule = m_indexedRules[index];
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(c)) {
-            Rules *rule = *it;
+        if (rule->match(c)) {
             qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
             if (rule->isTemporary()) {
-                it = m_rules.erase(it);
-            } else {
-                ++it;
+                m_rules.removeOne(rule);
+                removedTemporary = true;
             }
             ret.append(rule);
-            continue;
         }
-        ++it;
+    }
+    if (removedTemporary) {
+        invalidateMatchIndex();
     }
     return WindowRules(ret);
 }
@@ -981,6 +1041,7 @@ void RuleBook::load()
     RuleBookSettings book(m_config);
     book.load();
     m_rules = book.rules().toList();
+    invalidateMatchIndex();
 }
 
 void RuleBook::save()
@@ -1013,6 +1074,7 @@ void RuleBook::temporaryRulesMessage(const QString &message)
     }
     Rules *rule = new Rules(message, true);
     m_rules.prepend(rule); // highest priority first
+    invalidateMatchIndex();
     if (!was_temporary) {
         QTimer::singleShot(60000, this, &RuleBook::cleanupTemporaryRules);
     }
@@ -1025,6 +1087,7 @@ void RuleBook::cleanupTemporaryRules()
          it != m_rules.end();) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            invalidateMatchIndex();
         } else {
             if ((*it)->isTemporary()) {
                 has_temporary = true;
@@ -1051,6 +1114,7 @@ void RuleBook::discardUsed(Window *c, bool withdrawn)
                 Rules *r = *it;
                 it = m_rules.erase(it);
                 delete r;
+                invalidateMatchIndex();
                 continue;
             }
         }
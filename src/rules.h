@@ -10,7 +10,9 @@
 #ifndef KWIN_RULES_H
 #define KWIN_RULES_H
 
+#include <QHash>
 #include <QRect>
+#include <QRegularExpression>
 #include <QVector>
 #include <netwm_def.h>
 
@@ -151,6 +153,12 @@ public:
     bool update(Window *, int selection);
     bool isTemporary() const;
     bool discardTemporary(bool force); // removes if temporary and forced or too old
+    /**
+     * Returns the window class that has to be matched exactly, or a null byte array if the
+     * rule matches the window class in some other way. If @a complete is set to @c true, the
+     * returned value contains both the resource name and the resource class.
+     */
+    QByteArray exactWMClass(bool *complete) const;
     bool applyPlacement(Placement::Policy &placement) const;
     bool applyGeometry(QRect &rect, bool init) const;
     // use 'invalidPoint' with applyPosition, unlike QSize() and QRect(), QPoint() is a valid point
@@ -220,6 +228,11 @@ private:
     StringMatch titlematch;
     QByteArray clientmachine;
     StringMatch clientmachinematch;
+    // compiled once when the rule is read, matching is done for every window and caption change
+    QRegularExpression wmclassregexp;
+    QRegularExpression windowroleregexp;
+    QRegularExpression titleregexp;
+    QRegularExpression clientmachineregexp;
     NET::WindowTypes types; // types for matching
     Placement::Policy placement;
     ForceRule placementrule;
@@ -324,9 +337,18 @@ private:
     void deleteAll();
     void initializeX11();
     void cleanupX11();
+    void invalidateMatchIndex();
+    void updateMatchIndex();
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules *> m_rules;
+    // rules that match the window class exactly are bucketed by the window class, so find()
+    // needs to evaluate only the rules that can possibly match, the indices refer to m_indexedRules
+    QVector<Rules *> m_indexedRules;
+    QHash<QByteArray, QVector<int>> m_wmclassIndex;
+    QHash<QByteArray, QVector<int>> m_completeWmclassIndex;
+    QVector<int> m_unindexedRules;
+    bool m_matchIndexDirty = true;
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 
@@ -60,6 +60,8 @@
 #include "shadowitem.h"
 #include "surfaceitem.h"
 #include "unmanaged.h"
+#include "utils/rectregion.h"
+#include "wayland/presentationtime_interface.h"
 #include "wayland/surface_interface.h"
 #include "waylandwindow.h"
 #include "windowitem.h"
@@ -106,11 +108,22 @@ QRegion SceneDelegate::repaints() const
     return m_scene->damage().translated(-viewport().topLeft());
 }
 
+QRegion SceneDelegate::opaque() const
+{
+    // The background is painted below the windows, so the whole viewport is opaque.
+    return layer()->rect();
+}
+
 SurfaceItem *SceneDelegate::scanoutCandidate() const
 {
     return m_scene->scanoutCandidate();
 }
 
+QVector<SurfaceItem *> SceneDelegate::overlayCandidates() const
+{
+    return m_scene->overlayCandidates();
+}
+
 void SceneDelegate::prePaint()
 {
     m_scene->prePaint(m_output);
@@ -258,9 +271,79 @@ SurfaceItem *Scene::scanoutCandidate() const
     return candidate;
 }
 
+static void findOverlayCandidates(SurfaceItem *item, QRegion *occluded, QVector<SurfaceItem *> *candidates)
+{
+    if (!item->isVisible()) {
+        return;
+    }
+
+    // Visit the subsurfaces from top to bottom, the ones above the parent first.
+    const QList<Item *> children = item->sortedChildItems();
+    auto it = children.crbegin();
+    for (; it != children.crend() && (*it)->z() >= 0; ++it) {
+        if (auto child = qobject_cast<SurfaceItem *>(*it)) {
+            findOverlayCandidates(child, occluded, candidates);
+        }
+    }
+
+    const QRect rect = item->mapToGlobal(item->rect());
+    if (!occluded->intersects(rect)) {
+        auto pixmap = item->pixmap();
+        if (pixmap) {
+            pixmap->update();
+            if (pixmap->isValid() && (!pixmap->hasAlphaChannel() || item->opaque().contains(item->rect()))) {
+                candidates->append(item);
+            }
+        }
+    }
+    *occluded += rect;
+
+    for (; it != children.crend(); ++it) {
+        if (auto child = qobject_cast<SurfaceItem *>(*it)) {
+            findOverlayCandidates(child, occluded, candidates);
+        }
+    }
+}
+
+QVector<SurfaceItem *> Scene::overlayCandidates() const
+{
+    return m_overlayCandidates;
+}
+
+void Scene::updateOverlayCandidates()
+{
+    m_overlayCandidates.clear();
+    if (!waylandServer()) {
+        return;
+    }
+    if (static_cast<EffectsHandlerImpl *>(effects)->blocksDirectScanout()) {
+        return;
+    }
+    if (m_paintContext.mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) {
+        return;
+    }
+
+    QRegion occluded;
+    for (int i = m_paintContext.phase2Data.size() - 1; i >= 0; --i) {
+        const Phase2Data &data = m_paintContext.phase2Data.at(i);
+        WindowItem *windowItem = data.item;
+        if (!windowItem->isVisible()) {
+            continue;
+        }
+        const Window *window = windowItem->window();
+        if (window->isOnOutput(painted_screen) && window->opacity() == 1.0
+            && !(data.mask & (PAINT_WINDOW_TRANSLUCENT | PAINT_WINDOW_TRANSFORMED)) && windowItem->surfaceItem()) {
+            findOverlayCandidates(windowItem->surfaceItem(), &occluded, &m_overlayCandidates);
+        }
+        // Anything below this window is covered by its decoration and shadow as well.
+        occluded += windowItem->mapToGlobal(windowItem->boundingRect());
+    }
+}
+
 void Scene::prePaint(Output *output)
 {
     createStackingOrder();
+    m_frameRendered = false;
 
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
         painted_screen = kwinApp()->platform()->enabledOutputs().constFirst();
@@ -306,20 +389,34 @@ void Scene::prePaint(Output *output)
     } else {
         preparePaintSimpleScreen();
     }
+
+    // The pixmaps of the candidates are updated here rather than when the compositor asks
+    // for the candidates, the overlay layers must see the current client buffers.
+    updateOverlayCandidates();
 }
 
 static void resetRepaintsHelper(Item *item, Output *output)
 {
+    if (!item->hasDirtySubtree(output)) {
+        return;
+    }
+
     item->resetRepaints(output);
 
     const auto childItems = item->childItems();
     for (Item *childItem : childItems) {
         resetRepaintsHelper(childItem, output);
     }
+
+    item->markSubtreeClean(output);
 }
 
 static void accumulateRepaints(Item *item, Output *output, QRegion *repaints)
 {
+    if (!item->hasDirtySubtree(output)) {
+        return;
+    }
+
     *repaints += item->repaints(output);
     item->resetRepaints(output);
 
@@ -327,6 +424,8 @@ static void accumulateRepaints(Item *item, Output *output, QRegion *repaints)
     for (Item *childItem : childItems) {
         accumulateRepaints(childItem, output, repaints);
     }
+
+    item->markSubtreeClean(output);
 }
 
 void Scene::preparePaintGenericScreen()
@@ -400,8 +499,25 @@ void Scene::postPaint()
     effects->postPaintScreen();
 
     if (waylandServer()) {
+        RenderLoop *renderLoop = painted_screen->renderLoop();
         const std::chrono::milliseconds frameTime =
-            std::chrono::duration_cast<std::chrono::milliseconds>(painted_screen->renderLoop()->lastPresentationTimestamp());
+            std::chrono::duration_cast<std::chrono::milliseconds>(renderLoop->lastPresentationTimestamp());
+
+        PendingPresentationFeedback &pending = m_presentationFeedback[renderLoop];
+        if (!pending.feedback) {
+            pending.output = painted_screen;
+            pending.feedback = std::make_unique<KWaylandServer::PresentationFeedback>();
+            connect(renderLoop, &RenderLoop::framePresented, this, &Scene::handleFramePresented, Qt::UniqueConnection);
+            connect(renderLoop, &QObject::destroyed, this, &Scene::handleRenderLoopDestroyed, Qt::UniqueConnection);
+        }
+
+        // A single fence is shared by all surfaces painted in this frame. If the frame has
+        // been scanned out directly, the compositor hasn't read the client buffers with the
+        // GPU and they are released when the display stops scanning them out.
+        std::optional<FileDescriptor> releaseFence;
+        if (!m_frameRendered) {
+            releaseFence = FileDescriptor();
+        }
 
         for (WindowItem *windowItem : std::as_const(stacking_order)) {
             Window *window = windowItem->window();
@@ -410,13 +526,64 @@ void Scene::postPaint()
             }
             if (auto surface = window->surface()) {
                 surface->frameRendered(frameTime.count());
+                surface->takePresentationFeedback(pending.feedback.get());
+                if (surface->wantsReleaseFence()) {
+                    if (!releaseFence) {
+                        releaseFence = createReleaseFence();
+                    }
+                    if (releaseFence->isValid()) {
+                        surface->setReleaseFence(*releaseFence);
+                    }
+                }
             }
         }
     }
 
+    m_overlayCandidates.clear();
     clearStackingOrder();
 }
 
+static KWaylandServer::PresentationFeedback::Flags presentationFeedbackFlags(RenderLoop::PresentationFlags flags)
+{
+    KWaylandServer::PresentationFeedback::Flags ret;
+    if (flags.testFlag(RenderLoop::PresentationFlag::VSync)) {
+        ret |= KWaylandServer::PresentationFeedback::Flag::VSync;
+    }
+    if (flags.testFlag(RenderLoop::PresentationFlag::HardwareClock)) {
+        ret |= KWaylandServer::PresentationFeedback::Flag::HardwareClock;
+    }
+    if (flags.testFlag(RenderLoop::PresentationFlag::HardwareCompletion)) {
+        ret |= KWaylandServer::PresentationFeedback::Flag::HardwareCompletion;
+    }
+    if (flags.testFlag(RenderLoop::PresentationFlag::ZeroCopy)) {
+        ret |= KWaylandServer::PresentationFeedback::Flag::ZeroCopy;
+    }
+    return ret;
+}
+
+void Scene::handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp)
+{
+    auto it = m_presentationFeedback.find(renderLoop);
+    if (it == m_presentationFeedback.end()) {
+        return;
+    }
+
+    const PendingPresentationFeedback pending = std::move(it->second);
+    m_presentationFeedback.erase(it);
+
+    const std::chrono::nanoseconds refreshDuration(1'000'000'000'000ull / renderLoop->refreshRate());
+    pending.feedback->presented(waylandServer()->findWaylandOutput(pending.output),
+                                timestamp,
+                                refreshDuration,
+                                renderLoop->lastPresentationSequence(),
+                                presentationFeedbackFlags(renderLoop->lastPresentationFlags()));
+}
+
+void Scene::handleRenderLoopDestroyed(QObject *renderLoop)
+{
+    m_presentationFeedback.erase(static_cast<RenderLoop *>(renderLoop));
+}
+
 static QMatrix4x4 createProjectionMatrix(const QRect &rect)
 {
     // Create a perspective projection with a 60° field-of-view,
@@ -488,6 +655,7 @@ void Scene::paintScreen(const QRegion &region)
     effects->paintScreen(m_paintContext.mask, region, data);
 
     m_paintScreenCount = 0;
+    m_frameRendered = true;
     Q_EMIT frameRendered();
 }
 
@@ -524,22 +692,24 @@ void Scene::paintGenericScreen(int, const ScreenPaintData &)
 // to reduce painting and improve performance.
 void Scene::paintSimpleScreen(int, const QRegion &region)
 {
-    // This is the occlusion culling pass
-    QRegion visible = region;
+    // This is the occlusion culling pass. It runs every frame, so the intermediate
+    // regions are computed with RectRegion and converted to QRegion only once per window.
+    RectRegion visible(region);
     for (int i = m_paintContext.phase2Data.size() - 1; i >= 0; --i) {
         Phase2Data *data = &m_paintContext.phase2Data[i];
-        data->region = visible;
 
         if (!(data->mask & PAINT_WINDOW_TRANSFORMED)) {
-            data->region &= data->item->mapToGlobal(data->item->boundingRect());
+            data->region = visible.intersected(data->item->mapToGlobal(data->item->boundingRect())).toQRegion();
 
             if (!(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
-                visible -= data->opaque;
+                visible -= RectRegion(data->opaque);
             }
+        } else {
+            data->region = visible.toQRegion();
         }
     }
 
-    paintBackground(visible);
+    paintBackground(visible.toQRegion());
 
     for (const Phase2Data &paintData : std::as_const(m_paintContext.phase2Data)) {
         paintWindow(paintData.item, paintData.mask, paintData.region);
@@ -617,6 +787,11 @@ bool Scene::supportsNativeFence() const
     return false;
 }
 
+FileDescriptor Scene::createReleaseFence()
+{
+    return FileDescriptor();
+}
+
 QMatrix4x4 Scene::screenProjectionMatrix() const
 {
     return QMatrix4x4();
@@ -13,13 +13,21 @@
 #include "kwineffects.h"
 #include "renderlayerdelegate.h"
 #include "utils/common.h"
+#include "utils/filedescriptor.h"
 #include "window.h"
 
+#include <map>
+#include <memory>
 #include <optional>
 
 #include <QElapsedTimer>
 #include <QMatrix4x4>
 
+namespace KWaylandServer
+{
+class PresentationFeedback;
+}
+
 namespace KWin
 {
 
@@ -57,7 +65,9 @@ public:
     QRect viewport() const;
 
     QRegion repaints() const override;
+    QRegion opaque() const override;
     SurfaceItem *scanoutCandidate() const override;
+    QVector<SurfaceItem *> overlayCandidates() const override;
     void prePaint() override;
     void postPaint() override;
     void paint(RenderTarget *renderTarget, const QRegion &region) override;
@@ -96,6 +106,7 @@ public:
     virtual bool initFailed() const = 0;
 
     SurfaceItem *scanoutCandidate() const;
+    QVector<SurfaceItem *> overlayCandidates() const;
     void prePaint(Output *output);
     void postPaint();
     virtual void paint(RenderTarget *renderTarget, const QRegion &region) = 0;
@@ -131,6 +142,12 @@ public:
     virtual bool makeOpenGLContextCurrent();
     virtual void doneOpenGLContextCurrent();
     virtual bool supportsNativeFence() const;
+    /**
+     * Creates a sync file that will be signaled when the rendering commands that have been
+     * submitted so far finish executing. Returns an invalid file descriptor if the rendering
+     * is synchronous or the platform doesn't support native fences.
+     */
+    virtual FileDescriptor createReleaseFence();
 
     virtual QMatrix4x4 screenProjectionMatrix() const;
 
@@ -232,6 +249,16 @@ protected:
     QVector<WindowItem *> stacking_order;
 
 private:
+    void updateOverlayCandidates();
+    void handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp);
+    void handleRenderLoopDestroyed(QObject *renderLoop);
+
+    struct PendingPresentationFeedback
+    {
+        Output *output = nullptr;
+        std::unique_ptr<KWaylandServer::PresentationFeedback> feedback;
+    };
+
     std::chrono::milliseconds m_expectedPresentTimestamp = std::chrono::milliseconds::zero();
     QList<SceneDelegate *> m_delegates;
     QRect m_geometry;
@@ -240,7 +267,13 @@ private:
     qreal m_renderTargetScale = 1;
     // how many times finalPaintScreen() has been called
     int m_paintScreenCount = 0;
+    // whether the current frame has been rendered rather than scanned out directly
+    bool m_frameRendered = false;
     PaintContext m_paintContext;
+    // surfaces that can be shown in overlay layers in the current frame, top to bottom
+    QVector<SurfaceItem *> m_overlayCandidates;
+    // presentation feedback of the painted frames that are yet to be presented
+    std::map<RenderLoop *, PendingPresentationFeedback> m_presentationFeedback;
 };
 
 } // namespace
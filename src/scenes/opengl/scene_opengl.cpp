@@ -13,6 +13,7 @@
 */
 #include "scene_opengl.h"
 #include "openglsurfacetexture.h"
+#include "textureuploader.h"
 
 #include "platform.h"
 #include "wayland_server.h"
@@ -36,11 +37,13 @@
 
 #include <cmath>
 #include <cstddef>
+#include <optional>
 
 #include <QGraphicsScale>
 #include <QMatrix4x4>
 #include <QPainter>
 #include <QStringList>
+#include <QTimer>
 #include <QVector2D>
 #include <QVector4D>
 #include <QtMath>
@@ -68,6 +71,22 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
         glGenVertexArrays(1, &vao);
         glBindVertexArray(vao);
     }
+
+    // Link the shaders used by the scene and most effects ahead of time, one per event loop
+    // iteration, so the first frame that needs them doesn't stall. With the shader cache
+    // this is mostly loading program binaries from disk.
+    bool ok;
+    const int warmUp = qEnvironmentVariableIntValue("KWIN_GL_SHADER_WARMUP", &ok);
+    if (!ok || warmUp) {
+        m_shaderWarmUpQueue = {
+            ShaderTrait::MapTexture,
+            ShaderTrait::MapTexture | ShaderTrait::Modulate,
+            ShaderTrait::MapTexture | ShaderTrait::AdjustSaturation,
+            ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+            ShaderTrait::UniformColor,
+        };
+        QTimer::singleShot(0, this, &SceneOpenGL::warmUpShaders);
+    }
 }
 
 SceneOpenGL::~SceneOpenGL()
@@ -77,6 +96,18 @@ SceneOpenGL::~SceneOpenGL()
     }
 }
 
+void SceneOpenGL::warmUpShaders()
+{
+    if (m_shaderWarmUpQueue.isEmpty() || !makeOpenGLContextCurrent()) {
+        return;
+    }
+    ShaderManager::instance()->shader(m_shaderWarmUpQueue.takeFirst());
+    doneOpenGLContextCurrent();
+    if (!m_shaderWarmUpQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &SceneOpenGL::warmUpShaders);
+    }
+}
+
 SceneOpenGL *SceneOpenGL::createScene(OpenGLBackend *backend, QObject *parent)
 {
     if (SceneOpenGL::supported(backend)) {
@@ -94,9 +125,16 @@ bool SceneOpenGL::initFailed() const
 void SceneOpenGL::paint(RenderTarget *renderTarget, const QRegion &region)
 {
     Q_UNUSED(renderTarget)
+    TextureUploader *textureUploader = m_backend->textureUploader();
+    if (textureUploader) {
+        textureUploader->beginFrame();
+    }
     GLVertexBuffer::streamingBuffer()->beginFrame();
     paintScreen(region);
     GLVertexBuffer::streamingBuffer()->endOfFrame();
+    if (textureUploader) {
+        painted_screen->renderLoop()->addTextureUploadSize(textureUploader->endFrame());
+    }
 }
 
 QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) const
@@ -195,6 +233,31 @@ bool SceneOpenGL::supportsNativeFence() const
     return m_backend->supportsNativeFence();
 }
 
+#ifndef EGL_ANDROID_native_fence_sync
+#define EGL_SYNC_NATIVE_FENCE_ANDROID 0x3144
+#define EGL_NO_NATIVE_FENCE_FD_ANDROID -1
+#endif // EGL_ANDROID_native_fence_sync
+
+FileDescriptor SceneOpenGL::createReleaseFence()
+{
+    if (!m_backend->supportsNativeFence()) {
+        return FileDescriptor();
+    }
+
+    const EGLDisplay display = kwinApp()->platform()->sceneEglDisplay();
+    const EGLSyncKHR sync = eglCreateSyncKHR(display, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+    if (sync == EGL_NO_SYNC_KHR) {
+        return FileDescriptor();
+    }
+
+    // The native fence will get a valid sync file fd only after a flush.
+    glFlush();
+    FileDescriptor fence(eglDupNativeFenceFDANDROID(display, sync));
+    eglDestroySyncKHR(display, sync);
+
+    return fence;
+}
+
 Shadow *SceneOpenGL::createShadow(Window *window)
 {
     return new SceneOpenGLShadow(window);
@@ -317,8 +380,10 @@ static GLTexture *bindSurfaceTexture(SurfaceItem *surfaceItem)
     if (platformSurfaceTexture->texture()) {
         const QRegion region = surfaceItem->damage();
         if (!region.isEmpty()) {
-            platformSurfaceTexture->update(region);
+            // The damage is reset first because the texture may postpone the update and
+            // re-add the damage to the surface item.
             surfaceItem->resetDamage();
+            platformSurfaceTexture->update(region);
         }
     } else {
         if (!surfacePixmap->isValid()) {
@@ -391,6 +456,7 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
         if (!quads.isEmpty()) {
             SceneOpenGLShadow *shadow = static_cast<SceneOpenGLShadow *>(shadowItem->shadow());
             context->renderNodes.append(RenderNode{
+                .item = item,
                 .texture = shadow->shadowTexture(),
                 .quads = quads,
                 .transformMatrix = context->transformStack.top(),
@@ -404,6 +470,7 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
         if (!quads.isEmpty()) {
             auto renderer = static_cast<const SceneOpenGLDecorationRenderer *>(decorationItem->renderer());
             context->renderNodes.append(RenderNode{
+                .item = item,
                 .texture = renderer->texture(),
                 .quads = quads,
                 .transformMatrix = context->transformStack.top(),
@@ -420,6 +487,7 @@ void SceneOpenGL::createRenderNode(Item *item, RenderContext *context)
                 // Don't bother with blending if the entire surface is opaque
                 bool hasAlpha = pixmap->hasAlphaChannel() && !surfaceItem->shape().subtracted(surfaceItem->opaque()).isEmpty();
                 context->renderNodes.append(RenderNode{
+                    .item = item,
                     .texture = bindSurfaceTexture(surfaceItem),
                     .quads = quads,
                     .transformMatrix = context->transformStack.top(),
@@ -495,6 +563,45 @@ static QMatrix4x4 transformForPaintData(int mask, const WindowPaintData &data)
     return matrix;
 }
 
+static bool isTranslation(const QMatrix4x4 &matrix)
+{
+    QMatrix4x4 translation;
+    translation.translate(matrix(0, 3), matrix(1, 3));
+    return matrix == translation;
+}
+
+static void emitVertices(const QVector<GLVertex2D> &quadVertices, GLenum primitiveType, const QVector2D &translation, GLVertex2D *vertex)
+{
+    const GLVertex2D *v = quadVertices.constData();
+    const int quadCount = quadVertices.count() / 4;
+
+    if (primitiveType == GL_QUADS) {
+        for (int i = 0; i < quadCount * 4; ++i) {
+            vertex[i].position = v[i].position + translation;
+            vertex[i].texcoord = v[i].texcoord;
+        }
+        return;
+    }
+
+    // Each quad is split in two triangles, see WindowQuadList::makeInterleavedArrays()
+    static const int order[6] = {1, 0, 3, 3, 2, 1};
+    for (int i = 0; i < quadCount; ++i, v += 4) {
+        for (int j = 0; j < 6; ++j) {
+            vertex->position = v[order[j]].position + translation;
+            vertex->texcoord = v[order[j]].texcoord;
+            ++vertex;
+        }
+    }
+}
+
+static bool canBatch(const SceneOpenGL::RenderNode &a, const SceneOpenGL::RenderNode &b)
+{
+    return a.texture == b.texture
+        && a.opacity == b.opacity
+        && a.hasAlpha == b.hasAlpha
+        && a.transformMatrix == b.transformMatrix;
+}
+
 void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const WindowPaintData &data)
 {
     if (region.isEmpty()) {
@@ -506,6 +613,10 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
         .hardwareClipping = region != infiniteRegion() && ((mask & Scene::PAINT_WINDOW_TRANSFORMED) || (mask & Scene::PAINT_SCREEN_TRANSFORMED)),
     };
 
+    // Reuse the storage of the render node list from the previous call.
+    renderContext.renderNodes.swap(m_renderNodes);
+    renderContext.renderNodes.clear();
+
     renderContext.transformStack.push(QMatrix4x4());
     renderContext.opacityStack.push(data.opacity());
 
@@ -518,6 +629,7 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
         quadCount += node.quads.count();
     }
     if (!quadCount) {
+        m_renderNodes.swap(renderContext.renderNodes);
         return;
     }
 
@@ -526,6 +638,10 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     const int verticesPerQuad = indexedQuads ? 4 : 6;
     const size_t size = verticesPerQuad * quadCount * sizeof(GLVertex2D);
 
+    // If the quads are not clipped in software, they are the same as in the previous frame
+    // and the cached vertices of the items can be used.
+    const bool softwareClipping = renderContext.clip != infiniteRegion() && !renderContext.hardwareClipping;
+
     ShaderTraits shaderTraits = ShaderTrait::MapTexture;
 
     if (data.brightness() != 1.0 || data.crossFadeProgress() != 1.0) {
@@ -561,8 +677,16 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
 
         const QMatrix4x4 matrix = renderNode.texture->matrix(renderNode.coordinateType);
 
-        renderNode.quads.makeInterleavedArrays(primitiveType, &map[v], matrix);
-        v += renderNode.quads.count() * verticesPerQuad;
+        if (!softwareClipping && isTranslation(renderNode.transformMatrix)) {
+            // Bake the translation into the vertices so consecutive nodes share the same
+            // model-view-projection matrix and can be drawn with fewer state changes.
+            const QVector2D translation(renderNode.transformMatrix(0, 3), renderNode.transformMatrix(1, 3));
+            emitVertices(renderNode.item->quadVertices(matrix), primitiveType, translation, &map[v]);
+            renderNode.transformMatrix = QMatrix4x4();
+        } else {
+            renderNode.quads.makeInterleavedArrays(primitiveType, &map[v], matrix);
+        }
+        v += renderNode.vertexCount;
     }
 
     vbo->unmap();
@@ -582,6 +706,8 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     float opacity = -1.0;
+    std::optional<QMatrix4x4> transformMatrix;
+    GLTexture *texture = nullptr;
 
     // The scissor region must be in the render target local coordinate system.
     QRegion scissorRegion = infiniteRegion();
@@ -590,28 +716,48 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     }
 
     const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
-    for (int i = 0; i < renderContext.renderNodes.count(); i++) {
-        const RenderNode &renderNode = renderContext.renderNodes[i];
+    for (int i = 0; i < renderContext.renderNodes.count();) {
+        const RenderNode &renderNode = renderContext.renderNodes[i++];
         if (renderNode.vertexCount == 0) {
             continue;
         }
 
+        // The vertices of consecutive nodes are adjacent in the vertex buffer, so the nodes
+        // that share the same state can be drawn at once.
+        int vertexCount = renderNode.vertexCount;
+        for (; i < renderContext.renderNodes.count(); ++i) {
+            const RenderNode &nextNode = renderContext.renderNodes[i];
+            if (nextNode.vertexCount == 0) {
+                continue;
+            }
+            if (!canBatch(renderNode, nextNode)) {
+                break;
+            }
+            vertexCount += nextNode.vertexCount;
+        }
+
         setBlendEnabled(renderNode.hasAlpha || renderNode.opacity < 1.0);
 
-        shader->setUniform(GLShader::ModelViewProjectionMatrix,
-                           modelViewProjection * renderNode.transformMatrix);
+        if (transformMatrix != renderNode.transformMatrix) {
+            shader->setUniform(GLShader::ModelViewProjectionMatrix,
+                               modelViewProjection * renderNode.transformMatrix);
+            transformMatrix = renderNode.transformMatrix;
+        }
         if (opacity != renderNode.opacity) {
             shader->setUniform(GLShader::ModulationConstant,
                                modulate(renderNode.opacity, data.brightness()));
             opacity = renderNode.opacity;
         }
 
-        renderNode.texture->setFilter(GL_LINEAR);
-        renderNode.texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        renderNode.texture->bind();
+        if (texture != renderNode.texture) {
+            renderNode.texture->setFilter(GL_LINEAR);
+            renderNode.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+            renderNode.texture->bind();
+            texture = renderNode.texture;
+        }
 
         vbo->draw(scissorRegion, primitiveType, renderNode.firstVertex,
-                  renderNode.vertexCount, renderContext.hardwareClipping);
+                  vertexCount, renderContext.hardwareClipping);
     }
 
     vbo->unbindArrays();
@@ -625,6 +771,8 @@ void SceneOpenGL::render(Item *item, int mask, const QRegion &region, const Wind
     if (renderContext.hardwareClipping) {
         glDisable(GL_SCISSOR_TEST);
     }
+
+    m_renderNodes.swap(renderContext.renderNodes);
 }
 
 //****************************************
@@ -30,6 +30,7 @@ class KWIN_EXPORT SceneOpenGL
 public:
     struct RenderNode
     {
+        const Item *item = nullptr;
         GLTexture *texture = nullptr;
         WindowQuadList quads;
         QMatrix4x4 transformMatrix;
@@ -57,6 +58,7 @@ public:
     bool makeOpenGLContextCurrent() override;
     void doneOpenGLContextCurrent() override;
     bool supportsNativeFence() const override;
+    FileDescriptor createReleaseFence() override;
     DecorationRenderer *createDecorationRenderer(Decoration::DecoratedClientImpl *impl) override;
     bool animationsSupported() const override;
     SurfaceTexture *createSurfaceTextureInternal(SurfacePixmapInternal *pixmap) override;
@@ -94,12 +96,15 @@ private:
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void createRenderNode(Item *item, RenderContext *context);
+    void warmUpShaders();
 
     bool init_ok = true;
     OpenGLBackend *m_backend;
     QMatrix4x4 m_screenProjectionMatrix;
     GLuint vao = 0;
     bool m_blendingEnabled = false;
+    QVector<RenderNode> m_renderNodes;
+    QVector<ShaderTraits> m_shaderWarmUpQueue;
 };
 
 /**
@@ -0,0 +1,280 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "qpainterrasterizer.h"
+
+#include <QPainter>
+
+#include <atomic>
+#include <cstring>
+
+namespace KWin
+{
+
+static const int s_tileSize = 128;
+
+static bool isIntegral(const QRectF &rect)
+{
+    return QRectF(rect.toRect()) == rect;
+}
+
+static bool isOpaqueCopySupported(QImage::Format destination, QImage::Format source)
+{
+    if (destination != QImage::Format_RGB32 && destination != QImage::Format_ARGB32_Premultiplied) {
+        return false;
+    }
+    // Premultiplied and straight alpha are the same where the image is opaque.
+    return source == QImage::Format_RGB32
+        || source == QImage::Format_ARGB32
+        || source == QImage::Format_ARGB32_Premultiplied;
+}
+
+QPainterRasterizer::QPainterRasterizer(int threadCount)
+    : m_threadCount(std::max(1, threadCount))
+{
+    // The calling thread rasterizes tiles too.
+    m_threadPool.setMaxThreadCount(std::max(1, m_threadCount - 1));
+}
+
+QPainterRasterizer::~QPainterRasterizer()
+{
+    m_threadPool.waitForDone();
+}
+
+int QPainterRasterizer::threadCount() const
+{
+    return m_threadCount;
+}
+
+void QPainterRasterizer::begin(QImage *buffer)
+{
+    Q_ASSERT(!m_buffer);
+    m_buffer = buffer;
+}
+
+void QPainterRasterizer::end()
+{
+    flush();
+    m_buffer = nullptr;
+}
+
+bool QPainterRasterizer::isActive() const
+{
+    return m_buffer;
+}
+
+void QPainterRasterizer::drawImage(const QTransform &transform, const QRegion &clip, qreal opacity,
+                                   const QRectF &target, const QImage &image, const QRectF &source,
+                                   const QRegion &opaque)
+{
+    if (image.isNull() || opacity <= 0) {
+        return;
+    }
+    Command command;
+    command.transform = transform;
+    command.clip = clip;
+    command.opacity = opacity;
+    command.target = target;
+    command.image = image;
+    command.source = source;
+    command.opaque = opaque;
+    record(std::move(command));
+}
+
+void QPainterRasterizer::fillRect(const QTransform &transform, const QRegion &clip, const QRectF &rect, const QColor &color)
+{
+    if (color.alpha() == 0) {
+        return;
+    }
+    Command command;
+    command.transform = transform;
+    command.clip = clip;
+    command.target = rect;
+    command.color = color;
+    record(std::move(command));
+}
+
+void QPainterRasterizer::record(Command &&command)
+{
+    command.bounds = command.transform.mapRect(command.target).toAlignedRect()
+        & command.clip.boundingRect()
+        & m_buffer->rect();
+    if (command.bounds.isEmpty()) {
+        return;
+    }
+    m_commands.append(std::move(command));
+}
+
+void QPainterRasterizer::flush()
+{
+    if (m_commands.isEmpty()) {
+        return;
+    }
+
+    QRegion dirty;
+    for (const Command &command : qAsConst(m_commands)) {
+        dirty += command.bounds;
+    }
+
+    // Every tile gets the list of the draw commands that touch it, in painting order.
+    const QRect dirtyRect = dirty.boundingRect();
+    for (int y = dirtyRect.y() - dirtyRect.y() % s_tileSize; y <= dirtyRect.bottom(); y += s_tileSize) {
+        for (int x = dirtyRect.x() - dirtyRect.x() % s_tileSize; x <= dirtyRect.right(); x += s_tileSize) {
+            const QRect rect = QRect(x, y, s_tileSize, s_tileSize) & m_buffer->rect();
+            if (!dirty.intersects(rect)) {
+                continue;
+            }
+            Tile tile;
+            tile.rect = rect;
+            for (int i = 0; i < m_commands.count(); ++i) {
+                if (m_commands[i].bounds.intersects(rect)) {
+                    tile.commands.append(i);
+                }
+            }
+            m_tiles.append(tile);
+        }
+    }
+
+    // The buffer must not be detached by the worker threads.
+    m_bits = m_buffer->bits();
+
+    std::atomic<int> nextTile{0};
+    auto rasterize = [this, &nextTile]() {
+        for (int i = nextTile++; i < m_tiles.count(); i = nextTile++) {
+            renderTile(m_tiles[i]);
+        }
+    };
+
+    const int workerCount = std::min(m_threadCount, int(m_tiles.count())) - 1;
+    for (int i = 0; i < workerCount; ++i) {
+        m_threadPool.start(rasterize);
+    }
+    rasterize();
+    m_threadPool.waitForDone();
+
+    m_tiles.clear();
+    m_commands.clear();
+}
+
+void QPainterRasterizer::renderTile(const Tile &tile)
+{
+    const int bytesPerLine = m_buffer->bytesPerLine();
+    uchar *tileBits = m_bits + tile.rect.y() * bytesPerLine + tile.rect.x() * (m_buffer->depth() / 8);
+
+    // The tile shares the memory with the buffer, so tiles can be painted independently.
+    QImage tileImage(tileBits, tile.rect.width(), tile.rect.height(), bytesPerLine, m_buffer->format());
+    QPainter painter;
+
+    for (int index : tile.commands) {
+        const Command &command = m_commands[index];
+        QRegion clip = command.clip & tile.rect;
+        if (clip.isEmpty()) {
+            continue;
+        }
+
+        if (command.image.isNull()) {
+            if (fillColor(command, tile.rect, tileBits, clip)) {
+                continue;
+            }
+        } else if (copyImage(command, tile.rect, tileBits, &clip) && clip.isEmpty()) {
+            continue;
+        }
+
+        if (!painter.isActive()) {
+            painter.begin(&tileImage);
+        }
+        // The clip is set in tile coordinates before the transform of the command is applied.
+        painter.resetTransform();
+        painter.setClipRegion(clip.translated(-tile.rect.topLeft()));
+        painter.setTransform(command.transform * QTransform::fromTranslate(-tile.rect.x(), -tile.rect.y()));
+        painter.setOpacity(command.opacity);
+        if (command.image.isNull()) {
+            painter.fillRect(command.target, command.color);
+        } else {
+            painter.drawImage(command.target, command.image, command.source);
+        }
+    }
+
+    if (painter.isActive()) {
+        painter.end();
+    }
+}
+
+bool QPainterRasterizer::copyImage(const Command &command, const QRect &tileRect, uchar *tileBits, QRegion *clip) const
+{
+    if (command.opacity < 1 || command.transform.type() > QTransform::TxTranslate) {
+        return false;
+    }
+    if (!isOpaqueCopySupported(m_buffer->format(), command.image.format())) {
+        return false;
+    }
+    if (command.source.size() != command.target.size() || !isIntegral(command.source) || !isIntegral(command.target)) {
+        return false;
+    }
+    const QPointF translation(command.transform.dx(), command.transform.dy());
+    if (translation != QPointF(translation.toPoint())) {
+        return false;
+    }
+
+    const QPoint targetOffset = translation.toPoint();
+    const QRect target = command.target.toRect().translated(targetOffset);
+    const QPoint sourceOffset = command.source.toRect().topLeft() - target.topLeft();
+
+    QRegion opaque;
+    if (command.image.format() == QImage::Format_RGB32) {
+        opaque = target;
+    } else {
+        opaque = command.opaque.translated(targetOffset) & target;
+    }
+    opaque &= command.image.rect().translated(-sourceOffset);
+
+    const QRegion copied = *clip & opaque;
+    if (copied.isEmpty()) {
+        return false;
+    }
+
+    const int bytesPerLine = m_buffer->bytesPerLine();
+    for (const QRect &rect : copied) {
+        const int rowSize = rect.width() * 4;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const uchar *source = command.image.constScanLine(y + sourceOffset.y()) + (rect.x() + sourceOffset.x()) * 4;
+            uchar *destination = tileBits + (y - tileRect.y()) * bytesPerLine + (rect.x() - tileRect.x()) * 4;
+            std::memcpy(destination, source, rowSize);
+        }
+    }
+
+    *clip -= copied;
+    return true;
+}
+
+bool QPainterRasterizer::fillColor(const Command &command, const QRect &tileRect, uchar *tileBits, const QRegion &clip) const
+{
+    if (command.color.alpha() != 255 || command.transform.type() > QTransform::TxTranslate) {
+        return false;
+    }
+    const QImage::Format format = m_buffer->format();
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32 && format != QImage::Format_ARGB32_Premultiplied) {
+        return false;
+    }
+    const QRectF mappedTarget = command.transform.mapRect(command.target);
+    if (!isIntegral(mappedTarget)) {
+        return false;
+    }
+
+    // An opaque color has the same representation in all of the supported formats.
+    const quint32 pixel = command.color.rgb();
+    const int bytesPerLine = m_buffer->bytesPerLine();
+    const QRegion filled = clip & mappedTarget.toRect();
+    for (const QRect &rect : filled) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            quint32 *destination = reinterpret_cast<quint32 *>(tileBits + (y - tileRect.y()) * bytesPerLine) + (rect.x() - tileRect.x());
+            std::fill_n(destination, rect.width(), pixel);
+        }
+    }
+    return true;
+}
+
+} // namespace KWin
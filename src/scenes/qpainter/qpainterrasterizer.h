@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QColor>
+#include <QImage>
+#include <QRegion>
+#include <QThreadPool>
+#include <QTransform>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The QPainterRasterizer class rasterizes the scene on several threads.
+ *
+ * The draw commands are recorded while the scene is being painted, they are rasterized when
+ * flush() is called. The damaged part of the buffer is split in tiles, every tile gets the list
+ * of the draw commands that touch it and the tiles are rasterized in parallel.
+ *
+ * Opaque images that are neither scaled nor blended are copied row by row, and opaque fills
+ * are written directly to the buffer, other draw commands are rasterized using QPainter.
+ */
+class KWIN_EXPORT QPainterRasterizer
+{
+public:
+    explicit QPainterRasterizer(int threadCount);
+    ~QPainterRasterizer();
+
+    /**
+     * Returns the number of threads that rasterize the tiles, including the calling thread.
+     */
+    int threadCount() const;
+
+    /**
+     * Starts recording draw commands for the @a buffer.
+     */
+    void begin(QImage *buffer);
+
+    /**
+     * Rasterizes the recorded draw commands and stops recording.
+     */
+    void end();
+
+    /**
+     * Returns @c true if the draw commands are being recorded.
+     */
+    bool isActive() const;
+
+    /**
+     * Records a draw command that draws the @a source rectangle of the @a image into the
+     * @a target rectangle. The @a transform maps the target rectangle to the buffer, and the
+     * @a clip is specified in buffer coordinates. The @a opaque region is specified in target
+     * coordinates and indicates that the image has no transparent pixels there.
+     */
+    void drawImage(const QTransform &transform, const QRegion &clip, qreal opacity,
+                   const QRectF &target, const QImage &image, const QRectF &source,
+                   const QRegion &opaque = QRegion());
+
+    /**
+     * Records a draw command that fills the @a rect with the specified @a color.
+     */
+    void fillRect(const QTransform &transform, const QRegion &clip, const QRectF &rect, const QColor &color);
+
+    /**
+     * Rasterizes the draw commands that have been recorded so far. This must be called before
+     * something else paints into the buffer.
+     */
+    void flush();
+
+private:
+    struct Command
+    {
+        QTransform transform;
+        QRegion clip;
+        QRect bounds;
+        qreal opacity = 1;
+        QRectF target;
+        QImage image;
+        QRectF source;
+        QRegion opaque;
+        QColor color;
+    };
+
+    struct Tile
+    {
+        QRect rect;
+        QVector<int> commands;
+    };
+
+    void record(Command &&command);
+    void renderTile(const Tile &tile);
+    bool copyImage(const Command &command, const QRect &tileRect, uchar *tileBits, QRegion *clip) const;
+    bool fillColor(const Command &command, const QRect &tileRect, uchar *tileBits, const QRegion &clip) const;
+
+    QImage *m_buffer = nullptr;
+    uchar *m_bits = nullptr;
+    QVector<Command> m_commands;
+    QVector<Tile> m_tiles;
+    QThreadPool m_threadPool;
+    int m_threadCount;
+};
+
+} // namespace KWin
@@ -7,7 +7,9 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "scene_qpainter.h"
+#include "qpainterrasterizer.h"
 #include "qpaintersurfacetexture.h"
+#include "qpaintersurfacetexture_wayland.h"
 // KWin
 #include "composite.h"
 #include "cursor.h"
@@ -28,6 +30,7 @@
 #include <KDecoration2/Decoration>
 #include <QDebug>
 #include <QPainter>
+#include <QThread>
 
 #include <cmath>
 
@@ -47,6 +50,15 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+    // The tiles are rasterized on all cores unless specified otherwise.
+    bool ok = false;
+    int threadCount = qEnvironmentVariableIntValue("KWIN_QPAINTER_THREADS", &ok);
+    if (!ok) {
+        threadCount = QThread::idealThreadCount();
+    }
+    if (threadCount > 1) {
+        m_rasterizer.reset(new QPainterRasterizer(threadCount));
+    }
 }
 
 SceneQPainter::~SceneQPainter()
@@ -58,6 +70,16 @@ bool SceneQPainter::initFailed() const
     return false;
 }
 
+QPainter *SceneQPainter::scenePainter() const
+{
+    // Whoever asks for the painter is going to paint with it, so the recorded draw commands
+    // must be rasterized first.
+    if (m_rasterizer && m_rasterizer->isActive()) {
+        m_rasterizer->flush();
+    }
+    return m_painter.data();
+}
+
 void SceneQPainter::paintGenericScreen(int mask, const ScreenPaintData &data)
 {
     m_painter->save();
@@ -73,13 +95,26 @@ void SceneQPainter::paint(RenderTarget *target, const QRegion &region)
     if (buffer && !buffer->isNull()) {
         m_painter->begin(buffer);
         m_painter->setWindow(painted_screen->geometry());
+        if (m_rasterizer) {
+            m_rasterizer->begin(buffer);
+        }
         paintScreen(region);
+        if (m_rasterizer) {
+            m_rasterizer->end();
+        }
         m_painter->end();
     }
 }
 
 void SceneQPainter::paintBackground(const QRegion &region)
 {
+    if (m_rasterizer && m_rasterizer->isActive()) {
+        const QTransform transform = m_painter->combinedTransform();
+        for (const QRect &rect : region) {
+            m_rasterizer->fillRect(transform, transform.mapRect(QRectF(rect)).toAlignedRect(), rect, Qt::black);
+        }
+        return;
+    }
     for (const QRect &rect : region) {
         m_painter->fillRect(rect, Qt::black);
     }
@@ -116,11 +151,12 @@ void SceneQPainter::render(Item *item, int mask, const QRegion &_region, const W
         return;
     }
 
-    QPainter *painter = scenePainter();
+    QPainter *painter = m_painter.data();
     painter->save();
     painter->setClipRegion(region);
     painter->setClipping(true);
     painter->setOpacity(data.opacity());
+    m_deviceClip = painter->combinedTransform().map(region);
 
     if (mask & Scene::PAINT_WINDOW_TRANSFORMED) {
         painter->translate(data.xTranslation(), data.yTranslation());
@@ -179,19 +215,21 @@ void SceneQPainter::renderSurfaceItem(QPainter *painter, SurfaceItem *surfaceIte
         static_cast<QPainterSurfaceTexture *>(surfaceTexture->texture());
     if (!platformSurfaceTexture->isValid()) {
         platformSurfaceTexture->create();
-    } else {
+    } else if (!surfaceItem->damage().isEmpty()) {
         platformSurfaceTexture->update(surfaceItem->damage());
     }
     surfaceItem->resetDamage();
 
+    // The image may reference the client's buffer, it must not outlive this function.
+    const QImage image = platformSurfaceTexture->image();
+    const QRegion opaque = surfaceItem->opaque();
     const QRegion shape = surfaceItem->shape();
+    const QMatrix4x4 matrix = surfaceItem->surfaceToBufferMatrix();
     for (const QRectF rect : shape) {
-        const QMatrix4x4 matrix = surfaceItem->surfaceToBufferMatrix();
         const QPointF bufferTopLeft = matrix.map(rect.topLeft());
         const QPointF bufferBottomRight = matrix.map(rect.bottomRight());
 
-        painter->drawImage(rect, platformSurfaceTexture->image(),
-                           QRectF(bufferTopLeft, bufferBottomRight));
+        drawImage(painter, rect, image, QRectF(bufferTopLeft, bufferBottomRight), opaque);
     }
 }
 
@@ -201,10 +239,23 @@ void SceneQPainter::renderDecorationItem(QPainter *painter, DecorationItem *deco
     QRect dtr, dlr, drr, dbr;
     decorationItem->window()->layoutDecorationRects(dlr, dtr, drr, dbr);
 
-    painter->drawImage(dtr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top));
-    painter->drawImage(dlr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left));
-    painter->drawImage(drr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right));
-    painter->drawImage(dbr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom));
+    const QImage top = renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top);
+    const QImage left = renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left);
+    const QImage right = renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right);
+    const QImage bottom = renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom);
+    drawImage(painter, dtr, top, top.rect());
+    drawImage(painter, dlr, left, left.rect());
+    drawImage(painter, drr, right, right.rect());
+    drawImage(painter, dbr, bottom, bottom.rect());
+}
+
+void SceneQPainter::drawImage(QPainter *painter, const QRectF &target, const QImage &image, const QRectF &source, const QRegion &opaque) const
+{
+    if (m_rasterizer && m_rasterizer->isActive()) {
+        m_rasterizer->drawImage(painter->combinedTransform(), m_deviceClip, painter->opacity(), target, image, source, opaque);
+    } else {
+        painter->drawImage(target, image, source);
+    }
 }
 
 DecorationRenderer *SceneQPainter::createDecorationRenderer(Decoration::DecoratedClientImpl *impl)
@@ -219,7 +270,12 @@ SurfaceTexture *SceneQPainter::createSurfaceTextureInternal(SurfacePixmapInterna
 
 SurfaceTexture *SceneQPainter::createSurfaceTextureWayland(SurfacePixmapWayland *pixmap)
 {
-    return m_backend->createSurfaceTextureWayland(pixmap);
+    auto texture = static_cast<QPainterSurfaceTextureWayland *>(m_backend->createSurfaceTextureWayland(pixmap));
+    // The rasterizer's worker threads can't be protected against the client truncating its
+    // shm pool, so they only get to see copies of the client buffers. Without them, the
+    // buffers are painted on this thread while they are being accessed.
+    texture->setDirectSampling(!m_rasterizer);
+    return texture;
 }
 
 //****************************************
@@ -18,6 +18,8 @@
 namespace KWin
 {
 
+class QPainterRasterizer;
+
 class KWIN_EXPORT SceneQPainter : public Scene
 {
     Q_OBJECT
@@ -57,9 +59,12 @@ private:
     void renderSurfaceItem(QPainter *painter, SurfaceItem *surfaceItem) const;
     void renderDecorationItem(QPainter *painter, DecorationItem *decorationItem) const;
     void renderItem(QPainter *painter, Item *item) const;
+    void drawImage(QPainter *painter, const QRectF &target, const QImage &image, const QRectF &source, const QRegion &opaque = QRegion()) const;
 
     QPainterBackend *m_backend;
     QScopedPointer<QPainter> m_painter;
+    QScopedPointer<QPainterRasterizer> m_rasterizer;
+    QRegion m_deviceClip;
 };
 
 class SceneQPainterShadow : public Shadow
@@ -94,11 +99,6 @@ private:
     QImage m_images[int(DecorationPart::Count)];
 };
 
-inline QPainter *SceneQPainter::scenePainter() const
-{
-    return m_painter.data();
-}
-
 } // KWin
 
 #endif // KWIN_SCENEQPAINTER_H
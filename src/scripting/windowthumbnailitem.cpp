@@ -10,16 +10,14 @@
 #include "composite.h"
 #include "effects.h"
 #include "renderbackend.h"
-#include "scene.h"
 #include "screens.h"
 #include "scripting_logging.h"
 #include "virtualdesktops.h"
 #include "window.h"
-#include "windowitem.h"
+#include "windowthumbnailcache.h"
 #include "workspace.h"
 
 #include <kwingltexture.h>
-#include <kwinglutils.h>
 
 #include <QQuickWindow>
 #include <QRunnable>
@@ -69,6 +67,8 @@ void ThumbnailTextureProvider::setTexture(const QSharedPointer<GLTexture> &nativ
                                                                        QQuickWindow::TextureHasAlphaChannel));
 #endif
         m_texture->setFiltering(QSGTexture::Linear);
+        // Thumbnails are mipmapped so they can be scaled down without aliasing.
+        m_texture->setMipmapFiltering(QSGTexture::Linear);
         m_texture->setHorizontalWrapMode(QSGTexture::ClampToEdge);
         m_texture->setVerticalWrapMode(QSGTexture::ClampToEdge);
     }
@@ -105,14 +105,13 @@ WindowThumbnailItem::WindowThumbnailItem(QQuickItem *parent)
     : QQuickItem(parent)
 {
     setFlag(ItemHasContents);
-    updateFrameRenderingConnection();
 
     connect(Compositor::self(), &Compositor::aboutToToggleCompositing,
             this, &WindowThumbnailItem::destroyOffscreenTexture);
     connect(Compositor::self(), &Compositor::compositingToggled,
-            this, &WindowThumbnailItem::updateFrameRenderingConnection);
+            this, &WindowThumbnailItem::updateOffscreenTexture);
     connect(this, &QQuickItem::windowChanged,
-            this, &WindowThumbnailItem::updateFrameRenderingConnection);
+            this, &WindowThumbnailItem::updateOffscreenTexture);
 }
 
 WindowThumbnailItem::~WindowThumbnailItem()
@@ -154,22 +153,6 @@ QSGTextureProvider *WindowThumbnailItem::textureProvider() const
     return m_provider;
 }
 
-void WindowThumbnailItem::updateFrameRenderingConnection()
-{
-    disconnect(m_frameRenderingConnection);
-
-    if (!Compositor::compositing()) {
-        return;
-    }
-    if (!window()) {
-        return;
-    }
-
-    if (Compositor::self()->backend()->compositingType() == OpenGLCompositing) {
-        m_frameRenderingConnection = connect(Compositor::self()->scene(), &Scene::preFrameRender, this, &WindowThumbnailItem::updateOffscreenTexture);
-    }
-}
-
 QSize WindowThumbnailItem::sourceSize() const
 {
     return m_sourceSize;
@@ -186,46 +169,27 @@ void WindowThumbnailItem::setSourceSize(const QSize &sourceSize)
 
 void WindowThumbnailItem::destroyOffscreenTexture()
 {
-    if (!Compositor::compositing()) {
-        return;
-    }
-    if (Compositor::self()->backend()->compositingType() != OpenGLCompositing) {
-        return;
-    }
-
-    if (m_offscreenTexture) {
-        Scene *scene = Compositor::self()->scene();
-        scene->makeOpenGLContextCurrent();
-        m_offscreenTarget.reset();
-        m_offscreenTexture.reset();
-
-        if (m_acquireFence) {
-            glDeleteSync(m_acquireFence);
-            m_acquireFence = 0;
-        }
-        scene->doneOpenGLContextCurrent();
-    }
+    m_thumbnail.reset();
 }
 
 QSGNode *WindowThumbnailItem::updatePaintNode(QSGNode *oldNode, QQuickItem::UpdatePaintNodeData *)
 {
-    if (Compositor::compositing() && !m_offscreenTexture) {
+    const QSharedPointer<GLTexture> offscreenTexture = m_thumbnail ? m_thumbnail->texture() : nullptr;
+    if (Compositor::compositing() && !offscreenTexture) {
         return oldNode;
     }
 
     // Wait for rendering commands to the offscreen texture complete if there are any.
-    if (m_acquireFence) {
-        glClientWaitSync(m_acquireFence, GL_SYNC_FLUSH_COMMANDS_BIT, 5000);
-        glDeleteSync(m_acquireFence);
-        m_acquireFence = 0;
+    if (m_thumbnail) {
+        m_thumbnail->waitForRendering();
     }
 
     if (!m_provider) {
         m_provider = new ThumbnailTextureProvider(window());
     }
 
-    if (m_offscreenTexture) {
-        m_provider->setTexture(m_offscreenTexture);
+    if (offscreenTexture) {
+        m_provider->setTexture(offscreenTexture);
     } else {
         const QImage placeholderImage = fallbackImage();
         m_provider->setTexture(window()->createTextureFromImage(placeholderImage));
@@ -239,7 +203,7 @@ QSGNode *WindowThumbnailItem::updatePaintNode(QSGNode *oldNode, QQuickItem::Upda
     }
     node->setTexture(m_provider->texture());
 
-    if (m_offscreenTexture && m_offscreenTexture->isYInverted()) {
+    if (offscreenTexture && offscreenTexture->isYInverted()) {
         node->setTextureCoordinatesTransform(QSGImageNode::MirrorVertically);
     } else {
         node->setTextureCoordinatesTransform(QSGImageNode::NoTransform);
@@ -317,8 +281,6 @@ void WindowThumbnailItem::setClient(Window *client)
     if (m_client) {
         disconnect(m_client, &Window::frameGeometryChanged,
                    this, &WindowThumbnailItem::invalidateOffscreenTexture);
-        disconnect(m_client, &Window::damaged,
-                   this, &WindowThumbnailItem::invalidateOffscreenTexture);
         disconnect(m_client, &Window::frameGeometryChanged,
                    this, &WindowThumbnailItem::updateImplicitSize);
     }
@@ -326,8 +288,6 @@ void WindowThumbnailItem::setClient(Window *client)
     if (m_client) {
         connect(m_client, &Window::frameGeometryChanged,
                 this, &WindowThumbnailItem::invalidateOffscreenTexture);
-        connect(m_client, &Window::damaged,
-                this, &WindowThumbnailItem::invalidateOffscreenTexture);
         connect(m_client, &Window::frameGeometryChanged,
                 this, &WindowThumbnailItem::updateImplicitSize);
         setWId(m_client->internalId());
@@ -369,7 +329,7 @@ QRectF WindowThumbnailItem::paintedRect() const
     if (!m_client) {
         return QRectF();
     }
-    if (!m_offscreenTexture) {
+    if (!m_thumbnail || !m_thumbnail->texture()) {
         const QSizeF iconSize = m_client->icon().actualSize(window(), boundingRect().size().toSize());
         return centeredSize(boundingRect(), iconSize);
     }
@@ -394,19 +354,19 @@ QRectF WindowThumbnailItem::paintedRect() const
 
 void WindowThumbnailItem::invalidateOffscreenTexture()
 {
-    m_dirty = true;
+    updateOffscreenTexture();
     update();
 }
 
 void WindowThumbnailItem::updateOffscreenTexture()
 {
-    if (m_acquireFence || !m_dirty || !m_client) {
+    if (!m_client || !window() || !Compositor::compositing()
+        || Compositor::self()->backend()->compositingType() != OpenGLCompositing) {
+        destroyOffscreenTexture();
         return;
     }
-    Q_ASSERT(window());
 
-    const QRect geometry = m_client->visibleGeometry();
-    QSize textureSize = geometry.size();
+    QSize textureSize = m_client->visibleGeometry().size();
     if (sourceSize().width() > 0) {
         textureSize.setWidth(sourceSize().width());
     }
@@ -417,38 +377,16 @@ void WindowThumbnailItem::updateOffscreenTexture()
     m_devicePixelRatio = window()->devicePixelRatio();
     textureSize *= m_devicePixelRatio;
 
-    if (!m_offscreenTexture || m_offscreenTexture->size() != textureSize) {
-        m_offscreenTexture.reset(new GLTexture(GL_RGBA8, textureSize));
-        m_offscreenTexture->setFilter(GL_LINEAR);
-        m_offscreenTexture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_offscreenTarget.reset(new GLFramebuffer(m_offscreenTexture.data()));
+    // The thumbnail is shared with other items showing the same window at a similar size,
+    // and it is re-rendered by the cache when the window is damaged.
+    const QSharedPointer<WindowThumbnail> thumbnail = WindowThumbnailCache::self()->thumbnail(m_client, textureSize, m_devicePixelRatio);
+    if (m_thumbnail != thumbnail) {
+        if (m_thumbnail) {
+            disconnect(m_thumbnail.data(), &WindowThumbnail::updated, this, &WindowThumbnailItem::update);
+        }
+        m_thumbnail = thumbnail;
+        connect(m_thumbnail.data(), &WindowThumbnail::updated, this, &WindowThumbnailItem::update);
     }
-
-    GLFramebuffer::pushFramebuffer(m_offscreenTarget.data());
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    QMatrix4x4 projectionMatrix;
-    projectionMatrix.ortho(geometry.x(), geometry.x() + geometry.width(),
-                           geometry.y(), geometry.y() + geometry.height(), -1, 1);
-
-    WindowPaintData data;
-    data.setProjectionMatrix(projectionMatrix);
-
-    // The thumbnail must be rendered using kwin's opengl context as VAOs are not
-    // shared across contexts. Unfortunately, this also introduces a latency of 1
-    // frame, which is not ideal, but it is acceptable for things such as thumbnails.
-    const int mask = Scene::PAINT_WINDOW_TRANSFORMED;
-    Compositor::self()->scene()->render(m_client->windowItem(), mask, infiniteRegion(), data);
-    GLFramebuffer::popFramebuffer();
-
-    // The fence is needed to avoid the case where qtquick renderer starts using
-    // the texture while all rendering commands to it haven't completed yet.
-    m_dirty = false;
-    m_acquireFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-
-    // We know that the texture has changed, so schedule an item update.
-    update();
 }
 
 } // namespace KWin
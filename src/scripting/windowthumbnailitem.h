@@ -10,13 +10,10 @@
 #include <QQuickItem>
 #include <QUuid>
 
-#include <epoxy/gl.h>
-
 namespace KWin
 {
 class Window;
-class GLFramebuffer;
-class GLTexture;
+class WindowThumbnail;
 class ThumbnailTextureProvider;
 
 class WindowThumbnailItem : public QQuickItem
@@ -86,20 +83,14 @@ private:
     void updateOffscreenTexture();
     void destroyOffscreenTexture();
     void updateImplicitSize();
-    void updateFrameRenderingConnection();
 
     QSize m_sourceSize;
     QUuid m_wId;
     QPointer<Window> m_client;
-    bool m_dirty = false;
 
     mutable ThumbnailTextureProvider *m_provider = nullptr;
-    QSharedPointer<GLTexture> m_offscreenTexture;
-    QScopedPointer<GLFramebuffer> m_offscreenTarget;
-    GLsync m_acquireFence = 0;
+    QSharedPointer<WindowThumbnail> m_thumbnail;
     qreal m_devicePixelRatio = 1;
-
-    QMetaObject::Connection m_frameRenderingConnection;
 };
 
 } // namespace KWin
@@ -72,6 +72,11 @@ SurfacePixmap *SurfaceItem::previousPixmap() const
     return m_previousPixmap.data();
 }
 
+bool SurfaceItem::allowsTearing() const
+{
+    return false;
+}
+
 void SurfaceItem::referencePreviousPixmap()
 {
     if (m_previousPixmap && m_previousPixmap->isDiscarded()) {
@@ -41,6 +41,12 @@ public:
     void referencePreviousPixmap();
     void unreferencePreviousPixmap();
 
+    /**
+     * Returns @c true if the contents of the surface may be presented without waiting
+     * for the next vblank; otherwise returns @c false.
+     */
+    virtual bool allowsTearing() const;
+
 protected:
     explicit SurfaceItem(Window *window, Item *parent = nullptr);
 
@@ -71,6 +71,11 @@ KWaylandServer::SurfaceInterface *SurfaceItemWayland::surface() const
     return m_surface;
 }
 
+bool SurfaceItemWayland::allowsTearing() const
+{
+    return m_surface && m_surface->presentationHint() == KWaylandServer::PresentationHint::Async;
+}
+
 void SurfaceItemWayland::handleSurfaceToBufferMatrixChanged()
 {
     setSurfaceToBufferMatrix(m_surface->surfaceToBufferMatrix());
@@ -34,6 +34,8 @@ public:
 
     KWaylandServer::SurfaceInterface *surface() const;
 
+    bool allowsTearing() const override;
+
 private Q_SLOTS:
     void handleSurfaceToBufferMatrixChanged();
     void handleSurfaceCommitted();
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "kwin_export.h"
+#include "utils/rectregion.h"
 
 #include <QList>
 #include <QRegion>
@@ -16,6 +17,8 @@ namespace KWin
 
 /**
  * The DamageJournal class is a helper that tracks last N damage regions.
+ *
+ * The regions are stored as RectRegion objects so accumulating them is cheap.
  */
 class KWIN_EXPORT DamageJournal
 {
@@ -45,7 +48,7 @@ public:
         while (m_log.size() >= m_capacity) {
             m_log.takeLast();
         }
-        m_log.prepend(region);
+        m_log.prepend(RectRegion(region));
     }
 
     /**
@@ -65,24 +68,23 @@ public:
      */
     QRegion accumulate(int bufferAge, const QRegion &fallback = QRegion()) const
     {
-        QRegion region;
         if (bufferAge > 0 && bufferAge <= m_log.size()) {
+            RectRegion region;
             for (int i = 0; i < bufferAge - 1; ++i) {
                 region |= m_log[i];
             }
-        } else {
-            region = fallback;
+            return region.toQRegion();
         }
-        return region;
+        return fallback;
     }
 
     QRegion lastDamage() const
     {
-        return m_log.first();
+        return m_log.first().toQRegion();
     }
 
 private:
-    QList<QRegion> m_log;
+    QList<RectRegion> m_log;
     int m_capacity = 10;
 };
 
@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "filedescriptor.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <utility>
+
+namespace KWin
+{
+
+FileDescriptor::FileDescriptor(int fd)
+    : m_fd(fd)
+{
+}
+
+FileDescriptor::FileDescriptor(FileDescriptor &&other)
+    : m_fd(std::exchange(other.m_fd, -1))
+{
+}
+
+FileDescriptor &FileDescriptor::operator=(FileDescriptor &&other)
+{
+    if (this != &other) {
+        if (m_fd != -1) {
+            ::close(m_fd);
+        }
+        m_fd = std::exchange(other.m_fd, -1);
+    }
+    return *this;
+}
+
+FileDescriptor::~FileDescriptor()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+}
+
+bool FileDescriptor::isValid() const
+{
+    return m_fd != -1;
+}
+
+int FileDescriptor::get() const
+{
+    return m_fd;
+}
+
+int FileDescriptor::take()
+{
+    return std::exchange(m_fd, -1);
+}
+
+FileDescriptor FileDescriptor::duplicate() const
+{
+    if (m_fd != -1) {
+        return FileDescriptor(fcntl(m_fd, F_DUPFD_CLOEXEC, 0));
+    } else {
+        return {};
+    }
+}
+
+bool FileDescriptor::isReadable() const
+{
+    pollfd fd;
+    fd.fd = m_fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    return poll(&fd, 1, 0) == 1 && (fd.revents & POLLIN);
+}
+
+} // namespace KWin
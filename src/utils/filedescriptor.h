@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+namespace KWin
+{
+
+/**
+ * The FileDescriptor class owns a file descriptor and closes it when it goes out of scope.
+ */
+class KWIN_EXPORT FileDescriptor
+{
+public:
+    FileDescriptor() = default;
+    explicit FileDescriptor(int fd);
+    FileDescriptor(FileDescriptor &&other);
+    FileDescriptor &operator=(FileDescriptor &&other);
+    ~FileDescriptor();
+
+    bool isValid() const;
+    int get() const;
+    int take();
+
+    /**
+     * Returns a new FileDescriptor that refers to the same open file description.
+     */
+    FileDescriptor duplicate() const;
+
+    /**
+     * Returns @c true if the file descriptor is readable, without blocking. For sync files,
+     * this means that the corresponding fence has been signaled.
+     */
+    bool isReadable() const;
+
+private:
+    int m_fd = -1;
+};
+
+} // namespace KWin
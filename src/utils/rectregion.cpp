@@ -0,0 +1,558 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "rectregion.h"
+
+#include <algorithm>
+#include <climits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace KWin
+{
+
+/**
+ * A horizontal span [x1, x2) of a band.
+ */
+struct RectRegionSpan
+{
+    int x1;
+    int x2;
+};
+
+using SpanList = QVarLengthArray<RectRegionSpan, 16>;
+
+/**
+ * The RectRegionBuilder class assembles a region band by band, from top to bottom, and merges
+ * vertically adjacent bands that consist of the same spans.
+ */
+class RectRegionBuilder
+{
+public:
+    explicit RectRegionBuilder(RectRegion *region)
+        : m_region(region)
+    {
+        m_region->m_rects.clear();
+    }
+
+    void appendBand(int y1, int y2, const SpanList &spans)
+    {
+        if (spans.isEmpty() || y1 >= y2) {
+            return;
+        }
+
+        QVarLengthArray<QRect, 8> &rects = m_region->m_rects;
+        if (m_lastBand != -1 && rects[m_lastBand].bottom() + 1 == y1 && rects.size() - m_lastBand == spans.size()) {
+            bool same = true;
+            for (int i = 0; i < spans.size(); ++i) {
+                const QRect &rect = rects[m_lastBand + i];
+                if (rect.left() != spans[i].x1 || rect.right() + 1 != spans[i].x2) {
+                    same = false;
+                    break;
+                }
+            }
+            if (same) {
+                for (int i = m_lastBand; i < rects.size(); ++i) {
+                    rects[i].setBottom(y2 - 1);
+                }
+                return;
+            }
+        }
+
+        m_lastBand = rects.size();
+        for (const RectRegionSpan &span : spans) {
+            rects.append(QRect(QPoint(span.x1, y1), QPoint(span.x2 - 1, y2 - 1)));
+        }
+    }
+
+    void finish()
+    {
+        const QVarLengthArray<QRect, 8> &rects = m_region->m_rects;
+        if (rects.isEmpty()) {
+            m_region->m_boundingRect = QRect();
+            return;
+        }
+
+        int left = rects.first().left();
+        int right = rects.first().right();
+        for (const QRect &rect : rects) {
+            left = std::min(left, rect.left());
+            right = std::max(right, rect.right());
+        }
+        m_region->m_boundingRect = QRect(QPoint(left, rects.first().top()), QPoint(right, rects.last().bottom()));
+    }
+
+private:
+    RectRegion *m_region;
+    int m_lastBand = -1;
+};
+
+/**
+ * The BandCursor class walks over the bands of a region.
+ */
+class BandCursor
+{
+public:
+    explicit BandCursor(const RectRegion &region)
+        : m_rects(region.begin())
+        , m_count(region.rectCount())
+    {
+        m_end = bandEnd();
+    }
+
+    bool atEnd() const
+    {
+        return m_start >= m_count;
+    }
+
+    int top() const
+    {
+        return m_rects[m_start].top();
+    }
+
+    int bottom() const
+    {
+        return m_rects[m_start].bottom() + 1;
+    }
+
+    void spans(SpanList *spans) const
+    {
+        for (int i = m_start; i < m_end; ++i) {
+            spans->append(RectRegionSpan{m_rects[i].left(), m_rects[i].right() + 1});
+        }
+    }
+
+    void next()
+    {
+        m_start = m_end;
+        m_end = bandEnd();
+    }
+
+private:
+    int bandEnd() const
+    {
+        int end = m_start;
+        while (end < m_count && m_rects[end].top() == m_rects[m_start].top()) {
+            ++end;
+        }
+        return end;
+    }
+
+    const QRect *m_rects;
+    int m_count;
+    int m_start = 0;
+    int m_end = 0;
+};
+
+enum class RegionOp {
+    Union,
+    Intersect,
+    Subtract,
+};
+
+static void uniteSpans(const SpanList &a, const SpanList &b, SpanList *result)
+{
+    int i = 0;
+    int j = 0;
+    while (i < a.size() || j < b.size()) {
+        RectRegionSpan span;
+        if (j == b.size() || (i < a.size() && a[i].x1 < b[j].x1)) {
+            span = a[i++];
+        } else {
+            span = b[j++];
+        }
+        if (!result->isEmpty() && span.x1 <= result->last().x2) {
+            result->last().x2 = std::max(result->last().x2, span.x2);
+        } else {
+            result->append(span);
+        }
+    }
+}
+
+static void intersectSpans(const SpanList &a, const SpanList &b, SpanList *result)
+{
+    int i = 0;
+    int j = 0;
+    while (i < a.size() && j < b.size()) {
+        const int x1 = std::max(a[i].x1, b[j].x1);
+        const int x2 = std::min(a[i].x2, b[j].x2);
+        if (x1 < x2) {
+            result->append(RectRegionSpan{x1, x2});
+        }
+        if (a[i].x2 < b[j].x2) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+}
+
+static void subtractSpans(const SpanList &a, const SpanList &b, SpanList *result)
+{
+    int j = 0;
+    for (const RectRegionSpan &span : a) {
+        int x = span.x1;
+        while (j < b.size() && b[j].x2 <= x) {
+            ++j;
+        }
+        for (int k = j; k < b.size() && b[k].x1 < span.x2; ++k) {
+            if (b[k].x1 > x) {
+                result->append(RectRegionSpan{x, b[k].x1});
+            }
+            x = std::max(x, b[k].x2);
+            if (x >= span.x2) {
+                break;
+            }
+        }
+        if (x < span.x2) {
+            result->append(RectRegionSpan{x, span.x2});
+        }
+    }
+}
+
+static RectRegion combine(const RectRegion &a, const RectRegion &b, RegionOp op)
+{
+    RectRegion result;
+    RectRegionBuilder builder(&result);
+
+    BandCursor bandA(a);
+    BandCursor bandB(b);
+
+    SpanList spansA;
+    SpanList spansB;
+    SpanList spans;
+
+    int y = INT_MIN;
+    while (!bandA.atEnd() || !bandB.atEnd()) {
+        if (op == RegionOp::Intersect && (bandA.atEnd() || bandB.atEnd())) {
+            break;
+        }
+        if (op == RegionOp::Subtract && bandA.atEnd()) {
+            break;
+        }
+
+        const int topA = bandA.atEnd() ? INT_MAX : bandA.top();
+        const int topB = bandB.atEnd() ? INT_MAX : bandB.top();
+        y = std::max(y, std::min(topA, topB));
+
+        const bool inA = topA <= y;
+        const bool inB = topB <= y;
+
+        int nextY = INT_MAX;
+        if (!bandA.atEnd()) {
+            nextY = std::min(nextY, inA ? bandA.bottom() : topA);
+        }
+        if (!bandB.atEnd()) {
+            nextY = std::min(nextY, inB ? bandB.bottom() : topB);
+        }
+
+        spansA.clear();
+        spansB.clear();
+        spans.clear();
+        if (inA) {
+            bandA.spans(&spansA);
+        }
+        if (inB) {
+            bandB.spans(&spansB);
+        }
+
+        switch (op) {
+        case RegionOp::Union:
+            uniteSpans(spansA, spansB, &spans);
+            break;
+        case RegionOp::Intersect:
+            intersectSpans(spansA, spansB, &spans);
+            break;
+        case RegionOp::Subtract:
+            subtractSpans(spansA, spansB, &spans);
+            break;
+        }
+        builder.appendBand(y, nextY, spans);
+
+        if (inA && nextY == bandA.bottom()) {
+            bandA.next();
+        }
+        if (inB && nextY == bandB.bottom()) {
+            bandB.next();
+        }
+        y = nextY;
+    }
+
+    builder.finish();
+    return result;
+}
+
+#if defined(__SSE2__)
+static inline __m128i max_epi32(__m128i a, __m128i b)
+{
+    const __m128i mask = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i min_epi32(__m128i a, __m128i b)
+{
+    const __m128i mask = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+/**
+ * Clips the given @a rects against the @a clip rectangle. The rectangles that remain
+ * are appended to @a result in the same order.
+ */
+static void clipRects(const QRect *rects, int count, const QRect &clip, QVarLengthArray<QRect, 8> *result)
+{
+#if defined(__SSE2__)
+    // The rectangles are processed as (left, top, right, bottom) vectors, so a clip takes
+    // a single max and a single min operation.
+    const __m128i lower = _mm_setr_epi32(clip.left(), clip.top(), INT_MIN, INT_MIN);
+    const __m128i upper = _mm_setr_epi32(INT_MAX, INT_MAX, clip.right(), clip.bottom());
+    for (int i = 0; i < count; ++i) {
+        const QRect &rect = rects[i];
+        __m128i box = _mm_setr_epi32(rect.left(), rect.top(), rect.right(), rect.bottom());
+        box = min_epi32(max_epi32(box, lower), upper);
+
+        alignas(16) int clipped[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(clipped), box);
+        if (clipped[0] <= clipped[2] && clipped[1] <= clipped[3]) {
+            result->append(QRect(QPoint(clipped[0], clipped[1]), QPoint(clipped[2], clipped[3])));
+        }
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        const QRect clipped = rects[i] & clip;
+        if (!clipped.isEmpty()) {
+            result->append(clipped);
+        }
+    }
+#endif
+}
+
+RectRegion::RectRegion(const QRect &rect)
+{
+    if (!rect.isEmpty()) {
+        m_rects.append(rect);
+        m_boundingRect = rect;
+    }
+}
+
+RectRegion::RectRegion(int x, int y, int width, int height)
+    : RectRegion(QRect(x, y, width, height))
+{
+}
+
+RectRegion::RectRegion(const QRegion &region)
+{
+    RectRegionBuilder builder(this);
+    SpanList spans;
+
+    // The rectangles of a QRegion are banded already, but bands may not be merged.
+    const QRect *rect = region.begin();
+    const QRect *end = region.end();
+    while (rect != end) {
+        const int top = rect->top();
+        const int bottom = rect->bottom() + 1;
+        spans.clear();
+        for (; rect != end && rect->top() == top; ++rect) {
+            spans.append(RectRegionSpan{rect->left(), rect->right() + 1});
+        }
+        builder.appendBand(top, bottom, spans);
+    }
+
+    builder.finish();
+}
+
+bool RectRegion::isEmpty() const
+{
+    return m_rects.isEmpty();
+}
+
+QRect RectRegion::boundingRect() const
+{
+    return m_boundingRect;
+}
+
+int RectRegion::rectCount() const
+{
+    return m_rects.size();
+}
+
+const QRect *RectRegion::begin() const
+{
+    return m_rects.constData();
+}
+
+const QRect *RectRegion::end() const
+{
+    return m_rects.constData() + m_rects.size();
+}
+
+bool RectRegion::intersects(const QRect &rect) const
+{
+    if (!m_boundingRect.intersects(rect)) {
+        return false;
+    }
+    for (const QRect &r : m_rects) {
+        if (r.top() > rect.bottom()) {
+            break;
+        }
+        if (r.intersects(rect)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RectRegion RectRegion::translated(const QPoint &offset) const
+{
+    return translated(offset.x(), offset.y());
+}
+
+RectRegion RectRegion::translated(int dx, int dy) const
+{
+    RectRegion result(*this);
+    for (QRect &rect : result.m_rects) {
+        rect.translate(dx, dy);
+    }
+    result.m_boundingRect.translate(dx, dy);
+    return result;
+}
+
+RectRegion RectRegion::united(const RectRegion &other) const
+{
+    if (isEmpty()) {
+        return other;
+    }
+    if (other.isEmpty()) {
+        return *this;
+    }
+    if (rectCount() == 1 && m_boundingRect.contains(other.m_boundingRect)) {
+        return *this;
+    }
+    if (other.rectCount() == 1 && other.m_boundingRect.contains(m_boundingRect)) {
+        return other;
+    }
+    return combine(*this, other, RegionOp::Union);
+}
+
+RectRegion RectRegion::intersected(const RectRegion &other) const
+{
+    if (!m_boundingRect.intersects(other.m_boundingRect)) {
+        return RectRegion();
+    }
+    if (other.rectCount() == 1) {
+        return intersected(other.m_boundingRect);
+    }
+    if (rectCount() == 1) {
+        return other.intersected(m_boundingRect);
+    }
+    return combine(*this, other, RegionOp::Intersect);
+}
+
+RectRegion RectRegion::intersected(const QRect &rect) const
+{
+    if (!m_boundingRect.intersects(rect)) {
+        return RectRegion();
+    }
+    if (rect.contains(m_boundingRect)) {
+        return *this;
+    }
+
+    QVarLengthArray<QRect, 8> clipped;
+    clipRects(m_rects.constData(), m_rects.size(), rect, &clipped);
+
+    // Clipping keeps the bands intact, but some of them may have to be merged now.
+    RectRegion result;
+    RectRegionBuilder builder(&result);
+    SpanList spans;
+    for (int i = 0; i < clipped.size();) {
+        const int top = clipped[i].top();
+        const int bottom = clipped[i].bottom() + 1;
+        spans.clear();
+        for (; i < clipped.size() && clipped[i].top() == top; ++i) {
+            spans.append(RectRegionSpan{clipped[i].left(), clipped[i].right() + 1});
+        }
+        builder.appendBand(top, bottom, spans);
+    }
+    builder.finish();
+    return result;
+}
+
+RectRegion RectRegion::subtracted(const RectRegion &other) const
+{
+    if (!m_boundingRect.intersects(other.m_boundingRect)) {
+        return *this;
+    }
+    if (other.rectCount() == 1 && other.m_boundingRect.contains(m_boundingRect)) {
+        return RectRegion();
+    }
+    return combine(*this, other, RegionOp::Subtract);
+}
+
+RectRegion RectRegion::operator|(const RectRegion &other) const
+{
+    return united(other);
+}
+
+RectRegion RectRegion::operator&(const RectRegion &other) const
+{
+    return intersected(other);
+}
+
+RectRegion RectRegion::operator&(const QRect &rect) const
+{
+    return intersected(rect);
+}
+
+RectRegion RectRegion::operator-(const RectRegion &other) const
+{
+    return subtracted(other);
+}
+
+RectRegion &RectRegion::operator|=(const RectRegion &other)
+{
+    *this = united(other);
+    return *this;
+}
+
+RectRegion &RectRegion::operator&=(const RectRegion &other)
+{
+    *this = intersected(other);
+    return *this;
+}
+
+RectRegion &RectRegion::operator&=(const QRect &rect)
+{
+    *this = intersected(rect);
+    return *this;
+}
+
+RectRegion &RectRegion::operator-=(const RectRegion &other)
+{
+    *this = subtracted(other);
+    return *this;
+}
+
+bool RectRegion::operator==(const RectRegion &other) const
+{
+    return m_rects.size() == other.m_rects.size() && std::equal(m_rects.begin(), m_rects.end(), other.m_rects.begin());
+}
+
+bool RectRegion::operator!=(const RectRegion &other) const
+{
+    return !(*this == other);
+}
+
+QRegion RectRegion::toQRegion() const
+{
+    QRegion region;
+    region.setRects(m_rects.constData(), m_rects.size());
+    return region;
+}
+
+} // namespace KWin
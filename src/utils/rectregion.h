@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QRect>
+#include <QRegion>
+#include <QVarLengthArray>
+
+namespace KWin
+{
+
+/**
+ * The RectRegion class is a lightweight replacement for QRegion in the paint path.
+ *
+ * The region is stored as a list of rectangles in the same banded form that QRegion uses:
+ * the rectangles are sorted by their top and then by their left edges, rectangles with the
+ * same top edge have the same height and neither overlap nor touch horizontally, and vertically
+ * adjacent bands with the same rectangles are merged. Regions with a few rectangles don't
+ * allocate memory, which makes RectRegion well suited for the temporary regions that are
+ * computed every frame. Use toQRegion() to pass the region to APIs that expect a QRegion.
+ */
+class KWIN_EXPORT RectRegion
+{
+public:
+    RectRegion() = default;
+    RectRegion(const QRect &rect);
+    RectRegion(int x, int y, int width, int height);
+    explicit RectRegion(const QRegion &region);
+
+    bool isEmpty() const;
+    QRect boundingRect() const;
+    int rectCount() const;
+
+    const QRect *begin() const;
+    const QRect *end() const;
+
+    /**
+     * Returns @c true if the region overlaps the given @a rect; otherwise returns @c false.
+     */
+    bool intersects(const QRect &rect) const;
+
+    RectRegion translated(const QPoint &offset) const;
+    RectRegion translated(int dx, int dy) const;
+
+    RectRegion united(const RectRegion &other) const;
+    RectRegion intersected(const RectRegion &other) const;
+    RectRegion intersected(const QRect &rect) const;
+    RectRegion subtracted(const RectRegion &other) const;
+
+    RectRegion operator|(const RectRegion &other) const;
+    RectRegion operator&(const RectRegion &other) const;
+    RectRegion operator&(const QRect &rect) const;
+    RectRegion operator-(const RectRegion &other) const;
+
+    RectRegion &operator|=(const RectRegion &other);
+    RectRegion &operator&=(const RectRegion &other);
+    RectRegion &operator&=(const QRect &rect);
+    RectRegion &operator-=(const RectRegion &other);
+
+    bool operator==(const RectRegion &other) const;
+    bool operator!=(const RectRegion &other) const;
+
+    QRegion toQRegion() const;
+
+private:
+    friend class RectRegionBuilder;
+
+    QVarLengthArray<QRect, 8> m_rects;
+    QRect m_boundingRect;
+};
+
+} // namespace KWin
@@ -44,6 +44,7 @@ private Q_SLOTS:
     void testFrameCallback();
     void testAttachBuffer();
     void testMultipleSurfaces();
+    void testShmBufferAccess();
     void testOpaque();
     void testInput();
     void testScale();
@@ -602,6 +603,65 @@ void TestWaylandSurface::testMultipleSurfaces()
     QCOMPARE(buffer1Data, black);
 }
 
+void TestWaylandSurface::testShmBufferAccess()
+{
+    // this test verifies that the data of a shm buffer references the client's memory without
+    // copying it, and that it can only be accessed while no other buffer is being accessed
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage black(24, 24, QImage::Format_RGB32);
+    black.fill(Qt::black);
+    QSharedPointer<Buffer> blackBuffer = m_shm->createBuffer(black).toStrongRef();
+    QVERIFY(blackBuffer);
+
+    QSignalSpy damageSpy(serverSurface, &KWaylandServer::SurfaceInterface::damaged);
+    QVERIFY(damageSpy.isValid());
+    s->attachBuffer(blackBuffer);
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+
+    auto buffer = qobject_cast<ShmClientBuffer *>(serverSurface->buffer());
+    QVERIFY(buffer);
+    QImage data = buffer->data();
+    QCOMPARE(data, black);
+    const QImage deepCopy = data.copy();
+
+    // the data refers to the client's memory, changes made by the client are visible
+    QImage white(24, 24, QImage::Format_RGB32);
+    white.fill(Qt::white);
+    QImage clientImage(static_cast<uchar *>(blackBuffer->address()), 24, 24, blackBuffer->stride(), QImage::Format_RGB32);
+    clientImage.fill(Qt::white);
+    QCOMPARE(data, white);
+    QCOMPARE(deepCopy, black);
+
+    // only one buffer can be accessed at a time
+    QSharedPointer<Buffer> otherBuffer = m_shm->createBuffer(black).toStrongRef();
+    QScopedPointer<Surface> s2(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface2 = serverSurfaceCreated.last().first().value<KWaylandServer::SurfaceInterface *>();
+    QSignalSpy damageSpy2(serverSurface2, &KWaylandServer::SurfaceInterface::damaged);
+    QVERIFY(damageSpy2.isValid());
+    s2->attachBuffer(otherBuffer);
+    s2->damage(QRect(0, 0, 24, 24));
+    s2->commit(Surface::CommitFlag::None);
+    QVERIFY(damageSpy2.wait());
+    auto buffer2 = qobject_cast<ShmClientBuffer *>(serverSurface2->buffer());
+    QVERIFY(buffer2);
+    QVERIFY(buffer2->data().isNull());
+
+    // once the access has ended, the other buffer can be accessed
+    data = QImage();
+    QCOMPARE(buffer2->data(), black);
+}
+
 void TestWaylandSurface::testOpaque()
 {
     using namespace KWayland::Client;
@@ -0,0 +1,566 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "utils/filedescriptor.h"
+#include "wayland/compositor_interface.h"
+#include "wayland/display.h"
+#include "wayland/drm_fourcc.h"
+#include "wayland/linuxdmabufv1clientbuffer.h"
+#include "wayland/linuxexplicitsynchronization_v1_interface.h"
+#include "wayland/subcompositor_interface.h"
+#include "wayland/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/subcompositor.h"
+#include "KWayland/Client/subsurface.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+#include "qwayland-linux-explicit-synchronization-unstable-v1.h"
+
+#include <cerrno> // For EPROTO
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class LinuxDmaBuf : public QtWayland::zwp_linux_dmabuf_v1
+{
+};
+
+class ExplicitSynchronization : public QtWayland::zwp_linux_explicit_synchronization_v1
+{
+};
+
+class SurfaceSynchronization : public QtWayland::zwp_linux_surface_synchronization_v1
+{
+};
+
+class BufferRelease : public QObject, public QtWayland::zwp_linux_buffer_release_v1
+{
+    Q_OBJECT
+
+public:
+    explicit BufferRelease(struct ::zwp_linux_buffer_release_v1 *object)
+        : QtWayland::zwp_linux_buffer_release_v1(object)
+    {
+    }
+
+    ~BufferRelease() override
+    {
+        wl_proxy_destroy(reinterpret_cast<wl_proxy *>(object()));
+    }
+
+Q_SIGNALS:
+    void fencedRelease(int fence);
+    void immediateRelease();
+
+protected:
+    void zwp_linux_buffer_release_v1_fenced_release(int32_t fence) override
+    {
+        Q_EMIT fencedRelease(fence);
+    }
+
+    void zwp_linux_buffer_release_v1_immediate_release() override
+    {
+        Q_EMIT immediateRelease();
+    }
+};
+
+class TestRendererInterface : public LinuxDmaBufV1ClientBufferIntegration::RendererInterface
+{
+public:
+    LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        return new LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+    }
+};
+
+/**
+ * A pipe whose read end is used as a fence. The fence is signaled once a byte is written
+ * to the pipe, which is how the surface sees a sync file that has become readable.
+ */
+class TestFence
+{
+public:
+    TestFence()
+    {
+        int fds[2];
+        if (pipe(fds) == 0) {
+            m_readEnd = KWin::FileDescriptor(fds[0]);
+            m_writeEnd = KWin::FileDescriptor(fds[1]);
+        }
+    }
+
+    int fd() const
+    {
+        return m_readEnd.get();
+    }
+
+    void signal()
+    {
+        const char byte = 0;
+        QCOMPARE(write(m_writeEnd.get(), &byte, 1), 1);
+    }
+
+private:
+    KWin::FileDescriptor m_readEnd;
+    KWin::FileDescriptor m_writeEnd;
+};
+
+class TestLinuxExplicitSynchronizationV1Interface : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testAcquireFence();
+    void testAcquireFenceOrdering();
+    void testSynchronizedSubSurface();
+    void testFencedRelease();
+    void testImmediateRelease();
+    void testNoBuffer();
+    void testDuplicateFence();
+    void testDuplicateSynchronization();
+    void testDestroyedSurface();
+
+private:
+    wl_buffer *createBuffer(const QSize &size);
+    SurfaceInterface *createSurface(QScopedPointer<KWayland::Client::Surface> &clientSurface);
+
+    KWaylandServer::Display *m_display = nullptr;
+    CompositorInterface *m_serverCompositor = nullptr;
+    TestRendererInterface m_rendererInterface;
+
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    QThread *m_thread = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_clientCompositor = nullptr;
+    KWayland::Client::SubCompositor *m_clientSubCompositor = nullptr;
+    LinuxDmaBuf *m_dmabuf = nullptr;
+    ExplicitSynchronization *m_explicitSynchronization = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-explicit-synchronization-test-0");
+
+void TestLinuxExplicitSynchronizationV1Interface::init()
+{
+    m_display = new KWaylandServer::Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_serverCompositor = new CompositorInterface(m_display, m_display);
+    new SubCompositorInterface(m_display, m_display);
+    auto dmabuf = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+    dmabuf->setRendererInterface(&m_rendererInterface);
+    new LinuxExplicitSynchronizationV1Interface(m_display, m_display);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    connect(&registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, &registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            // Version 3 doesn't need the format table, the test renderer accepts any format.
+            m_dmabuf = new LinuxDmaBuf();
+            m_dmabuf->init(registry, id, std::min(version, 3u));
+        } else if (interface == QByteArrayLiteral("zwp_linux_explicit_synchronization_v1")) {
+            m_explicitSynchronization = new ExplicitSynchronization();
+            m_explicitSynchronization->init(registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_dmabuf);
+    QVERIFY(m_explicitSynchronization);
+
+    const auto compositorInterface = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_clientCompositor = registry.createCompositor(compositorInterface.name, compositorInterface.version, this);
+    QVERIFY(m_clientCompositor->isValid());
+    const auto subCompositorInterface = registry.interface(KWayland::Client::Registry::Interface::SubCompositor);
+    m_clientSubCompositor = registry.createSubCompositor(subCompositorInterface.name, subCompositorInterface.version, this);
+    QVERIFY(m_clientSubCompositor->isValid());
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::cleanup()
+{
+#define CLEANUP(variable)   \
+    if (variable) {         \
+        delete variable;    \
+        variable = nullptr; \
+    }
+    CLEANUP(m_explicitSynchronization)
+    CLEANUP(m_dmabuf)
+    CLEANUP(m_clientSubCompositor)
+    CLEANUP(m_clientCompositor)
+    CLEANUP(m_queue)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_display)
+#undef CLEANUP
+    // this is a child of the display
+    m_serverCompositor = nullptr;
+}
+
+wl_buffer *TestLinuxExplicitSynchronizationV1Interface::createBuffer(const QSize &size)
+{
+    const int stride = size.width() * 4;
+    const KWin::FileDescriptor memfd(memfd_create("kwin-test-buffer", MFD_CLOEXEC));
+    if (!memfd.isValid() || ftruncate(memfd.get(), stride * size.height()) != 0) {
+        return nullptr;
+    }
+
+    zwp_linux_buffer_params_v1 *params = m_dmabuf->create_params();
+    zwp_linux_buffer_params_v1_add(params, memfd.get(), 0, 0, stride, 0, 0);
+    wl_buffer *buffer = zwp_linux_buffer_params_v1_create_immed(params, size.width(), size.height(), DRM_FORMAT_ARGB8888, 0);
+    zwp_linux_buffer_params_v1_destroy(params);
+    return buffer;
+}
+
+SurfaceInterface *TestLinuxExplicitSynchronizationV1Interface::createSurface(QScopedPointer<KWayland::Client::Surface> &clientSurface)
+{
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    clientSurface.reset(m_clientCompositor->createSurface(this));
+    if (!serverSurfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testAcquireFence()
+{
+    // This test verifies that a content update is not applied until its acquire fence is signaled.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    TestFence fence;
+    wl_buffer *buffer = createBuffer(QSize(100, 50));
+    QVERIFY(buffer);
+    clientSurface->attachBuffer(buffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    synchronization->set_acquire_fence(fence.fd());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(!committedSpy.wait(100));
+    QVERIFY(!serverSurface->buffer());
+
+    fence.signal();
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->buffer());
+    QCOMPARE(serverSurface->buffer()->size(), QSize(100, 50));
+
+    clientSurface.reset();
+    wl_buffer_destroy(buffer);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testAcquireFenceOrdering()
+{
+    // This test verifies that content updates without an acquire fence are queued behind the
+    // content updates that still wait for their acquire fences.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    TestFence fence;
+    wl_buffer *buffer = createBuffer(QSize(100, 50));
+    QVERIFY(buffer);
+    clientSurface->attachBuffer(buffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    synchronization->set_acquire_fence(fence.fd());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    clientSurface->setScale(2);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(!committedSpy.wait(100));
+    QCOMPARE(serverSurface->bufferScale(), 1);
+
+    fence.signal();
+    QVERIFY(committedSpy.wait());
+    if (committedSpy.count() < 2) {
+        QVERIFY(committedSpy.wait());
+    }
+    QCOMPARE(committedSpy.count(), 2);
+    QVERIFY(serverSurface->buffer());
+    QCOMPARE(serverSurface->bufferScale(), 2);
+
+    clientSurface.reset();
+    wl_buffer_destroy(buffer);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testSynchronizedSubSurface()
+{
+    // This test verifies that the content update of a synchronized sub-surface that waits for
+    // its acquire fence is applied atomically with the content update of its parent.
+    QScopedPointer<KWayland::Client::Surface> parentClientSurface;
+    SurfaceInterface *parentServerSurface = createSurface(parentClientSurface);
+    QVERIFY(parentServerSurface);
+    QScopedPointer<KWayland::Client::Surface> childClientSurface;
+    SurfaceInterface *childServerSurface = createSurface(childClientSurface);
+    QVERIFY(childServerSurface);
+
+    QSignalSpy childSubSurfaceAddedSpy(parentServerSurface, &SurfaceInterface::childSubSurfaceAdded);
+    QScopedPointer<KWayland::Client::SubSurface> subSurface(m_clientSubCompositor->createSubSurface(QPointer<KWayland::Client::Surface>(childClientSurface.data()), QPointer<KWayland::Client::Surface>(parentClientSurface.data())));
+    QVERIFY(childSubSurfaceAddedSpy.wait());
+    QVERIFY(childServerSurface->subSurface()->isSynchronized());
+
+    QSignalSpy parentCommittedSpy(parentServerSurface, &SurfaceInterface::committed);
+    QSignalSpy childCommittedSpy(childServerSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*childClientSurface));
+
+    TestFence fence;
+    wl_buffer *childBuffer = createBuffer(QSize(50, 50));
+    QVERIFY(childBuffer);
+    childClientSurface->attachBuffer(childBuffer);
+    childClientSurface->damage(QRect(0, 0, 50, 50));
+    synchronization->set_acquire_fence(fence.fd());
+    childClientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    wl_buffer *parentBuffer = createBuffer(QSize(100, 100));
+    QVERIFY(parentBuffer);
+    parentClientSurface->attachBuffer(parentBuffer);
+    parentClientSurface->damage(QRect(0, 0, 100, 100));
+    parentClientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    // Neither the parent nor the child can be applied until the acquire fence of the child is signaled.
+    QVERIFY(!parentCommittedSpy.wait(100));
+    QVERIFY(childCommittedSpy.isEmpty());
+    QVERIFY(!parentServerSurface->buffer());
+    QVERIFY(!childServerSurface->buffer());
+
+    // The child commits again while the parent is waiting, this content update belongs to
+    // the next commit of the parent.
+    childClientSurface->setScale(2);
+    childClientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    fence.signal();
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(parentCommittedSpy.count(), 1);
+    QCOMPARE(childCommittedSpy.count(), 1);
+    QVERIFY(parentServerSurface->buffer());
+    QVERIFY(childServerSurface->buffer());
+    QCOMPARE(childServerSurface->bufferScale(), 1);
+
+    parentClientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(childCommittedSpy.count(), 2);
+    QCOMPARE(childServerSurface->bufferScale(), 2);
+
+    subSurface.reset();
+    childClientSurface.reset();
+    parentClientSurface.reset();
+    wl_buffer_destroy(childBuffer);
+    wl_buffer_destroy(parentBuffer);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testFencedRelease()
+{
+    // This test verifies that the client receives the release fence attached by the compositor
+    // once the buffer is no longer used.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    wl_buffer *firstBuffer = createBuffer(QSize(100, 50));
+    QVERIFY(firstBuffer);
+    QScopedPointer<BufferRelease> release(new BufferRelease(synchronization->get_release()));
+    QSignalSpy fencedReleaseSpy(release.data(), &BufferRelease::fencedRelease);
+    QSignalSpy immediateReleaseSpy(release.data(), &BufferRelease::immediateRelease);
+    clientSurface->attachBuffer(firstBuffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->wantsReleaseFence());
+
+    // The compositor has submitted a frame that reads the buffer.
+    TestFence fence;
+    serverSurface->setReleaseFence(KWin::FileDescriptor(dup(fence.fd())));
+
+    // The buffer is not released while it's still attached to the surface.
+    QVERIFY(!fencedReleaseSpy.wait(100));
+
+    wl_buffer *secondBuffer = createBuffer(QSize(100, 50));
+    QVERIFY(secondBuffer);
+    clientSurface->attachBuffer(secondBuffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(fencedReleaseSpy.wait());
+    QVERIFY(immediateReleaseSpy.isEmpty());
+    QVERIFY(!serverSurface->wantsReleaseFence());
+
+    // The received fence refers to the same pipe, so it is signaled along with the original.
+    const KWin::FileDescriptor receivedFence(fencedReleaseSpy.first().first().toInt());
+    QVERIFY(receivedFence.isValid());
+    QVERIFY(!receivedFence.isReadable());
+    fence.signal();
+    QVERIFY(receivedFence.isReadable());
+
+    clientSurface.reset();
+    wl_buffer_destroy(firstBuffer);
+    wl_buffer_destroy(secondBuffer);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testImmediateRelease()
+{
+    // This test verifies that a buffer without a release fence is released immediately.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    wl_buffer *firstBuffer = createBuffer(QSize(100, 50));
+    QVERIFY(firstBuffer);
+    QScopedPointer<BufferRelease> release(new BufferRelease(synchronization->get_release()));
+    QSignalSpy fencedReleaseSpy(release.data(), &BufferRelease::fencedRelease);
+    QSignalSpy immediateReleaseSpy(release.data(), &BufferRelease::immediateRelease);
+    clientSurface->attachBuffer(firstBuffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    wl_buffer *secondBuffer = createBuffer(QSize(100, 50));
+    QVERIFY(secondBuffer);
+    clientSurface->attachBuffer(secondBuffer);
+    clientSurface->damage(QRect(0, 0, 100, 50));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(immediateReleaseSpy.wait());
+    QVERIFY(fencedReleaseSpy.isEmpty());
+
+    clientSurface.reset();
+    wl_buffer_destroy(firstBuffer);
+    wl_buffer_destroy(secondBuffer);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testNoBuffer()
+{
+    // Committing an acquire fence without a buffer is a protocol error.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    QVERIFY(createSurface(clientSurface));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    TestFence fence;
+    synchronization->set_acquire_fence(fence.fd());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testDuplicateFence()
+{
+    // Setting the acquire fence twice for the same content update is a protocol error.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    QVERIFY(createSurface(clientSurface));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    TestFence fence;
+    synchronization->set_acquire_fence(fence.fd());
+    synchronization->set_acquire_fence(fence.fd());
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testDuplicateSynchronization()
+{
+    // Creating a second synchronization object for the same surface is a protocol error.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    QVERIFY(createSurface(clientSurface));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QScopedPointer<SurfaceSynchronization> first(new SurfaceSynchronization);
+    first->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+    QScopedPointer<SurfaceSynchronization> second(new SurfaceSynchronization);
+    second->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+}
+
+void TestLinuxExplicitSynchronizationV1Interface::testDestroyedSurface()
+{
+    // Using the synchronization object after its surface has been destroyed is a protocol error.
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+
+    QScopedPointer<SurfaceSynchronization> synchronization(new SurfaceSynchronization);
+    synchronization->init(m_explicitSynchronization->get_synchronization(*clientSurface));
+
+    QSignalSpy surfaceDestroyedSpy(serverSurface, &QObject::destroyed);
+    clientSurface.reset();
+    QVERIFY(surfaceDestroyedSpy.wait());
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    TestFence fence;
+    synchronization->set_acquire_fence(fence.fd());
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxExplicitSynchronizationV1Interface)
+
+#include "test_linuxexplicitsynchronization_v1_interface.moc"
@@ -0,0 +1,260 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "wayland/compositor_interface.h"
+#include "wayland/display.h"
+#include "wayland/presentationtime_interface.h"
+#include "wayland/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/shm_pool.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-presentation-time.h"
+
+using namespace KWaylandServer;
+
+class Presentation : public QtWayland::wp_presentation
+{
+};
+
+class PresentationFeedbackClient : public QObject, public QtWayland::wp_presentation_feedback
+{
+    Q_OBJECT
+
+public:
+    ~PresentationFeedbackClient() override
+    {
+        if (object() && !done) {
+            wp_presentation_feedback_destroy(object());
+        }
+    }
+
+    bool done = false;
+    quint64 seconds = 0;
+    quint32 nanoseconds = 0;
+    quint32 refresh = 0;
+    quint64 sequence = 0;
+    quint32 flags = 0;
+
+Q_SIGNALS:
+    void presented();
+    void discarded();
+
+protected:
+    void wp_presentation_feedback_presented(uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) override
+    {
+        this->seconds = (quint64(tv_sec_hi) << 32) | tv_sec_lo;
+        this->nanoseconds = tv_nsec;
+        this->refresh = refresh;
+        this->sequence = (quint64(seq_hi) << 32) | seq_lo;
+        this->flags = flags;
+        wp_presentation_feedback_destroy(object());
+        done = true;
+        Q_EMIT presented();
+    }
+
+    void wp_presentation_feedback_discarded() override
+    {
+        wp_presentation_feedback_destroy(object());
+        done = true;
+        Q_EMIT discarded();
+    }
+};
+
+class TestPresentationTimeInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPresentationTimeInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPresented();
+    void testDiscarded();
+
+private:
+    SurfaceInterface *createSurface(QScopedPointer<KWayland::Client::Surface> &clientSurface);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::ShmPool *m_shm;
+
+    QThread *m_thread;
+    KWaylandServer::Display m_display;
+    CompositorInterface *m_serverCompositor;
+    Presentation *m_presentation = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-presentation-time-test-0");
+
+void TestPresentationTimeInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_display.createShm();
+    new PresentationTimeInterface(&m_display);
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+    QVERIFY(!m_connection->connections().isEmpty());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_presentation")) {
+            m_presentation = new Presentation();
+            m_presentation->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    QSignalSpy shmSpy(registry, &KWayland::Client::Registry::shmAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_presentation);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+
+    m_shm = registry->createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shm->isValid());
+}
+
+TestPresentationTimeInterface::~TestPresentationTimeInterface()
+{
+    if (m_presentation) {
+        delete m_presentation;
+        m_presentation = nullptr;
+    }
+    if (m_shm) {
+        delete m_shm;
+        m_shm = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+SurfaceInterface *TestPresentationTimeInterface::createSurface(QScopedPointer<KWayland::Client::Surface> &clientSurface)
+{
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    clientSurface.reset(m_clientCompositor->createSurface(this));
+    if (!serverSurfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+void TestPresentationTimeInterface::testPresented()
+{
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    // Request presentation feedback and commit a new buffer.
+    QScopedPointer<PresentationFeedbackClient> clientFeedback(new PresentationFeedbackClient);
+    clientFeedback->init(m_presentation->feedback(*clientSurface));
+    QSignalSpy presentedSpy(clientFeedback.data(), &PresentationFeedbackClient::presented);
+
+    QImage image(QSize(100, 50), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    clientSurface->attachBuffer(m_shm->createBuffer(image));
+    clientSurface->damage(image.rect());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    // The compositor takes the feedback after painting the surface.
+    PresentationFeedback feedback;
+    serverSurface->takePresentationFeedback(&feedback);
+    QVERIFY(!feedback.isEmpty());
+
+    // The feedback must not be taken twice.
+    PresentationFeedback otherFeedback;
+    serverSurface->takePresentationFeedback(&otherFeedback);
+    QVERIFY(otherFeedback.isEmpty());
+
+    const std::chrono::nanoseconds timestamp = std::chrono::seconds(5) + std::chrono::nanoseconds(42);
+    feedback.presented(nullptr, timestamp, std::chrono::nanoseconds(16666666), 1234, PresentationFeedback::Flag::VSync | PresentationFeedback::Flag::ZeroCopy);
+    QVERIFY(feedback.isEmpty());
+    QVERIFY(presentedSpy.wait());
+    QCOMPARE(clientFeedback->seconds, quint64(5));
+    QCOMPARE(clientFeedback->nanoseconds, quint32(42));
+    QCOMPARE(clientFeedback->refresh, quint32(16666666));
+    QCOMPARE(clientFeedback->sequence, quint64(1234));
+    QCOMPARE(clientFeedback->flags, quint32(WP_PRESENTATION_FEEDBACK_KIND_VSYNC | WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY));
+}
+
+void TestPresentationTimeInterface::testDiscarded()
+{
+    QScopedPointer<KWayland::Client::Surface> clientSurface;
+    SurfaceInterface *serverSurface = createSurface(clientSurface);
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<PresentationFeedbackClient> firstFeedback(new PresentationFeedbackClient);
+    firstFeedback->init(m_presentation->feedback(*clientSurface));
+    QSignalSpy firstDiscardedSpy(firstFeedback.data(), &PresentationFeedbackClient::discarded);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    // A content update that has not been presented yet is superseded by the next commit.
+    QScopedPointer<PresentationFeedbackClient> secondFeedback(new PresentationFeedbackClient);
+    secondFeedback->init(m_presentation->feedback(*clientSurface));
+    QSignalSpy secondDiscardedSpy(secondFeedback.data(), &PresentationFeedbackClient::discarded);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(firstDiscardedSpy.wait());
+    QCOMPARE(secondDiscardedSpy.count(), 0);
+
+    // Destroying the feedback without presenting it discards the content update as well.
+    {
+        PresentationFeedback feedback;
+        serverSurface->takePresentationFeedback(&feedback);
+        QVERIFY(!feedback.isEmpty());
+    }
+    QVERIFY(secondDiscardedSpy.wait());
+}
+
+QTEST_GUILESS_MAIN(TestPresentationTimeInterface)
+
+#include "test_presentationtime_interface.moc"
@@ -0,0 +1,188 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "wayland/compositor_interface.h"
+#include "wayland/display.h"
+#include "wayland/surface_interface.h"
+#include "wayland/tearingcontrol_v1_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-tearing-control-v1.h"
+
+using namespace KWaylandServer;
+
+class TearingControlManager : public QtWayland::wp_tearing_control_manager_v1
+{
+};
+
+class TearingControl : public QtWayland::wp_tearing_control_v1
+{
+};
+
+class TestTearingControlV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestTearingControlV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPresentationHint();
+    void testDuplicate();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    KWaylandServer::Display m_display;
+    CompositorInterface *m_serverCompositor;
+    TearingControlManager *m_tearingControlManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-tearing-control-test-0");
+
+void TestTearingControlV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new TearingControlManagerV1Interface(&m_display);
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+    QVERIFY(!m_connection->connections().isEmpty());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_tearing_control_manager_v1")) {
+            m_tearingControlManager = new TearingControlManager();
+            m_tearingControlManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_tearingControlManager);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+}
+
+TestTearingControlV1Interface::~TestTearingControlV1Interface()
+{
+    if (m_tearingControlManager) {
+        delete m_tearingControlManager;
+        m_tearingControlManager = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestTearingControlV1Interface::testPresentationHint()
+{
+    // Create a test surface.
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreatedSpy.isValid());
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::VSync);
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    // The hint is double-buffered state, so it's applied on the next commit.
+    QScopedPointer<TearingControl> clientTearingControl(new TearingControl);
+    clientTearingControl->init(m_tearingControlManager->get_tearing_control(*clientSurface));
+    clientTearingControl->set_presentation_hint(TearingControl::presentation_hint_async);
+    m_connection->flush();
+    QVERIFY(!committedSpy.wait(100));
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::VSync);
+
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::Async);
+
+    clientTearingControl->set_presentation_hint(TearingControl::presentation_hint_vsync);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::VSync);
+
+    // If the tearing control object is destroyed, the hint is reset on the next commit.
+    clientTearingControl->set_presentation_hint(TearingControl::presentation_hint_async);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::Async);
+
+    clientTearingControl->destroy();
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->presentationHint(), PresentationHint::VSync);
+}
+
+void TestTearingControlV1Interface::testDuplicate()
+{
+    // Creating a second tearing control object for the same surface is a protocol error.
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QVERIFY(errorSpy.isValid());
+
+    QScopedPointer<TearingControl> first(new TearingControl);
+    first->init(m_tearingControlManager->get_tearing_control(*clientSurface));
+    QScopedPointer<TearingControl> second(new TearingControl);
+    second->init(m_tearingControlManager->get_tearing_control(*clientSurface));
+    m_connection->flush();
+
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+}
+
+QTEST_GUILESS_MAIN(TestTearingControlV1Interface)
+
+#include "test_tearingcontrol_v1_interface.moc"
@@ -6,6 +6,7 @@
 
 #include "clientbuffer.h"
 #include "clientbuffer_p.h"
+#include "linuxexplicitsynchronization_v1_interface_p.h"
 
 #include "qwayland-server-wayland.h"
 
@@ -62,6 +63,14 @@ void ClientBuffer::unref()
     Q_ASSERT(d->refCount > 0);
     --d->refCount;
     if (!isReferenced()) {
+        for (LinuxBufferReleaseV1Interface *release : std::as_const(d->releasePoints)) {
+            if (release) {
+                release->sendRelease(d->releaseFence);
+            }
+        }
+        d->releasePoints.clear();
+        d->releaseFence = KWin::FileDescriptor();
+
         if (isDestroyed()) {
             delete this;
         } else {
@@ -70,6 +79,24 @@ void ClientBuffer::unref()
     }
 }
 
+bool ClientBuffer::wantsReleaseFence() const
+{
+    Q_D(const ClientBuffer);
+    return !d->releasePoints.isEmpty();
+}
+
+void ClientBuffer::setReleaseFence(KWin::FileDescriptor &&fence)
+{
+    Q_D(ClientBuffer);
+    d->releaseFence = std::move(fence);
+}
+
+void ClientBuffer::addReleasePoint(LinuxBufferReleaseV1Interface *release)
+{
+    Q_D(ClientBuffer);
+    d->releasePoints.append(release);
+}
+
 void ClientBuffer::markAsDestroyed()
 {
     Q_D(ClientBuffer);
@@ -14,9 +14,15 @@
 
 struct wl_resource;
 
+namespace KWin
+{
+class FileDescriptor;
+}
+
 namespace KWaylandServer
 {
 class ClientBufferPrivate;
+class LinuxBufferReleaseV1Interface;
 
 /**
  * The ClientBuffer class represents a client buffer.
@@ -63,7 +69,21 @@ public:
     virtual bool hasAlphaChannel() const = 0;
     virtual Origin origin() const = 0;
 
+    /**
+     * Returns @c true if the client wants to be notified with a release fence when the
+     * compositor has finished reading this buffer; otherwise returns @c false.
+     */
+    bool wantsReleaseFence() const;
+
+    /**
+     * Sets the fence that will be signaled when the compositor has finished reading this
+     * buffer. The fence is passed to the client when the buffer is released if the client
+     * uses explicit synchronization.
+     */
+    void setReleaseFence(KWin::FileDescriptor &&fence);
+
     void markAsDestroyed(); ///< @internal
+    void addReleasePoint(LinuxBufferReleaseV1Interface *release); ///< @internal
 
 protected:
     ClientBuffer(ClientBufferPrivate &dd);
@@ -7,9 +7,15 @@
 #pragma once
 
 #include "clientbuffer.h"
+#include "utils/filedescriptor.h"
+
+#include <QPointer>
+#include <QVector>
 
 namespace KWaylandServer
 {
+class LinuxBufferReleaseV1Interface;
+
 class ClientBufferPrivate
 {
 public:
@@ -20,6 +26,8 @@ public:
     int refCount = 0;
     wl_resource *resource = nullptr;
     bool isDestroyed = false;
+    QVector<QPointer<LinuxBufferReleaseV1Interface>> releasePoints;
+    KWin::FileDescriptor releaseFence;
 };
 
 } // namespace KWaylandServer
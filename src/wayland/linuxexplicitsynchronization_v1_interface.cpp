@@ -0,0 +1,178 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "linuxexplicitsynchronization_v1_interface.h"
+#include "display.h"
+#include "linuxdmabufv1clientbuffer.h"
+#include "linuxexplicitsynchronization_v1_interface_p.h"
+#include "surface_interface_p.h"
+
+static const int s_version = 2;
+
+namespace KWaylandServer
+{
+class LinuxExplicitSynchronizationV1InterfacePrivate : public QtWaylandServer::zwp_linux_explicit_synchronization_v1
+{
+public:
+    LinuxExplicitSynchronizationV1InterfacePrivate(Display *display);
+
+protected:
+    void zwp_linux_explicit_synchronization_v1_destroy(Resource *resource) override;
+    void zwp_linux_explicit_synchronization_v1_get_synchronization(Resource *resource, uint32_t id, struct ::wl_resource *surface) override;
+};
+
+LinuxExplicitSynchronizationV1InterfacePrivate::LinuxExplicitSynchronizationV1InterfacePrivate(Display *display)
+    : QtWaylandServer::zwp_linux_explicit_synchronization_v1(*display, s_version)
+{
+}
+
+void LinuxExplicitSynchronizationV1InterfacePrivate::zwp_linux_explicit_synchronization_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxExplicitSynchronizationV1InterfacePrivate::zwp_linux_explicit_synchronization_v1_get_synchronization(Resource *resource, uint32_t id, struct ::wl_resource *surface_resource)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    if (LinuxSurfaceSynchronizationV1Interface::get(surface)) {
+        wl_resource_post_error(resource->handle, error_synchronization_exists, "the specified surface already has a synchronization object");
+        return;
+    }
+
+    wl_resource *synchronizationResource = wl_resource_create(resource->client(), &zwp_linux_surface_synchronization_v1_interface, resource->version(), id);
+    if (!synchronizationResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+
+    new LinuxSurfaceSynchronizationV1Interface(surface, synchronizationResource);
+}
+
+LinuxExplicitSynchronizationV1Interface::LinuxExplicitSynchronizationV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new LinuxExplicitSynchronizationV1InterfacePrivate(display))
+{
+}
+
+LinuxExplicitSynchronizationV1Interface::~LinuxExplicitSynchronizationV1Interface()
+{
+}
+
+LinuxSurfaceSynchronizationV1Interface::LinuxSurfaceSynchronizationV1Interface(SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::zwp_linux_surface_synchronization_v1(resource)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->synchronizationExtension = this;
+}
+
+LinuxSurfaceSynchronizationV1Interface::~LinuxSurfaceSynchronizationV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->synchronizationExtension = nullptr;
+    }
+}
+
+LinuxSurfaceSynchronizationV1Interface *LinuxSurfaceSynchronizationV1Interface::get(SurfaceInterface *surface)
+{
+    return SurfaceInterfacePrivate::get(surface)->synchronizationExtension;
+}
+
+bool LinuxSurfaceSynchronizationV1Interface::validate(const SurfaceState &state)
+{
+    if (!state.acquireFence.isValid() && !state.bufferRelease) {
+        return true;
+    }
+    if (!state.bufferIsSet || !state.buffer) {
+        wl_resource_post_error(resource()->handle, error_no_buffer, "no buffer is attached to the surface");
+        return false;
+    }
+    if (!qobject_cast<LinuxDmaBufV1ClientBuffer *>(state.buffer)) {
+        wl_resource_post_error(resource()->handle, error_unsupported_buffer, "explicit synchronization is only supported with linux-dmabuf buffers");
+        return false;
+    }
+    return true;
+}
+
+void LinuxSurfaceSynchronizationV1Interface::zwp_linux_surface_synchronization_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void LinuxSurfaceSynchronizationV1Interface::zwp_linux_surface_synchronization_v1_destroy(Resource *resource)
+{
+    // The acquire fence that has been set since the last commit is discarded, but the
+    // release objects are not affected.
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->pending.acquireFence = KWin::FileDescriptor();
+    }
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxSurfaceSynchronizationV1Interface::zwp_linux_surface_synchronization_v1_set_acquire_fence(Resource *resource, int32_t fd)
+{
+    KWin::FileDescriptor fence(fd);
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the surface has been destroyed");
+        return;
+    }
+
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    if (surfacePrivate->pending.acquireFence.isValid()) {
+        wl_resource_post_error(resource->handle, error_duplicate_fence, "the acquire fence has already been set");
+        return;
+    }
+
+    surfacePrivate->pending.acquireFence = std::move(fence);
+}
+
+void LinuxSurfaceSynchronizationV1Interface::zwp_linux_surface_synchronization_v1_get_release(Resource *resource, uint32_t release)
+{
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the surface has been destroyed");
+        return;
+    }
+
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    if (surfacePrivate->pending.bufferRelease) {
+        wl_resource_post_error(resource->handle, error_duplicate_release, "the release object has already been requested");
+        return;
+    }
+
+    wl_resource *releaseResource = wl_resource_create(resource->client(), &zwp_linux_buffer_release_v1_interface, resource->version(), release);
+    if (!releaseResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+
+    surfacePrivate->pending.bufferRelease = new LinuxBufferReleaseV1Interface(releaseResource);
+}
+
+LinuxBufferReleaseV1Interface::LinuxBufferReleaseV1Interface(wl_resource *resource)
+    : QtWaylandServer::zwp_linux_buffer_release_v1(resource)
+{
+}
+
+void LinuxBufferReleaseV1Interface::sendRelease(const KWin::FileDescriptor &fence)
+{
+    if (fence.isValid()) {
+        send_fenced_release(fence.get());
+    } else {
+        send_immediate_release();
+    }
+    wl_resource_destroy(resource()->handle);
+}
+
+void LinuxBufferReleaseV1Interface::zwp_linux_buffer_release_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,42 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class LinuxExplicitSynchronizationV1InterfacePrivate;
+
+/**
+ * The LinuxExplicitSynchronizationV1Interface is an extension that allows clients to use
+ * explicit synchronization with linux dma-buf client buffers.
+ *
+ * The clients can attach an acquire fence to the content update. The compositor will not
+ * apply the content update until the acquire fence has been signaled. The clients can also
+ * request a release fence, which is signaled when the compositor has finished reading the
+ * buffer.
+ *
+ * LinuxExplicitSynchronizationV1Interface corresponds to the Wayland interface
+ * @c zwp_linux_explicit_synchronization_v1.
+ */
+class KWIN_EXPORT LinuxExplicitSynchronizationV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LinuxExplicitSynchronizationV1Interface(Display *display, QObject *parent = nullptr);
+    ~LinuxExplicitSynchronizationV1Interface() override;
+
+private:
+    QScopedPointer<LinuxExplicitSynchronizationV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "utils/filedescriptor.h"
+
+#include "qwayland-server-linux-explicit-synchronization-unstable-v1.h"
+
+#include <QObject>
+#include <QPointer>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+struct SurfaceState;
+
+class LinuxSurfaceSynchronizationV1Interface : public QtWaylandServer::zwp_linux_surface_synchronization_v1
+{
+public:
+    LinuxSurfaceSynchronizationV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~LinuxSurfaceSynchronizationV1Interface() override;
+
+    static LinuxSurfaceSynchronizationV1Interface *get(SurfaceInterface *surface);
+
+    /**
+     * Checks whether the synchronization state of the given content update is valid. If it
+     * is not, a protocol error is posted and @c false is returned.
+     */
+    bool validate(const SurfaceState &state);
+
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void zwp_linux_surface_synchronization_v1_destroy_resource(Resource *resource) override;
+    void zwp_linux_surface_synchronization_v1_destroy(Resource *resource) override;
+    void zwp_linux_surface_synchronization_v1_set_acquire_fence(Resource *resource, int32_t fd) override;
+    void zwp_linux_surface_synchronization_v1_get_release(Resource *resource, uint32_t release) override;
+};
+
+/**
+ * The LinuxBufferReleaseV1Interface class represents a request to be notified when the
+ * compositor has finished reading a buffer committed to a surface.
+ */
+class LinuxBufferReleaseV1Interface : public QObject, public QtWaylandServer::zwp_linux_buffer_release_v1
+{
+    Q_OBJECT
+
+public:
+    explicit LinuxBufferReleaseV1Interface(wl_resource *resource);
+
+    /**
+     * Notifies the client that the buffer can be reused once the @a fence is signaled. If
+     * the @a fence is not valid, the buffer can be reused immediately. The release object
+     * is destroyed afterwards.
+     */
+    void sendRelease(const KWin::FileDescriptor &fence);
+
+protected:
+    void zwp_linux_buffer_release_v1_destroy_resource(Resource *resource) override;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,133 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "presentationtime_interface.h"
+#include "display.h"
+#include "output_interface.h"
+#include "surface_interface_p.h"
+
+#include "qwayland-server-presentation-time.h"
+
+#include <time.h>
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+class PresentationTimeInterfacePrivate : public QtWaylandServer::wp_presentation
+{
+public:
+    PresentationTimeInterfacePrivate(Display *display);
+
+protected:
+    void wp_presentation_bind_resource(Resource *resource) override;
+    void wp_presentation_destroy(Resource *resource) override;
+    void wp_presentation_feedback(Resource *resource, struct ::wl_resource *surface, uint32_t callback) override;
+};
+
+PresentationTimeInterfacePrivate::PresentationTimeInterfacePrivate(Display *display)
+    : QtWaylandServer::wp_presentation(*display, s_version)
+{
+}
+
+void PresentationTimeInterfacePrivate::wp_presentation_bind_resource(Resource *resource)
+{
+    send_clock_id(resource->handle, CLOCK_MONOTONIC);
+}
+
+void PresentationTimeInterfacePrivate::wp_presentation_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PresentationTimeInterfacePrivate::wp_presentation_feedback(Resource *resource, struct ::wl_resource *surface_resource, uint32_t callback)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+
+    wl_resource *feedbackResource = wl_resource_create(resource->client(),
+                                                       &wp_presentation_feedback_interface,
+                                                       /* version */ 1,
+                                                       callback);
+    if (!feedbackResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+
+    wl_resource_set_implementation(feedbackResource, nullptr, nullptr, [](wl_resource *resource) {
+        wl_list_remove(wl_resource_get_link(resource));
+    });
+
+    wl_list_insert(surfacePrivate->pending.presentationFeedbacks.prev, wl_resource_get_link(feedbackResource));
+}
+
+PresentationTimeInterface::PresentationTimeInterface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PresentationTimeInterfacePrivate(display))
+{
+}
+
+PresentationTimeInterface::~PresentationTimeInterface()
+{
+}
+
+PresentationFeedback::PresentationFeedback()
+    : m_resources(new wl_list)
+{
+    wl_list_init(m_resources);
+}
+
+PresentationFeedback::~PresentationFeedback()
+{
+    discarded();
+    delete m_resources;
+}
+
+bool PresentationFeedback::isEmpty() const
+{
+    return wl_list_empty(m_resources);
+}
+
+void PresentationFeedback::presented(OutputInterface *output, std::chrono::nanoseconds timestamp, std::chrono::nanoseconds refresh, quint64 sequence, Flags flags)
+{
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timestamp);
+    const auto nanoseconds = timestamp - seconds;
+    const quint64 secondsCount = seconds.count();
+
+    wl_resource *resource;
+    wl_resource *tmp;
+
+    wl_resource_for_each_safe (resource, tmp, m_resources) {
+        if (output) {
+            const auto outputResources = output->clientResources(wl_resource_get_client(resource));
+            for (wl_resource *outputResource : outputResources) {
+                wp_presentation_feedback_send_sync_output(resource, outputResource);
+            }
+        }
+        wp_presentation_feedback_send_presented(resource,
+                                                secondsCount >> 32,
+                                                secondsCount & 0xffffffff,
+                                                nanoseconds.count(),
+                                                refresh.count(),
+                                                sequence >> 32,
+                                                sequence & 0xffffffff,
+                                                uint32_t(flags));
+        wl_resource_destroy(resource);
+    }
+}
+
+void PresentationFeedback::discarded()
+{
+    wl_resource *resource;
+    wl_resource *tmp;
+
+    wl_resource_for_each_safe (resource, tmp, m_resources) {
+        wp_presentation_feedback_send_discarded(resource);
+        wl_resource_destroy(resource);
+    }
+}
+
+} // namespace KWaylandServer
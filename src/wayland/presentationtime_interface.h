@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QObject>
+
+#include <chrono>
+
+struct wl_list;
+
+namespace KWaylandServer
+{
+class Display;
+class OutputInterface;
+class PresentationTimeInterfacePrivate;
+class SurfaceInterface;
+
+/**
+ * The PresentationTimeInterface is an extension that provides accurate presentation feedback.
+ *
+ * The PresentationTimeInterface allows clients to request feedback about when exactly their
+ * content updates have been shown on the screen, so they can time their rendering to the
+ * display refresh cycle.
+ *
+ * PresentationTimeInterface corresponds to the Wayland interface @c wp_presentation.
+ */
+class KWIN_EXPORT PresentationTimeInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PresentationTimeInterface(Display *display, QObject *parent = nullptr);
+    ~PresentationTimeInterface() override;
+
+private:
+    QScopedPointer<PresentationTimeInterfacePrivate> d;
+};
+
+/**
+ * The PresentationFeedback class represents a set of @c wp_presentation_feedback objects that
+ * have been taken from surfaces painted in the same frame.
+ *
+ * If the PresentationFeedback is destroyed before presented() is called, all remaining feedback
+ * objects will be notified that their content updates have been discarded.
+ *
+ * @see SurfaceInterface::takePresentationFeedback()
+ */
+class KWIN_EXPORT PresentationFeedback
+{
+public:
+    /**
+     * This enum type describes how the content updates have been presented.
+     */
+    enum class Flag : uint {
+        VSync = 0x1,
+        HardwareClock = 0x2,
+        HardwareCompletion = 0x4,
+        ZeroCopy = 0x8,
+    };
+    Q_DECLARE_FLAGS(Flags, Flag)
+
+    PresentationFeedback();
+    ~PresentationFeedback();
+
+    /**
+     * Returns @c true if no feedback has been requested by the surfaces; otherwise returns @c false.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Notifies the clients that their content updates have been presented on the specified
+     * @a output at the given @a timestamp. The @a timestamp must be sourced from the monotonic
+     * clock. The @a refresh specifies the duration of the current refresh cycle, or zero if it
+     * is unknown. The @a sequence specifies the vertical retrace counter value, if available.
+     */
+    void presented(OutputInterface *output, std::chrono::nanoseconds timestamp, std::chrono::nanoseconds refresh, quint64 sequence, Flags flags);
+
+    /**
+     * Notifies the clients that their content updates have never been presented.
+     */
+    void discarded();
+
+private:
+    wl_list *m_resources;
+    friend class SurfaceInterface;
+    Q_DISABLE_COPY(PresentationFeedback)
+};
+
+} // namespace KWaylandServer
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PresentationFeedback::Flags)
@@ -164,6 +164,11 @@ void SubSurfaceInterfacePrivate::subsurface_set_desync(Resource *)
     mode = SubSurfaceInterface::Mode::Desynchronized;
     if (!q->isSynchronized()) {
         auto surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        // The content updates locked by the deferred commits of the parent surface won't be
+        // applied by the parent anymore.
+        while (!surfacePrivate->lockedStates.empty()) {
+            surfacePrivate->commitFromCache();
+        }
         surfacePrivate->commitFromCache();
     }
     Q_EMIT q->modeChanged(SubSurfaceInterface::Mode::Desynchronized);
@@ -11,7 +11,9 @@
 #include "display.h"
 #include "idleinhibit_v1_interface_p.h"
 #include "linuxdmabufv1clientbuffer.h"
+#include "linuxexplicitsynchronization_v1_interface_p.h"
 #include "pointerconstraints_v1_interface_p.h"
+#include "presentationtime_interface.h"
 #include "region_interface_p.h"
 #include "subcompositor_interface.h"
 #include "subsurface_interface_p.h"
@@ -20,17 +22,47 @@
 #include "utils.h"
 
 #include <wayland-server.h>
+
+#include "wayland-presentation-time-server-protocol.h"
 // std
 #include <algorithm>
 
 namespace KWaylandServer
 {
+static void discardPresentationFeedbacks(wl_list *feedbacks)
+{
+    wl_resource *resource;
+    wl_resource *tmp;
+
+    wl_resource_for_each_safe (resource, tmp, feedbacks) {
+        wp_presentation_feedback_send_discarded(resource);
+        wl_resource_destroy(resource);
+    }
+}
+
+static void discardDeferredState(SurfaceState *state)
+{
+    wl_resource *resource;
+    wl_resource *tmp;
+
+    wl_resource_for_each_safe (resource, tmp, &state->frameCallbacks) {
+        wl_resource_destroy(resource);
+    }
+    discardPresentationFeedbacks(&state->presentationFeedbacks);
+    if (state->bufferRelease) {
+        state->bufferRelease->sendRelease(KWin::FileDescriptor());
+    }
+}
+
 SurfaceInterfacePrivate::SurfaceInterfacePrivate(SurfaceInterface *q)
     : q(q)
 {
     wl_list_init(&current.frameCallbacks);
     wl_list_init(&pending.frameCallbacks);
     wl_list_init(&cached.frameCallbacks);
+    wl_list_init(&current.presentationFeedbacks);
+    wl_list_init(&pending.presentationFeedbacks);
+    wl_list_init(&cached.presentationFeedbacks);
 }
 
 SurfaceInterfacePrivate::~SurfaceInterfacePrivate()
@@ -48,6 +80,26 @@ SurfaceInterfacePrivate::~SurfaceInterfacePrivate()
         wl_resource_destroy(resource);
     }
 
+    discardPresentationFeedbacks(&current.presentationFeedbacks);
+    discardPresentationFeedbacks(&pending.presentationFeedbacks);
+    discardPresentationFeedbacks(&cached.presentationFeedbacks);
+
+    if (acquireFenceNotifier) {
+        acquireFenceNotifier->setEnabled(false);
+    }
+    for (const auto &state : deferredStates) {
+        discardDeferredState(state.get());
+    }
+    for (const auto &state : lockedStates) {
+        discardDeferredState(state.get());
+    }
+    if (pending.bufferRelease) {
+        pending.bufferRelease->sendRelease(KWin::FileDescriptor());
+    }
+    if (cached.bufferRelease) {
+        cached.bufferRelease->sendRelease(KWin::FileDescriptor());
+    }
+
     if (current.buffer) {
         current.buffer->unref();
     }
@@ -59,6 +111,12 @@ void SurfaceInterfacePrivate::addChild(SubSurfaceInterface *child)
     pending.above.append(child);
     cached.above.append(child);
     current.above.append(child);
+    for (const auto &state : deferredStates) {
+        state->above.append(child);
+    }
+    for (const auto &state : lockedStates) {
+        state->above.append(child);
+    }
     child->surface()->setOutputs(outputs);
     Q_EMIT q->childSubSurfaceAdded(child);
     Q_EMIT q->childSubSurfacesChanged();
@@ -73,6 +131,14 @@ void SurfaceInterfacePrivate::removeChild(SubSurfaceInterface *child)
     cached.above.removeAll(child);
     current.below.removeAll(child);
     current.above.removeAll(child);
+    for (const auto &state : deferredStates) {
+        state->below.removeAll(child);
+        state->above.removeAll(child);
+    }
+    for (const auto &state : lockedStates) {
+        state->below.removeAll(child);
+        state->above.removeAll(child);
+    }
     Q_EMIT q->childSubSurfaceRemoved(child);
     Q_EMIT q->childSubSurfacesChanged();
 }
@@ -300,10 +366,132 @@ void SurfaceInterfacePrivate::surface_set_input_region(Resource *resource, struc
 void SurfaceInterfacePrivate::surface_commit(Resource *resource)
 {
     Q_UNUSED(resource)
+    if (synchronizationExtension && !synchronizationExtension->validate(pending)) {
+        return;
+    }
+
+    // The content update can't be applied until its acquire fence is signaled. Keep the
+    // content updates in order, so wait for the previous deferred updates as well. The
+    // content update of a synchronized sub-surface is only cached; its acquire fence is
+    // waited for when the parent surface is committed, so both are applied atomically.
+    const bool synchronized = subSurface && subSurface->isSynchronized();
+    if (deferredStates.empty() && (synchronized || (isFenceSignaled(pending.acquireFence) && synchronizedChildrenReady()))) {
+        commit(&pending);
+    } else {
+        deferCommit();
+    }
+}
+
+void SurfaceInterfacePrivate::commit(SurfaceState *state)
+{
     if (subSurface) {
-        commitSubSurface();
+        commitSubSurface(state);
     } else {
-        applyState(&pending);
+        applyState(state);
+    }
+}
+
+bool SurfaceInterfacePrivate::isFenceSignaled(const KWin::FileDescriptor &fence)
+{
+    return !fence.isValid() || fence.isReadable();
+}
+
+bool SurfaceInterfacePrivate::synchronizedChildrenReady() const
+{
+    for (const QList<SubSurfaceInterface *> &children : {current.below, current.above}) {
+        for (SubSurfaceInterface *subsurface : children) {
+            if (subsurface->mode() != SubSurfaceInterface::Mode::Synchronized) {
+                continue;
+            }
+            const SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(subsurface->surface());
+            if (!isFenceSignaled(surfacePrivate->cached.acquireFence) || !surfacePrivate->synchronizedChildrenReady()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SurfaceInterfacePrivate::lockSynchronizedChildren(SurfaceState *state)
+{
+    for (const QList<SubSurfaceInterface *> &children : {current.below, current.above}) {
+        for (SubSurfaceInterface *subsurface : children) {
+            if (subsurface->mode() != SubSurfaceInterface::Mode::Synchronized) {
+                continue;
+            }
+            SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(subsurface->surface());
+
+            auto locked = std::make_unique<SurfaceState>();
+            wl_list_init(&locked->frameCallbacks);
+            wl_list_init(&locked->presentationFeedbacks);
+            locked->below = surfacePrivate->cached.below;
+            locked->above = surfacePrivate->cached.above;
+            surfacePrivate->cached.mergeInto(locked.get());
+            surfacePrivate->hasCacheState = false;
+
+            if (locked->acquireFence.isValid()) {
+                state->childAcquireFences.push_back(locked->acquireFence.duplicate());
+            }
+            surfacePrivate->lockedStates.push_back(std::move(locked));
+            surfacePrivate->lockSynchronizedChildren(state);
+        }
+    }
+}
+
+void SurfaceInterfacePrivate::deferCommit()
+{
+    auto state = std::make_unique<SurfaceState>();
+    wl_list_init(&state->frameCallbacks);
+    wl_list_init(&state->presentationFeedbacks);
+    state->below = pending.below;
+    state->above = pending.above;
+    pending.mergeInto(state.get());
+
+    // The cached states of the synchronized sub-surfaces belong to this content update,
+    // later commits of the sub-surfaces must not leak into it.
+    if (!subSurface || !subSurface->isSynchronized()) {
+        lockSynchronizedChildren(state.get());
+    }
+
+    deferredStates.push_back(std::move(state));
+    if (!acquireFenceNotifier) {
+        processDeferredCommits();
+    }
+}
+
+void SurfaceInterfacePrivate::processDeferredCommits()
+{
+    if (acquireFenceNotifier) {
+        acquireFenceNotifier->setEnabled(false);
+        acquireFenceNotifier.reset();
+    }
+
+    while (!deferredStates.empty()) {
+        SurfaceState *state = deferredStates.front().get();
+
+        const KWin::FileDescriptor *unsignaledFence = nullptr;
+        if (!isFenceSignaled(state->acquireFence)) {
+            unsignaledFence = &state->acquireFence;
+        } else {
+            for (const KWin::FileDescriptor &fence : state->childAcquireFences) {
+                if (!isFenceSignaled(fence)) {
+                    unsignaledFence = &fence;
+                    break;
+                }
+            }
+        }
+
+        if (unsignaledFence) {
+            acquireFenceNotifier.reset(new QSocketNotifier(unsignaledFence->get(), QSocketNotifier::Read));
+            QObject::connect(acquireFenceNotifier.data(), &QSocketNotifier::activated, q, [this]() {
+                processDeferredCommits();
+            });
+            return;
+        }
+
+        const std::unique_ptr<SurfaceState> next = std::move(deferredStates.front());
+        deferredStates.pop_front();
+        commit(next.get());
     }
 }
 
@@ -396,6 +584,50 @@ bool SurfaceInterface::hasFrameCallbacks() const
     return !wl_list_empty(&d->current.frameCallbacks);
 }
 
+void SurfaceInterface::takePresentationFeedback(PresentationFeedback *feedback)
+{
+    wl_list_insert_list(feedback->m_resources->prev, &d->current.presentationFeedbacks);
+    wl_list_init(&d->current.presentationFeedbacks);
+
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->takePresentationFeedback(feedback);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->takePresentationFeedback(feedback);
+    }
+}
+
+bool SurfaceInterface::wantsReleaseFence() const
+{
+    if (d->bufferRef && d->bufferRef->wantsReleaseFence()) {
+        return true;
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        if (subsurface->surface()->wantsReleaseFence()) {
+            return true;
+        }
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        if (subsurface->surface()->wantsReleaseFence()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SurfaceInterface::setReleaseFence(const KWin::FileDescriptor &fence)
+{
+    if (d->bufferRef && d->bufferRef->wantsReleaseFence()) {
+        d->bufferRef->setReleaseFence(fence.duplicate());
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->setReleaseFence(fence);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->setReleaseFence(fence);
+    }
+}
+
 QMatrix4x4 SurfaceInterfacePrivate::buildSurfaceToBufferMatrix()
 {
     // The order of transforms is reversed, i.e. the viewport transform is the first one.
@@ -470,6 +702,12 @@ void SurfaceState::mergeInto(SurfaceState *target)
         target->damage = damage;
         target->bufferDamage = bufferDamage;
         target->bufferIsSet = bufferIsSet;
+        target->acquireFence = std::move(acquireFence);
+        if (target->bufferRelease) {
+            // The superseded buffer has never been used by the compositor.
+            target->bufferRelease->sendRelease(KWin::FileDescriptor());
+        }
+        target->bufferRelease = bufferRelease;
     }
     if (viewport.sourceGeometryIsSet) {
         target->viewport.sourceGeometry = viewport.sourceGeometry;
@@ -486,6 +724,10 @@ void SurfaceState::mergeInto(SurfaceState *target)
     }
     wl_list_insert_list(&target->frameCallbacks, &frameCallbacks);
 
+    // A content update that has never been presented is superseded by the new one.
+    discardPresentationFeedbacks(&target->presentationFeedbacks);
+    wl_list_insert_list(&target->presentationFeedbacks, &presentationFeedbacks);
+
     if (shadowIsSet) {
         target->shadow = shadow;
         target->shadowIsSet = true;
@@ -518,11 +760,16 @@ void SurfaceState::mergeInto(SurfaceState *target)
         target->bufferTransform = bufferTransform;
         target->bufferTransformIsSet = true;
     }
+    if (presentationHintIsSet) {
+        target->presentationHint = presentationHint;
+        target->presentationHintIsSet = true;
+    }
 
     *this = SurfaceState{};
     below = target->below;
     above = target->above;
     wl_list_init(&frameCallbacks);
+    wl_list_init(&presentationFeedbacks);
 }
 
 void SurfaceInterfacePrivate::applyState(SurfaceState *next)
@@ -564,6 +811,18 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
         }
     }
 
+    // The acquire fence has been signaled by now, the client buffer will be released
+    // once the compositor stops referencing it.
+    current.acquireFence = KWin::FileDescriptor();
+    if (current.bufferRelease) {
+        if (bufferRef) {
+            bufferRef->addReleasePoint(current.bufferRelease);
+        } else {
+            current.bufferRelease->sendRelease(KWin::FileDescriptor());
+        }
+        current.bufferRelease.clear();
+    }
+
     // TODO: Refactor the state management code because it gets more clumsy.
     if (current.buffer) {
         bufferSize = current.buffer->size();
@@ -672,30 +931,36 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
     Q_EMIT q->committed();
 }
 
-void SurfaceInterfacePrivate::commitSubSurface()
+void SurfaceInterfacePrivate::commitSubSurface(SurfaceState *state)
 {
     if (subSurface->isSynchronized()) {
-        commitToCache();
+        commitToCache(state);
     } else {
         if (hasCacheState) {
-            commitToCache();
+            commitToCache(state);
             commitFromCache();
         } else {
-            applyState(&pending);
+            applyState(state);
         }
     }
 }
 
-void SurfaceInterfacePrivate::commitToCache()
+void SurfaceInterfacePrivate::commitToCache(SurfaceState *state)
 {
-    pending.mergeInto(&cached);
+    state->mergeInto(&cached);
     hasCacheState = true;
 }
 
 void SurfaceInterfacePrivate::commitFromCache()
 {
-    applyState(&cached);
-    hasCacheState = false;
+    if (!lockedStates.empty()) {
+        const std::unique_ptr<SurfaceState> next = std::move(lockedStates.front());
+        lockedStates.pop_front();
+        applyState(next.get());
+    } else {
+        applyState(&cached);
+        hasCacheState = false;
+    }
 }
 
 bool SurfaceInterfacePrivate::computeEffectiveMapped() const
@@ -759,6 +1024,11 @@ KWin::Output::Transform SurfaceInterface::bufferTransform() const
     return d->current.bufferTransform;
 }
 
+PresentationHint SurfaceInterface::presentationHint() const
+{
+    return d->current.presentationHint;
+}
+
 ClientBuffer *SurfaceInterface::buffer() const
 {
     return d->bufferRef;
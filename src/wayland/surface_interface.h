@@ -13,6 +13,11 @@
 #include <QPointer>
 #include <QRegion>
 
+namespace KWin
+{
+class FileDescriptor;
+}
+
 namespace KWaylandServer
 {
 class BlurInterface;
@@ -21,12 +26,27 @@ class ConfinedPointerV1Interface;
 class ContrastInterface;
 class CompositorInterface;
 class LockedPointerV1Interface;
+class PresentationFeedback;
 class ShadowInterface;
 class SlideInterface;
 class SubSurfaceInterface;
 class SurfaceInterfacePrivate;
 class LinuxDmaBufV1Feedback;
 
+/**
+ * This enum type describes how the content updates of a surface should be presented.
+ */
+enum class PresentationHint {
+    /**
+     * The content updates are synchronized to the vertical blanking period, no tearing is visible.
+     */
+    VSync,
+    /**
+     * The content updates should be presented as soon as possible, tearing is acceptable.
+     */
+    Async,
+};
+
 /**
  * @brief Resource representing a wl_surface.
  *
@@ -158,6 +178,31 @@ public:
     void frameRendered(quint32 msec);
     bool hasFrameCallbacks() const;
 
+    /**
+     * Moves the presentation feedback objects attached to the current state of this surface
+     * and its sub-surfaces to the specified @a feedback. The compositor should call this
+     * function after the surface has been painted, and notify the @a feedback once the frame
+     * has been presented on the screen.
+     *
+     * @see PresentationTimeInterface
+     */
+    void takePresentationFeedback(PresentationFeedback *feedback);
+
+    /**
+     * Returns @c true if the client wants to receive a release fence for the current buffer
+     * of this surface or any of its sub-surfaces; otherwise returns @c false.
+     *
+     * @see LinuxExplicitSynchronizationV1Interface
+     */
+    bool wantsReleaseFence() const;
+
+    /**
+     * Attaches a duplicate of the given @a fence to the current buffers of this surface and its
+     * sub-surfaces that have been requested to be released with a fence. The @a fence must be
+     * signaled when the compositor has finished reading the buffers.
+     */
+    void setReleaseFence(const KWin::FileDescriptor &fence);
+
     QRegion damage() const;
     QRegion opaque() const;
     QRegion input() const;
@@ -170,6 +215,11 @@ public:
      * be rotated 90 degrees counter clockwise.
      */
     KWin::Output::Transform bufferTransform() const;
+    /**
+     * Returns the presentation hint that has been set with the tearing control protocol.
+     * It defaults to PresentationHint::VSync.
+     */
+    PresentationHint presentationHint() const;
     /**
      * @returns the current ClientBuffer, might be @c nullptr.
      */
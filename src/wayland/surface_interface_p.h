@@ -8,16 +8,26 @@
 
 #include "surface_interface.h"
 #include "utils.h"
+#include "utils/filedescriptor.h"
 // Qt
 #include <QHash>
+#include <QScopedPointer>
+#include <QSocketNotifier>
 #include <QVector>
+// std
+#include <deque>
+#include <memory>
+#include <vector>
 // Wayland
 #include "qwayland-server-wayland.h"
 
 namespace KWaylandServer
 {
 class IdleInhibitorV1Interface;
+class LinuxBufferReleaseV1Interface;
+class LinuxSurfaceSynchronizationV1Interface;
 class SurfaceRole;
+class TearingControlV1Interface;
 class ViewportInterface;
 
 struct SurfaceState
@@ -38,15 +48,22 @@ struct SurfaceState
     bool childrenChanged = false;
     bool bufferScaleIsSet = false;
     bool bufferTransformIsSet = false;
+    bool presentationHintIsSet = false;
     qint32 bufferScale = 1;
     KWin::Output::Transform bufferTransform = KWin::Output::Transform::Normal;
+    PresentationHint presentationHint = PresentationHint::VSync;
     wl_list frameCallbacks;
+    wl_list presentationFeedbacks;
     QPoint offset = QPoint();
     QPointer<ClientBuffer> buffer;
     QPointer<ShadowInterface> shadow;
     QPointer<BlurInterface> blur;
     QPointer<ContrastInterface> contrast;
     QPointer<SlideInterface> slide;
+    KWin::FileDescriptor acquireFence;
+    QPointer<LinuxBufferReleaseV1Interface> bufferRelease;
+    // acquire fences of the synchronized sub-surfaces that are applied along with this state
+    std::vector<KWin::FileDescriptor> childAcquireFences;
 
     // Subsurfaces are stored in two lists. The below list contains subsurfaces that
     // are below their parent surface; the above list contains subsurfaces that are
@@ -86,10 +103,16 @@ public:
     void installPointerConstraint(ConfinedPointerV1Interface *confinement);
     void installIdleInhibitor(IdleInhibitorV1Interface *inhibitor);
 
-    void commitToCache();
+    void commit(SurfaceState *state);
+    void commitToCache(SurfaceState *state);
     void commitFromCache();
 
-    void commitSubSurface();
+    void commitSubSurface(SurfaceState *state);
+    void deferCommit();
+    void processDeferredCommits();
+    void lockSynchronizedChildren(SurfaceState *state);
+    bool synchronizedChildrenReady() const;
+    static bool isFenceSignaled(const KWin::FileDescriptor &fence);
     QMatrix4x4 buildSurfaceToBufferMatrix();
     void applyState(SurfaceState *next);
 
@@ -123,6 +146,13 @@ public:
 
     QVector<IdleInhibitorV1Interface *> idleInhibitors;
     ViewportInterface *viewportExtension = nullptr;
+    LinuxSurfaceSynchronizationV1Interface *synchronizationExtension = nullptr;
+    TearingControlV1Interface *tearingControlExtension = nullptr;
+    // content updates that wait for their acquire fences to be signaled, in commit order
+    std::deque<std::unique_ptr<SurfaceState>> deferredStates;
+    // cached states that will be applied by the deferred content updates of the parent surface
+    std::deque<std::unique_ptr<SurfaceState>> lockedStates;
+    QScopedPointer<QSocketNotifier, QScopedPointerDeleteLater> acquireFenceNotifier;
     QScopedPointer<LinuxDmaBufV1Feedback> dmabufFeedbackV1;
     ClientConnection *client = nullptr;
 
@@ -38,6 +38,7 @@
 #include "wayland/keyboard_shortcuts_inhibit_v1_interface.h"
 #include "wayland/keystate_interface.h"
 #include "wayland/linuxdmabufv1clientbuffer.h"
+#include "wayland/linuxexplicitsynchronization_v1_interface.h"
 #include "wayland/output_interface.h"
 #include "wayland/outputconfiguration_v2_interface.h"
 #include "wayland/outputmanagement_v2_interface.h"
@@ -46,6 +47,7 @@
 #include "wayland/plasmawindowmanagement_interface.h"
 #include "wayland/pointerconstraints_v1_interface.h"
 #include "wayland/pointergestures_v1_interface.h"
+#include "wayland/presentationtime_interface.h"
 #include "wayland/primaryoutput_v1_interface.h"
 #include "wayland/primaryselectiondevicemanager_v1_interface.h"
 #include "wayland/relativepointer_v1_interface.h"
@@ -55,6 +57,7 @@
 #include "wayland/shadow_interface.h"
 #include "wayland/subcompositor_interface.h"
 #include "wayland/tablet_v2_interface.h"
+#include "wayland/tearingcontrol_v1_interface.h"
 #include "wayland/viewporter_interface.h"
 #include "wayland/xdgactivation_v1_interface.h"
 #include "wayland/xdgdecoration_v1_interface.h"
@@ -327,6 +330,12 @@ void WaylandServer::handleOutputDisabled(Output *output)
     }
 }
 
+KWaylandServer::OutputInterface *WaylandServer::findWaylandOutput(Output *output) const
+{
+    WaylandOutput *waylandOutput = m_waylandOutputs.value(output);
+    return waylandOutput ? waylandOutput->waylandOutput() : nullptr;
+}
+
 Output *WaylandServer::findOutput(KWaylandServer::OutputInterface *outputIface) const
 {
     for (auto it = m_waylandOutputs.constBegin(); it != m_waylandOutputs.constEnd(); ++it) {
@@ -408,6 +417,8 @@ bool WaylandServer::init(InitializationFlags flags)
     });
 
     new ViewporterInterface(m_display, m_display);
+    new PresentationTimeInterface(m_display, m_display);
+    new TearingControlManagerV1Interface(m_display, m_display);
     m_display->createShm();
     m_seat = new SeatInterface(m_display, m_display);
     new PointerGesturesV1Interface(m_display, m_display);
@@ -506,6 +517,8 @@ KWaylandServer::LinuxDmaBufV1ClientBufferIntegration *WaylandServer::linuxDmabuf
 {
     if (!m_linuxDmabuf) {
         m_linuxDmabuf = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+        // Explicit synchronization is only supported for dmabuf client buffers.
+        new LinuxExplicitSynchronizationV1Interface(m_display, m_display);
     }
     return m_linuxDmabuf;
 }
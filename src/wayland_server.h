@@ -224,6 +224,7 @@ public:
     }
 
     Output *findOutput(KWaylandServer::OutputInterface *output) const;
+    KWaylandServer::OutputInterface *findWaylandOutput(Output *output) const;
 
     /**
      * Returns the first socket name that can be used to connect to this server.
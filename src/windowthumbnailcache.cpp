@@ -0,0 +1,362 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "windowthumbnailcache.h"
+#include "composite.h"
+#include "effects.h"
+#include "output.h"
+#include "renderbackend.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "window.h"
+#include "windowitem.h"
+#include "workspace.h"
+
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <cmath>
+
+namespace KWin
+{
+
+// Thumbnails of windows other than the active one are refreshed at most at this rate.
+static const std::chrono::milliseconds s_inactiveRefreshInterval(100);
+static const qint64 s_defaultMemoryBudget = 128 * 1024 * 1024;
+static const int s_maxMipLevels = 4;
+
+WindowThumbnail::WindowThumbnail(Window *window, int level, qreal devicePixelRatio)
+    : m_window(window)
+    , m_level(level)
+    , m_devicePixelRatio(devicePixelRatio)
+{
+    connect(window, &Window::damaged, this, &WindowThumbnail::markDirty);
+    connect(window, &Window::frameGeometryChanged, this, &WindowThumbnail::markDirty);
+}
+
+WindowThumbnail::~WindowThumbnail()
+{
+    destroyTexture();
+}
+
+Window *WindowThumbnail::window() const
+{
+    return m_window;
+}
+
+QSharedPointer<GLTexture> WindowThumbnail::texture() const
+{
+    return m_texture;
+}
+
+QSize WindowThumbnail::textureSize() const
+{
+    const QSize size = m_window->visibleGeometry().size() * m_devicePixelRatio;
+    return QSize(std::max(1, (size.width() + (1 << m_level) - 1) >> m_level),
+                 std::max(1, (size.height() + (1 << m_level) - 1) >> m_level));
+}
+
+qint64 WindowThumbnail::memoryUsage() const
+{
+    if (!m_texture) {
+        return 0;
+    }
+    // The mipmap chain adds up to a third of the base level.
+    const QSize size = m_texture->size();
+    return qint64(size.width()) * size.height() * 4 * 4 / 3;
+}
+
+void WindowThumbnail::markDirty()
+{
+    m_dirty = true;
+}
+
+void WindowThumbnail::waitForRendering()
+{
+    if (m_acquireFence) {
+        glClientWaitSync(m_acquireFence, GL_SYNC_FLUSH_COMMANDS_BIT, 5000);
+        glDeleteSync(m_acquireFence);
+        m_acquireFence = 0;
+    }
+}
+
+void WindowThumbnail::render()
+{
+    const QRect geometry = m_window->visibleGeometry();
+    const QSize size = textureSize();
+    if (!m_texture || m_texture->size() != size) {
+        const int levels = std::min(s_maxMipLevels, int(std::log2(std::max(size.width(), size.height()))) + 1);
+        m_texture.reset(new GLTexture(GL_RGBA8, size, levels));
+        m_texture->setFilter(levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        m_framebuffer.reset(new GLFramebuffer(m_texture.data()));
+    }
+
+    GLFramebuffer::pushFramebuffer(m_framebuffer.data());
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    QMatrix4x4 projectionMatrix;
+    projectionMatrix.ortho(geometry.x(), geometry.x() + geometry.width(),
+                           geometry.y(), geometry.y() + geometry.height(), -1, 1);
+
+    WindowPaintData data;
+    data.setProjectionMatrix(projectionMatrix);
+
+    // The thumbnail must be rendered using kwin's opengl context as VAOs are not
+    // shared across contexts. Unfortunately, this also introduces a latency of 1
+    // frame, which is not ideal, but it is acceptable for things such as thumbnails.
+    const int mask = Scene::PAINT_WINDOW_TRANSFORMED;
+    Compositor::self()->scene()->render(m_window->windowItem(), mask, infiniteRegion(), data);
+    GLFramebuffer::popFramebuffer();
+
+    m_texture->bind();
+    m_texture->generateMipmaps();
+    m_texture->unbind();
+
+    // The fence is needed to avoid the case where qtquick renderer starts using
+    // the texture while all rendering commands to it haven't completed yet.
+    if (m_acquireFence) {
+        glDeleteSync(m_acquireFence);
+    }
+    m_acquireFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_dirty = false;
+    m_lastUpdate = std::chrono::steady_clock::now();
+
+    Q_EMIT updated();
+}
+
+void WindowThumbnail::destroyTexture()
+{
+    if (!m_texture && !m_acquireFence) {
+        return;
+    }
+
+    // The scene may be already gone if compositing is being torn down.
+    Scene *scene = Compositor::self() ? Compositor::self()->scene() : nullptr;
+    if (scene) {
+        scene->makeOpenGLContextCurrent();
+    }
+    m_framebuffer.reset();
+    m_texture.reset();
+    if (m_acquireFence) {
+        glDeleteSync(m_acquireFence);
+        m_acquireFence = 0;
+    }
+    if (scene) {
+        scene->doneOpenGLContextCurrent();
+    }
+    m_dirty = true;
+}
+
+KWIN_SINGLETON_FACTORY(WindowThumbnailCache)
+
+WindowThumbnailCache::WindowThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , m_memoryBudget(s_defaultMemoryBudget)
+{
+    m_throttleTimer.setSingleShot(true);
+    connect(&m_throttleTimer, &QTimer::timeout, this, [this]() {
+        // Throttled thumbnails are updated in the next frame.
+        for (auto it = m_used.constBegin(); it != m_used.constEnd(); ++it) {
+            const QSharedPointer<WindowThumbnail> thumbnail = it.value().toStrongRef();
+            if (thumbnail && thumbnail->m_dirty && thumbnail->m_window->output()) {
+                thumbnail->m_window->output()->renderLoop()->scheduleRepaint();
+            }
+        }
+    });
+
+    connect(Compositor::self(), &Compositor::aboutToToggleCompositing, this, &WindowThumbnailCache::destroyTextures);
+    connect(Compositor::self(), &Compositor::sceneCreated, this, [this]() {
+        if (Compositor::self()->backend()->compositingType() == OpenGLCompositing) {
+            connect(Compositor::self()->scene(), &Scene::preFrameRender, this, &WindowThumbnailCache::updateThumbnails);
+        }
+    });
+    if (Compositor::compositing() && Compositor::self()->backend()->compositingType() == OpenGLCompositing) {
+        connect(Compositor::self()->scene(), &Scene::preFrameRender, this, &WindowThumbnailCache::updateThumbnails);
+    }
+}
+
+WindowThumbnailCache::~WindowThumbnailCache()
+{
+    for (WindowThumbnail *thumbnail : m_unused) {
+        delete thumbnail;
+    }
+    s_self = nullptr;
+}
+
+QSharedPointer<WindowThumbnail> WindowThumbnailCache::thumbnail(Window *window, const QSize &size, qreal devicePixelRatio)
+{
+    // Pick the smallest bucket that is still at least as large as the requested size.
+    const QSize windowSize = window->visibleGeometry().size() * devicePixelRatio;
+    int level = 0;
+    if (size.width() > 0 && size.height() > 0) {
+        const qreal ratio = std::min(qreal(windowSize.width()) / size.width(), qreal(windowSize.height()) / size.height());
+        if (ratio >= 2) {
+            level = int(std::log2(ratio));
+        }
+    }
+
+    const Key key{window, level, devicePixelRatio};
+    if (const QSharedPointer<WindowThumbnail> thumbnail = m_used.value(key).toStrongRef()) {
+        return thumbnail;
+    }
+
+    WindowThumbnail *thumbnail = nullptr;
+    for (auto it = m_unused.begin(); it != m_unused.end(); ++it) {
+        if ((*it)->m_window == window && (*it)->m_level == level && qFuzzyCompare((*it)->m_devicePixelRatio, devicePixelRatio)) {
+            thumbnail = *it;
+            m_unused.erase(it);
+            break;
+        }
+    }
+    if (!thumbnail) {
+        thumbnail = new WindowThumbnail(window, level, devicePixelRatio);
+        if (!m_windows.contains(window)) {
+            m_windows.insert(window);
+            connect(window, &QObject::destroyed, this, [this, window]() {
+                removeWindow(window);
+            });
+        }
+    }
+    if (!thumbnail->m_texture && window->output()) {
+        // The thumbnail is rendered before the next frame.
+        window->output()->renderLoop()->scheduleRepaint();
+    }
+
+    // The consumers can outlive the cache, e.g. when the workspace is being torn down.
+    const QPointer<WindowThumbnailCache> cache(this);
+    const QSharedPointer<WindowThumbnail> ret(thumbnail, [cache](WindowThumbnail *thumbnail) {
+        if (cache) {
+            cache->release(thumbnail);
+        } else {
+            delete thumbnail;
+        }
+    });
+    m_used.insert(key, ret);
+    return ret;
+}
+
+void WindowThumbnailCache::release(WindowThumbnail *thumbnail)
+{
+    if (!thumbnail->m_window) {
+        destroy(thumbnail);
+        return;
+    }
+    m_used.remove(Key{thumbnail->m_window, thumbnail->m_level, thumbnail->m_devicePixelRatio});
+    m_unused.push_back(thumbnail);
+    evict();
+}
+
+void WindowThumbnailCache::evict()
+{
+    // Used thumbnails are never evicted, so the budget only bounds the memory held by the
+    // thumbnails that are kept around for later.
+    qint64 unusedMemory = 0;
+    for (const WindowThumbnail *thumbnail : m_unused) {
+        unusedMemory += thumbnail->memoryUsage();
+    }
+    while (unusedMemory > m_memoryBudget && !m_unused.empty()) {
+        WindowThumbnail *thumbnail = m_unused.front();
+        m_unused.pop_front();
+        unusedMemory -= thumbnail->memoryUsage();
+        destroy(thumbnail);
+    }
+}
+
+void WindowThumbnailCache::destroy(WindowThumbnail *thumbnail)
+{
+    delete thumbnail;
+}
+
+void WindowThumbnailCache::removeWindow(Window *window)
+{
+    m_windows.remove(window);
+    for (auto it = m_unused.begin(); it != m_unused.end();) {
+        if ((*it)->m_window == window) {
+            destroy(*it);
+            it = m_unused.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_used.begin(); it != m_used.end();) {
+        if (it.key().window == window) {
+            if (const QSharedPointer<WindowThumbnail> thumbnail = it.value().toStrongRef()) {
+                thumbnail->m_window = nullptr;
+            }
+            it = m_used.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void WindowThumbnailCache::updateThumbnails()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const Window *activeWindow = workspace()->activeWindow();
+
+    bool throttled = false;
+    for (auto it = m_used.constBegin(); it != m_used.constEnd(); ++it) {
+        const QSharedPointer<WindowThumbnail> thumbnail = it.value().toStrongRef();
+        if (!thumbnail || !thumbnail->m_dirty) {
+            continue;
+        }
+        if (thumbnail->m_texture && thumbnail->m_window != activeWindow
+            && now - thumbnail->m_lastUpdate < s_inactiveRefreshInterval) {
+            throttled = true;
+            continue;
+        }
+        thumbnail->render();
+    }
+
+    if (throttled && !m_throttleTimer.isActive()) {
+        m_throttleTimer.start(s_inactiveRefreshInterval);
+    }
+}
+
+void WindowThumbnailCache::destroyTextures()
+{
+    for (WindowThumbnail *thumbnail : m_unused) {
+        delete thumbnail;
+    }
+    m_unused.clear();
+
+    for (auto it = m_used.constBegin(); it != m_used.constEnd(); ++it) {
+        if (const QSharedPointer<WindowThumbnail> thumbnail = it.value().toStrongRef()) {
+            thumbnail->destroyTexture();
+        }
+    }
+}
+
+qint64 WindowThumbnailCache::memoryUsage() const
+{
+    qint64 usage = 0;
+    for (auto it = m_used.constBegin(); it != m_used.constEnd(); ++it) {
+        if (const QSharedPointer<WindowThumbnail> thumbnail = it.value().toStrongRef()) {
+            usage += thumbnail->memoryUsage();
+        }
+    }
+    for (const WindowThumbnail *thumbnail : m_unused) {
+        usage += thumbnail->memoryUsage();
+    }
+    return usage;
+}
+
+qint64 WindowThumbnailCache::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+void WindowThumbnailCache::setMemoryBudget(qint64 budget)
+{
+    m_memoryBudget = budget;
+    evict();
+}
+
+} // namespace KWin
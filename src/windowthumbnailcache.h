@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2022 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSize>
+#include <QTimer>
+
+#include <chrono>
+#include <epoxy/gl.h>
+#include <list>
+
+namespace KWin
+{
+
+class GLFramebuffer;
+class GLTexture;
+class Window;
+class WindowThumbnailCache;
+
+/**
+ * The WindowThumbnail class holds a downscaled rendering of a window.
+ *
+ * The thumbnail is stored in a mipmapped texture, which is at least as large as requested,
+ * so the consumers can scale it down further without aliasing.
+ */
+class KWIN_EXPORT WindowThumbnail : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~WindowThumbnail() override;
+
+    Window *window() const;
+
+    /**
+     * Returns the texture with the contents of the window, or @c null if the window hasn't
+     * been rendered yet.
+     */
+    QSharedPointer<GLTexture> texture() const;
+
+    /**
+     * Waits until the GPU has finished rendering the thumbnail. This must be called before
+     * the texture is used in another OpenGL context.
+     */
+    void waitForRendering();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the contents of the texture have changed.
+     */
+    void updated();
+
+private:
+    WindowThumbnail(Window *window, int level, qreal devicePixelRatio);
+
+    QSize textureSize() const;
+    qint64 memoryUsage() const;
+    void markDirty();
+    void render();
+    void destroyTexture();
+
+    Window *m_window;
+    int m_level;
+    qreal m_devicePixelRatio;
+    QSharedPointer<GLTexture> m_texture;
+    QScopedPointer<GLFramebuffer> m_framebuffer;
+    GLsync m_acquireFence = 0;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+    bool m_dirty = true;
+
+    friend class WindowThumbnailCache;
+};
+
+/**
+ * The WindowThumbnailCache class shares window thumbnails between all thumbnail consumers.
+ *
+ * Thumbnails are keyed by the window and a size bucket, every bucket is half as large as the
+ * previous one, so consumers showing the same window at similar sizes share the thumbnail.
+ * Thumbnails of the active window are refreshed every frame, others at a lower rate.
+ *
+ * Thumbnails that are no longer used are kept around for a while in case they are needed
+ * again, e.g. when the task switcher is shown again, until the memory budget is exceeded.
+ */
+class KWIN_EXPORT WindowThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~WindowThumbnailCache() override;
+
+    /**
+     * Returns a thumbnail of the @a window that is at least @a size large, in device pixels.
+     */
+    QSharedPointer<WindowThumbnail> thumbnail(Window *window, const QSize &size, qreal devicePixelRatio);
+
+    /**
+     * Returns the amount of video memory used by the thumbnails, in bytes.
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * Returns the maximum amount of video memory that can be held by unused thumbnails.
+     */
+    qint64 memoryBudget() const;
+    void setMemoryBudget(qint64 budget);
+
+private:
+    struct Key
+    {
+        Window *window;
+        int level;
+        qreal devicePixelRatio;
+
+        bool operator==(const Key &other) const
+        {
+            return window == other.window && level == other.level && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+        }
+    };
+    friend uint qHash(const Key &key, uint seed = 0)
+    {
+        return ::qHash(key.window, seed) ^ ::qHash(key.level, seed);
+    }
+
+    void release(WindowThumbnail *thumbnail);
+    void evict();
+    void destroy(WindowThumbnail *thumbnail);
+    void removeWindow(Window *window);
+    void updateThumbnails();
+    void destroyTextures();
+
+    QHash<Key, QWeakPointer<WindowThumbnail>> m_used;
+    std::list<WindowThumbnail *> m_unused;
+    // windows whose destruction is being tracked
+    QSet<Window *> m_windows;
+    QTimer m_throttleTimer;
+    qint64 m_memoryBudget;
+
+    KWIN_SINGLETON(WindowThumbnailCache)
+};
+
+} // namespace KWin
@@ -52,6 +52,7 @@
 #include "virtualdesktops.h"
 #include "was_user_interaction_x11_filter.h"
 #include "wayland_server.h"
+#include "windowthumbnailcache.h"
 #include "xwaylandwindow.h"
 // KDE
 #include <KConfig>
@@ -183,6 +184,7 @@ Workspace::Workspace()
 
     new DBusInterface(this);
     Outline::create(this);
+    WindowThumbnailCache::create(this);
 
     initShortcuts();
 